@@ -387,6 +387,35 @@ gimp_zoom_quality_get_type (void)
   return type;
 }
 
+GType
+gimp_xcf_compression_codec_get_type (void)
+{
+  static const GEnumValue values[] =
+  {
+    { GIMP_XCF_COMPRESSION_CODEC_ZLIB, "GIMP_XCF_COMPRESSION_CODEC_ZLIB", "zlib" },
+    { GIMP_XCF_COMPRESSION_CODEC_ZSTD, "GIMP_XCF_COMPRESSION_CODEC_ZSTD", "zstd" },
+    { 0, NULL, NULL }
+  };
+
+  static const GimpEnumDesc descs[] =
+  {
+    { GIMP_XCF_COMPRESSION_CODEC_ZLIB, NC_("xcf-compression-codec", "zlib (compatible)"), NULL },
+    { GIMP_XCF_COMPRESSION_CODEC_ZSTD, NC_("xcf-compression-codec", "Zstandard (fast)"), NULL },
+    { 0, NULL, NULL }
+  };
+
+  static GType type = 0;
+
+  if (G_UNLIKELY (! type))
+    {
+      type = g_enum_register_static ("GimpXcfCompressionCodec", values);
+      gimp_type_set_translation_context (type, "xcf-compression-codec");
+      gimp_enum_set_value_descriptions (type, descs);
+    }
+
+  return type;
+}
+
 
 /* Generated data ends here */
 
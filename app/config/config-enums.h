@@ -165,4 +165,15 @@ typedef enum
 } GimpZoomQuality;
 
 
+#define GIMP_TYPE_XCF_COMPRESSION_CODEC (gimp_xcf_compression_codec_get_type ())
+
+GType gimp_xcf_compression_codec_get_type (void) G_GNUC_CONST;
+
+typedef enum
+{
+  GIMP_XCF_COMPRESSION_CODEC_ZLIB, /*< desc="zlib (compatible)" >*/
+  GIMP_XCF_COMPRESSION_CODEC_ZSTD  /*< desc="Zstandard (fast)"  >*/
+} GimpXcfCompressionCodec;
+
+
 #endif /* __CONFIG_ENUMS_H__ */
@@ -120,6 +120,9 @@ enum
   PROP_EXPORT_METADATA_EXIF,
   PROP_EXPORT_METADATA_XMP,
   PROP_EXPORT_METADATA_IPTC,
+  PROP_XCF_COMPRESSION_CODEC,
+  PROP_XCF_ZSTD_LEVEL,
+  PROP_XCF_LAZY_LOADING,
   PROP_DEBUG_POLICY,
   PROP_CHECK_UPDATES,
   PROP_CHECK_UPDATE_TIMESTAMP,
@@ -783,6 +786,28 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                             TRUE,
                             GIMP_PARAM_STATIC_STRINGS);
 
+  GIMP_CONFIG_PROP_ENUM (object_class, PROP_XCF_COMPRESSION_CODEC,
+                         "xcf-compression-codec",
+                         "XCF compression codec",
+                         XCF_COMPRESSION_CODEC_BLURB,
+                         GIMP_TYPE_XCF_COMPRESSION_CODEC,
+                         GIMP_XCF_COMPRESSION_CODEC_ZLIB,
+                         GIMP_PARAM_STATIC_STRINGS);
+
+  GIMP_CONFIG_PROP_INT (object_class, PROP_XCF_ZSTD_LEVEL,
+                        "xcf-zstd-level",
+                        "XCF Zstandard compression level",
+                        XCF_ZSTD_LEVEL_BLURB,
+                        1, 19, 3,
+                        GIMP_PARAM_STATIC_STRINGS);
+
+  GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_XCF_LAZY_LOADING,
+                            "xcf-lazy-loading",
+                            "Load XCF pixel data on demand",
+                            XCF_LAZY_LOADING_BLURB,
+                            FALSE,
+                            GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_PROP_ENUM (object_class, PROP_DEBUG_POLICY,
                          "debug-policy",
                          "Try generating backtrace upon errors",
@@ -1167,6 +1192,15 @@ gimp_core_config_set_property (GObject      *object,
     case PROP_EXPORT_METADATA_IPTC:
       core_config->export_metadata_iptc = g_value_get_boolean (value);
       break;
+    case PROP_XCF_COMPRESSION_CODEC:
+      core_config->xcf_compression_codec = g_value_get_enum (value);
+      break;
+    case PROP_XCF_ZSTD_LEVEL:
+      core_config->xcf_zstd_level = g_value_get_int (value);
+      break;
+    case PROP_XCF_LAZY_LOADING:
+      core_config->xcf_lazy_loading = g_value_get_boolean (value);
+      break;
     case PROP_DEBUG_POLICY:
       core_config->debug_policy = g_value_get_enum (value);
       break;
@@ -1432,6 +1466,15 @@ gimp_core_config_get_property (GObject    *object,
     case PROP_EXPORT_METADATA_IPTC:
       g_value_set_boolean (value, core_config->export_metadata_iptc);
       break;
+    case PROP_XCF_COMPRESSION_CODEC:
+      g_value_set_enum (value, core_config->xcf_compression_codec);
+      break;
+    case PROP_XCF_ZSTD_LEVEL:
+      g_value_set_int (value, core_config->xcf_zstd_level);
+      break;
+    case PROP_XCF_LAZY_LOADING:
+      g_value_set_boolean (value, core_config->xcf_lazy_loading);
+      break;
     case PROP_DEBUG_POLICY:
       g_value_set_enum (value, core_config->debug_policy);
       break;
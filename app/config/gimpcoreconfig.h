@@ -104,6 +104,9 @@ struct _GimpCoreConfig
   gboolean                export_metadata_exif;
   gboolean                export_metadata_xmp;
   gboolean                export_metadata_iptc;
+  GimpXcfCompressionCodec xcf_compression_codec;
+  gint                    xcf_zstd_level;
+  gboolean                xcf_lazy_loading;
   GimpDebugPolicy         debug_policy;
 #ifdef G_OS_WIN32
   GimpWin32PointerInputAPI win32_pointer_input_api;
@@ -250,6 +250,21 @@ _("Export XMP metadata by default.")
 #define EXPORT_METADATA_IPTC_BLURB \
 _("Export IPTC metadata by default.")
 
+#define XCF_COMPRESSION_CODEC_BLURB \
+_("Codec used for tile data when saving XCF files with compression.  " \
+  "Zstandard is much faster than zlib, but the resulting files can only " \
+  "be opened by GIMP 3.2 or newer.")
+
+#define XCF_ZSTD_LEVEL_BLURB \
+_("Compression level used when saving XCF files with Zstandard " \
+  "compression.  Higher levels produce smaller files, but are slower.")
+
+#define XCF_LAZY_LOADING_BLURB \
+_("When enabled, the pixel data of compressed XCF files is only " \
+  "decompressed when it is first needed, instead of while opening the " \
+  "file.  The file is kept open until all of its pixels have been " \
+  "loaded.")
+
 #define GENERATE_BACKTRACE_BLURB \
 _("Try generating debug data for bug reporting when appropriate.")
 
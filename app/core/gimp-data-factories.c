@@ -34,6 +34,7 @@
 #include "gimp-palettes.h"
 #include "gimpcontainer.h"
 #include "gimpbrush-load.h"
+#include "gimpbrush-save.h"
 #include "gimpbrush.h"
 #include "gimpbrushclipboard.h"
 #include "gimpbrushgenerated-load.h"
@@ -44,10 +45,12 @@
 #include "gimpgradient-load.h"
 #include "gimpgradient.h"
 #include "gimpmybrush-load.h"
+#include "gimpmybrush-save.h"
 #include "gimpmybrush.h"
 #include "gimppalette-load.h"
 #include "gimppalette.h"
 #include "gimppattern-load.h"
+#include "gimppattern-save.h"
 #include "gimppattern.h"
 #include "gimppatternclipboard.h"
 #include "gimptagcache.h"
@@ -74,6 +77,7 @@ gimp_data_factories_init (Gimp *gimp)
                                   gimp_brush_get_standard);
   gimp_object_set_static_name (GIMP_OBJECT (gimp->brush_factory),
                                "brush factory");
+  gimp_data_loader_factory_set_parallel (gimp->brush_factory, TRUE);
   gimp_data_loader_factory_add_loader (gimp->brush_factory,
                                        "GIMP Brush",
                                        gimp_brush_load,
@@ -104,6 +108,10 @@ gimp_data_factories_init (Gimp *gimp)
                                        gimp_brush_pipe_load,
                                        GIMP_BRUSH_PIPE_FILE_EXTENSION,
                                        TRUE);
+  gimp_data_loader_factory_set_index (gimp->brush_factory,
+                                      "brushes.index",
+                                      gimp_brush_load_index,
+                                      gimp_brush_save_index);
 
   gimp->dynamics_factory =
     gimp_data_loader_factory_new (gimp,
@@ -115,6 +123,7 @@ gimp_data_factories_init (Gimp *gimp)
                                   gimp_dynamics_get_standard);
   gimp_object_set_static_name (GIMP_OBJECT (gimp->dynamics_factory),
                                "dynamics factory");
+  gimp_data_loader_factory_set_parallel (gimp->dynamics_factory, TRUE);
   gimp_data_loader_factory_add_loader (gimp->dynamics_factory,
                                        "GIMP Paint Dynamics",
                                        gimp_dynamics_load,
@@ -131,11 +140,16 @@ gimp_data_factories_init (Gimp *gimp)
                                   NULL);
   gimp_object_set_static_name (GIMP_OBJECT (gimp->mybrush_factory),
                                "mypaint brush factory");
+  gimp_data_loader_factory_set_parallel (gimp->mybrush_factory, TRUE);
   gimp_data_loader_factory_add_loader (gimp->mybrush_factory,
                                        "MyPaint Brush",
                                        gimp_mybrush_load,
                                        GIMP_MYBRUSH_FILE_EXTENSION,
                                        FALSE);
+  gimp_data_loader_factory_set_index (gimp->mybrush_factory,
+                                      "mypaint-brushes.index",
+                                      gimp_mybrush_load_index,
+                                      gimp_mybrush_save_index);
 
   gimp->pattern_factory =
     gimp_data_loader_factory_new (gimp,
@@ -147,6 +161,7 @@ gimp_data_factories_init (Gimp *gimp)
                                   gimp_pattern_get_standard);
   gimp_object_set_static_name (GIMP_OBJECT (gimp->pattern_factory),
                                "pattern factory");
+  gimp_data_loader_factory_set_parallel (gimp->pattern_factory, TRUE);
   gimp_data_loader_factory_add_loader (gimp->pattern_factory,
                                        "GIMP Pattern",
                                        gimp_pattern_load,
@@ -155,6 +170,10 @@ gimp_data_factories_init (Gimp *gimp)
   gimp_data_loader_factory_add_fallback (gimp->pattern_factory,
                                          "Pattern from GdkPixbuf",
                                          gimp_pattern_load_pixbuf);
+  gimp_data_loader_factory_set_index (gimp->pattern_factory,
+                                      "patterns.index",
+                                      gimp_pattern_load_index,
+                                      gimp_pattern_save_index);
 
   gimp->gradient_factory =
     gimp_data_loader_factory_new (gimp,
@@ -166,6 +185,7 @@ gimp_data_factories_init (Gimp *gimp)
                                   gimp_gradient_get_standard);
   gimp_object_set_static_name (GIMP_OBJECT (gimp->gradient_factory),
                                "gradient factory");
+  gimp_data_loader_factory_set_parallel (gimp->gradient_factory, TRUE);
   gimp_data_loader_factory_add_loader (gimp->gradient_factory,
                                        "GIMP Gradient",
                                        gimp_gradient_load,
@@ -187,6 +207,7 @@ gimp_data_factories_init (Gimp *gimp)
                                   gimp_palette_get_standard);
   gimp_object_set_static_name (GIMP_OBJECT (gimp->palette_factory),
                                "palette factory");
+  gimp_data_loader_factory_set_parallel (gimp->palette_factory, TRUE);
   gimp_data_loader_factory_add_loader (gimp->palette_factory,
                                        "GIMP Palette",
                                        gimp_palette_load,
@@ -46,44 +46,72 @@ extern "C"
 
 
 #define GIMP_PARALLEL_MAX_THREADS           64
-#define GIMP_PARALLEL_RUN_ASYNC_MAX_THREADS  1
+#define GIMP_PARALLEL_RUN_ASYNC_MAX_THREADS GIMP_PARALLEL_MAX_THREADS
 
 
+typedef struct _GimpParallelRunAsyncThread GimpParallelRunAsyncThread;
+
 typedef struct
 {
-  GimpAsync        *async;
-  gint              priority;
-  GimpRunAsyncFunc  func;
-  gpointer          user_data;
-  GDestroyNotify    user_data_destroy_func;
+  GimpAsync                  *async;
+  gint                        priority;
+  GimpRunAsyncFunc            func;
+  gpointer                    user_data;
+  GDestroyNotify              user_data_destroy_func;
+  gboolean                    concurrent;
+
+  GimpParallelRunAsyncThread *queue_thread;
 } GimpParallelRunAsyncTask;
 
-typedef struct
+struct _GimpParallelRunAsyncThread
 {
   GThread   *thread;
 
   gboolean   quit;
 
   GimpAsync *current_async;
-} GimpParallelRunAsyncThread;
 
+  /* each thread owns a priority-sorted task queue.  the queue, as well as
+   * 'current_async', is protected by 'mutex'.  'n_tasks' and 'head_priority'
+   * mirror the queue's state, and are read without locking by other threads,
+   * when looking for a task to steal.
+   */
+  GMutex     mutex;
+  GQueue     queue;
+  gint       n_tasks;
+  gint       head_priority;
+};
 
-/*  local function prototypes  */
 
-static void                       gimp_parallel_notify_num_processors   (GimpGeglConfig             *config);
-
-static void                       gimp_parallel_set_n_threads           (gint                        n_threads,
-                                                                         gboolean                    finish_tasks);
+/*  local function prototypes  */
 
-static void                       gimp_parallel_run_async_set_n_threads (gint                        n_threads,
-                                                                         gboolean                    finish_tasks);
-static gpointer                   gimp_parallel_run_async_thread_func   (GimpParallelRunAsyncThread *thread);
-static void                       gimp_parallel_run_async_enqueue_task  (GimpParallelRunAsyncTask   *task);
-static GimpParallelRunAsyncTask * gimp_parallel_run_async_dequeue_task  (void);
-static gboolean                   gimp_parallel_run_async_execute_task  (GimpParallelRunAsyncTask   *task);
-static void                       gimp_parallel_run_async_abort_task    (GimpParallelRunAsyncTask   *task);
-static void                       gimp_parallel_run_async_cancel        (GimpAsync                  *async);
-static void                       gimp_parallel_run_async_waiting       (GimpAsync                  *async);
+static void                       gimp_parallel_notify_num_processors        (GimpGeglConfig             *config);
+
+static void                       gimp_parallel_set_n_threads                (gint                        n_threads,
+                                                                              gboolean                    finish_tasks);
+
+static void                       gimp_parallel_run_async_set_n_threads      (gint                        n_threads,
+                                                                              gboolean                    finish_tasks);
+static GimpAsync                * gimp_parallel_run_async_submit             (gint                        priority,
+                                                                              gboolean                    concurrent,
+                                                                              GimpRunAsyncFunc            func,
+                                                                              gpointer                    user_data,
+                                                                              GDestroyNotify              user_data_destroy_func);
+static gpointer                   gimp_parallel_run_async_thread_func        (GimpParallelRunAsyncThread *thread);
+static void                       gimp_parallel_run_async_enqueue_task       (GimpParallelRunAsyncTask   *task,
+                                                                              GimpParallelRunAsyncThread *thread);
+static GimpParallelRunAsyncTask * gimp_parallel_run_async_dequeue_task       (GimpParallelRunAsyncThread *thread);
+static GimpParallelRunAsyncTask * gimp_parallel_run_async_pop_task           (GimpParallelRunAsyncThread *thread);
+static gboolean                   gimp_parallel_run_async_has_pending_task   (gint                        priority);
+static void                       gimp_parallel_run_async_update_queue_state (GimpParallelRunAsyncThread *thread);
+static void                       gimp_parallel_run_async_unqueue_count      (GimpParallelRunAsyncTask   *task);
+static void                       gimp_parallel_run_async_wake_thread        (gboolean                    serial);
+static gboolean                   gimp_parallel_run_async_execute_task       (GimpParallelRunAsyncTask   *task);
+static void                       gimp_parallel_run_async_abort_task         (GimpParallelRunAsyncTask   *task);
+static void                       gimp_parallel_run_async_lock_queues        (void);
+static void                       gimp_parallel_run_async_unlock_queues      (void);
+static void                       gimp_parallel_run_async_cancel             (GimpAsync                  *async);
+static void                       gimp_parallel_run_async_waiting            (GimpAsync                  *async);
 
 
 /*  local variables  */
@@ -91,9 +119,30 @@ static void                       gimp_parallel_run_async_waiting       (GimpAsy
 static gint                       gimp_parallel_run_async_n_threads = 0;
 static GimpParallelRunAsyncThread gimp_parallel_run_async_threads[GIMP_PARALLEL_RUN_ASYNC_MAX_THREADS];
 
+/* tasks that weren't submitted as concurrent may rely on running one at a
+ * time, in the order of their priority, as they did when there was a single
+ * async thread.  they go to the serial queue, which only the first thread
+ * takes tasks from, and which is never stolen from.
+ */
+static GimpParallelRunAsyncThread gimp_parallel_run_async_serial;
+
+/* 'rw_lock' protects the thread count: it's held for reading while
+ * enqueueing tasks, and while accessing more than a single queue, and for
+ * writing while the thread count changes.
+ */
+static GRWLock                    gimp_parallel_run_async_rw_lock;
+
+/* 'mutex' and 'cond' are only used for putting idle threads to sleep */
 static GMutex                     gimp_parallel_run_async_mutex;
 static GCond                      gimp_parallel_run_async_cond;
-static GQueue                     gimp_parallel_run_async_queue = G_QUEUE_INIT;
+static gint                       gimp_parallel_run_async_n_waiting = 0;
+
+static GPrivate                   gimp_parallel_run_async_current_thread;
+static guint                      gimp_parallel_run_async_next_thread = 0;
+
+static gint                       gimp_parallel_run_async_n_queued = 0;
+static gint                       gimp_parallel_run_async_n_serial_queued = 0;
+static gint                       gimp_parallel_run_async_n_steals = 0;
 
 
 /*  public functions  */
@@ -141,44 +190,24 @@ gimp_parallel_run_async_full (gint             priority,
                               gpointer         user_data,
                               GDestroyNotify   user_data_destroy_func)
 {
-  GimpAsync                *async;
-  GimpParallelRunAsyncTask *task;
-
   g_return_val_if_fail (func != NULL, NULL);
 
-  async = gimp_async_new ();
-
-  task = g_slice_new (GimpParallelRunAsyncTask);
-
-  task->async                  = GIMP_ASYNC (g_object_ref (async));
-  task->priority               = priority;
-  task->func                   = func;
-  task->user_data              = user_data;
-  task->user_data_destroy_func = user_data_destroy_func;
-
-  if (gimp_parallel_run_async_n_threads > 0)
-    {
-      g_signal_connect_after (async, "cancel",
-                              G_CALLBACK (gimp_parallel_run_async_cancel),
-                              NULL);
-      g_signal_connect_after (async, "waiting",
-                              G_CALLBACK (gimp_parallel_run_async_waiting),
-                              NULL);
-
-      g_mutex_lock (&gimp_parallel_run_async_mutex);
-
-      gimp_parallel_run_async_enqueue_task (task);
-
-      g_cond_signal (&gimp_parallel_run_async_cond);
+  return gimp_parallel_run_async_submit (priority, FALSE,
+                                         func, user_data,
+                                         user_data_destroy_func);
+}
 
-      g_mutex_unlock (&gimp_parallel_run_async_mutex);
-    }
-  else
-    {
-      while (gimp_parallel_run_async_execute_task (task));
-    }
+GimpAsync *
+gimp_parallel_run_async_concurrent_full (gint             priority,
+                                         GimpRunAsyncFunc func,
+                                         gpointer         user_data,
+                                         GDestroyNotify   user_data_destroy_func)
+{
+  g_return_val_if_fail (func != NULL, NULL);
 
-  return async;
+  return gimp_parallel_run_async_submit (priority, TRUE,
+                                         func, user_data,
+                                         user_data_destroy_func);
 }
 
 GimpAsync *
@@ -249,6 +278,20 @@ gimp_parallel_run_async_independent_full (gint             priority,
 }
 
 
+gint
+gimp_parallel_run_async_get_n_queued (void)
+{
+  return g_atomic_int_get (&gimp_parallel_run_async_n_queued) +
+         g_atomic_int_get (&gimp_parallel_run_async_n_serial_queued);
+}
+
+gint
+gimp_parallel_run_async_get_n_steals (void)
+{
+  return g_atomic_int_get (&gimp_parallel_run_async_n_steals);
+}
+
+
 /*  private functions  */
 
 
@@ -266,16 +309,71 @@ gimp_parallel_set_n_threads (gint     n_threads,
   gimp_parallel_run_async_set_n_threads (n_threads, finish_tasks);
 }
 
+static GimpAsync *
+gimp_parallel_run_async_submit (gint             priority,
+                                gboolean         concurrent,
+                                GimpRunAsyncFunc func,
+                                gpointer         user_data,
+                                GDestroyNotify   user_data_destroy_func)
+{
+  GimpAsync                *async;
+  GimpParallelRunAsyncTask *task;
+
+  async = gimp_async_new ();
+
+  task = g_slice_new (GimpParallelRunAsyncTask);
+
+  task->async                  = GIMP_ASYNC (g_object_ref (async));
+  task->priority               = priority;
+  task->func                   = func;
+  task->user_data              = user_data;
+  task->user_data_destroy_func = user_data_destroy_func;
+  task->concurrent             = concurrent;
+  task->queue_thread           = NULL;
+
+  g_rw_lock_reader_lock (&gimp_parallel_run_async_rw_lock);
+
+  if (gimp_parallel_run_async_n_threads > 0)
+    {
+      g_signal_connect_after (async, "cancel",
+                              G_CALLBACK (gimp_parallel_run_async_cancel),
+                              NULL);
+      g_signal_connect_after (async, "waiting",
+                              G_CALLBACK (gimp_parallel_run_async_waiting),
+                              NULL);
+
+      gimp_parallel_run_async_enqueue_task (
+        task,
+        (GimpParallelRunAsyncThread *) g_private_get (
+          &gimp_parallel_run_async_current_thread));
+
+      g_rw_lock_reader_unlock (&gimp_parallel_run_async_rw_lock);
+
+      gimp_parallel_run_async_wake_thread (! concurrent);
+    }
+  else
+    {
+      g_rw_lock_reader_unlock (&gimp_parallel_run_async_rw_lock);
+
+      while (gimp_parallel_run_async_execute_task (task));
+    }
+
+  return async;
+}
+
 static void
 gimp_parallel_run_async_set_n_threads (gint     n_threads,
                                        gboolean finish_tasks)
 {
-  gint i;
+  GQueue orphans = G_QUEUE_INIT;
+  gint   i;
 
   n_threads = CLAMP (n_threads, 0, GIMP_PARALLEL_RUN_ASYNC_MAX_THREADS);
 
   if (n_threads > gimp_parallel_run_async_n_threads) /* need more threads */
     {
+      g_rw_lock_writer_lock (&gimp_parallel_run_async_rw_lock);
+
       for (i = gimp_parallel_run_async_n_threads; i < n_threads; i++)
         {
           GimpParallelRunAsyncThread *thread =
@@ -283,27 +381,48 @@ gimp_parallel_run_async_set_n_threads (gint     n_threads,
 
           thread->quit = FALSE;
 
+          gimp_parallel_run_async_update_queue_state (thread);
+
           thread->thread = g_thread_new (
             "async",
             (GThreadFunc) gimp_parallel_run_async_thread_func,
             thread);
         }
+
+      g_atomic_int_set (&gimp_parallel_run_async_n_threads, n_threads);
+
+      g_rw_lock_writer_unlock (&gimp_parallel_run_async_rw_lock);
     }
   else if (n_threads < gimp_parallel_run_async_n_threads) /* need less threads */
     {
-      g_mutex_lock (&gimp_parallel_run_async_mutex);
-
       for (i = n_threads; i < gimp_parallel_run_async_n_threads; i++)
         {
           GimpParallelRunAsyncThread *thread =
             &gimp_parallel_run_async_threads[i];
+          GimpAsync                  *async  = NULL;
+
+          g_atomic_int_set (&thread->quit, TRUE);
+
+          if (! finish_tasks)
+            {
+              g_mutex_lock (&thread->mutex);
+
+              if (thread->current_async)
+                async = GIMP_ASYNC (g_object_ref (thread->current_async));
+
+              g_mutex_unlock (&thread->mutex);
+            }
 
-          thread->quit = TRUE;
+          if (async)
+            {
+              gimp_cancelable_cancel (GIMP_CANCELABLE (async));
 
-          if (thread->current_async && ! finish_tasks)
-            gimp_cancelable_cancel (GIMP_CANCELABLE (thread->current_async));
+              g_object_unref (async);
+            }
         }
 
+      g_mutex_lock (&gimp_parallel_run_async_mutex);
+
       g_cond_broadcast (&gimp_parallel_run_async_cond);
 
       g_mutex_unlock (&gimp_parallel_run_async_mutex);
@@ -315,21 +434,71 @@ gimp_parallel_run_async_set_n_threads (gint     n_threads,
 
           g_thread_join (thread->thread);
         }
-    }
 
-  gimp_parallel_run_async_n_threads = n_threads;
+      /* collect the tasks left in the queues of the removed threads */
+      g_rw_lock_writer_lock (&gimp_parallel_run_async_rw_lock);
+
+      for (i = n_threads; i < gimp_parallel_run_async_n_threads; i++)
+        {
+          GimpParallelRunAsyncThread *thread =
+            &gimp_parallel_run_async_threads[i];
+          GimpParallelRunAsyncTask   *task;
+
+          while ((task = gimp_parallel_run_async_pop_task (thread)))
+            g_queue_push_tail (&orphans, task);
+        }
+
+      /* the serial queue goes away with the first thread */
+      if (n_threads == 0)
+        {
+          GimpParallelRunAsyncTask *task;
+
+          while ((task = gimp_parallel_run_async_pop_task (
+                           &gimp_parallel_run_async_serial)))
+            {
+              g_queue_push_tail (&orphans, task);
+            }
+        }
+
+      g_atomic_int_set (&gimp_parallel_run_async_n_threads, n_threads);
 
-  if (n_threads == 0)
+      g_rw_lock_writer_unlock (&gimp_parallel_run_async_rw_lock);
+    }
+
+  if (! g_queue_is_empty (&orphans))
     {
       GimpParallelRunAsyncTask *task;
 
-      /* finish remaining tasks */
-      while ((task = gimp_parallel_run_async_dequeue_task ()))
+      if (n_threads > 0)
         {
-          if (finish_tasks)
-            while (gimp_parallel_run_async_execute_task (task));
-          else
-            gimp_parallel_run_async_abort_task (task);
+          /* hand the remaining tasks over to the remaining threads */
+          g_rw_lock_reader_lock (&gimp_parallel_run_async_rw_lock);
+
+          while ((task = (GimpParallelRunAsyncTask *) g_queue_pop_head (
+                                                        &orphans)))
+            {
+              gimp_parallel_run_async_enqueue_task (task, NULL);
+            }
+
+          g_rw_lock_reader_unlock (&gimp_parallel_run_async_rw_lock);
+
+          g_mutex_lock (&gimp_parallel_run_async_mutex);
+
+          g_cond_broadcast (&gimp_parallel_run_async_cond);
+
+          g_mutex_unlock (&gimp_parallel_run_async_mutex);
+        }
+      else
+        {
+          /* finish remaining tasks */
+          while ((task = (GimpParallelRunAsyncTask *) g_queue_pop_head (
+                                                        &orphans)))
+            {
+              if (finish_tasks)
+                while (gimp_parallel_run_async_execute_task (task));
+              else
+                gimp_parallel_run_async_abort_task (task);
+            }
         }
     }
 }
@@ -337,54 +506,80 @@ gimp_parallel_run_async_set_n_threads (gint     n_threads,
 static gpointer
 gimp_parallel_run_async_thread_func (GimpParallelRunAsyncThread *thread)
 {
-  g_mutex_lock (&gimp_parallel_run_async_mutex);
+  g_private_set (&gimp_parallel_run_async_current_thread, thread);
 
   while (TRUE)
     {
       GimpParallelRunAsyncTask *task;
 
-      while (! thread->quit &&
-             (task = gimp_parallel_run_async_dequeue_task ()))
+      while (! g_atomic_int_get (&thread->quit) &&
+             (task = gimp_parallel_run_async_dequeue_task (thread)))
         {
           gboolean resume;
 
+          g_mutex_lock (&thread->mutex);
+
           thread->current_async = GIMP_ASYNC (g_object_ref (task->async));
 
+          g_mutex_unlock (&thread->mutex);
+
           do
             {
-              g_mutex_unlock (&gimp_parallel_run_async_mutex);
-
               resume = gimp_parallel_run_async_execute_task (task);
-
-              g_mutex_lock (&gimp_parallel_run_async_mutex);
             }
           while (resume &&
-                 (g_queue_is_empty (&gimp_parallel_run_async_queue) ||
-                  task->priority <
-                  ((GimpParallelRunAsyncTask *)
-                     g_queue_peek_head (
-                       &gimp_parallel_run_async_queue))->priority));
+                 ! gimp_parallel_run_async_has_pending_task (task->priority));
+
+          g_mutex_lock (&thread->mutex);
 
           g_clear_object (&thread->current_async);
 
+          g_mutex_unlock (&thread->mutex);
+
           if (resume)
-            gimp_parallel_run_async_enqueue_task (task);
+            {
+              g_rw_lock_reader_lock (&gimp_parallel_run_async_rw_lock);
+
+              gimp_parallel_run_async_enqueue_task (task, thread);
+
+              g_rw_lock_reader_unlock (&gimp_parallel_run_async_rw_lock);
+            }
         }
 
-      if (thread->quit)
-        break;
+      g_mutex_lock (&gimp_parallel_run_async_mutex);
+
+      g_atomic_int_inc (&gimp_parallel_run_async_n_waiting);
+
+      while (! g_atomic_int_get (&thread->quit) &&
+             ! g_atomic_int_get (&gimp_parallel_run_async_n_queued) &&
+             ! (thread == &gimp_parallel_run_async_threads[0] &&
+                g_atomic_int_get (&gimp_parallel_run_async_n_serial_queued)))
+        {
+          g_cond_wait (&gimp_parallel_run_async_cond,
+                       &gimp_parallel_run_async_mutex);
+        }
+
+      g_atomic_int_add (&gimp_parallel_run_async_n_waiting, -1);
+
+      g_mutex_unlock (&gimp_parallel_run_async_mutex);
 
-      g_cond_wait (&gimp_parallel_run_async_cond,
-                   &gimp_parallel_run_async_mutex);
+      if (g_atomic_int_get (&thread->quit))
+        break;
     }
 
-  g_mutex_unlock (&gimp_parallel_run_async_mutex);
+  g_private_set (&gimp_parallel_run_async_current_thread, NULL);
 
   return NULL;
 }
 
+/* must be called with 'rw_lock' held for reading.  serial tasks are always
+ * queued on the serial queue.  otherwise, if 'thread' is NULL, or doesn't
+ * belong to the current set of threads, the task is queued on one of the
+ * threads in a round-robin fashion.
+ */
 static void
-gimp_parallel_run_async_enqueue_task (GimpParallelRunAsyncTask *task)
+gimp_parallel_run_async_enqueue_task (GimpParallelRunAsyncTask   *task,
+                                      GimpParallelRunAsyncThread *thread)
 {
   GList *link;
   GList *iter;
@@ -396,13 +591,34 @@ gimp_parallel_run_async_enqueue_task (GimpParallelRunAsyncTask *task)
       return;
     }
 
+  if (! task->concurrent)
+    {
+      thread = &gimp_parallel_run_async_serial;
+    }
+  else if (! thread ||
+           thread - gimp_parallel_run_async_threads >=
+           gimp_parallel_run_async_n_threads)
+    {
+      guint index;
+
+      index = (guint) g_atomic_int_add (
+        (gint *) &gimp_parallel_run_async_next_thread, 1);
+
+      thread = &gimp_parallel_run_async_threads[
+        index % gimp_parallel_run_async_n_threads];
+    }
+
   link       = g_list_alloc ();
   link->data = task;
 
+  g_mutex_lock (&thread->mutex);
+
+  task->queue_thread = thread;
+
   g_object_set_data (G_OBJECT (task->async),
                      "gimp-parallel-run-async-link", link);
 
-  for (iter = g_queue_peek_tail_link (&gimp_parallel_run_async_queue);
+  for (iter = g_queue_peek_tail_link (&thread->queue);
        iter;
        iter = g_list_previous (iter))
     {
@@ -423,33 +639,207 @@ gimp_parallel_run_async_enqueue_task (GimpParallelRunAsyncTask *task)
       if (link->next)
         link->next->prev = link;
       else
-        gimp_parallel_run_async_queue.tail = link;
+        thread->queue.tail = link;
 
-      gimp_parallel_run_async_queue.length++;
+      thread->queue.length++;
+    }
+  else
+    {
+      g_queue_push_head_link (&thread->queue, link);
     }
+
+  gimp_parallel_run_async_update_queue_state (thread);
+
+  if (task->concurrent)
+    g_atomic_int_inc (&gimp_parallel_run_async_n_queued);
   else
+    g_atomic_int_inc (&gimp_parallel_run_async_n_serial_queued);
+
+  g_mutex_unlock (&thread->mutex);
+}
+
+/* pops the highest-priority task out of all the queues, preferring the
+ * queue of 'thread' among tasks of equal priority.  taking a task out of the
+ * queue of a different thread counts as a steal.  only the first thread
+ * takes tasks out of the serial queue.
+ */
+static GimpParallelRunAsyncTask *
+gimp_parallel_run_async_dequeue_task (GimpParallelRunAsyncThread *thread)
+{
+  while (TRUE)
     {
-      g_queue_push_head_link (&gimp_parallel_run_async_queue, link);
+      GimpParallelRunAsyncThread *victim = NULL;
+      GimpParallelRunAsyncTask   *task;
+      gint                        priority = G_MAXINT;
+      gint                        n_threads;
+      gint                        i;
+
+      if (g_atomic_int_get (&thread->n_tasks) > 0)
+        {
+          victim   = thread;
+          priority = g_atomic_int_get (&thread->head_priority);
+        }
+
+      if (thread == &gimp_parallel_run_async_threads[0] &&
+          g_atomic_int_get (&gimp_parallel_run_async_serial.n_tasks) > 0 &&
+          (! victim ||
+           g_atomic_int_get (&gimp_parallel_run_async_serial.head_priority) <
+           priority))
+        {
+          victim   = &gimp_parallel_run_async_serial;
+          priority = g_atomic_int_get (
+            &gimp_parallel_run_async_serial.head_priority);
+        }
+
+      n_threads = g_atomic_int_get (&gimp_parallel_run_async_n_threads);
+
+      for (i = 0; i < n_threads; i++)
+        {
+          GimpParallelRunAsyncThread *other_thread =
+            &gimp_parallel_run_async_threads[i];
+
+          if (other_thread == thread ||
+              ! g_atomic_int_get (&other_thread->n_tasks))
+            {
+              continue;
+            }
+
+          if (! victim ||
+              g_atomic_int_get (&other_thread->head_priority) < priority)
+            {
+              victim   = other_thread;
+              priority = g_atomic_int_get (&other_thread->head_priority);
+            }
+        }
+
+      if (! victim)
+        return NULL;
+
+      task = gimp_parallel_run_async_pop_task (victim);
+
+      if (task)
+        {
+          if (victim != thread && victim != &gimp_parallel_run_async_serial)
+            g_atomic_int_inc (&gimp_parallel_run_async_n_steals);
+
+          return task;
+        }
+
+      /* the queue was emptied under our feet; look again */
     }
 }
 
 static GimpParallelRunAsyncTask *
-gimp_parallel_run_async_dequeue_task (void)
+gimp_parallel_run_async_pop_task (GimpParallelRunAsyncThread *thread)
 {
   GimpParallelRunAsyncTask *task;
 
-  task = (GimpParallelRunAsyncTask *) g_queue_pop_head (
-                                        &gimp_parallel_run_async_queue);
+  g_mutex_lock (&thread->mutex);
+
+  task = (GimpParallelRunAsyncTask *) g_queue_pop_head (&thread->queue);
 
   if (task)
     {
       g_object_set_data (G_OBJECT (task->async),
                          "gimp-parallel-run-async-link", NULL);
+
+      task->queue_thread = NULL;
+
+      gimp_parallel_run_async_update_queue_state (thread);
+
+      gimp_parallel_run_async_unqueue_count (task);
     }
 
+  g_mutex_unlock (&thread->mutex);
+
   return task;
 }
 
+/* returns TRUE if there's a queued task whose priority is at least as high
+ * as 'priority', in which case a running task should yield to it.
+ */
+static gboolean
+gimp_parallel_run_async_has_pending_task (gint priority)
+{
+  gint n_threads;
+  gint i;
+
+  if (! g_atomic_int_get (&gimp_parallel_run_async_n_queued) &&
+      ! g_atomic_int_get (&gimp_parallel_run_async_n_serial_queued))
+    {
+      return FALSE;
+    }
+
+  if (g_atomic_int_get (&gimp_parallel_run_async_serial.n_tasks) &&
+      g_atomic_int_get (&gimp_parallel_run_async_serial.head_priority) <=
+      priority)
+    {
+      return TRUE;
+    }
+
+  n_threads = g_atomic_int_get (&gimp_parallel_run_async_n_threads);
+
+  for (i = 0; i < n_threads; i++)
+    {
+      GimpParallelRunAsyncThread *thread = &gimp_parallel_run_async_threads[i];
+
+      if (g_atomic_int_get (&thread->n_tasks) &&
+          g_atomic_int_get (&thread->head_priority) <= priority)
+        {
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+/* must be called with 'thread->mutex' held, or while no other thread may
+ * access the queue.
+ */
+static void
+gimp_parallel_run_async_update_queue_state (GimpParallelRunAsyncThread *thread)
+{
+  GimpParallelRunAsyncTask *head;
+
+  head = (GimpParallelRunAsyncTask *) g_queue_peek_head (&thread->queue);
+
+  g_atomic_int_set (&thread->head_priority,
+                    head ? head->priority : G_MAXINT);
+  g_atomic_int_set (&thread->n_tasks,
+                    g_queue_get_length (&thread->queue));
+}
+
+/* must be called with the mutex of the queue the task was taken out of */
+static void
+gimp_parallel_run_async_unqueue_count (GimpParallelRunAsyncTask *task)
+{
+  if (task->concurrent)
+    g_atomic_int_add (&gimp_parallel_run_async_n_queued, -1);
+  else
+    g_atomic_int_add (&gimp_parallel_run_async_n_serial_queued, -1);
+}
+
+static void
+gimp_parallel_run_async_wake_thread (gboolean serial)
+{
+  /* idle threads increment 'n_waiting' before checking 'n_queued', while we
+   * increment 'n_queued' before checking 'n_waiting', so at least one side
+   * is guaranteed to see the other's update.
+   */
+  if (g_atomic_int_get (&gimp_parallel_run_async_n_waiting))
+    {
+      g_mutex_lock (&gimp_parallel_run_async_mutex);
+
+      /* only the first thread runs serial tasks, wake it up for sure */
+      if (serial)
+        g_cond_broadcast (&gimp_parallel_run_async_cond);
+      else
+        g_cond_signal (&gimp_parallel_run_async_cond);
+
+      g_mutex_unlock (&gimp_parallel_run_async_mutex);
+    }
+}
+
 static gboolean
 gimp_parallel_run_async_execute_task (GimpParallelRunAsyncTask *task)
 {
@@ -487,6 +877,36 @@ gimp_parallel_run_async_abort_task (GimpParallelRunAsyncTask *task)
   g_slice_free (GimpParallelRunAsyncTask, task);
 }
 
+/* locks all the queues, so that tasks can't move between them.  the queues
+ * are always locked in the same order, and the worker threads never hold
+ * more than a single queue lock at a time, so this can't deadlock.
+ */
+static void
+gimp_parallel_run_async_lock_queues (void)
+{
+  gint i;
+
+  g_rw_lock_reader_lock (&gimp_parallel_run_async_rw_lock);
+
+  for (i = 0; i < gimp_parallel_run_async_n_threads; i++)
+    g_mutex_lock (&gimp_parallel_run_async_threads[i].mutex);
+
+  g_mutex_lock (&gimp_parallel_run_async_serial.mutex);
+}
+
+static void
+gimp_parallel_run_async_unlock_queues (void)
+{
+  gint i;
+
+  g_mutex_unlock (&gimp_parallel_run_async_serial.mutex);
+
+  for (i = gimp_parallel_run_async_n_threads - 1; i >= 0; i--)
+    g_mutex_unlock (&gimp_parallel_run_async_threads[i].mutex);
+
+  g_rw_lock_reader_unlock (&gimp_parallel_run_async_rw_lock);
+}
+
 static void
 gimp_parallel_run_async_cancel (GimpAsync *async)
 {
@@ -499,22 +919,31 @@ gimp_parallel_run_async_cancel (GimpAsync *async)
   if (! link)
     return;
 
-  g_mutex_lock (&gimp_parallel_run_async_mutex);
+  gimp_parallel_run_async_lock_queues ();
 
   link = (GList *) g_object_get_data (G_OBJECT (async),
                                       "gimp-parallel-run-async-link");
 
   if (link)
     {
+      GimpParallelRunAsyncThread *thread;
+
       g_object_set_data (G_OBJECT (async),
                          "gimp-parallel-run-async-link", NULL);
 
-      task = (GimpParallelRunAsyncTask *) link->data;
+      task   = (GimpParallelRunAsyncTask *) link->data;
+      thread = task->queue_thread;
 
-      g_queue_delete_link (&gimp_parallel_run_async_queue, link);
+      g_queue_delete_link (&thread->queue, link);
+
+      task->queue_thread = NULL;
+
+      gimp_parallel_run_async_update_queue_state (thread);
+
+      gimp_parallel_run_async_unqueue_count (task);
     }
 
-  g_mutex_unlock (&gimp_parallel_run_async_mutex);
+  gimp_parallel_run_async_unlock_queues ();
 
   if (task)
     gimp_parallel_run_async_abort_task (task);
@@ -531,22 +960,25 @@ gimp_parallel_run_async_waiting (GimpAsync *async)
   if (! link)
     return;
 
-  g_mutex_lock (&gimp_parallel_run_async_mutex);
+  gimp_parallel_run_async_lock_queues ();
 
   link = (GList *) g_object_get_data (G_OBJECT (async),
                                       "gimp-parallel-run-async-link");
 
   if (link)
     {
-      GimpParallelRunAsyncTask *task = (GimpParallelRunAsyncTask *) link->data;
+      GimpParallelRunAsyncTask   *task   = (GimpParallelRunAsyncTask *) link->data;
+      GimpParallelRunAsyncThread *thread = task->queue_thread;
 
       task->priority = G_MININT;
 
-      g_queue_unlink         (&gimp_parallel_run_async_queue, link);
-      g_queue_push_head_link (&gimp_parallel_run_async_queue, link);
+      g_queue_unlink         (&thread->queue, link);
+      g_queue_push_head_link (&thread->queue, link);
+
+      gimp_parallel_run_async_update_queue_state (thread);
     }
 
-  g_mutex_unlock (&gimp_parallel_run_async_mutex);
+  gimp_parallel_run_async_unlock_queues ();
 }
 
 } /* extern "C" */
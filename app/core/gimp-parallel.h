@@ -31,12 +31,19 @@ GimpAsync * gimp_parallel_run_async_full             (gint              priority
                                                       GimpRunAsyncFunc  func,
                                                       gpointer          user_data,
                                                       GDestroyNotify    user_data_destroy_func);
+GimpAsync * gimp_parallel_run_async_concurrent_full  (gint              priority,
+                                                      GimpRunAsyncFunc  func,
+                                                      gpointer          user_data,
+                                                      GDestroyNotify    user_data_destroy_func);
 GimpAsync * gimp_parallel_run_async_independent      (GimpRunAsyncFunc  func,
                                                       gpointer          user_data);
 GimpAsync * gimp_parallel_run_async_independent_full (gint              priority,
                                                       GimpRunAsyncFunc  func,
                                                       gpointer          user_data);
 
+gint        gimp_parallel_run_async_get_n_queued     (void);
+gint        gimp_parallel_run_async_get_n_steals     (void);
+
 
 #ifdef __cplusplus
 
@@ -191,6 +191,158 @@ gimp_boundary_find (GeglBuffer          *buffer,
   return gimp_boundary_free (boundary, FALSE);
 }
 
+/**
+ * gimp_boundary_find_area:
+ * @buffer:    a #GeglBuffer
+ * @format:    a #Babl float format representing the component to analyze
+ * @bounds:    the bounds of the outline
+ * @area:      the part of @bounds whose segments should be returned
+ * @threshold: pixel value of boundary line
+ * @num_segs:  number of returned #GimpBoundSeg's
+ *
+ * This function returns the part of the outline found by
+ * gimp_boundary_find() with %GIMP_BOUNDARY_WITHIN_BOUNDS and @bounds
+ * that lies in @area: the horizontal segments on the scanlines, and the
+ * vertical segments on the columns, that start in @area, as well as the
+ * ones on the bottom and right edges of @bounds if @area touches them.
+ *
+ * The outlines of a set of areas partitioning @bounds together form the
+ * outline of @bounds, with segments split at the area edges, so that
+ * the outline of a changed area can be recomputed on its own.
+ *
+ * Returns: the boundary array.
+ **/
+GimpBoundSeg *
+gimp_boundary_find_area (GeglBuffer          *buffer,
+                         const Babl          *format,
+                         const GeglRectangle *bounds,
+                         const GeglRectangle *area,
+                         gfloat               threshold,
+                         gint                *num_segs)
+{
+  GimpBoundary  *boundary;
+  GeglRectangle  rect;
+  GeglRectangle  src_rect;
+  gfloat        *src;
+  guint8        *mask;
+  gint           stride;
+  gint           n_rows;
+  gint           n_cols;
+  gint           x, y;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (format != NULL, NULL);
+  g_return_val_if_fail (babl_format_get_bytes_per_pixel (format) ==
+                        sizeof (gfloat), NULL);
+  g_return_val_if_fail (bounds != NULL, NULL);
+  g_return_val_if_fail (area != NULL, NULL);
+  g_return_val_if_fail (num_segs != NULL, NULL);
+
+  *num_segs = 0;
+
+  if (! gegl_rectangle_intersect (&rect, area, bounds))
+    return NULL;
+
+  /*  the scanlines and columns owned by the area; the last ones of
+   *  @bounds also belong to the areas touching them
+   */
+  n_rows = rect.height + (rect.y + rect.height == bounds->y + bounds->height);
+  n_cols = rect.width  + (rect.x + rect.width  == bounds->x + bounds->width);
+
+  /*  the mask of the area, with a one-pixel margin in which the pixels
+   *  outside of @bounds are unselected
+   */
+  stride = rect.width + 2;
+  mask   = g_new0 (guint8, (gsize) stride * (rect.height + 2));
+
+  gegl_rectangle_set (&src_rect,
+                      rect.x - 1,     rect.y - 1,
+                      rect.width + 2, rect.height + 2);
+  gegl_rectangle_intersect (&src_rect, &src_rect, bounds);
+
+  src = g_new (gfloat, (gsize) src_rect.width * src_rect.height);
+
+  gegl_buffer_get (buffer, &src_rect, 1.0, format, src,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (y = 0; y < src_rect.height; y++)
+    {
+      const gfloat *s = src + (gsize) y * src_rect.width;
+      guint8       *d = mask + (gsize) (src_rect.y - rect.y + 1 + y) * stride +
+                               (src_rect.x - rect.x + 1);
+
+      for (x = 0; x < src_rect.width; x++)
+        d[x] = s[x] > threshold;
+    }
+
+  g_free (src);
+
+  boundary = gimp_boundary_new (NULL);
+
+  /*  horizontal segments, between each row and the one above it  */
+  for (y = 0; y < n_rows; y++)
+    {
+      const guint8 *above = mask + (gsize) y       * stride + 1;
+      const guint8 *below = mask + (gsize) (y + 1) * stride + 1;
+      gint          start = 0;
+
+      for (x = 0; x <= rect.width; x++)
+        {
+          if (x == rect.width            ||
+              above[x] == below[x]       ||
+              above[x] != above[start]   ||
+              above[start] == below[start])
+            {
+              if (x > start && above[start] != below[start])
+                {
+                  gimp_boundary_add_seg (boundary,
+                                         rect.x + start, rect.y + y,
+                                         rect.x + x,     rect.y + y,
+                                         below[start]);
+                }
+
+              start = x;
+            }
+        }
+    }
+
+  /*  vertical segments, between each column and the one to its left  */
+  for (x = 0; x < n_cols; x++)
+    {
+      const guint8 *left  = mask + stride + x;
+      const guint8 *right = mask + stride + x + 1;
+      gint          start = 0;
+
+      for (y = 0; y <= rect.height; y++)
+        {
+          gsize i = (gsize) y     * stride;
+          gsize s = (gsize) start * stride;
+
+          if (y == rect.height     ||
+              left[i] == right[i]  ||
+              left[i] != left[s]   ||
+              left[s] == right[s])
+            {
+              if (y > start && left[s] != right[s])
+                {
+                  gimp_boundary_add_seg (boundary,
+                                         rect.x + x, rect.y + start,
+                                         rect.x + x, rect.y + y,
+                                         right[s]);
+                }
+
+              start = y;
+            }
+        }
+    }
+
+  g_free (mask);
+
+  *num_segs = boundary->num_segs;
+
+  return gimp_boundary_free (boundary, FALSE);
+}
+
 /**
  * gimp_boundary_sort:
  * @segs:       unsorted input segs.
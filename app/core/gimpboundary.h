@@ -51,6 +51,12 @@ GimpBoundSeg * gimp_boundary_find      (GeglBuffer          *buffer,
                                         gint                 y2,
                                         gfloat               threshold,
                                         gint                *num_segs);
+GimpBoundSeg * gimp_boundary_find_area (GeglBuffer          *buffer,
+                                        const Babl          *format,
+                                        const GeglRectangle *bounds,
+                                        const GeglRectangle *area,
+                                        gfloat               threshold,
+                                        gint                *num_segs);
 GimpBoundSeg * gimp_boundary_sort      (const GimpBoundSeg  *segs,
                                         gint                 num_segs,
                                         gint                *num_groups);
@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
@@ -30,6 +32,8 @@
 #include "gimpbrush-header.h"
 #include "gimpbrush-load.h"
 #include "gimpbrush-private.h"
+#include "gimpbrushpipe.h"
+#include "gimpdataloaderfactory.h"
 #include "gimppattern-header.h"
 #include "gimptempbuf.h"
 
@@ -526,6 +530,127 @@ gimp_brush_load_abr (GimpContext   *context,
   return g_list_reverse (brush_list);
 }
 
+/*  restores a brush or brush pipe written by gimp_brush_save_index(),
+ *  without its pixels, unless it is a brush small enough to be stored
+ *  whole
+ */
+GimpData *
+gimp_brush_load_index (GDataInputStream  *input,
+                       GError           **error)
+{
+  GimpBrush   *brush            = NULL;
+  gchar       *name             = NULL;
+  gchar       *mime_type        = NULL;
+  gchar       *checksum         = NULL;
+  guint32      spacing;
+  guint32      width;
+  guint32      height;
+  guint32      thumb_width;
+  guint32      thumb_height;
+  guint32      has_pixmap;
+  GimpTempBuf *thumbnail        = NULL;
+  GimpTempBuf *pixmap_thumbnail = NULL;
+  gboolean     pipe;
+
+  g_return_val_if_fail (G_IS_DATA_INPUT_STREAM (input), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (! (name      = gimp_data_index_read_string (input, error)) ||
+      ! (mime_type = gimp_data_index_read_string (input, error)) ||
+      ! (checksum  = gimp_data_index_read_string (input, error)))
+    {
+      goto out;
+    }
+
+  if (! gimp_data_index_read_uint32 (input, &spacing,      error) ||
+      ! gimp_data_index_read_uint32 (input, &width,        error) ||
+      ! gimp_data_index_read_uint32 (input, &height,       error) ||
+      ! gimp_data_index_read_uint32 (input, &thumb_width,  error) ||
+      ! gimp_data_index_read_uint32 (input, &thumb_height, error) ||
+      ! gimp_data_index_read_uint32 (input, &has_pixmap,   error))
+    {
+      goto out;
+    }
+
+  pipe = ! strcmp (mime_type, "image/x-gimp-gih");
+
+  if ((! pipe && strcmp (mime_type, "image/x-gimp-gbr")) ||
+      spacing > G_MAXINT                                  ||
+      width  < 1 || width  > GIMP_BRUSH_MAX_SIZE          ||
+      height < 1 || height > GIMP_BRUSH_MAX_SIZE          ||
+      thumb_width  < 1 || thumb_width  > width            ||
+      thumb_height < 1 || thumb_height > height           ||
+      has_pixmap > 1)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   _("Invalid brush index entry."));
+      goto out;
+    }
+
+  thumbnail = gimp_temp_buf_new (thumb_width, thumb_height,
+                                 babl_format ("Y u8"));
+
+  if (! gimp_data_index_read (input,
+                              gimp_temp_buf_get_data (thumbnail),
+                              gimp_temp_buf_get_data_size (thumbnail),
+                              error))
+    {
+      goto out;
+    }
+
+  if (has_pixmap)
+    {
+      pixmap_thumbnail = gimp_temp_buf_new (thumb_width, thumb_height,
+                                            babl_format ("R'G'B' u8"));
+
+      if (! gimp_data_index_read (input,
+                                  gimp_temp_buf_get_data (pixmap_thumbnail),
+                                  gimp_temp_buf_get_data_size (pixmap_thumbnail),
+                                  error))
+        {
+          goto out;
+        }
+    }
+
+  brush = g_object_new (pipe ? GIMP_TYPE_BRUSH_PIPE : GIMP_TYPE_BRUSH,
+                        "name",      name,
+                        "mime-type", mime_type,
+                        NULL);
+
+  brush->priv->spacing  = spacing;
+  brush->priv->x_axis.x = width  / 2.0;
+  brush->priv->x_axis.y = 0.0;
+  brush->priv->y_axis.x = 0.0;
+  brush->priv->y_axis.y = height / 2.0;
+
+  if (! pipe && thumb_width == width && thumb_height == height)
+    {
+      brush->priv->mask   = g_steal_pointer (&thumbnail);
+      brush->priv->pixmap = g_steal_pointer (&pixmap_thumbnail);
+    }
+  else
+    {
+      brush->priv->width            = width;
+      brush->priv->height           = height;
+      brush->priv->thumbnail        = g_steal_pointer (&thumbnail);
+      brush->priv->pixmap_thumbnail = g_steal_pointer (&pixmap_thumbnail);
+      brush->priv->checksum         = g_steal_pointer (&checksum);
+    }
+
+ out:
+  if (thumbnail)
+    gimp_temp_buf_unref (thumbnail);
+
+  if (pixmap_thumbnail)
+    gimp_temp_buf_unref (pixmap_thumbnail);
+
+  g_free (name);
+  g_free (mime_type);
+  g_free (checksum);
+
+  return (GimpData *) brush;
+}
+
 
 /*  private functions  */
 
@@ -41,6 +41,18 @@ struct _GimpBrushPrivate
   GimpBrushCache  *mask_cache;
   GimpBrushCache  *pixmap_cache;
   GimpBrushCache  *boundary_cache;
+
+  /*  brushes restored from the data index load their pixels when
+   *  first needed.  until then, mask and pixmap are NULL, and only
+   *  the size, thumbnails of the mask and pixmap and the checksum are
+   *  known.  load_mutex protects the loading
+   */
+  gint             width;
+  gint             height;
+  GimpTempBuf     *thumbnail;
+  GimpTempBuf     *pixmap_thumbnail;
+  gchar           *checksum;
+  GMutex           load_mutex;
 };
 
 
@@ -18,15 +18,28 @@
 #include "config.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
 
 #include "core-types.h"
 
 #include "gimpbrush.h"
 #include "gimpbrush-header.h"
 #include "gimpbrush-save.h"
+#include "gimpdataloaderfactory.h"
+#include "gimptagged.h"
 #include "gimptempbuf.h"
 
 
+/*  the size of the thumbnails kept in the data index, large enough for
+ *  the views of the brush dialogs
+ */
+#define THUMBNAIL_SIZE 64
+
+
+static GimpTempBuf * gimp_brush_save_index_thumbnail (GimpTempBuf *buf,
+                                                      gdouble      scale);
+
+
 gboolean
 gimp_brush_save (GimpData       *data,
                  GOutputStream  *output,
@@ -105,3 +118,123 @@ gimp_brush_save (GimpData       *data,
 
   return TRUE;
 }
+
+gboolean
+gimp_brush_save_index (GimpData           *data,
+                       GDataOutputStream  *output,
+                       GError            **error)
+{
+  GimpBrush   *brush            = GIMP_BRUSH (data);
+  GimpTempBuf *mask;
+  GimpTempBuf *pixmap;
+  GimpTempBuf *thumbnail;
+  GimpTempBuf *pixmap_thumbnail = NULL;
+  const gchar *mime_type;
+  gchar       *checksum;
+  gint         width;
+  gint         height;
+  gboolean     success;
+
+  mime_type = gimp_data_get_mime_type (data);
+
+  /*  only brushes which are alone in their file, and brush pipes, can
+   *  load their pixels from the file later.  generated brushes are
+   *  quick to load anyway, and Photoshop brushes come many per file,
+   *  they are simply not indexed
+   */
+  if (g_strcmp0 (mime_type, "image/x-gimp-gbr") &&
+      g_strcmp0 (mime_type, "image/x-gimp-gih"))
+    {
+      return FALSE;
+    }
+
+  mask     = gimp_brush_get_mask   (brush);
+  pixmap   = gimp_brush_get_pixmap (brush);
+  checksum = gimp_tagged_get_checksum (GIMP_TAGGED (brush));
+  width    = gimp_temp_buf_get_width  (mask);
+  height   = gimp_temp_buf_get_height (mask);
+
+  if (width <= THUMBNAIL_SIZE && height <= THUMBNAIL_SIZE)
+    {
+      /*  small brushes are stored whole, and restored loaded, except
+       *  for brush pipes, whose other brushes are only in the file
+       */
+      thumbnail = gimp_temp_buf_ref (mask);
+
+      if (pixmap)
+        pixmap_thumbnail = gimp_temp_buf_ref (pixmap);
+    }
+  else
+    {
+      gdouble scale = MIN ((gdouble) THUMBNAIL_SIZE / width,
+                           (gdouble) THUMBNAIL_SIZE / height);
+
+      thumbnail = gimp_brush_save_index_thumbnail (mask, scale);
+
+      if (pixmap)
+        pixmap_thumbnail = gimp_brush_save_index_thumbnail (pixmap, scale);
+    }
+
+  success =
+    gimp_data_index_write_string (output, gimp_object_get_name (brush),
+                                  error)                                     &&
+    gimp_data_index_write_string (output, mime_type, error)                  &&
+    gimp_data_index_write_string (output, checksum,  error)                  &&
+    g_data_output_stream_put_uint32 (output, gimp_brush_get_spacing (brush),
+                                     NULL, error)                            &&
+    g_data_output_stream_put_uint32 (output, width,  NULL, error)            &&
+    g_data_output_stream_put_uint32 (output, height, NULL, error)            &&
+    g_data_output_stream_put_uint32 (output,
+                                     gimp_temp_buf_get_width (thumbnail),
+                                     NULL, error)                            &&
+    g_data_output_stream_put_uint32 (output,
+                                     gimp_temp_buf_get_height (thumbnail),
+                                     NULL, error)                            &&
+    g_data_output_stream_put_uint32 (output, pixmap_thumbnail != NULL,
+                                     NULL, error)                            &&
+    g_output_stream_write_all (G_OUTPUT_STREAM (output),
+                               gimp_temp_buf_get_data (thumbnail),
+                               gimp_temp_buf_get_data_size (thumbnail),
+                               NULL, NULL, error)                            &&
+    (! pixmap_thumbnail ||
+     g_output_stream_write_all (G_OUTPUT_STREAM (output),
+                                gimp_temp_buf_get_data (pixmap_thumbnail),
+                                gimp_temp_buf_get_data_size (pixmap_thumbnail),
+                                NULL, NULL, error));
+
+  if (pixmap_thumbnail)
+    gimp_temp_buf_unref (pixmap_thumbnail);
+
+  gimp_temp_buf_unref (thumbnail);
+  g_free (checksum);
+
+  return success;
+}
+
+
+/*  private functions  */
+
+static GimpTempBuf *
+gimp_brush_save_index_thumbnail (GimpTempBuf *buf,
+                                 gdouble      scale)
+{
+  const Babl  *format = gimp_temp_buf_get_format (buf);
+  GeglBuffer  *buffer = gimp_temp_buf_create_buffer (buf);
+  GimpTempBuf *thumbnail;
+
+  thumbnail =
+    gimp_temp_buf_new (MAX (1, gimp_temp_buf_get_width  (buf) * scale),
+                       MAX (1, gimp_temp_buf_get_height (buf) * scale),
+                       format);
+
+  gegl_buffer_get (buffer,
+                   GEGL_RECTANGLE (0, 0,
+                                   gimp_temp_buf_get_width  (thumbnail),
+                                   gimp_temp_buf_get_height (thumbnail)),
+                   scale, format, gimp_temp_buf_get_data (thumbnail),
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+
+  g_object_unref (buffer);
+
+  return thumbnail;
+}
@@ -20,9 +20,13 @@
 
 
 /*  don't call this function directly, use gimp_data_save() instead  */
-gboolean   gimp_brush_save (GimpData       *data,
-                            GOutputStream  *output,
-                            GError        **error);
+gboolean   gimp_brush_save       (GimpData           *data,
+                                  GOutputStream      *output,
+                                  GError            **error);
+
+gboolean   gimp_brush_save_index (GimpData           *data,
+                                  GDataOutputStream  *output,
+                                  GError            **error);
 
 
 #endif  /*  __GIMP_BRUSH_SAVE_H__  */
@@ -26,6 +26,7 @@
 
 #include "core-types.h"
 
+#include "gimp-memsize.h"
 #include "gimpbezierdesc.h"
 #include "gimpbrush.h"
 #include "gimpbrush-boundary.h"
@@ -37,6 +38,7 @@
 #include "gimpbrushcache.h"
 #include "gimpbrushgenerated.h"
 #include "gimpbrushpipe.h"
+#include "gimpbrushpipe-load.h"
 #include "gimptagged.h"
 #include "gimptempbuf.h"
 
@@ -94,9 +96,18 @@ static GimpBrush   * gimp_brush_real_select_brush     (GimpBrush            *bru
 static gboolean      gimp_brush_real_want_null_motion (GimpBrush            *brush,
                                                        const GimpCoords     *last_coords,
                                                        const GimpCoords     *current_coords);
+static void          gimp_brush_real_take_pixels      (GimpBrush            *brush,
+                                                       GimpBrush            *loaded);
 
 static gchar       * gimp_brush_get_checksum          (GimpTagged           *tagged);
 
+static GimpTempBuf * gimp_brush_compose_preview       (const GimpTempBuf    *mask_buf,
+                                                       const GimpTempBuf    *pixmap_buf);
+static GimpTempBuf * gimp_brush_get_thumbnail_preview (GimpBrush            *brush,
+                                                       gint                  width,
+                                                       gint                  height);
+static void          gimp_brush_load_file             (GimpBrush            *brush);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpBrush, gimp_brush, GIMP_TYPE_DATA,
                          G_ADD_PRIVATE (GimpBrush)
@@ -148,6 +159,7 @@ gimp_brush_class_init (GimpBrushClass *klass)
   klass->transform_mask             = gimp_brush_real_transform_mask;
   klass->transform_pixmap           = gimp_brush_real_transform_pixmap;
   klass->transform_boundary         = gimp_brush_real_transform_boundary;
+  klass->take_pixels                = gimp_brush_real_take_pixels;
   klass->spacing_changed            = NULL;
 
   g_object_class_install_property (object_class, PROP_SPACING,
@@ -176,6 +188,8 @@ gimp_brush_init (GimpBrush *brush)
   brush->priv->y_axis.y = 15.0;
 
   brush->priv->blur_hardness = 1.0;
+
+  g_mutex_init (&brush->priv->load_mutex);
 }
 
 static void
@@ -194,6 +208,12 @@ gimp_brush_finalize (GObject *object)
   g_clear_object (&brush->priv->pixmap_cache);
   g_clear_object (&brush->priv->boundary_cache);
 
+  g_clear_pointer (&brush->priv->thumbnail,        gimp_temp_buf_unref);
+  g_clear_pointer (&brush->priv->pixmap_thumbnail, gimp_temp_buf_unref);
+  g_clear_pointer (&brush->priv->checksum,         g_free);
+
+  g_mutex_clear (&brush->priv->load_mutex);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -244,11 +264,25 @@ gimp_brush_get_memsize (GimpObject *object,
   GimpBrush *brush   = GIMP_BRUSH (object);
   gint64     memsize = 0;
 
+  g_mutex_lock (&brush->priv->load_mutex);
+
   memsize += gimp_temp_buf_get_memsize (brush->priv->mask);
   memsize += gimp_temp_buf_get_memsize (brush->priv->pixmap);
+  memsize += gimp_temp_buf_get_memsize (brush->priv->thumbnail);
+  memsize += gimp_temp_buf_get_memsize (brush->priv->pixmap_thumbnail);
+  memsize += gimp_string_get_memsize (brush->priv->checksum);
+
+  g_mutex_unlock (&brush->priv->load_mutex);
 
   memsize += gimp_brush_mipmap_get_memsize (brush);
 
+  memsize += gimp_object_get_memsize (GIMP_OBJECT (brush->priv->mask_cache),
+                                      gui_size);
+  memsize += gimp_object_get_memsize (GIMP_OBJECT (brush->priv->pixmap_cache),
+                                      gui_size);
+  memsize += gimp_object_get_memsize (GIMP_OBJECT (brush->priv->boundary_cache),
+                                      gui_size);
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -260,8 +294,20 @@ gimp_brush_get_size (GimpViewable *viewable,
 {
   GimpBrush *brush = GIMP_BRUSH (viewable);
 
-  *width  = gimp_temp_buf_get_width  (brush->priv->mask);
-  *height = gimp_temp_buf_get_height (brush->priv->mask);
+  g_mutex_lock (&brush->priv->load_mutex);
+
+  if (brush->priv->thumbnail)
+    {
+      *width  = brush->priv->width;
+      *height = brush->priv->height;
+    }
+  else
+    {
+      *width  = gimp_temp_buf_get_width  (brush->priv->mask);
+      *height = gimp_temp_buf_get_height (brush->priv->mask);
+    }
+
+  g_mutex_unlock (&brush->priv->load_mutex);
 
   return TRUE;
 }
@@ -273,17 +319,23 @@ gimp_brush_get_new_preview (GimpViewable *viewable,
                             gint          height)
 {
   GimpBrush         *brush       = GIMP_BRUSH (viewable);
-  const GimpTempBuf *mask_buf    = brush->priv->mask;
-  const GimpTempBuf *pixmap_buf  = brush->priv->pixmap;
+  const GimpTempBuf *mask_buf;
+  const GimpTempBuf *pixmap_buf;
   GimpTempBuf       *return_buf  = NULL;
   gint               mask_width;
   gint               mask_height;
-  guchar            *mask_data;
-  guchar            *mask;
-  guchar            *buf;
-  gint               x, y;
   gboolean           scaled = FALSE;
 
+  return_buf = gimp_brush_get_thumbnail_preview (brush, width, height);
+
+  if (return_buf)
+    return return_buf;
+
+  gimp_brush_load_pixels (brush);
+
+  mask_buf   = brush->priv->mask;
+  pixmap_buf = brush->priv->pixmap;
+
   mask_width  = gimp_temp_buf_get_width  (mask_buf);
   mask_height = gimp_temp_buf_get_height (mask_buf);
 
@@ -332,50 +384,7 @@ gimp_brush_get_new_preview (GimpViewable *viewable,
         }
     }
 
-  return_buf = gimp_temp_buf_new (mask_width, mask_height,
-                                  babl_format ("R'G'B'A u8"));
-
-  mask = mask_data = gimp_temp_buf_lock (mask_buf, babl_format ("Y u8"),
-                                         GEGL_ACCESS_READ);
-  buf  = gimp_temp_buf_get_data (return_buf);
-
-  if (pixmap_buf)
-    {
-      guchar *pixmap_data;
-      guchar *pixmap;
-
-      pixmap = pixmap_data = gimp_temp_buf_lock (pixmap_buf,
-                                                 babl_format ("R'G'B' u8"),
-                                                 GEGL_ACCESS_READ);
-
-      for (y = 0; y < mask_height; y++)
-        {
-          for (x = 0; x < mask_width ; x++)
-            {
-              *buf++ = *pixmap++;
-              *buf++ = *pixmap++;
-              *buf++ = *pixmap++;
-              *buf++ = *mask++;
-            }
-        }
-
-      gimp_temp_buf_unlock (pixmap_buf, pixmap_data);
-    }
-  else
-    {
-      for (y = 0; y < mask_height; y++)
-        {
-          for (x = 0; x < mask_width ; x++)
-            {
-              *buf++ = 0;
-              *buf++ = 0;
-              *buf++ = 0;
-              *buf++ = *mask++;
-            }
-        }
-    }
-
-  gimp_temp_buf_unlock (mask_buf, mask_data);
+  return_buf = gimp_brush_compose_preview (mask_buf, pixmap_buf);
 
   if (scaled)
     {
@@ -392,11 +401,14 @@ gimp_brush_get_description (GimpViewable  *viewable,
                             gchar        **tooltip)
 {
   GimpBrush *brush = GIMP_BRUSH (viewable);
+  gint       width;
+  gint       height;
+
+  gimp_brush_get_size (viewable, &width, &height);
 
   return g_strdup_printf ("%s (%d × %d)",
                           gimp_object_get_name (brush),
-                          gimp_temp_buf_get_width  (brush->priv->mask),
-                          gimp_temp_buf_get_height (brush->priv->mask));
+                          width, height);
 }
 
 static void
@@ -434,6 +446,9 @@ gimp_brush_copy (GimpData *data,
   GimpBrush *brush     = GIMP_BRUSH (data);
   GimpBrush *src_brush = GIMP_BRUSH (src_data);
 
+  gimp_brush_load_pixels (brush);
+  gimp_brush_load_pixels (src_brush);
+
   g_clear_pointer (&brush->priv->mask, gimp_temp_buf_unref);
   if (src_brush->priv->mask)
     brush->priv->mask = gimp_temp_buf_copy (src_brush->priv->mask);
@@ -453,13 +468,19 @@ static void
 gimp_brush_real_begin_use (GimpBrush *brush)
 {
   brush->priv->mask_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref, 'M', 'm');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref,
+                          (GimpBrushCacheSizeFunc) gimp_temp_buf_get_memsize,
+                          'M', 'm');
 
   brush->priv->pixmap_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref, 'P', 'p');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_temp_buf_unref,
+                          (GimpBrushCacheSizeFunc) gimp_temp_buf_get_memsize,
+                          'P', 'p');
 
   brush->priv->boundary_cache =
-    gimp_brush_cache_new ((GDestroyNotify) gimp_bezier_desc_free, 'B', 'b');
+    gimp_brush_cache_new ((GDestroyNotify) gimp_bezier_desc_free,
+                          (GimpBrushCacheSizeFunc) gimp_bezier_desc_get_memsize,
+                          'B', 'b');
 }
 
 static void
@@ -489,13 +510,29 @@ gimp_brush_real_want_null_motion (GimpBrush        *brush,
   return TRUE;
 }
 
+static void
+gimp_brush_real_take_pixels (GimpBrush *brush,
+                             GimpBrush *loaded)
+{
+  brush->priv->mask = gimp_temp_buf_ref (loaded->priv->mask);
+
+  if (loaded->priv->pixmap)
+    brush->priv->pixmap = gimp_temp_buf_ref (loaded->priv->pixmap);
+}
+
 static gchar *
 gimp_brush_get_checksum (GimpTagged *tagged)
 {
   GimpBrush *brush           = GIMP_BRUSH (tagged);
   gchar     *checksum_string = NULL;
 
-  if (brush->priv->mask)
+  g_mutex_lock (&brush->priv->load_mutex);
+
+  if (brush->priv->thumbnail)
+    {
+      checksum_string = g_strdup (brush->priv->checksum);
+    }
+  else if (brush->priv->mask)
     {
       GChecksum *checksum = g_checksum_new (G_CHECKSUM_MD5);
 
@@ -521,9 +558,214 @@ gimp_brush_get_checksum (GimpTagged *tagged)
       g_checksum_free (checksum);
     }
 
+  g_mutex_unlock (&brush->priv->load_mutex);
+
   return checksum_string;
 }
 
+static GimpTempBuf *
+gimp_brush_compose_preview (const GimpTempBuf *mask_buf,
+                            const GimpTempBuf *pixmap_buf)
+{
+  GimpTempBuf *return_buf;
+  gint         mask_width;
+  gint         mask_height;
+  guchar      *mask_data;
+  guchar      *mask;
+  guchar      *buf;
+  gint         x, y;
+
+  mask_width  = gimp_temp_buf_get_width  (mask_buf);
+  mask_height = gimp_temp_buf_get_height (mask_buf);
+
+  return_buf = gimp_temp_buf_new (mask_width, mask_height,
+                                  babl_format ("R'G'B'A u8"));
+
+  mask = mask_data = gimp_temp_buf_lock (mask_buf, babl_format ("Y u8"),
+                                         GEGL_ACCESS_READ);
+  buf  = gimp_temp_buf_get_data (return_buf);
+
+  if (pixmap_buf)
+    {
+      guchar *pixmap_data;
+      guchar *pixmap;
+
+      pixmap = pixmap_data = gimp_temp_buf_lock (pixmap_buf,
+                                                 babl_format ("R'G'B' u8"),
+                                                 GEGL_ACCESS_READ);
+
+      for (y = 0; y < mask_height; y++)
+        {
+          for (x = 0; x < mask_width ; x++)
+            {
+              *buf++ = *pixmap++;
+              *buf++ = *pixmap++;
+              *buf++ = *pixmap++;
+              *buf++ = *mask++;
+            }
+        }
+
+      gimp_temp_buf_unlock (pixmap_buf, pixmap_data);
+    }
+  else
+    {
+      for (y = 0; y < mask_height; y++)
+        {
+          for (x = 0; x < mask_width ; x++)
+            {
+              *buf++ = 0;
+              *buf++ = 0;
+              *buf++ = 0;
+              *buf++ = *mask++;
+            }
+        }
+    }
+
+  gimp_temp_buf_unlock (mask_buf, mask_data);
+
+  return return_buf;
+}
+
+/*  the thumbnails of a brush restored from the data index are enough
+ *  for previews no larger than themselves
+ */
+static GimpTempBuf *
+gimp_brush_get_thumbnail_preview (GimpBrush *brush,
+                                  gint       width,
+                                  gint       height)
+{
+  GimpTempBuf *thumbnail        = NULL;
+  GimpTempBuf *pixmap_thumbnail = NULL;
+  GimpTempBuf *preview;
+  gint         preview_width;
+  gint         preview_height;
+
+  /*  the brush may be loaded, and the thumbnails dropped, by another
+   *  thread while we're using them, so keep our own references
+   */
+  g_mutex_lock (&brush->priv->load_mutex);
+
+  if (brush->priv->thumbnail &&
+      MIN ((gdouble) width  / brush->priv->width,
+           (gdouble) height / brush->priv->height) <=
+      MIN ((gdouble) gimp_temp_buf_get_width  (brush->priv->thumbnail) /
+           brush->priv->width,
+           (gdouble) gimp_temp_buf_get_height (brush->priv->thumbnail) /
+           brush->priv->height))
+    {
+      thumbnail = gimp_temp_buf_ref (brush->priv->thumbnail);
+
+      if (brush->priv->pixmap_thumbnail)
+        pixmap_thumbnail = gimp_temp_buf_ref (brush->priv->pixmap_thumbnail);
+    }
+
+  g_mutex_unlock (&brush->priv->load_mutex);
+
+  if (! thumbnail)
+    return NULL;
+
+  preview = gimp_brush_compose_preview (thumbnail, pixmap_thumbnail);
+
+  preview_width  = gimp_temp_buf_get_width  (preview);
+  preview_height = gimp_temp_buf_get_height (preview);
+
+  if (preview_width > width || preview_height > height)
+    {
+      GeglBuffer  *buffer = gimp_temp_buf_create_buffer (preview);
+      GimpTempBuf *scaled;
+      gdouble      scale  = MIN ((gdouble) width  / preview_width,
+                                 (gdouble) height / preview_height);
+
+      scaled = gimp_temp_buf_new (MAX (1, preview_width  * scale),
+                                  MAX (1, preview_height * scale),
+                                  gimp_temp_buf_get_format (preview));
+
+      gegl_buffer_get (buffer,
+                       GEGL_RECTANGLE (0, 0,
+                                       gimp_temp_buf_get_width  (scaled),
+                                       gimp_temp_buf_get_height (scaled)),
+                       scale, gimp_temp_buf_get_format (scaled),
+                       gimp_temp_buf_get_data (scaled),
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+
+      g_object_unref (buffer);
+      gimp_temp_buf_unref (preview);
+
+      preview = scaled;
+    }
+
+  if (pixmap_thumbnail)
+    gimp_temp_buf_unref (pixmap_thumbnail);
+
+  gimp_temp_buf_unref (thumbnail);
+
+  return preview;
+}
+
+/*  called with load_mutex locked  */
+static void
+gimp_brush_load_file (GimpBrush *brush)
+{
+  GFile     *file;
+  GList     *list   = NULL;
+  GimpBrush *loaded = NULL;
+  GError    *error  = NULL;
+
+  file = gimp_data_get_file (GIMP_DATA (brush));
+
+  if (file)
+    {
+      GInputStream *input = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+
+      if (input)
+        {
+          GInputStream *buffered = g_buffered_input_stream_new (input);
+
+          if (gimp_file_has_extension (file, GIMP_BRUSH_PIPE_FILE_EXTENSION))
+            list = gimp_brush_pipe_load (NULL, file, buffered, &error);
+          else
+            list = gimp_brush_load (NULL, file, buffered, &error);
+
+          g_object_unref (buffered);
+          g_object_unref (input);
+        }
+    }
+
+  if (list)
+    {
+      loaded = g_object_ref (list->data);
+    }
+  else
+    {
+      /*  the file went away or changed since the index was written,
+       *  keep going with an empty brush of the same size
+       */
+      g_warning ("%s: failed to load brush '%s' from '%s': %s",
+                 G_STRFUNC,
+                 gimp_object_get_name (brush),
+                 file ? gimp_file_get_utf8_name (file) : "(none)",
+                 error ? error->message : "no data");
+
+      loaded = g_object_new (GIMP_TYPE_BRUSH,
+                             "name", gimp_object_get_name (brush),
+                             NULL);
+
+      loaded->priv->mask = gimp_temp_buf_new (MAX (brush->priv->width,  1),
+                                              MAX (brush->priv->height, 1),
+                                              babl_format ("Y u8"));
+      gimp_temp_buf_data_clear (loaded->priv->mask);
+    }
+
+  GIMP_BRUSH_GET_CLASS (brush)->take_pixels (brush, loaded);
+
+  g_object_unref (loaded);
+  g_list_free_full (list, g_object_unref);
+  g_clear_error (&error);
+
+  g_clear_pointer (&brush->priv->thumbnail,        gimp_temp_buf_unref);
+  g_clear_pointer (&brush->priv->pixmap_thumbnail, gimp_temp_buf_unref);
+}
+
 /*  public functions  */
 
 GimpData *
@@ -562,7 +804,11 @@ gimp_brush_begin_use (GimpBrush *brush)
   brush->priv->use_count++;
 
   if (brush->priv->use_count == 1)
-    GIMP_BRUSH_GET_CLASS (brush)->begin_use (brush);
+    {
+      gimp_brush_load_pixels (brush);
+
+      GIMP_BRUSH_GET_CLASS (brush)->begin_use (brush);
+    }
 }
 
 void
@@ -623,8 +869,7 @@ gimp_brush_transform_size (GimpBrush     *brush,
       aspect_ratio      == 0.0 &&
       fmod (angle, 0.5) == 0.0)
     {
-      *width  = gimp_temp_buf_get_width  (brush->priv->mask);
-      *height = gimp_temp_buf_get_height (brush->priv->mask);
+      gimp_brush_get_size (GIMP_VIEWABLE (brush), width, height);
 
       return;
     }
@@ -816,12 +1061,32 @@ gimp_brush_transform_boundary (GimpBrush *brush,
   return boundary;
 }
 
+/*  brushes restored from the data index only load their pixels when
+ *  they are first needed; code that accesses the brushes of a brush
+ *  pipe directly must call this first
+ */
+void
+gimp_brush_load_pixels (GimpBrush *brush)
+{
+  g_return_if_fail (GIMP_IS_BRUSH (brush));
+
+  /*  brushes can be used by the paint thread  */
+  g_mutex_lock (&brush->priv->load_mutex);
+
+  if (brush->priv->thumbnail)
+    gimp_brush_load_file (brush);
+
+  g_mutex_unlock (&brush->priv->load_mutex);
+}
+
 GimpTempBuf *
 gimp_brush_get_mask (GimpBrush *brush)
 {
   g_return_val_if_fail (brush != NULL, NULL);
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), NULL);
 
+  gimp_brush_load_pixels (brush);
+
   if (brush->priv->blurred_mask)
     {
       return brush->priv->blurred_mask;
@@ -835,6 +1100,8 @@ gimp_brush_get_pixmap (GimpBrush *brush)
   g_return_val_if_fail (brush != NULL, NULL);
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), NULL);
 
+  gimp_brush_load_pixels (brush);
+
   if(brush->priv->blurred_pixmap)
     {
       return brush->priv->blurred_pixmap;
@@ -871,6 +1138,9 @@ gimp_brush_get_blur_hardness (GimpBrush *brush)
 gint
 gimp_brush_get_width (GimpBrush *brush)
 {
+  gint width;
+  gint height;
+
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), 0);
 
   if (brush->priv->blurred_mask)
@@ -879,12 +1149,17 @@ gimp_brush_get_width (GimpBrush *brush)
   if (brush->priv->blurred_pixmap)
     return gimp_temp_buf_get_width (brush->priv->blurred_pixmap);
 
-  return gimp_temp_buf_get_width (brush->priv->mask);
+  gimp_brush_get_size (GIMP_VIEWABLE (brush), &width, &height);
+
+  return width;
 }
 
 gint
 gimp_brush_get_height (GimpBrush *brush)
 {
+  gint width;
+  gint height;
+
   g_return_val_if_fail (GIMP_IS_BRUSH (brush), 0);
 
   if (brush->priv->blurred_mask)
@@ -893,7 +1168,9 @@ gimp_brush_get_height (GimpBrush *brush)
   if (brush->priv->blurred_pixmap)
     return gimp_temp_buf_get_height (brush->priv->blurred_pixmap);
 
-  return gimp_temp_buf_get_height (brush->priv->mask);
+  gimp_brush_get_size (GIMP_VIEWABLE (brush), &width, &height);
+
+  return height;
 }
 
 gint
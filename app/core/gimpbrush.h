@@ -80,6 +80,8 @@ struct _GimpBrushClass
                                            gdouble           hardness,
                                            gint             *width,
                                            gint             *height);
+  void             (* take_pixels)        (GimpBrush        *brush,
+                                           GimpBrush        *loaded);
 
   /*  signals  */
   void             (* spacing_changed)    (GimpBrush        *brush);
@@ -133,6 +135,8 @@ const GimpBezierDesc * gimp_brush_transform_boundary (GimpBrush        *brush,
                                                       gint             *width,
                                                       gint             *height);
 
+void                   gimp_brush_load_pixels        (GimpBrush        *brush);
+
 GimpTempBuf          * gimp_brush_get_mask           (GimpBrush        *brush);
 GimpTempBuf          * gimp_brush_get_pixmap         (GimpBrush        *brush);
 
@@ -24,6 +24,7 @@
 #include <gegl.h>
 
 #include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
 
 #include "core-types.h"
 
@@ -33,42 +34,82 @@
 #include "gimp-intl.h"
 
 
-#define MAX_CACHED_DATA 20
+/*  the cache holds at most MAX_CACHED_DATA units, using at most
+ *  MAX_CACHED_SIZE bytes, evicting the least recently used ones
+ */
+#define MAX_CACHED_DATA 256
+#define MAX_CACHED_SIZE (16 * 1024 * 1024)
+
+/*  the transform parameters are quantized for lookup, so that nearly
+ *  identical dabs share their data
+ */
+#define SCALE_QUANTUM        (1.0 / 4096.0)
+#define ASPECT_RATIO_QUANTUM (1.0 / 1024.0)
+#define ANGLE_QUANTUM        (1.0 / 16384.0)
+#define HARDNESS_QUANTUM     (1.0 / 1024.0)
 
 
 enum
 {
   PROP_0,
-  PROP_DATA_DESTROY
+  PROP_DATA_DESTROY,
+  PROP_DATA_SIZE
 };
 
 
+typedef struct _GimpBrushCacheKey  GimpBrushCacheKey;
 typedef struct _GimpBrushCacheUnit GimpBrushCacheUnit;
 
-struct _GimpBrushCacheUnit
+struct _GimpBrushCacheKey
 {
-  gpointer data;
-
   gint     width;
   gint     height;
-  gdouble  scale;
-  gdouble  aspect_ratio;
-  gdouble  angle;
+  gint     scale;
+  gint     aspect_ratio;
+  gint     angle;
   gboolean reflect;
-  gdouble  hardness;
+  gint     hardness;
 };
 
+struct _GimpBrushCacheUnit
+{
+  GimpBrushCacheKey  key;
+
+  gpointer           data;
+  gsize              size;
+
+  GList              link;
+};
 
-static void   gimp_brush_cache_constructed  (GObject      *object);
-static void   gimp_brush_cache_finalize     (GObject      *object);
-static void   gimp_brush_cache_set_property (GObject      *object,
-                                             guint         property_id,
-                                             const GValue *value,
-                                             GParamSpec   *pspec);
-static void   gimp_brush_cache_get_property (GObject      *object,
-                                             guint         property_id,
-                                             GValue       *value,
-                                             GParamSpec   *pspec);
+
+static void       gimp_brush_cache_constructed  (GObject            *object);
+static void       gimp_brush_cache_finalize     (GObject            *object);
+static void       gimp_brush_cache_set_property (GObject            *object,
+                                                 guint               property_id,
+                                                 const GValue       *value,
+                                                 GParamSpec         *pspec);
+static void       gimp_brush_cache_get_property (GObject            *object,
+                                                 guint               property_id,
+                                                 GValue             *value,
+                                                 GParamSpec         *pspec);
+
+static gint64     gimp_brush_cache_get_memsize  (GimpObject         *object,
+                                                 gint64             *gui_size);
+
+static void       gimp_brush_cache_make_key     (GimpBrushCacheKey  *key,
+                                                 gint                width,
+                                                 gint                height,
+                                                 gdouble             scale,
+                                                 gdouble             aspect_ratio,
+                                                 gdouble             angle,
+                                                 gboolean            reflect,
+                                                 gdouble             hardness);
+static guint      gimp_brush_cache_key_hash     (gconstpointer       key);
+static gboolean   gimp_brush_cache_key_equal    (gconstpointer       key1,
+                                                 gconstpointer       key2);
+
+static void       gimp_brush_cache_remove_unit  (GimpBrushCache     *cache,
+                                                 GimpBrushCacheUnit *unit);
 
 
 G_DEFINE_TYPE (GimpBrushCache, gimp_brush_cache, GIMP_TYPE_OBJECT)
@@ -76,26 +117,44 @@ G_DEFINE_TYPE (GimpBrushCache, gimp_brush_cache, GIMP_TYPE_OBJECT)
 #define parent_class gimp_brush_cache_parent_class
 
 
+static guintptr gimp_brush_cache_total_memsize = 0;
+static gint     gimp_brush_cache_total_hits    = 0;
+static gint     gimp_brush_cache_total_misses  = 0;
+
+
 static void
 gimp_brush_cache_class_init (GimpBrushCacheClass *klass)
 {
-  GObjectClass  *object_class = G_OBJECT_CLASS (klass);
+  GObjectClass    *object_class      = G_OBJECT_CLASS (klass);
+  GimpObjectClass *gimp_object_class = GIMP_OBJECT_CLASS (klass);
 
-  object_class->constructed  = gimp_brush_cache_constructed;
-  object_class->finalize     = gimp_brush_cache_finalize;
-  object_class->set_property = gimp_brush_cache_set_property;
-  object_class->get_property = gimp_brush_cache_get_property;
+  object_class->constructed      = gimp_brush_cache_constructed;
+  object_class->finalize         = gimp_brush_cache_finalize;
+  object_class->set_property     = gimp_brush_cache_set_property;
+  object_class->get_property     = gimp_brush_cache_get_property;
+
+  gimp_object_class->get_memsize = gimp_brush_cache_get_memsize;
 
   g_object_class_install_property (object_class, PROP_DATA_DESTROY,
                                    g_param_spec_pointer ("data-destroy",
                                                          NULL, NULL,
                                                          GIMP_PARAM_READWRITE |
                                                          G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_class_install_property (object_class, PROP_DATA_SIZE,
+                                   g_param_spec_pointer ("data-size",
+                                                         NULL, NULL,
+                                                         GIMP_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT_ONLY));
 }
 
 static void
-gimp_brush_cache_init (GimpBrushCache *brush)
+gimp_brush_cache_init (GimpBrushCache *cache)
 {
+  cache->units = g_hash_table_new (gimp_brush_cache_key_hash,
+                                   gimp_brush_cache_key_equal);
+
+  g_queue_init (&cache->lru);
 }
 
 static void
@@ -106,6 +165,7 @@ gimp_brush_cache_constructed (GObject *object)
   G_OBJECT_CLASS (parent_class)->constructed (object);
 
   gimp_assert (cache->data_destroy != NULL);
+  gimp_assert (cache->data_size != NULL);
 }
 
 static void
@@ -113,8 +173,14 @@ gimp_brush_cache_finalize (GObject *object)
 {
   GimpBrushCache *cache = GIMP_BRUSH_CACHE (object);
 
+  GIMP_LOG (BRUSH_CACHE, "%c%c cache: %d hits, %d misses, %d evictions",
+            cache->debug_hit, cache->debug_miss,
+            cache->n_hits, cache->n_misses, cache->n_evictions);
+
   gimp_brush_cache_clear (cache);
 
+  g_clear_pointer (&cache->units, g_hash_table_unref);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -132,6 +198,10 @@ gimp_brush_cache_set_property (GObject      *object,
       cache->data_destroy = g_value_get_pointer (value);
       break;
 
+    case PROP_DATA_SIZE:
+      cache->data_size = g_value_get_pointer (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -152,26 +222,48 @@ gimp_brush_cache_get_property (GObject    *object,
       g_value_set_pointer (value, cache->data_destroy);
       break;
 
+    case PROP_DATA_SIZE:
+      g_value_set_pointer (value, cache->data_size);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
     }
 }
 
+static gint64
+gimp_brush_cache_get_memsize (GimpObject *object,
+                              gint64     *gui_size)
+{
+  GimpBrushCache *cache   = GIMP_BRUSH_CACHE (object);
+  gint64          memsize = 0;
+
+  memsize += cache->memsize;
+  memsize += g_queue_get_length (&cache->lru) *
+             (sizeof (GimpBrushCacheUnit) + 2 * sizeof (gpointer));
+
+  return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
+                                                                  gui_size);
+}
+
 
 /*  public functions  */
 
 GimpBrushCache *
-gimp_brush_cache_new (GDestroyNotify  data_destroy,
-                      gchar           debug_hit,
-                      gchar           debug_miss)
+gimp_brush_cache_new (GDestroyNotify         data_destroy,
+                      GimpBrushCacheSizeFunc data_size,
+                      gchar                  debug_hit,
+                      gchar                  debug_miss)
 {
   GimpBrushCache *cache;
 
   g_return_val_if_fail (data_destroy != NULL, NULL);
+  g_return_val_if_fail (data_size != NULL, NULL);
 
   cache =  g_object_new (GIMP_TYPE_BRUSH_CACHE,
                          "data-destroy", data_destroy,
+                         "data-size",    data_size,
                          NULL);
 
   cache->debug_hit  = debug_hit;
@@ -185,20 +277,8 @@ gimp_brush_cache_clear (GimpBrushCache *cache)
 {
   g_return_if_fail (GIMP_IS_BRUSH_CACHE (cache));
 
-  if (cache->cached_units)
-    {
-      GList *iter;
-
-      for (iter = cache->cached_units; iter; iter = g_list_next (iter))
-        {
-          GimpBrushCacheUnit *unit = iter->data;
-
-          cache->data_destroy (unit->data);
-        }
-
-      g_list_free_full (cache->cached_units, g_free);
-      cache->cached_units = NULL;
-    }
+  while (cache->lru.tail)
+    gimp_brush_cache_remove_unit (cache, cache->lru.tail->data);
 }
 
 gconstpointer
@@ -211,40 +291,38 @@ gimp_brush_cache_get (GimpBrushCache *cache,
                       gboolean        reflect,
                       gdouble         hardness)
 {
-  GList *iter;
+  GimpBrushCacheKey   key;
+  GimpBrushCacheUnit *unit;
 
   g_return_val_if_fail (GIMP_IS_BRUSH_CACHE (cache), NULL);
 
-  for (iter = cache->cached_units; iter; iter = g_list_next (iter))
+  gimp_brush_cache_make_key (&key,
+                             width, height,
+                             scale, aspect_ratio, angle, reflect, hardness);
+
+  unit = g_hash_table_lookup (cache->units, &key);
+
+  if (unit)
     {
-      GimpBrushCacheUnit *unit = iter->data;
-
-      if (unit->data                         &&
-          unit->width        == width        &&
-          unit->height       == height       &&
-          unit->scale        == scale        &&
-          unit->aspect_ratio == aspect_ratio &&
-          unit->angle        == angle        &&
-          unit->reflect      == reflect      &&
-          unit->hardness     == hardness)
-        {
-          if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
-            g_printerr ("%c", cache->debug_hit);
-
-          /* Make the returned cached brush first in the list. */
-          cache->cached_units = g_list_remove_link (cache->cached_units, iter);
-          iter->next = cache->cached_units;
-          if (cache->cached_units)
-            cache->cached_units->prev = iter;
-          cache->cached_units = iter;
-
-          return (gconstpointer) unit->data;
-        }
+      if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
+        g_printerr ("%c", cache->debug_hit);
+
+      cache->n_hits++;
+      g_atomic_int_inc (&gimp_brush_cache_total_hits);
+
+      /* Make the returned cached brush the most recently used. */
+      g_queue_unlink (&cache->lru, &unit->link);
+      g_queue_push_head_link (&cache->lru, &unit->link);
+
+      return (gconstpointer) unit->data;
     }
 
   if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
     g_printerr ("%c", cache->debug_miss);
 
+  cache->n_misses++;
+  g_atomic_int_inc (&gimp_brush_cache_total_misses);
+
   return NULL;
 }
 
@@ -259,44 +337,142 @@ gimp_brush_cache_add (GimpBrushCache *cache,
                       gboolean        reflect,
                       gdouble         hardness)
 {
-  GList              *iter;
   GimpBrushCacheUnit *unit;
-  GList              *last   = NULL;
-  gint                length = 0;
+  GList              *iter;
 
   g_return_if_fail (GIMP_IS_BRUSH_CACHE (cache));
   g_return_if_fail (data != NULL);
 
-  for (iter = cache->cached_units; iter; iter = g_list_next (iter))
+  /*  this only happens after a miss, which is expensive anyway  */
+  for (iter = cache->lru.head; iter; iter = g_list_next (iter))
     {
       unit = iter->data;
 
       if (data == unit->data)
         return;
+    }
+
+  unit = g_slice_new0 (GimpBrushCacheUnit);
 
-      length++;
-      last = iter;
+  gimp_brush_cache_make_key (&unit->key,
+                             width, height,
+                             scale, aspect_ratio, angle, reflect, hardness);
+
+  /*  replace the data of an equal key, which can come from a
+   *  different hardness than the one looked up
+   */
+  if (g_hash_table_contains (cache->units, &unit->key))
+    {
+      gimp_brush_cache_remove_unit (cache,
+                                    g_hash_table_lookup (cache->units,
+                                                         &unit->key));
     }
 
-  if (length > MAX_CACHED_DATA)
+  unit->data      = data;
+  unit->size      = cache->data_size (data);
+  unit->link.data = unit;
+
+  g_hash_table_insert (cache->units, &unit->key, unit);
+  g_queue_push_head_link (&cache->lru, &unit->link);
+
+  cache->memsize += unit->size;
+  g_atomic_pointer_add (&gimp_brush_cache_total_memsize, unit->size);
+
+  /*  evict the least recently used units, but always keep the new one  */
+  while (cache->lru.length > 1 &&
+         (cache->lru.length > MAX_CACHED_DATA ||
+          cache->memsize    > MAX_CACHED_SIZE))
     {
-      unit = last->data;
+      gimp_brush_cache_remove_unit (cache, cache->lru.tail->data);
 
-      cache->data_destroy (unit->data);
-      cache->cached_units = g_list_delete_link (cache->cached_units, last);
-      g_free (unit);
+      cache->n_evictions++;
     }
+}
+
+guint64
+gimp_brush_cache_get_total_memsize (void)
+{
+  return gimp_brush_cache_total_memsize;
+}
+
+gdouble
+gimp_brush_cache_get_hit_rate (void)
+{
+  gint hits   = g_atomic_int_get (&gimp_brush_cache_total_hits);
+  gint misses = g_atomic_int_get (&gimp_brush_cache_total_misses);
+
+  if (hits + misses == 0)
+    return 0.0;
+
+  return (gdouble) hits / (hits + misses);
+}
+
+
+/*  private functions  */
+
+static void
+gimp_brush_cache_make_key (GimpBrushCacheKey *key,
+                           gint               width,
+                           gint               height,
+                           gdouble            scale,
+                           gdouble            aspect_ratio,
+                           gdouble            angle,
+                           gboolean           reflect,
+                           gdouble            hardness)
+{
+  key->width        = width;
+  key->height       = height;
+  key->scale        = SIGNED_ROUND (scale        / SCALE_QUANTUM);
+  key->aspect_ratio = SIGNED_ROUND (aspect_ratio / ASPECT_RATIO_QUANTUM);
+  key->angle        = SIGNED_ROUND (angle        / ANGLE_QUANTUM);
+  key->reflect      = reflect ? TRUE : FALSE;
+  key->hardness     = SIGNED_ROUND (hardness     / HARDNESS_QUANTUM);
+}
+
+static guint
+gimp_brush_cache_key_hash (gconstpointer key)
+{
+  const GimpBrushCacheKey *k    = key;
+  guint                    hash = 17;
+
+  hash = hash * 31 + k->width;
+  hash = hash * 31 + k->height;
+  hash = hash * 31 + k->scale;
+  hash = hash * 31 + k->aspect_ratio;
+  hash = hash * 31 + k->angle;
+  hash = hash * 31 + k->reflect;
+  hash = hash * 31 + k->hardness;
+
+  return hash;
+}
+
+static gboolean
+gimp_brush_cache_key_equal (gconstpointer key1,
+                            gconstpointer key2)
+{
+  const GimpBrushCacheKey *k1 = key1;
+  const GimpBrushCacheKey *k2 = key2;
+
+  return k1->width        == k2->width        &&
+         k1->height       == k2->height       &&
+         k1->scale        == k2->scale        &&
+         k1->aspect_ratio == k2->aspect_ratio &&
+         k1->angle        == k2->angle        &&
+         k1->reflect      == k2->reflect      &&
+         k1->hardness     == k2->hardness;
+}
+
+static void
+gimp_brush_cache_remove_unit (GimpBrushCache     *cache,
+                              GimpBrushCacheUnit *unit)
+{
+  g_hash_table_remove (cache->units, &unit->key);
+  g_queue_unlink (&cache->lru, &unit->link);
 
-  unit = g_new0 (GimpBrushCacheUnit, 1);
+  cache->memsize -= unit->size;
+  g_atomic_pointer_add (&gimp_brush_cache_total_memsize, -(gssize) unit->size);
 
-  unit->data         = data;
-  unit->width        = width;
-  unit->height       = height;
-  unit->scale        = scale;
-  unit->aspect_ratio = aspect_ratio;
-  unit->angle        = angle;
-  unit->reflect      = reflect;
-  unit->hardness     = hardness;
+  cache->data_destroy (unit->data);
 
-  cache->cached_units = g_list_prepend (cache->cached_units, unit);
+  g_slice_free (GimpBrushCacheUnit, unit);
 }
@@ -34,6 +34,8 @@ gimp_brush_pipe_save (GimpData       *data,
   const gchar   *name;
   gint           i;
 
+  gimp_brush_load_pixels (GIMP_BRUSH (pipe));
+
   name = gimp_object_get_name (pipe);
 
   if (! g_output_stream_printf (output, NULL, NULL, error,
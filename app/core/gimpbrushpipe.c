@@ -57,6 +57,8 @@ static GimpBrush   * gimp_brush_pipe_select_brush     (GimpBrush        *brush,
 static gboolean      gimp_brush_pipe_want_null_motion (GimpBrush        *brush,
                                                        const GimpCoords *last_coords,
                                                        const GimpCoords *current_coords);
+static void          gimp_brush_pipe_take_pixels      (GimpBrush        *brush,
+                                                       GimpBrush        *loaded);
 
 
 G_DEFINE_TYPE (GimpBrushPipe, gimp_brush_pipe, GIMP_TYPE_BRUSH);
@@ -87,6 +89,7 @@ gimp_brush_pipe_class_init (GimpBrushPipeClass *klass)
   brush_class->end_use           = gimp_brush_pipe_end_use;
   brush_class->select_brush      = gimp_brush_pipe_select_brush;
   brush_class->want_null_motion  = gimp_brush_pipe_want_null_motion;
+  brush_class->take_pixels       = gimp_brush_pipe_take_pixels;
 }
 
 static void
@@ -175,6 +178,9 @@ gimp_brush_pipe_copy (GimpData *data,
   GimpBrushPipe *src_pipe = GIMP_BRUSH_PIPE (src_data);
   gint           i;
 
+  gimp_brush_load_pixels (GIMP_BRUSH (pipe));
+  gimp_brush_load_pixels (GIMP_BRUSH (src_pipe));
+
   pipe->dimension = src_pipe->dimension;
 
   g_clear_pointer (&pipe->rank, g_free);
@@ -334,6 +340,47 @@ gimp_brush_pipe_want_null_motion (GimpBrush        *brush,
   return TRUE;
 }
 
+static void
+gimp_brush_pipe_take_pixels (GimpBrush *brush,
+                             GimpBrush *loaded)
+{
+  GimpBrushPipe *pipe = GIMP_BRUSH_PIPE (brush);
+
+  if (GIMP_IS_BRUSH_PIPE (loaded))
+    {
+      GimpBrushPipe *src_pipe = GIMP_BRUSH_PIPE (loaded);
+
+      pipe->dimension = src_pipe->dimension;
+      pipe->rank      = g_steal_pointer (&src_pipe->rank);
+      pipe->stride    = g_steal_pointer (&src_pipe->stride);
+      pipe->select    = g_steal_pointer (&src_pipe->select);
+      pipe->index     = g_steal_pointer (&src_pipe->index);
+      pipe->params    = g_steal_pointer (&src_pipe->params);
+      pipe->n_brushes = src_pipe->n_brushes;
+      pipe->brushes   = g_steal_pointer (&src_pipe->brushes);
+
+      src_pipe->dimension = 0;
+      src_pipe->n_brushes = 0;
+      src_pipe->current   = NULL;
+    }
+  else
+    {
+      /*  the pipe's file could not be loaded, make it a pipe of the
+       *  empty brush it was replaced with
+       */
+      pipe->n_brushes  = 1;
+      pipe->brushes    = g_new (GimpBrush *, 1);
+      pipe->brushes[0] = g_object_ref (loaded);
+
+      gimp_brush_pipe_set_params (pipe, NULL);
+    }
+
+  pipe->current = pipe->brushes[0];
+
+  brush->priv->mask   = pipe->current->priv->mask;
+  brush->priv->pixmap = pipe->current->priv->pixmap;
+}
+
 
 /*  public functions  */
 
@@ -61,6 +61,9 @@
 
 #define RGBA_EPSILON 1e-6
 
+/*  the size of the tiles in which the boundary is cached  */
+#define BOUNDARY_TILE_SIZE 256
+
 enum
 {
   COLOR_CHANGED,
@@ -68,6 +71,14 @@ enum
 };
 
 
+typedef struct
+{
+  GimpBoundSeg *segs;
+  gint          num_segs;
+  gboolean      valid;
+} BoundaryTile;
+
+
 static void gimp_channel_pickable_iface_init (GimpPickableInterface *iface);
 
 static void       gimp_channel_finalize      (GObject           *object);
@@ -204,6 +215,13 @@ static void      gimp_channel_buffer_changed (GeglBuffer          *buffer,
                                               const GeglRectangle *rect,
                                               GimpChannel         *channel);
 
+static void      gimp_channel_free_boundary_tiles       (GimpChannel         *channel);
+static void      gimp_channel_invalidate_boundary_tiles (GimpChannel         *channel,
+                                                         const GeglRectangle *rect);
+static void      gimp_channel_find_boundary_tiles       (GimpChannel         *channel,
+                                                         const GeglRectangle *bounds,
+                                                         const GeglRectangle *mask_bounds);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpChannel, gimp_channel, GIMP_TYPE_DRAWABLE,
                          G_IMPLEMENT_INTERFACE (GIMP_TYPE_PICKABLE,
@@ -314,6 +332,7 @@ gimp_channel_init (GimpChannel *channel)
   channel->segs_out       = NULL;
   channel->num_segs_in    = 0;
   channel->num_segs_out   = 0;
+  channel->boundary_tiles = NULL;
   channel->empty          = FALSE;
   channel->bounds_known   = FALSE;
   channel->x1             = 0;
@@ -336,6 +355,8 @@ gimp_channel_finalize (GObject *object)
   g_clear_pointer (&channel->segs_in,  g_free);
   g_clear_pointer (&channel->segs_out, g_free);
 
+  gimp_channel_free_boundary_tiles (channel);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -348,6 +369,20 @@ gimp_channel_get_memsize (GimpObject *object,
   *gui_size += channel->num_segs_in  * sizeof (GimpBoundSeg);
   *gui_size += channel->num_segs_out * sizeof (GimpBoundSeg);
 
+  if (channel->boundary_tiles)
+    {
+      gint i;
+
+      for (i = 0; i < channel->boundary_tiles->len; i++)
+        {
+          BoundaryTile *tile = &g_array_index (channel->boundary_tiles,
+                                               BoundaryTile, i);
+
+          *gui_size += sizeof (BoundaryTile) +
+                       tile->num_segs * sizeof (GimpBoundSeg);
+        }
+    }
+
   return GIMP_OBJECT_CLASS (parent_class)->get_memsize (object, gui_size);
 }
 
@@ -964,6 +999,8 @@ gimp_channel_set_buffer (GimpDrawable        *drawable,
                                             channel);
     }
 
+  gimp_channel_free_boundary_tiles (channel);
+
   GIMP_DRAWABLE_CLASS (parent_class)->set_buffer (drawable,
                                                   push_undo, undo_desc,
                                                   buffer, bounds);
@@ -1042,25 +1079,38 @@ gimp_channel_real_boundary (GimpChannel         *channel,
 
           buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (channel));
 
-          channel->segs_out = gimp_boundary_find (buffer, &rect,
-                                                  babl_format ("Y float"),
-                                                  GIMP_BOUNDARY_IGNORE_BOUNDS,
-                                                  x1, y1, x2, y2,
-                                                  GIMP_BOUNDARY_HALF_WAY,
-                                                  &channel->num_segs_out);
-          x1 = MAX (x1, x3);
-          y1 = MAX (y1, y3);
-          x2 = MIN (x2, x4);
-          y2 = MIN (y2, y4);
-
-          if (x2 > x1 && y2 > y1)
+          /*  the outside boundary is empty unless the mask extends beyond
+           *  the bounds
+           */
+          if (x3 >= x1 && y3 >= y1 && x4 <= x2 && y4 <= y2)
+            {
+              channel->segs_out     = NULL;
+              channel->num_segs_out = 0;
+            }
+          else
+            {
+              channel->segs_out = gimp_boundary_find (buffer, &rect,
+                                                      babl_format ("Y float"),
+                                                      GIMP_BOUNDARY_IGNORE_BOUNDS,
+                                                      x1, y1, x2, y2,
+                                                      GIMP_BOUNDARY_HALF_WAY,
+                                                      &channel->num_segs_out);
+            }
+
+          if (MAX (x1, x3) < MIN (x2, x4) &&
+              MAX (y1, y3) < MIN (y2, y4))
             {
-              channel->segs_in = gimp_boundary_find (buffer, NULL,
-                                                     babl_format ("Y float"),
-                                                     GIMP_BOUNDARY_WITHIN_BOUNDS,
-                                                     x1, y1, x2, y2,
-                                                     GIMP_BOUNDARY_HALF_WAY,
-                                                     &channel->num_segs_in);
+              GeglRectangle bounds;
+
+              /*  only the tiles which changed since the last time are
+               *  traced again
+               */
+              gegl_rectangle_intersect (&bounds,
+                                        GEGL_RECTANGLE (x1, y1,
+                                                        x2 - x1, y2 - y1),
+                                        gegl_buffer_get_extent (buffer));
+
+              gimp_channel_find_boundary_tiles (channel, &bounds, &rect);
             }
           else
             {
@@ -1506,9 +1556,160 @@ gimp_channel_buffer_changed (GeglBuffer          *buffer,
                              const GeglRectangle *rect,
                              GimpChannel         *channel)
 {
+  gimp_channel_invalidate_boundary_tiles (channel, rect);
+
   gimp_drawable_invalidate_boundary (GIMP_DRAWABLE (channel));
 }
 
+static void
+gimp_channel_free_boundary_tiles (GimpChannel *channel)
+{
+  if (channel->boundary_tiles)
+    {
+      gint i;
+
+      for (i = 0; i < channel->boundary_tiles->len; i++)
+        {
+          g_free (g_array_index (channel->boundary_tiles,
+                                 BoundaryTile, i).segs);
+        }
+
+      g_clear_pointer (&channel->boundary_tiles, g_array_unref);
+    }
+}
+
+static void
+gimp_channel_invalidate_boundary_tiles (GimpChannel         *channel,
+                                        const GeglRectangle *rect)
+{
+  const GeglRectangle *bounds = &channel->boundary_bounds;
+  GeglRectangle        area;
+  gint                 n_tiles_x;
+  gint                 tx1, ty1, tx2, ty2;
+  gint                 tx, ty;
+
+  if (! channel->boundary_tiles)
+    return;
+
+  /*  a pixel affects the segments above and to the left of it, which
+   *  belong to its own tile, and the ones below and to the right of it,
+   *  which may belong to the neighboring tiles
+   */
+  if (! gegl_rectangle_intersect (&area,
+                                  GEGL_RECTANGLE (rect->x,         rect->y,
+                                                  rect->width + 1, rect->height + 1),
+                                  bounds))
+    return;
+
+  n_tiles_x = (bounds->width + BOUNDARY_TILE_SIZE - 1) / BOUNDARY_TILE_SIZE;
+
+  tx1 = (area.x - bounds->x) / BOUNDARY_TILE_SIZE;
+  ty1 = (area.y - bounds->y) / BOUNDARY_TILE_SIZE;
+  tx2 = (area.x + area.width  - 1 - bounds->x) / BOUNDARY_TILE_SIZE;
+  ty2 = (area.y + area.height - 1 - bounds->y) / BOUNDARY_TILE_SIZE;
+
+  for (ty = ty1; ty <= ty2; ty++)
+    for (tx = tx1; tx <= tx2; tx++)
+      {
+        g_array_index (channel->boundary_tiles,
+                       BoundaryTile, ty * n_tiles_x + tx).valid = FALSE;
+      }
+}
+
+static void
+gimp_channel_find_boundary_tiles (GimpChannel         *channel,
+                                  const GeglRectangle *bounds,
+                                  const GeglRectangle *mask_bounds)
+{
+  GeglBuffer   *buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (channel));
+  GimpBoundSeg *segs;
+  gint          n_tiles_x;
+  gint          n_tiles_y;
+  gint          num_segs = 0;
+  gint          tx, ty;
+  gint          i;
+
+  n_tiles_x = (bounds->width  + BOUNDARY_TILE_SIZE - 1) / BOUNDARY_TILE_SIZE;
+  n_tiles_y = (bounds->height + BOUNDARY_TILE_SIZE - 1) / BOUNDARY_TILE_SIZE;
+
+  if (channel->boundary_tiles &&
+      ! gegl_rectangle_equal (bounds, &channel->boundary_bounds))
+    {
+      gimp_channel_free_boundary_tiles (channel);
+    }
+
+  if (! channel->boundary_tiles)
+    {
+      channel->boundary_tiles = g_array_sized_new (FALSE, TRUE,
+                                                   sizeof (BoundaryTile),
+                                                   n_tiles_x * n_tiles_y);
+      g_array_set_size (channel->boundary_tiles, n_tiles_x * n_tiles_y);
+
+      channel->boundary_bounds = *bounds;
+    }
+
+  for (ty = 0; ty < n_tiles_y; ty++)
+    for (tx = 0; tx < n_tiles_x; tx++)
+      {
+        BoundaryTile *tile = &g_array_index (channel->boundary_tiles,
+                                             BoundaryTile,
+                                             ty * n_tiles_x + tx);
+
+        if (! tile->valid)
+          {
+            GeglRectangle area;
+
+            gegl_rectangle_set (&area,
+                                bounds->x + tx * BOUNDARY_TILE_SIZE,
+                                bounds->y + ty * BOUNDARY_TILE_SIZE,
+                                BOUNDARY_TILE_SIZE,
+                                BOUNDARY_TILE_SIZE);
+
+            g_clear_pointer (&tile->segs, g_free);
+            tile->num_segs = 0;
+
+            /*  the segments of a tile lie between its pixels and the
+             *  ones above and to the left of it; skip the tiles where
+             *  these are all unselected
+             */
+            if (gegl_rectangle_intersect (NULL,
+                                          GEGL_RECTANGLE (area.x - 1,
+                                                          area.y - 1,
+                                                          area.width  + 1,
+                                                          area.height + 1),
+                                          mask_bounds))
+              {
+                tile->segs = gimp_boundary_find_area (buffer,
+                                                      babl_format ("Y float"),
+                                                      bounds, &area,
+                                                      GIMP_BOUNDARY_HALF_WAY,
+                                                      &tile->num_segs);
+              }
+
+            tile->valid = TRUE;
+          }
+
+        num_segs += tile->num_segs;
+      }
+
+  segs = num_segs ? g_new (GimpBoundSeg, num_segs) : NULL;
+
+  channel->segs_in     = segs;
+  channel->num_segs_in = num_segs;
+
+  for (i = 0; i < channel->boundary_tiles->len; i++)
+    {
+      BoundaryTile *tile = &g_array_index (channel->boundary_tiles,
+                                           BoundaryTile, i);
+
+      if (tile->num_segs)
+        {
+          memcpy (segs, tile->segs, tile->num_segs * sizeof (GimpBoundSeg));
+          segs += tile->num_segs;
+        }
+    }
+}
+
 
 /*  public functions  */
 
@@ -49,6 +49,8 @@ struct _GimpChannel
   GimpBoundSeg *segs_out;          /*  outline of selected region     */
   gint          num_segs_in;       /*  number of lines in boundary    */
   gint          num_segs_out;      /*  number of lines in boundary    */
+  GArray       *boundary_tiles;    /*  segs_in, per tile              */
+  GeglRectangle boundary_bounds;   /*  area covered by boundary_tiles */
   gboolean      empty;             /*  is the region empty?           */
   gboolean      bounds_known;      /*  recalculate the bounds?        */
   gint          x1, y1;            /*  coordinates for bounding box   */
@@ -76,6 +76,8 @@ struct _GimpChunkIterator
   gint64          last_time;
   gint            last_area;
 
+  gint            n_rects;
+
   gdouble         target_area;
   gdouble         target_area_min;
   gdouble         target_area_history[TARGET_AREA_HISTORY_SIZE];
@@ -103,6 +105,11 @@ static void       gimp_chunk_iterator_calc_rect          (GimpChunkIterator   *i
                                                           GeglRectangle       *rect,
                                                           gboolean             readjust_height);
 
+static gboolean   gimp_chunk_iterator_update_target_area (GimpChunkIterator   *iter,
+                                                          gint64               time);
+static void       gimp_chunk_iterator_next_rect          (GimpChunkIterator   *iter,
+                                                          GeglRectangle       *rect);
+
 
 /*  private functions  */
 
@@ -269,8 +276,11 @@ gimp_chunk_iterator_set_target_area (GimpChunkIterator *iter,
 static gdouble
 gimp_chunk_iterator_get_target_area (GimpChunkIterator *iter)
 {
+  /*  the target area is the area processed per interval, which is split
+   *  between the rects handed out by a single call
+   */
   if (iter->target_area)
-    return iter->target_area;
+    return iter->target_area / iter->n_rects;
   else
     return iter->tile_rect.width * iter->tile_rect.height;
 }
@@ -346,6 +356,80 @@ gimp_chunk_iterator_calc_rect (GimpChunkIterator *iter,
   rect->width = MIN (rect->width, MAX_CHUNK_WIDTH);
 }
 
+static gboolean
+gimp_chunk_iterator_update_target_area (GimpChunkIterator *iter,
+                                        gint64             time)
+{
+  if (iter->last_area >= MIN_AREA_PER_ITERATION)
+    {
+      gdouble interval;
+
+      interval = (gdouble) (time - iter->last_time) / G_TIME_SPAN_SECOND;
+
+      gimp_chunk_iterator_set_target_area (
+        iter,
+        iter->last_area * iter->interval / interval);
+
+      interval = (gdouble) (time - iter->iteration_time) / G_TIME_SPAN_SECOND;
+
+      if (interval > iter->interval)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gimp_chunk_iterator_next_rect (GimpChunkIterator *iter,
+                               GeglRectangle     *rect)
+{
+  if (iter->current_x == iter->current_rect.x)
+    {
+      gimp_chunk_iterator_calc_rect (iter, rect, TRUE);
+    }
+  else
+    {
+      gimp_chunk_iterator_calc_rect (iter, rect, FALSE);
+
+      if (rect->width * rect->height >=
+          MAX_AREA_RATIO * gimp_chunk_iterator_get_target_area (iter))
+        {
+          GeglRectangle old_rect = *rect;
+
+          gimp_chunk_iterator_calc_rect (iter, rect, TRUE);
+
+          if (rect->height >= old_rect.height)
+            *rect = old_rect;
+        }
+    }
+
+  if (rect->height != iter->current_height)
+    {
+      /* if the chunk height changed in the middle of a row, merge the
+       * remaining area back into the current region, and reset the current
+       * area to the remainder of the row, using the new chunk height
+       */
+      if (rect->x != iter->current_rect.x)
+        {
+          GeglRectangle rem;
+
+          rem.x      = rect->x;
+          rem.y      = rect->y;
+          rem.width  = iter->current_rect.x + iter->current_rect.width -
+                       rect->x;
+          rem.height = rect->height;
+
+          gimp_chunk_iterator_merge_current_rect (iter);
+
+          gimp_chunk_iterator_set_current_rect (iter, &rem);
+        }
+
+      iter->current_height = rect->height;
+    }
+
+  iter->current_x += rect->width;
+}
+
 
 /*  public functions  */
 
@@ -367,6 +451,7 @@ gimp_chunk_iterator_new (cairo_region_t *region)
                 NULL);
 
   iter->interval = DEFAULT_INTERVAL;
+  iter->n_rects  = 1;
 
   return iter;
 }
@@ -460,72 +545,61 @@ gimp_chunk_iterator_get_rect (GimpChunkIterator *iter,
 
   time = g_get_monotonic_time ();
 
-  if (iter->last_area >= MIN_AREA_PER_ITERATION)
-    {
-      gdouble interval;
+  if (! gimp_chunk_iterator_update_target_area (iter, time))
+    return FALSE;
 
-      interval = (gdouble) (time - iter->last_time) / G_TIME_SPAN_SECOND;
+  iter->n_rects = 1;
 
-      gimp_chunk_iterator_set_target_area (
-        iter,
-        iter->last_area * iter->interval / interval);
+  gimp_chunk_iterator_next_rect (iter, rect);
 
-      interval = (gdouble) (time - iter->iteration_time) / G_TIME_SPAN_SECOND;
+  iter->last_time = time;
+  iter->last_area = rect->width * rect->height;
 
-      if (interval > iter->interval)
-        return FALSE;
-    }
+  return TRUE;
+}
 
-  if (iter->current_x == iter->current_rect.x)
-    {
-      gimp_chunk_iterator_calc_rect (iter, rect, TRUE);
-    }
-  else
-    {
-      gimp_chunk_iterator_calc_rect (iter, rect, FALSE);
+gint
+gimp_chunk_iterator_get_rects (GimpChunkIterator *iter,
+                               GeglRectangle     *rects,
+                               gint               max_rects)
+{
+  gint64 time;
+  gint64 area;
+  gint   n_rects;
 
-      if (rect->width * rect->height >=
-          MAX_AREA_RATIO * gimp_chunk_iterator_get_target_area (iter))
-        {
-          GeglRectangle old_rect = *rect;
+  g_return_val_if_fail (iter != NULL, 0);
+  g_return_val_if_fail (rects != NULL, 0);
+  g_return_val_if_fail (max_rects > 0, 0);
 
-          gimp_chunk_iterator_calc_rect (iter, rect, TRUE);
+  if (! gimp_chunk_iterator_prepare (iter))
+    return 0;
 
-          if (rect->height >= old_rect.height)
-            *rect = old_rect;
-        }
-    }
+  time = g_get_monotonic_time ();
 
-  if (rect->height != iter->current_height)
-    {
-      /* if the chunk height changed in the middle of a row, merge the
-       * remaining area back into the current region, and reset the current
-       * area to the remainder of the row, using the new chunk height
-       */
-      if (rect->x != iter->current_rect.x)
-        {
-          GeglRectangle rem;
+  if (! gimp_chunk_iterator_update_target_area (iter, time))
+    return 0;
 
-          rem.x      = rect->x;
-          rem.y      = rect->y;
-          rem.width  = iter->current_rect.x + iter->current_rect.width -
-                       rect->x;
-          rem.height = rect->height;
+  iter->n_rects = max_rects;
 
-          gimp_chunk_iterator_merge_current_rect (iter);
+  area = 0;
 
-          gimp_chunk_iterator_set_current_rect (iter, &rem);
-        }
+  for (n_rects = 0;
+       n_rects < max_rects && gimp_chunk_iterator_prepare (iter);
+       n_rects++)
+    {
+      gimp_chunk_iterator_next_rect (iter, &rects[n_rects]);
 
-      iter->current_height = rect->height;
+      area += rects[n_rects].width * rects[n_rects].height;
     }
 
-  iter->current_x += rect->width;
-
+  /* the time until the next call corresponds to the processing of all the
+   * rects, so the target area is in terms of their total area, and each
+   * rect gets an equal share of it.
+   */
   iter->last_time = time;
-  iter->last_area = rect->width * rect->height;
+  iter->last_area = MIN (area, G_MAXINT);
 
-  return TRUE;
+  return n_rects;
 }
 
 cairo_region_t *
@@ -36,6 +36,9 @@ void                gimp_chunk_iterator_set_interval      (GimpChunkIterator   *
 gboolean            gimp_chunk_iterator_next              (GimpChunkIterator   *iter);
 gboolean            gimp_chunk_iterator_get_rect          (GimpChunkIterator   *iter,
                                                            GeglRectangle       *rect);
+gint                gimp_chunk_iterator_get_rects         (GimpChunkIterator   *iter,
+                                                           GeglRectangle       *rects,
+                                                           gint                 max_rects);
 
 cairo_region_t    * gimp_chunk_iterator_stop              (GimpChunkIterator   *iter,
                                                            gboolean             free_region);
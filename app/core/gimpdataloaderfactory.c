@@ -43,8 +43,19 @@
  */
 #define GIMP_OBSOLETE_DATA_DIR_NAME "gimp-obsolete-files"
 
+/* The data index, which keeps the data of unchanged files in a form
+ * that is quick to restore, in the cache directory
+ */
+#define GIMP_DATA_INDEX_MAGIC          0x47444958  /*  "GDIX"  */
+#define GIMP_DATA_INDEX_VERSION        2
+
+/* room for the escaped URI of a path of PATH_MAX bytes */
+#define GIMP_DATA_INDEX_MAX_URI_LENGTH 16384
+
 
-typedef struct _GimpDataLoader GimpDataLoader;
+typedef struct _GimpDataLoader     GimpDataLoader;
+typedef struct _GimpDataLoaderJob  GimpDataLoaderJob;
+typedef struct _GimpDataIndexEntry GimpDataIndexEntry;
 
 struct _GimpDataLoader
 {
@@ -54,11 +65,48 @@ struct _GimpDataLoader
   gboolean          writable;
 };
 
+struct _GimpDataLoaderJob
+{
+  GimpDataLoader *loader;
+  GFile          *file;
+  GFile          *top_directory;
+  gboolean        dir_writable;
+  guint64         mtime;
+  guint32         mtime_usec;
+  guint64         size;
+  gboolean        cached;
+  gboolean        use_index;
+  GBytes         *index;
+  gboolean        index_new;
+  GList          *data_list;
+  GError         *error;
+};
+
+struct _GimpDataIndexEntry
+{
+  guint64  mtime;
+  guint32  mtime_usec;
+  guint64  size;
+  GBytes  *index;
+};
+
+typedef struct
+{
+  GimpDataFactory *factory;
+  GimpContext     *context;
+  GPtrArray       *jobs;
+} LoadData;
+
 
 struct _GimpDataLoaderFactoryPrivate
 {
-  GList          *loaders;
-  GimpDataLoader *fallback;
+  GList                  *loaders;
+  GimpDataLoader         *fallback;
+  gboolean                parallel;
+
+  gchar                  *index_name;
+  GimpDataIndexReadFunc   index_read_func;
+  GimpDataIndexWriteFunc  index_write_func;
 };
 
 #define GET_PRIVATE(obj) (((GimpDataLoaderFactory *) (obj))->priv)
@@ -79,18 +127,42 @@ static void   gimp_data_loader_factory_load           (GimpDataFactory *factory,
                                                        GimpContext     *context,
                                                        GHashTable      *cache);
 static void   gimp_data_loader_factory_load_directory (GimpDataFactory *factory,
-                                                       GimpContext     *context,
                                                        GHashTable      *cache,
+                                                       GHashTable      *index,
+                                                       GPtrArray       *jobs,
                                                        gboolean         dir_writable,
                                                        GFile           *directory,
                                                        GFile           *top_directory);
-static void   gimp_data_loader_factory_load_data      (GimpDataFactory *factory,
-                                                       GimpContext     *context,
+static void   gimp_data_loader_factory_add_job        (GimpDataFactory *factory,
                                                        GHashTable      *cache,
+                                                       GHashTable      *index,
+                                                       GPtrArray       *jobs,
                                                        gboolean         dir_writable,
                                                        GFile           *file,
                                                        GFileInfo       *info,
                                                        GFile           *top_directory);
+static void   gimp_data_loader_factory_load_data      (GimpDataFactory *factory,
+                                                       GimpContext     *context,
+                                                       GimpDataLoaderJob *job);
+static void   gimp_data_loader_factory_load_range     (gint             offset,
+                                                       gint             size,
+                                                       LoadData        *data);
+static void   gimp_data_loader_factory_add_data       (GimpDataFactory *factory,
+                                                       GimpDataLoaderJob *job);
+
+static GFile      * gimp_data_loader_factory_get_index_file
+                                                         (GimpDataFactory *factory);
+static GHashTable * gimp_data_loader_factory_read_index  (GimpDataFactory *factory);
+static void         gimp_data_loader_factory_write_index (GimpDataFactory *factory,
+                                                          GPtrArray       *jobs);
+static GList      * gimp_data_loader_factory_index_to_data
+                                                         (GimpDataFactory *factory,
+                                                          GBytes          *index,
+                                                          GError         **error);
+static GBytes     * gimp_data_loader_factory_data_to_index
+                                                         (GimpDataFactory *factory,
+                                                          GList           *data_list,
+                                                          GError         **error);
 
 static GimpDataLoader * gimp_data_loader_new          (const gchar     *name,
                                                        GimpDataLoadFunc load_func,
@@ -98,6 +170,9 @@ static GimpDataLoader * gimp_data_loader_new          (const gchar     *name,
                                                        gboolean         writable);
 static void            gimp_data_loader_free          (GimpDataLoader  *loader);
 
+static void            gimp_data_loader_job_free      (GimpDataLoaderJob *job);
+static void            gimp_data_index_entry_free     (GimpDataIndexEntry *entry);
+
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpDataLoaderFactory, gimp_data_loader_factory,
                             GIMP_TYPE_DATA_FACTORY)
@@ -133,6 +208,8 @@ gimp_data_loader_factory_finalize (GObject *object)
 
   g_clear_pointer (&priv->fallback, gimp_data_loader_free);
 
+  g_clear_pointer (&priv->index_name, g_free);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -289,6 +366,172 @@ gimp_data_loader_factory_add_fallback (GimpDataFactory  *factory,
   priv->fallback = gimp_data_loader_new (name, load_func, NULL, FALSE);
 }
 
+/**
+ * gimp_data_loader_factory_set_parallel:
+ * @factory:  a #GimpDataLoaderFactory
+ * @parallel: whether to load files in parallel
+ *
+ * Sets whether @factory's files are loaded by several threads at
+ * once.  This requires all of @factory's load functions to be
+ * thread-safe, and not to use the context they are passed.  The
+ * loaded data is added to @factory's container in the same order
+ * either way.
+ **/
+void
+gimp_data_loader_factory_set_parallel (GimpDataFactory *factory,
+                                       gboolean         parallel)
+{
+  g_return_if_fail (GIMP_IS_DATA_LOADER_FACTORY (factory));
+
+  GET_PRIVATE (factory)->parallel = parallel ? TRUE : FALSE;
+}
+
+/**
+ * gimp_data_loader_factory_set_index:
+ * @factory:    a #GimpDataLoaderFactory
+ * @index_name: the name of the index file, in the cache directory
+ * @read_func:  restores a data object from the index
+ * @write_func: writes a data object to the index
+ *
+ * Makes @factory keep an index of the data it loaded.  On the next
+ * start, the data of files which didn't change is restored from the
+ * index using @read_func instead of being loaded from the files,
+ * which allows @read_func to create data objects that load their
+ * contents on first use only.
+ *
+ * @read_func and @write_func are called from worker threads if
+ * @factory loads files in parallel.
+ **/
+void
+gimp_data_loader_factory_set_index (GimpDataFactory        *factory,
+                                    const gchar            *index_name,
+                                    GimpDataIndexReadFunc   read_func,
+                                    GimpDataIndexWriteFunc  write_func)
+{
+  GimpDataLoaderFactoryPrivate *priv;
+
+  g_return_if_fail (GIMP_IS_DATA_LOADER_FACTORY (factory));
+  g_return_if_fail (index_name != NULL);
+  g_return_if_fail (read_func != NULL);
+  g_return_if_fail (write_func != NULL);
+
+  priv = GET_PRIVATE (factory);
+
+  g_free (priv->index_name);
+
+  priv->index_name       = g_strdup (index_name);
+  priv->index_read_func  = read_func;
+  priv->index_write_func = write_func;
+}
+
+/*  helpers for the index read and write functions; strings are
+ *  stored with their length, and all reads fail with an error on
+ *  truncated or unreasonable entries
+ */
+
+gboolean
+gimp_data_index_read_uint32 (GDataInputStream  *input,
+                             guint32           *value,
+                             GError           **error)
+{
+  GError *my_error = NULL;
+
+  g_return_val_if_fail (G_IS_DATA_INPUT_STREAM (input), FALSE);
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  *value = g_data_input_stream_read_uint32 (input, NULL, &my_error);
+
+  if (my_error)
+    {
+      g_propagate_error (error, my_error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+gboolean
+gimp_data_index_read (GDataInputStream  *input,
+                      gpointer           buffer,
+                      gsize              size,
+                      GError           **error)
+{
+  gsize   bytes_read;
+  GError *my_error = NULL;
+
+  g_return_val_if_fail (G_IS_DATA_INPUT_STREAM (input), FALSE);
+  g_return_val_if_fail (buffer != NULL || size == 0, FALSE);
+
+  if (! g_input_stream_read_all (G_INPUT_STREAM (input), buffer, size,
+                                 &bytes_read, NULL, &my_error) ||
+      bytes_read != size)
+    {
+      if (my_error)
+        g_propagate_error (error, my_error);
+      else
+        g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                     _("Invalid data index entry."));
+
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+gchar *
+gimp_data_index_read_string (GDataInputStream  *input,
+                             GError           **error)
+{
+  gchar   *string;
+  guint32  length;
+
+  g_return_val_if_fail (G_IS_DATA_INPUT_STREAM (input), NULL);
+
+  if (! gimp_data_index_read_uint32 (input, &length, error))
+    return NULL;
+
+  if (length > GIMP_DATA_INDEX_MAX_STRING_LENGTH)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   _("Invalid data index entry."));
+      return NULL;
+    }
+
+  string = g_new (gchar, length + 1);
+
+  if (! gimp_data_index_read (input, string, length, error))
+    {
+      g_free (string);
+      return NULL;
+    }
+
+  string[length] = '\0';
+
+  return string;
+}
+
+gboolean
+gimp_data_index_write_string (GDataOutputStream  *output,
+                              const gchar        *string,
+                              GError            **error)
+{
+  g_return_val_if_fail (G_IS_DATA_OUTPUT_STREAM (output), FALSE);
+
+  if (! string)
+    string = "";
+
+  if (strlen (string) > GIMP_DATA_INDEX_MAX_STRING_LENGTH)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_WRITE,
+                   _("String too long for the data index."));
+      return FALSE;
+    }
+
+  return (g_data_output_stream_put_uint32 (output, strlen (string),
+                                           NULL, error) &&
+          g_data_output_stream_put_string (output, string, NULL, error));
+}
+
 
 /*  private functions  */
 
@@ -315,15 +558,30 @@ gimp_data_loader_factory_load (GimpDataFactory *factory,
                                GimpContext     *context,
                                GHashTable      *cache)
 {
-  const GList *ext_path;
-  GList       *path;
-  GList       *writable_path;
-  GList       *list;
+  GimpDataLoaderFactoryPrivate *priv = GET_PRIVATE (factory);
+  const GList                  *ext_path;
+  GList                        *path;
+  GList                        *writable_path;
+  GList                        *list;
+  GPtrArray                    *jobs;
+  GHashTable                   *index     = NULL;
+  gboolean                      use_index = FALSE;
+  gint                          i;
 
   path          = gimp_data_factory_get_data_path          (factory);
   writable_path = gimp_data_factory_get_data_path_writable (factory);
   ext_path      = gimp_data_factory_get_data_path_ext      (factory);
 
+  jobs = g_ptr_array_new_with_free_func (
+    (GDestroyNotify) gimp_data_loader_job_free);
+
+  /*  the index is only used, and rewritten, on the initial load  */
+  if (priv->index_name && ! cache)
+    {
+      use_index = TRUE;
+      index     = gimp_data_loader_factory_read_index (factory);
+    }
+
   for (list = (GList *) ext_path; list; list = g_list_next (list))
     {
       /* Adding data from extensions.
@@ -331,7 +589,8 @@ gimp_data_loader_factory_load (GimpDataFactory *factory,
        * writable, since writability of extension is only taken into
        * account for extension update).
        */
-      gimp_data_loader_factory_load_directory (factory, context, cache,
+      gimp_data_loader_factory_load_directory (factory, cache, index,
+                                               jobs,
                                                FALSE,
                                                list->data,
                                                list->data);
@@ -345,7 +604,8 @@ gimp_data_loader_factory_load (GimpDataFactory *factory,
                               (GCompareFunc) gimp_file_compare))
         dir_writable = TRUE;
 
-      gimp_data_loader_factory_load_directory (factory, context, cache,
+      gimp_data_loader_factory_load_directory (factory, cache, index,
+                                               jobs,
                                                dir_writable,
                                                list->data,
                                                list->data);
@@ -353,12 +613,77 @@ gimp_data_loader_factory_load (GimpDataFactory *factory,
 
   g_list_free_full (path,          (GDestroyNotify) g_object_unref);
   g_list_free_full (writable_path, (GDestroyNotify) g_object_unref);
+
+  /*  parse the files, possibly in parallel, then add their data to
+   *  the containers in the order the files were found, so the result
+   *  doesn't depend on which thread finished first
+   */
+  if (priv->parallel && jobs->len > 1)
+    {
+      LoadData data;
+
+      data.factory = factory;
+      data.context = context;
+      data.jobs    = jobs;
+
+      gegl_parallel_distribute_range (
+        jobs->len, 1,
+        (GeglParallelDistributeRangeFunc) gimp_data_loader_factory_load_range,
+        &data);
+    }
+  else
+    {
+      for (i = 0; i < jobs->len; i++)
+        {
+          gimp_data_loader_factory_load_data (factory, context,
+                                              g_ptr_array_index (jobs, i));
+        }
+    }
+
+  for (i = 0; i < jobs->len; i++)
+    gimp_data_loader_factory_add_data (factory, g_ptr_array_index (jobs, i));
+
+  if (use_index)
+    {
+      gboolean changed   = FALSE;
+      gint     n_indexed = 0;
+
+      for (i = 0; i < jobs->len; i++)
+        {
+          GimpDataLoaderJob *job = g_ptr_array_index (jobs, i);
+
+          if (job->index)
+            {
+              n_indexed++;
+
+              if (job->index_new)
+                changed = TRUE;
+            }
+        }
+
+      /*  rewrite the index if files were added, changed or removed  */
+      if (changed || ! index || n_indexed != g_hash_table_size (index))
+        gimp_data_loader_factory_write_index (factory, jobs);
+    }
+
+  g_clear_pointer (&index, g_hash_table_unref);
+
+  g_ptr_array_unref (jobs);
+}
+
+static gint
+gimp_data_loader_factory_compare_infos (GFileInfo *info1,
+                                        GFileInfo *info2)
+{
+  return strcmp (g_file_info_get_name (info1),
+                 g_file_info_get_name (info2));
 }
 
 static void
 gimp_data_loader_factory_load_directory (GimpDataFactory *factory,
-                                         GimpContext     *context,
                                          GHashTable      *cache,
+                                         GHashTable      *index,
+                                         GPtrArray       *jobs,
                                          gboolean         dir_writable,
                                          GFile           *directory,
                                          GFile           *top_directory)
@@ -369,81 +694,118 @@ gimp_data_loader_factory_load_directory (GimpDataFactory *factory,
                                           G_FILE_ATTRIBUTE_STANDARD_NAME ","
                                           G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN ","
                                           G_FILE_ATTRIBUTE_STANDARD_TYPE ","
-                                          G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                          G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
                                           G_FILE_QUERY_INFO_NONE,
                                           NULL, NULL);
 
   if (enumerator)
     {
       GFileInfo *info;
+      GList     *infos = NULL;
+      GList     *list;
 
       while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL)))
         {
-          GFileType  file_type;
-          GFile     *child;
-
           if (g_file_info_get_is_hidden (info))
             {
               g_object_unref (info);
               continue;
             }
 
+          infos = g_list_prepend (infos, info);
+        }
+
+      /*  the order of the enumeration depends on the file system  */
+      infos = g_list_sort (infos,
+                           (GCompareFunc) gimp_data_loader_factory_compare_infos);
+
+      for (list = infos; list; list = g_list_next (list))
+        {
+          GFileType  file_type;
+          GFile     *child;
+
+          info = list->data;
+
           file_type = g_file_info_get_file_type (info);
           child     = g_file_enumerator_get_child (enumerator, info);
 
           if (file_type == G_FILE_TYPE_DIRECTORY)
             {
-              gimp_data_loader_factory_load_directory (factory, context, cache,
+              gimp_data_loader_factory_load_directory (factory, cache, index,
+                                                       jobs,
                                                        dir_writable,
                                                        child,
                                                        top_directory);
             }
           else if (file_type == G_FILE_TYPE_REGULAR)
             {
-              gimp_data_loader_factory_load_data (factory, context, cache,
-                                                  dir_writable,
-                                                  child, info,
-                                                  top_directory);
+              gimp_data_loader_factory_add_job (factory, cache, index,
+                                                jobs,
+                                                dir_writable,
+                                                child, info,
+                                                top_directory);
             }
 
           g_object_unref (child);
-          g_object_unref (info);
         }
 
+      g_list_free_full (infos, (GDestroyNotify) g_object_unref);
+
       g_object_unref (enumerator);
     }
 }
 
 static void
-gimp_data_loader_factory_load_data (GimpDataFactory *factory,
-                                    GimpContext     *context,
-                                    GHashTable      *cache,
-                                    gboolean         dir_writable,
-                                    GFile           *file,
-                                    GFileInfo       *info,
-                                    GFile           *top_directory)
+gimp_data_loader_factory_add_job (GimpDataFactory *factory,
+                                  GHashTable      *cache,
+                                  GHashTable      *index,
+                                  GPtrArray       *jobs,
+                                  gboolean         dir_writable,
+                                  GFile           *file,
+                                  GFileInfo       *info,
+                                  GFile           *top_directory)
 {
-  GimpDataLoader *loader;
-  GimpContainer  *container;
-  GimpContainer  *container_obsolete;
-  GList          *data_list = NULL;
-  GInputStream   *input;
-  guint64         mtime;
-  GError         *error = NULL;
+  GimpDataLoader    *loader;
+  GimpDataLoaderJob *job;
 
   loader = gimp_data_loader_factory_get_loader (factory, file);
 
   if (! loader)
     return;
 
-  container          = gimp_data_factory_get_container          (factory);
-  container_obsolete = gimp_data_factory_get_container_obsolete (factory);
-
   if (gimp_data_factory_get_gimp (factory)->be_verbose)
     g_print ("  Loading %s\n", gimp_file_get_utf8_name (file));
 
-  mtime = g_file_info_get_attribute_uint64 (info,
-                                            G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  job = g_slice_new0 (GimpDataLoaderJob);
+
+  job->loader        = loader;
+  job->file          = g_object_ref (file);
+  job->top_directory = g_object_ref (top_directory);
+  job->dir_writable  = dir_writable;
+  job->mtime         = g_file_info_get_attribute_uint64 (info,
+                                                         G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  job->mtime_usec    = g_file_info_get_attribute_uint32 (info,
+                                                         G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+  job->size          = g_file_info_get_size (info);
+  job->use_index     = GET_PRIVATE (factory)->index_name && ! cache;
+
+  if (index)
+    {
+      gchar              *uri   = g_file_get_uri (file);
+      GimpDataIndexEntry *entry = g_hash_table_lookup (index, uri);
+
+      if (entry                                &&
+          entry->mtime      == job->mtime      &&
+          entry->mtime_usec == job->mtime_usec &&
+          entry->size       == job->size)
+        {
+          job->index = g_bytes_ref (entry->index);
+        }
+
+      g_free (uri);
+    }
 
   if (cache)
     {
@@ -451,36 +813,62 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
 
       if (cached_data &&
           gimp_data_get_mtime (cached_data->data) != 0 &&
-          gimp_data_get_mtime (cached_data->data) == mtime)
+          gimp_data_get_mtime (cached_data->data) == job->mtime)
         {
-          GList *list;
+          job->cached    = TRUE;
+          job->data_list = g_list_copy (cached_data);
+        }
+    }
 
-          for (list = cached_data; list; list = g_list_next (list))
-            gimp_container_add (container, list->data);
+  g_ptr_array_add (jobs, job);
+}
 
-          return;
-        }
+/*  called from worker threads when loading in parallel; must only
+ *  read the factory's loaders, and not touch its containers
+ */
+static void
+gimp_data_loader_factory_load_data (GimpDataFactory   *factory,
+                                    GimpContext       *context,
+                                    GimpDataLoaderJob *job)
+{
+  GInputStream *input;
+
+  if (job->cached)
+    return;
+
+  if (job->index)
+    {
+      job->data_list = gimp_data_loader_factory_index_to_data (factory,
+                                                               job->index,
+                                                               NULL);
+
+      if (job->data_list)
+        return;
+
+      /*  a broken entry, load the file instead  */
+      g_clear_pointer (&job->index, g_bytes_unref);
     }
 
-  input = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+  input = G_INPUT_STREAM (g_file_read (job->file, NULL, &job->error));
 
   if (input)
     {
       GInputStream *buffered = g_buffered_input_stream_new (input);
 
-      data_list = loader->load_func (context, file, buffered, &error);
+      job->data_list = job->loader->load_func (context, job->file, buffered,
+                                               &job->error);
 
-      if (error)
+      if (job->error)
         {
-          g_prefix_error (&error,
+          g_prefix_error (&job->error,
                           _("Error loading '%s': "),
-                          gimp_file_get_utf8_name (file));
+                          gimp_file_get_utf8_name (job->file));
         }
-      else if (! data_list)
+      else if (! job->data_list)
         {
-          g_set_error (&error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+          g_set_error (&job->error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
                        _("Error loading '%s'"),
-                       gimp_file_get_utf8_name (file));
+                       gimp_file_get_utf8_name (job->file));
         }
 
       g_object_unref (buffered);
@@ -488,12 +876,55 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
     }
   else
     {
-      g_prefix_error (&error,
+      g_prefix_error (&job->error,
                       _("Could not open '%s' for reading: "),
-                      gimp_file_get_utf8_name (file));
+                      gimp_file_get_utf8_name (job->file));
+    }
+
+  if (job->use_index && job->data_list && ! job->error)
+    {
+      job->index     = gimp_data_loader_factory_data_to_index (factory,
+                                                              job->data_list,
+                                                              NULL);
+      job->index_new = TRUE;
     }
+}
+
+static void
+gimp_data_loader_factory_load_range (gint      offset,
+                                     gint      size,
+                                     LoadData *data)
+{
+  gint i;
 
-  if (G_LIKELY (data_list))
+  for (i = offset; i < offset + size; i++)
+    {
+      gimp_data_loader_factory_load_data (data->factory, data->context,
+                                          g_ptr_array_index (data->jobs, i));
+    }
+}
+
+static void
+gimp_data_loader_factory_add_data (GimpDataFactory   *factory,
+                                   GimpDataLoaderJob *job)
+{
+  GimpContainer *container;
+  GimpContainer *container_obsolete;
+
+  container          = gimp_data_factory_get_container          (factory);
+  container_obsolete = gimp_data_factory_get_container_obsolete (factory);
+
+  if (job->cached)
+    {
+      GList *list;
+
+      for (list = job->data_list; list; list = g_list_next (list))
+        gimp_container_add (container, list->data);
+
+      return;
+    }
+
+  if (G_LIKELY (job->data_list))
     {
       GList    *list;
       gchar    *uri;
@@ -501,7 +932,7 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
       gboolean  writable  = FALSE;
       gboolean  deletable = FALSE;
 
-      uri = g_file_get_uri (file);
+      uri = g_file_get_uri (job->file);
 
       obsolete = (strstr (uri, GIMP_OBSOLETE_DATA_DIR_NAME) != 0);
 
@@ -510,16 +941,17 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
       /* obsolete files are immutable, don't check their writability */
       if (! obsolete)
         {
-          deletable = (g_list_length (data_list) == 1 && dir_writable);
-          writable  = (deletable && loader->writable);
+          deletable = (g_list_length (job->data_list) == 1 &&
+                       job->dir_writable);
+          writable  = (deletable && job->loader->writable);
         }
 
-      for (list = data_list; list; list = g_list_next (list))
+      for (list = job->data_list; list; list = g_list_next (list))
         {
           GimpData *data = list->data;
 
-          gimp_data_set_file (data, file, writable, deletable);
-          gimp_data_set_mtime (data, mtime);
+          gimp_data_set_file (data, job->file, writable, deletable);
+          gimp_data_set_mtime (data, job->mtime);
           gimp_data_clean (data);
 
           if (obsolete)
@@ -529,7 +961,7 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
             }
           else
             {
-              gimp_data_set_folder_tags (data, top_directory);
+              gimp_data_set_folder_tags (data, job->top_directory);
 
               gimp_container_add (container,
                                   GIMP_OBJECT (data));
@@ -538,20 +970,388 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
           g_object_unref (data);
         }
 
-      g_list_free (data_list);
+      g_clear_pointer (&job->data_list, g_list_free);
     }
 
   /*  not else { ... } because loader->load_func() can return a list
    *  of data objects *and* an error message if loading failed after
    *  something was already loaded
    */
-  if (G_UNLIKELY (error))
+  if (G_UNLIKELY (job->error))
     {
       gimp_message (gimp_data_factory_get_gimp (factory), NULL,
                     GIMP_MESSAGE_ERROR,
-                    _("Failed to load data:\n\n%s"), error->message);
+                    _("Failed to load data:\n\n%s"), job->error->message);
+      g_clear_error (&job->error);
+    }
+}
+
+static GFile *
+gimp_data_loader_factory_get_index_file (GimpDataFactory *factory)
+{
+  return g_file_new_build_filename (gimp_cache_directory (),
+                                    GET_PRIVATE (factory)->index_name,
+                                    NULL);
+}
+
+static GHashTable *
+gimp_data_loader_factory_read_index (GimpDataFactory *factory)
+{
+  GHashTable       *index;
+  GFile            *file;
+  GFileInputStream *input;
+  GFileInfo        *info;
+  GDataInputStream *data_input;
+  GError           *error = NULL;
+  guint64           remaining;
+  guint32           magic;
+  guint32           version;
+  guint32           n_entries;
+  guint32           i;
+
+  file  = gimp_data_loader_factory_get_index_file (factory);
+  input = g_file_read (file, NULL, NULL);
+
+  g_object_unref (file);
+
+  if (! input)
+    return NULL;
+
+  info = g_file_input_stream_query_info (input,
+                                         G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                         NULL, NULL);
+
+  if (! info)
+    {
+      g_object_unref (input);
+      return NULL;
+    }
+
+  /*  the lengths in the index are checked against what's left of the
+   *  file, so a corrupt one doesn't make us allocate huge buffers
+   */
+  remaining = g_file_info_get_size (info);
+  g_object_unref (info);
+
+  data_input = g_data_input_stream_new (G_INPUT_STREAM (input));
+  g_object_unref (input);
+
+  index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                 g_free,
+                                 (GDestroyNotify) gimp_data_index_entry_free);
+
+  magic = g_data_input_stream_read_uint32 (data_input, NULL, &error);
+
+  if (error || magic != GIMP_DATA_INDEX_MAGIC)
+    goto fail;
+
+  version = g_data_input_stream_read_uint32 (data_input, NULL, &error);
+
+  if (error || version != GIMP_DATA_INDEX_VERSION)
+    goto fail;
+
+  n_entries = g_data_input_stream_read_uint32 (data_input, NULL, &error);
+
+  if (error)
+    goto fail;
+
+  remaining -= 3 * sizeof (guint32);
+
+  for (i = 0; i < n_entries; i++)
+    {
+      GimpDataIndexEntry *entry;
+      GBytes             *uri;
+      guint32             length;
+
+      length = g_data_input_stream_read_uint32 (data_input, NULL, &error);
+
+      if (error                                  ||
+          length < 1                             ||
+          length > GIMP_DATA_INDEX_MAX_URI_LENGTH ||
+          length > remaining - sizeof (guint32))
+        {
+          goto fail;
+        }
+
+      remaining -= sizeof (guint32) + length;
+
+      uri = g_input_stream_read_bytes (G_INPUT_STREAM (data_input), length,
+                                       NULL, &error);
+
+      if (! uri)
+        goto fail;
+
+      if (g_bytes_get_size (uri) != length)
+        {
+          g_bytes_unref (uri);
+          goto fail;
+        }
+
+      entry = g_slice_new0 (GimpDataIndexEntry);
+
+      entry->mtime = g_data_input_stream_read_uint64 (data_input,
+                                                      NULL, &error);
+      if (! error)
+        entry->mtime_usec = g_data_input_stream_read_uint32 (data_input,
+                                                             NULL, &error);
+      if (! error)
+        entry->size = g_data_input_stream_read_uint64 (data_input,
+                                                       NULL, &error);
+      if (! error)
+        length = g_data_input_stream_read_uint32 (data_input, NULL, &error);
+
+      if (error)
+        {
+          gimp_data_index_entry_free (entry);
+          g_bytes_unref (uri);
+          goto fail;
+        }
+
+      remaining -= 2 * sizeof (guint64) + 2 * sizeof (guint32);
+
+      if (length > remaining)
+        {
+          gimp_data_index_entry_free (entry);
+          g_bytes_unref (uri);
+          goto fail;
+        }
+
+      remaining -= length;
+
+      entry->index = g_input_stream_read_bytes (G_INPUT_STREAM (data_input),
+                                                length, NULL, &error);
+
+      if (! entry->index || g_bytes_get_size (entry->index) != length)
+        {
+          gimp_data_index_entry_free (entry);
+          g_bytes_unref (uri);
+          goto fail;
+        }
+
+      g_hash_table_insert (index,
+                           g_strndup (g_bytes_get_data (uri, NULL),
+                                      g_bytes_get_size (uri)),
+                           entry);
+
+      g_bytes_unref (uri);
+    }
+
+  g_object_unref (data_input);
+
+  return index;
+
+ fail:
+  /*  a truncated, corrupt or outdated index is simply rebuilt  */
+  g_clear_error (&error);
+  g_hash_table_unref (index);
+  g_object_unref (data_input);
+
+  return NULL;
+}
+
+static void
+gimp_data_loader_factory_write_index (GimpDataFactory *factory,
+                                      GPtrArray       *jobs)
+{
+  GFile             *file;
+  GFile             *dir;
+  GOutputStream     *output;
+  GDataOutputStream *data_output;
+  GError            *error = NULL;
+  guint32            n_entries = 0;
+  gboolean           success;
+  gint               i;
+
+  file = gimp_data_loader_factory_get_index_file (factory);
+
+  dir  = g_file_get_parent (file);
+
+  /*  the cache directory may not exist yet; errors are reported below  */
+  if (! g_file_query_exists (dir, NULL))
+    g_file_make_directory_with_parents (dir, NULL, NULL);
+
+  g_object_unref (dir);
+
+  output = G_OUTPUT_STREAM (g_file_replace (file,
+                                            NULL, FALSE, G_FILE_CREATE_NONE,
+                                            NULL, &error));
+
+  if (! output)
+    {
+      gimp_message (gimp_data_factory_get_gimp (factory), NULL,
+                    GIMP_MESSAGE_WARNING,
+                    _("Failed to write data index '%s':\n\n%s"),
+                    gimp_file_get_utf8_name (file), error->message);
+      g_clear_error (&error);
+      g_object_unref (file);
+      return;
+    }
+
+  data_output = g_data_output_stream_new (output);
+
+  for (i = 0; i < jobs->len; i++)
+    {
+      GimpDataLoaderJob *job = g_ptr_array_index (jobs, i);
+
+      if (job->index)
+        n_entries++;
+    }
+
+  success =
+    g_data_output_stream_put_uint32 (data_output, GIMP_DATA_INDEX_MAGIC,
+                                     NULL, &error) &&
+    g_data_output_stream_put_uint32 (data_output, GIMP_DATA_INDEX_VERSION,
+                                     NULL, &error) &&
+    g_data_output_stream_put_uint32 (data_output, n_entries,
+                                     NULL, &error);
+
+  for (i = 0; success && i < jobs->len; i++)
+    {
+      GimpDataLoaderJob *job = g_ptr_array_index (jobs, i);
+      gchar             *uri;
+
+      if (! job->index)
+        continue;
+
+      uri = g_file_get_uri (job->file);
+
+      success =
+        g_data_output_stream_put_uint32 (data_output, strlen (uri),
+                                         NULL, &error)                   &&
+        g_data_output_stream_put_string (data_output, uri,
+                                         NULL, &error)                   &&
+        g_data_output_stream_put_uint64 (data_output, job->mtime,
+                                         NULL, &error)                   &&
+        g_data_output_stream_put_uint32 (data_output, job->mtime_usec,
+                                         NULL, &error)                   &&
+        g_data_output_stream_put_uint64 (data_output, job->size,
+                                         NULL, &error)                   &&
+        g_data_output_stream_put_uint32 (data_output,
+                                         g_bytes_get_size (job->index),
+                                         NULL, &error)                   &&
+        g_output_stream_write_all (G_OUTPUT_STREAM (data_output),
+                                   g_bytes_get_data (job->index, NULL),
+                                   g_bytes_get_size (job->index),
+                                   NULL, NULL, &error);
+
+      g_free (uri);
+    }
+
+  if (success)
+    {
+      success = g_output_stream_close (G_OUTPUT_STREAM (data_output),
+                                       NULL, &error);
+    }
+  else
+    {
+      GCancellable *cancellable = g_cancellable_new ();
+
+      /*  don't leave a truncated index behind  */
+      g_cancellable_cancel (cancellable);
+      g_output_stream_close (output, cancellable, NULL);
+      g_object_unref (cancellable);
+    }
+
+  if (! success)
+    {
+      gimp_message (gimp_data_factory_get_gimp (factory), NULL,
+                    GIMP_MESSAGE_WARNING,
+                    _("Failed to write data index '%s':\n\n%s"),
+                    gimp_file_get_utf8_name (file), error->message);
       g_clear_error (&error);
     }
+
+  g_object_unref (data_output);
+  g_object_unref (output);
+  g_object_unref (file);
+}
+
+static GList *
+gimp_data_loader_factory_index_to_data (GimpDataFactory  *factory,
+                                        GBytes           *index,
+                                        GError          **error)
+{
+  GimpDataLoaderFactoryPrivate *priv = GET_PRIVATE (factory);
+  GInputStream                 *input;
+  GDataInputStream             *data_input;
+  GList                        *data_list = NULL;
+  GError                       *my_error  = NULL;
+  guint32                       n_data;
+  guint32                       i;
+
+  input      = g_memory_input_stream_new_from_bytes (index);
+  data_input = g_data_input_stream_new (input);
+  g_object_unref (input);
+
+  n_data = g_data_input_stream_read_uint32 (data_input, NULL, &my_error);
+
+  for (i = 0; i < n_data && ! my_error; i++)
+    {
+      GimpData *data = priv->index_read_func (data_input, &my_error);
+
+      if (! data)
+        break;
+
+      data_list = g_list_prepend (data_list, data);
+    }
+
+  g_object_unref (data_input);
+
+  if (my_error || i < n_data)
+    {
+      if (my_error)
+        g_propagate_error (error, my_error);
+
+      g_list_free_full (data_list, g_object_unref);
+
+      return NULL;
+    }
+
+  return g_list_reverse (data_list);
+}
+
+static GBytes *
+gimp_data_loader_factory_data_to_index (GimpDataFactory  *factory,
+                                        GList            *data_list,
+                                        GError          **error)
+{
+  GimpDataLoaderFactoryPrivate *priv = GET_PRIVATE (factory);
+  GOutputStream                *output;
+  GDataOutputStream            *data_output;
+  GList                        *list;
+  gboolean                      success;
+
+  output      = g_memory_output_stream_new_resizable ();
+  data_output = g_data_output_stream_new (output);
+
+  success = g_data_output_stream_put_uint32 (data_output,
+                                             g_list_length (data_list),
+                                             NULL, error);
+
+  for (list = data_list; success && list; list = g_list_next (list))
+    success = priv->index_write_func (list->data, data_output, error);
+
+  if (success)
+    success = g_output_stream_close (G_OUTPUT_STREAM (data_output),
+                                     NULL, error);
+
+  g_object_unref (data_output);
+
+  if (success)
+    {
+      GBytes *bytes;
+
+      bytes = g_memory_output_stream_steal_as_bytes (
+        G_MEMORY_OUTPUT_STREAM (output));
+
+      g_object_unref (output);
+
+      return bytes;
+    }
+
+  g_object_unref (output);
+
+  return NULL;
 }
 
 static GimpDataLoader *
@@ -578,3 +1378,30 @@ gimp_data_loader_free (GimpDataLoader *loader)
 
   g_slice_free (GimpDataLoader, loader);
 }
+
+static void
+gimp_data_loader_job_free (GimpDataLoaderJob *job)
+{
+  /*  the cached data is owned by the refresh cache  */
+  if (! job->cached)
+    g_list_free_full (job->data_list, g_object_unref);
+  else
+    g_list_free (job->data_list);
+
+  g_clear_error (&job->error);
+
+  g_clear_pointer (&job->index, g_bytes_unref);
+
+  g_object_unref (job->file);
+  g_object_unref (job->top_directory);
+
+  g_slice_free (GimpDataLoaderJob, job);
+}
+
+static void
+gimp_data_index_entry_free (GimpDataIndexEntry *entry)
+{
+  g_clear_pointer (&entry->index, g_bytes_unref);
+
+  g_slice_free (GimpDataIndexEntry, entry);
+}
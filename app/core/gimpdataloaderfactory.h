@@ -25,10 +25,20 @@
 #include "gimpdatafactory.h"
 
 
-typedef GList * (* GimpDataLoadFunc) (GimpContext   *context,
-                                      GFile         *file,
-                                      GInputStream  *input,
-                                      GError       **error);
+typedef GList    * (* GimpDataLoadFunc)       (GimpContext        *context,
+                                                GFile              *file,
+                                                GInputStream       *input,
+                                                GError            **error);
+
+typedef GimpData * (* GimpDataIndexReadFunc)  (GDataInputStream   *input,
+                                                GError            **error);
+typedef gboolean   (* GimpDataIndexWriteFunc) (GimpData           *data,
+                                                GDataOutputStream  *output,
+                                                GError            **error);
+
+
+/*  large enough for the JSON of MyPaint brushes  */
+#define GIMP_DATA_INDEX_MAX_STRING_LENGTH 32768
 
 
 #define GIMP_TYPE_DATA_LOADER_FACTORY            (gimp_data_loader_factory_get_type ())
@@ -74,5 +84,25 @@ void              gimp_data_loader_factory_add_fallback (GimpDataFactory
                                                          const gchar             *name,
                                                          GimpDataLoadFunc         load_func);
 
+void              gimp_data_loader_factory_set_parallel (GimpDataFactory         *factory,
+                                                         gboolean                 parallel);
+void              gimp_data_loader_factory_set_index    (GimpDataFactory         *factory,
+                                                         const gchar             *index_name,
+                                                         GimpDataIndexReadFunc    read_func,
+                                                         GimpDataIndexWriteFunc   write_func);
+
+gboolean          gimp_data_index_read_uint32           (GDataInputStream        *input,
+                                                         guint32                 *value,
+                                                         GError                 **error);
+gboolean          gimp_data_index_read                  (GDataInputStream        *input,
+                                                         gpointer                 buffer,
+                                                         gsize                    size,
+                                                         GError                 **error);
+gchar           * gimp_data_index_read_string           (GDataInputStream        *input,
+                                                         GError                 **error);
+gboolean          gimp_data_index_write_string          (GDataOutputStream       *output,
+                                                         const gchar             *string,
+                                                         GError                 **error);
+
 
 #endif  /*  __GIMP_DATA_LOADER_FACTORY_H__  */
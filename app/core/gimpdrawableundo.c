@@ -24,10 +24,17 @@
 
 #include "core-types.h"
 
+#include "gegl/gimp-gegl-loops.h"
+#include "gegl/gimp-gegl-utils.h"
+#include "gegl/gimptilebackendcompressed.h"
+
 #include "gimp-memsize.h"
+#include "gimp-parallel.h"
+#include "gimpasync.h"
 #include "gimpimage.h"
 #include "gimpdrawable.h"
 #include "gimpdrawableundo.h"
+#include "gimpundostack.h"
 
 
 enum
@@ -57,6 +64,15 @@ static void     gimp_drawable_undo_pop          (GimpUndo            *undo,
                                                  GimpUndoAccumulator *accum);
 static void     gimp_drawable_undo_free         (GimpUndo            *undo,
                                                  GimpUndoMode         undo_mode);
+static void     gimp_drawable_undo_compress     (GimpUndo            *undo);
+
+static void     gimp_drawable_undo_compress_async_func
+                                                (GimpAsync           *async,
+                                                 GeglBuffer          *buffer);
+static void     gimp_drawable_undo_compress_async_callback
+                                                (GimpAsync           *async,
+                                                 GimpDrawableUndo    *drawable_undo);
+static void     gimp_drawable_undo_decompress   (GimpDrawableUndo    *drawable_undo);
 
 
 G_DEFINE_TYPE (GimpDrawableUndo, gimp_drawable_undo, GIMP_TYPE_ITEM_UNDO)
@@ -79,6 +95,7 @@ gimp_drawable_undo_class_init (GimpDrawableUndoClass *klass)
 
   undo_class->pop                = gimp_drawable_undo_pop;
   undo_class->free               = gimp_drawable_undo_free;
+  undo_class->compress           = gimp_drawable_undo_compress;
 
   g_object_class_install_property (object_class, PROP_BUFFER,
                                    g_param_spec_object ("buffer", NULL, NULL,
@@ -174,7 +191,10 @@ gimp_drawable_undo_get_memsize (GimpObject *object,
   GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (object);
   gint64            memsize       = 0;
 
-  memsize += gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
+  if (drawable_undo->compressed_size)
+    memsize += drawable_undo->compressed_size;
+  else
+    memsize += gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -189,6 +209,11 @@ gimp_drawable_undo_pop (GimpUndo            *undo,
 
   GIMP_UNDO_CLASS (parent_class)->pop (undo, undo_mode, accum);
 
+  /*  the buffer receives the drawable's pixels in return, so it has to
+   *  be a plain buffer again
+   */
+  gimp_drawable_undo_decompress (drawable_undo);
+
   gimp_drawable_swap_pixels (GIMP_DRAWABLE (GIMP_ITEM_UNDO (undo)->item),
                              drawable_undo->buffer,
                              drawable_undo->x,
@@ -201,7 +226,164 @@ gimp_drawable_undo_free (GimpUndo     *undo,
 {
   GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
 
+  if (drawable_undo->compress_async)
+    gimp_async_cancel_and_wait (drawable_undo->compress_async);
+
   g_clear_object (&drawable_undo->buffer);
 
+  drawable_undo->compressed_size = 0;
+
   GIMP_UNDO_CLASS (parent_class)->free (undo, undo_mode);
 }
+
+static void
+gimp_drawable_undo_compress (GimpUndo *undo)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+
+  if (! drawable_undo->buffer          ||
+      drawable_undo->compressed_size ||
+      drawable_undo->compress_async)
+    {
+      return;
+    }
+
+  /*  the buffer isn't touched until the undo is popped or freed, both
+   *  of which wait for the compression to finish first, so it can be
+   *  read from another thread meanwhile.  each undo step compresses
+   *  its own buffer, so the steps can be compressed concurrently.
+   */
+  drawable_undo->compress_async = gimp_parallel_run_async_concurrent_full (
+    +1,
+    (GimpRunAsyncFunc) gimp_drawable_undo_compress_async_func,
+    g_object_ref (drawable_undo->buffer),
+    (GDestroyNotify) g_object_unref);
+
+  gimp_async_add_callback_for_object (
+    drawable_undo->compress_async,
+    (GimpAsyncCallback) gimp_drawable_undo_compress_async_callback,
+    drawable_undo,
+    drawable_undo);
+
+  /*  the async stays alive until its callbacks ran, which clears
+   *  compress_async
+   */
+  g_object_unref (drawable_undo->compress_async);
+}
+
+static void
+gimp_drawable_undo_compress_async_func (GimpAsync  *async,
+                                        GeglBuffer *buffer)
+{
+  GeglTileBackend     *backend;
+  GeglBuffer          *compressed;
+  const GeglRectangle *extent;
+  gint                 tile_width;
+  gint                 tile_height;
+  gint                 y;
+
+  extent = gegl_buffer_get_extent (buffer);
+
+  g_object_get (buffer,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+
+  backend = gimp_tile_backend_compressed_new (extent,
+                                              tile_width, tile_height,
+                                              gegl_buffer_get_format (buffer));
+
+  compressed = gegl_buffer_new_for_backend (extent, backend);
+
+  g_object_unref (backend);
+
+  /*  copy a row of tiles at a time, so we can be canceled in between  */
+  for (y = extent->y; y < extent->y + extent->height; y += tile_height)
+    {
+      GeglRectangle rect;
+
+      if (gimp_async_is_canceled (async))
+        {
+          g_object_unref (compressed);
+
+          gimp_async_abort (async);
+
+          return;
+        }
+
+      rect.x      = extent->x;
+      rect.y      = y;
+      rect.width  = extent->width;
+      rect.height = MIN (tile_height, extent->y + extent->height - y);
+
+      gimp_gegl_buffer_copy (buffer, &rect, GEGL_ABYSS_NONE,
+                             compressed, &rect);
+    }
+
+  /*  store all tiles in the backend  */
+  gegl_buffer_flush (compressed);
+
+  gimp_async_finish_full (async, compressed, g_object_unref);
+}
+
+static void
+gimp_drawable_undo_compress_async_callback (GimpAsync        *async,
+                                            GimpDrawableUndo *drawable_undo)
+{
+  GeglBuffer      *compressed;
+  GeglTileBackend *backend;
+  gint64           old_memsize;
+
+  drawable_undo->compress_async = NULL;
+
+  if (! gimp_async_is_finished (async) || ! drawable_undo->buffer)
+    return;
+
+  compressed = gimp_async_get_result (async);
+
+  g_object_get (compressed,
+                "backend", &backend,
+                NULL);
+
+  old_memsize = gimp_object_get_memsize (GIMP_OBJECT (drawable_undo), NULL);
+
+  g_object_unref (drawable_undo->buffer);
+  drawable_undo->buffer = g_object_ref (compressed);
+
+  drawable_undo->compressed_size =
+    gimp_tile_backend_compressed_get_memsize (
+      GIMP_TILE_BACKEND_COMPRESSED (backend));
+
+  g_object_unref (backend);
+
+  if (GIMP_UNDO (drawable_undo)->stack)
+    {
+      gint64 memsize;
+
+      memsize = gimp_object_get_memsize (GIMP_OBJECT (drawable_undo), NULL);
+
+      gimp_undo_stack_update_memsize (GIMP_UNDO (drawable_undo)->stack,
+                                      GIMP_UNDO (drawable_undo),
+                                      memsize - old_memsize, 0);
+    }
+}
+
+static void
+gimp_drawable_undo_decompress (GimpDrawableUndo *drawable_undo)
+{
+  GeglBuffer *buffer;
+
+  if (drawable_undo->compress_async)
+    gimp_async_cancel_and_wait (drawable_undo->compress_async);
+
+  if (! drawable_undo->compressed_size)
+    return;
+
+  /*  only reads the tiles of the undo, one by one  */
+  buffer = gimp_gegl_buffer_dup (drawable_undo->buffer);
+
+  g_object_unref (drawable_undo->buffer);
+  drawable_undo->buffer = buffer;
+
+  drawable_undo->compressed_size = 0;
+}
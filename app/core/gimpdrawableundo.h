@@ -40,6 +40,9 @@ struct _GimpDrawableUndo
   GeglBuffer   *buffer;
   gint          x;
   gint          y;
+
+  GimpAsync    *compress_async;
+  gint64        compressed_size;  /* > 0 if buffer is compressed          */
 };
 
 struct _GimpDrawableUndoClass
@@ -48,6 +48,10 @@ static void   gimp_filter_stack_remove_node      (GimpFilterStack *stack,
                                                   GimpFilter      *filter);
 static void   gimp_filter_stack_update_last_node (GimpFilterStack *stack);
 
+static void   gimp_filter_stack_add_cache_node   (GimpFilterStack *stack);
+static void   gimp_filter_stack_remove_cache_node
+                                                 (GimpFilterStack *stack);
+
 static void   gimp_filter_stack_filter_active    (GimpFilter      *filter,
                                                   GimpFilterStack *stack);
 
@@ -114,8 +118,12 @@ gimp_filter_stack_add (GimpContainer *container,
     {
       if (stack->graph)
         {
+          gimp_filter_stack_remove_cache_node (stack);
+
           gegl_node_add_child (stack->graph, gimp_filter_get_node (filter));
           gimp_filter_stack_add_node (stack, filter);
+
+          gimp_filter_stack_add_cache_node (stack);
         }
 
       gimp_filter_stack_update_last_node (stack);
@@ -129,6 +137,11 @@ gimp_filter_stack_remove (GimpContainer *container,
   GimpFilterStack *stack  = GIMP_FILTER_STACK (container);
   GimpFilter      *filter = GIMP_FILTER (object);
 
+  gimp_filter_stack_remove_cache_node (stack);
+
+  if (filter == stack->cached_filter)
+    stack->cached_filter = NULL;
+
   if (stack->graph && gimp_filter_get_active (filter))
     {
       gimp_filter_stack_remove_node (stack, filter);
@@ -137,6 +150,8 @@ gimp_filter_stack_remove (GimpContainer *container,
 
   GIMP_CONTAINER_CLASS (parent_class)->remove (container, object);
 
+  gimp_filter_stack_add_cache_node (stack);
+
   if (gimp_filter_get_active (filter))
     {
       gimp_filter_set_is_last_node (filter, FALSE);
@@ -152,6 +167,8 @@ gimp_filter_stack_reorder (GimpContainer *container,
   GimpFilterStack *stack  = GIMP_FILTER_STACK (container);
   GimpFilter      *filter = GIMP_FILTER (object);
 
+  gimp_filter_stack_remove_cache_node (stack);
+
   if (stack->graph && gimp_filter_get_active (filter))
     gimp_filter_stack_remove_node (stack, filter);
 
@@ -164,6 +181,8 @@ gimp_filter_stack_reorder (GimpContainer *container,
       if (stack->graph)
         gimp_filter_stack_add_node (stack, filter);
     }
+
+  gimp_filter_stack_add_cache_node (stack);
 }
 
 
@@ -220,9 +239,43 @@ gimp_filter_stack_get_graph (GimpFilterStack *stack)
 
   gegl_node_link (previous, output);
 
+  gimp_filter_stack_add_cache_node (stack);
+
   return stack->graph;
 }
 
+/*  caches the composite of the filters below @filter, so that changes
+ *  of @filter don't need to render them again.  used for the layer
+ *  which is being worked on.
+ */
+void
+gimp_filter_stack_set_cached_filter (GimpFilterStack *stack,
+                                     GimpFilter      *filter)
+{
+  g_return_if_fail (GIMP_IS_FILTER_STACK (stack));
+  g_return_if_fail (filter == NULL || GIMP_IS_FILTER (filter));
+  g_return_if_fail (filter == NULL ||
+                    gimp_container_have (GIMP_CONTAINER (stack),
+                                         GIMP_OBJECT (filter)));
+
+  if (filter == stack->cached_filter)
+    return;
+
+  gimp_filter_stack_remove_cache_node (stack);
+
+  stack->cached_filter = filter;
+
+  gimp_filter_stack_add_cache_node (stack);
+}
+
+GimpFilter *
+gimp_filter_stack_get_cached_filter (GimpFilterStack *stack)
+{
+  g_return_val_if_fail (GIMP_IS_FILTER_STACK (stack), NULL);
+
+  return stack->cached_filter;
+}
+
 
 /*  private functions  */
 
@@ -326,6 +379,8 @@ gimp_filter_stack_filter_active (GimpFilter      *filter,
 {
   if (stack->graph)
     {
+      gimp_filter_stack_remove_cache_node (stack);
+
       if (gimp_filter_get_active (filter))
         {
           gegl_node_add_child (stack->graph, gimp_filter_get_node (filter));
@@ -336,6 +391,8 @@ gimp_filter_stack_filter_active (GimpFilter      *filter,
           gimp_filter_stack_remove_node (stack, filter);
           gegl_node_remove_child (stack->graph, gimp_filter_get_node (filter));
         }
+
+      gimp_filter_stack_add_cache_node (stack);
     }
 
   gimp_filter_stack_update_last_node (stack);
@@ -343,3 +400,57 @@ gimp_filter_stack_filter_active (GimpFilter      *filter,
   if (! gimp_filter_get_active (filter))
     gimp_filter_set_is_last_node (filter, FALSE);
 }
+
+/*  creates the cache node between the cached filter and the filters
+ *  below it, if there are any
+ */
+static void
+gimp_filter_stack_add_cache_node (GimpFilterStack *stack)
+{
+  GeglNode *node;
+  GeglNode *node_below;
+
+  if (! stack->graph || ! stack->cached_filter ||
+      ! gimp_filter_get_active (stack->cached_filter))
+    {
+      return;
+    }
+
+  node       = gimp_filter_get_node (stack->cached_filter);
+  node_below = gegl_node_get_producer (node, "input", NULL);
+
+  if (! node_below ||
+      node_below == gegl_node_get_input_proxy (stack->graph, "input"))
+    {
+      return;
+    }
+
+  stack->cache_node = gegl_node_new_child (stack->graph,
+                                           "operation", "gegl:cache",
+                                           NULL);
+
+  gegl_node_link_many (node_below, stack->cache_node, node, NULL);
+}
+
+static void
+gimp_filter_stack_remove_cache_node (GimpFilterStack *stack)
+{
+  GeglNode *node_below;
+  GeglNode *node;
+
+  if (! stack->cache_node)
+    return;
+
+  node_below = gegl_node_get_producer (stack->cache_node, "input", NULL);
+  node       = gimp_filter_get_node (stack->cached_filter);
+
+  gegl_node_disconnect (stack->cache_node, "input");
+
+  gegl_node_link (node_below, node);
+
+  /*  the filters below might change while the node is unlinked, so
+   *  drop it along with its cached tiles
+   */
+  gegl_node_remove_child (stack->graph, stack->cache_node);
+  stack->cache_node = NULL;
+}
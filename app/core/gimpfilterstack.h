@@ -35,9 +35,12 @@ typedef struct _GimpFilterStackClass GimpFilterStackClass;
 
 struct _GimpFilterStack
 {
-  GimpList  parent_instance;
+  GimpList    parent_instance;
 
-  GeglNode *graph;
+  GeglNode   *graph;
+
+  GimpFilter *cached_filter;
+  GeglNode   *cache_node;
 };
 
 struct _GimpFilterStackClass
@@ -51,5 +54,11 @@ GimpContainer * gimp_filter_stack_new       (GType            filter_type);
 
 GeglNode *      gimp_filter_stack_get_graph (GimpFilterStack *stack);
 
+void            gimp_filter_stack_set_cached_filter
+                                            (GimpFilterStack *stack,
+                                             GimpFilter      *filter);
+GimpFilter *    gimp_filter_stack_get_cached_filter
+                                            (GimpFilterStack *stack);
+
 
 #endif  /*  __GIMP_FILTER_STACK_H__  */
@@ -46,6 +46,13 @@
 #define PIXELS_PER_THREAD \
   (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
 
+/* the chunks of an incremental histogram are squares whose side is
+ * MIN_CHUNK_SIZE, doubled until there are no more than MAX_N_CHUNKS of
+ * them
+ */
+#define MIN_CHUNK_SIZE 256
+#define MAX_N_CHUNKS   256
+
 
 enum
 {
@@ -55,6 +62,23 @@ enum
   PROP_VALUES
 };
 
+typedef struct
+{
+  /*  what the chunks were calculated from  */
+  const Babl    *buffer_format;
+  GeglRectangle  buffer_rect;
+  gboolean       has_mask;
+  GeglRectangle  mask_rect;
+
+  gint           chunk_size;
+  gint           n_chunks_x;
+  gint           n_chunks_y;
+  gint           n_values;
+  gdouble      **chunks;
+  gboolean      *valid;
+  guint         *serials;       /* bumped whenever a chunk is invalidated */
+} ChunkCache;
+
 struct _GimpHistogramPrivate
 {
   GimpTRCType  trc;
@@ -62,6 +86,9 @@ struct _GimpHistogramPrivate
   gint         n_bins;
   gdouble     *values;
   GimpAsync   *calculate_async;
+
+  gboolean     incremental;
+  ChunkCache  *cache;
 };
 
 typedef struct
@@ -73,10 +100,18 @@ typedef struct
   GeglBuffer    *mask;
   GeglRectangle  mask_rect;
 
+  /*  the invalid chunks, if incremental  */
+  gboolean       incremental;
+  gint           n_chunks;
+  gint          *chunk_indices;
+  guint         *chunk_serials;
+  GeglRectangle *chunk_rects;
+
   /*  output  */
   gint           n_components;
   gint           n_bins;
   gdouble       *values;
+  gdouble      **chunk_values;
 } CalculateContext;
 
 typedef struct
@@ -112,8 +147,20 @@ static void       gimp_histogram_set_values               (GimpHistogram
                                                            gint                  n_bins,
                                                            gdouble              *values);
 
+static void       gimp_histogram_cache_free               (ChunkCache           *cache);
+static void       gimp_histogram_prepare_chunks           (GimpHistogram        *histogram,
+                                                           CalculateContext     *context,
+                                                           const Babl           *buffer_format);
+static void       gimp_histogram_update_chunks            (GimpHistogram        *histogram,
+                                                           CalculateContext     *context);
+static void       gimp_histogram_free_chunks              (CalculateContext     *context);
+
 static void       gimp_histogram_calculate_internal       (GimpAsync            *async,
                                                            CalculateContext     *context);
+static gdouble  * gimp_histogram_calculate_rect           (GimpAsync            *async,
+                                                           CalculateContext     *context,
+                                                           const Babl           *format,
+                                                           const GeglRectangle  *rect);
 static void       gimp_histogram_calculate_area           (const GeglRectangle  *area,
                                                            CalculateData        *data);
 static void       gimp_histogram_calculate_async_callback (GimpAsync            *async,
@@ -224,6 +271,23 @@ gimp_histogram_get_memsize (GimpObject *object,
     memsize += (histogram->priv->n_channels *
                 histogram->priv->n_bins * sizeof (gdouble));
 
+  if (histogram->priv->cache)
+    {
+      ChunkCache *cache    = histogram->priv->cache;
+      gint        n_chunks = cache->n_chunks_x * cache->n_chunks_y;
+      gint        i;
+
+      memsize += sizeof (ChunkCache) + n_chunks * sizeof (gdouble *);
+
+      memsize += n_chunks * (sizeof (gboolean) + sizeof (guint));
+
+      for (i = 0; i < n_chunks; i++)
+        {
+          if (cache->chunks[i])
+            memsize += cache->n_values * sizeof (gdouble);
+        }
+    }
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -301,8 +365,16 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
         context.mask_rect = *gegl_buffer_get_extent (mask);
     }
 
+  gimp_histogram_prepare_chunks (histogram, &context,
+                                 gegl_buffer_get_format (buffer));
+
   gimp_histogram_calculate_internal (NULL, &context);
 
+  if (context.incremental)
+    gimp_histogram_update_chunks (histogram, &context);
+
+  gimp_histogram_free_chunks (&context);
+
   gimp_histogram_set_values (histogram,
                              context.n_components, context.n_bins,
                              context.values);
@@ -335,9 +407,6 @@ gimp_histogram_calculate_async (GimpHistogram       *histogram,
                                           gegl_buffer_get_format (buffer));
   context->buffer_rect = *buffer_rect;
 
-  gimp_gegl_buffer_copy (buffer, &rect, GEGL_ABYSS_NONE,
-                         context->buffer, NULL);
-
   if (mask)
     {
       if (mask_rect)
@@ -349,9 +418,51 @@ gimp_histogram_calculate_async (GimpHistogram       *histogram,
                                       GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
 
       context->mask = gegl_buffer_new (&rect, gegl_buffer_get_format (mask));
+    }
+
+  gimp_histogram_prepare_chunks (histogram, context,
+                                 gegl_buffer_get_format (buffer));
+
+  if (context->incremental)
+    {
+      gint i;
+
+      /*  only copy the chunks we are going to calculate  */
+      for (i = 0; i < context->n_chunks; i++)
+        {
+          GeglRectangle chunk_rect = context->chunk_rects[i];
 
-      gimp_gegl_buffer_copy (mask, &rect, GEGL_ABYSS_NONE,
-                             context->mask, NULL);
+          gegl_rectangle_align_to_buffer (&rect, &chunk_rect, buffer,
+                                          GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
+
+          gimp_gegl_buffer_copy (buffer, &rect, GEGL_ABYSS_NONE,
+                                 context->buffer, NULL);
+
+          if (mask)
+            {
+              chunk_rect.x += context->mask_rect.x - buffer_rect->x;
+              chunk_rect.y += context->mask_rect.y - buffer_rect->y;
+
+              gegl_rectangle_align_to_buffer (&rect, &chunk_rect, mask,
+                                              GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
+
+              gimp_gegl_buffer_copy (mask, &rect, GEGL_ABYSS_NONE,
+                                     context->mask, NULL);
+            }
+        }
+    }
+  else
+    {
+      gimp_gegl_buffer_copy (buffer, gegl_buffer_get_extent (context->buffer),
+                             GEGL_ABYSS_NONE,
+                             context->buffer, NULL);
+
+      if (mask)
+        {
+          gimp_gegl_buffer_copy (mask, gegl_buffer_get_extent (context->mask),
+                                 GEGL_ABYSS_NONE,
+                                 context->mask, NULL);
+        }
     }
 
   histogram->priv->calculate_async = gimp_parallel_run_async (
@@ -375,9 +486,108 @@ gimp_histogram_clear_values (GimpHistogram *histogram,
   if (histogram->priv->calculate_async)
     gimp_async_cancel_and_wait (histogram->priv->calculate_async);
 
+  g_clear_pointer (&histogram->priv->cache, gimp_histogram_cache_free);
+
   gimp_histogram_set_values (histogram, n_components, 0, NULL);
 }
 
+/**
+ * gimp_histogram_set_incremental:
+ * @histogram:   a %GimpHistogram
+ * @incremental: whether to calculate @histogram incrementally
+ *
+ * Sets whether @histogram is calculated incrementally.  An incremental
+ * histogram keeps the histogram of each chunk of the area it was last
+ * calculated from, and only recalculates the chunks that were
+ * invalidated using gimp_histogram_invalidate(), as long as it's
+ * recalculated from the same area of a buffer of the same format, and
+ * with the same mask area.
+ **/
+void
+gimp_histogram_set_incremental (GimpHistogram *histogram,
+                                gboolean       incremental)
+{
+  g_return_if_fail (GIMP_IS_HISTOGRAM (histogram));
+
+  incremental = incremental ? TRUE : FALSE;
+
+  if (incremental != histogram->priv->incremental)
+    {
+      histogram->priv->incremental = incremental;
+
+      if (! incremental)
+        {
+          if (histogram->priv->calculate_async)
+            gimp_async_cancel_and_wait (histogram->priv->calculate_async);
+
+          g_clear_pointer (&histogram->priv->cache, gimp_histogram_cache_free);
+        }
+    }
+}
+
+gboolean
+gimp_histogram_get_incremental (GimpHistogram *histogram)
+{
+  g_return_val_if_fail (GIMP_IS_HISTOGRAM (histogram), FALSE);
+
+  return histogram->priv->incremental;
+}
+
+/**
+ * gimp_histogram_invalidate:
+ * @histogram: a %GimpHistogram
+ * @rect:      the changed area, in the coordinates of the buffer
+ *             @histogram is calculated from, or %NULL
+ *
+ * Marks the chunks of an incremental @histogram that intersect @rect,
+ * or all of its chunks if @rect is %NULL, for recalculation by the
+ * next call to gimp_histogram_calculate() or
+ * gimp_histogram_calculate_async().  The current values of @histogram
+ * are not affected.
+ **/
+void
+gimp_histogram_invalidate (GimpHistogram       *histogram,
+                           const GeglRectangle *rect)
+{
+  ChunkCache    *cache;
+  GeglRectangle  area;
+  gint           x1, y1;
+  gint           x2, y2;
+  gint           x, y;
+
+  g_return_if_fail (GIMP_IS_HISTOGRAM (histogram));
+
+  cache = histogram->priv->cache;
+
+  if (! cache)
+    return;
+
+  if (! rect)
+    rect = &cache->buffer_rect;
+
+  if (! gegl_rectangle_intersect (&area, rect, &cache->buffer_rect))
+    return;
+
+  /*  chunks being calculated right now are left alone, and are only
+   *  installed as valid if their serial didn't change in the meantime
+   */
+  x1 = (area.x - cache->buffer_rect.x)                   / cache->chunk_size;
+  y1 = (area.y - cache->buffer_rect.y)                   / cache->chunk_size;
+  x2 = (area.x + area.width  - cache->buffer_rect.x - 1) / cache->chunk_size;
+  y2 = (area.y + area.height - cache->buffer_rect.y - 1) / cache->chunk_size;
+
+  for (y = y1; y <= y2; y++)
+    {
+      for (x = x1; x <= x2; x++)
+        {
+          gint i = y * cache->n_chunks_x + x;
+
+          cache->valid[i] = FALSE;
+          cache->serials[i]++;
+        }
+    }
+}
+
 
 #define HISTOGRAM_VALUE(c,i) (priv->values[(c) * priv->n_bins + (i)])
 
@@ -877,11 +1087,199 @@ gimp_histogram_set_values (GimpHistogram *histogram,
   g_object_notify (G_OBJECT (histogram), "values");
 }
 
+static void
+gimp_histogram_cache_free (ChunkCache *cache)
+{
+  gint n_chunks = cache->n_chunks_x * cache->n_chunks_y;
+  gint i;
+
+  for (i = 0; i < n_chunks; i++)
+    g_free (cache->chunks[i]);
+
+  g_free (cache->chunks);
+  g_free (cache->valid);
+  g_free (cache->serials);
+
+  g_slice_free (ChunkCache, cache);
+}
+
+/*  called in the main thread, before calculating the histogram.  resets
+ *  the chunk cache if it doesn't match @context, and fills @context with
+ *  the chunks that need to be recalculated.
+ */
+static void
+gimp_histogram_prepare_chunks (GimpHistogram    *histogram,
+                               CalculateContext *context,
+                               const Babl       *buffer_format)
+{
+  GimpHistogramPrivate *priv = histogram->priv;
+  ChunkCache           *cache;
+  gint                  n_chunks;
+  gint                  i;
+
+  if (! priv->incremental)
+    return;
+
+  cache = priv->cache;
+
+  if (cache &&
+      (cache->buffer_format != buffer_format                          ||
+       ! gegl_rectangle_equal (&cache->buffer_rect,
+                               &context->buffer_rect)                 ||
+       cache->has_mask != (context->mask != NULL)                     ||
+       (context->mask &&
+        ! gegl_rectangle_equal (&cache->mask_rect,
+                                &context->mask_rect))))
+    {
+      g_clear_pointer (&priv->cache, gimp_histogram_cache_free);
+
+      cache = NULL;
+    }
+
+  if (! cache)
+    {
+      const GeglRectangle *rect = &context->buffer_rect;
+
+      cache = g_slice_new0 (ChunkCache);
+
+      cache->buffer_format = buffer_format;
+      cache->buffer_rect   = *rect;
+      cache->has_mask      = (context->mask != NULL);
+      cache->mask_rect     = context->mask_rect;
+
+      cache->chunk_size = MIN_CHUNK_SIZE;
+
+      while (((rect->width  + cache->chunk_size - 1) / cache->chunk_size) *
+             ((rect->height + cache->chunk_size - 1) / cache->chunk_size) >
+             MAX_N_CHUNKS)
+        {
+          cache->chunk_size *= 2;
+        }
+
+      cache->n_chunks_x = (rect->width  + cache->chunk_size - 1) /
+                          cache->chunk_size;
+      cache->n_chunks_y = (rect->height + cache->chunk_size - 1) /
+                          cache->chunk_size;
+
+      n_chunks = cache->n_chunks_x * cache->n_chunks_y;
+
+      cache->chunks  = g_new0 (gdouble *, n_chunks);
+      cache->valid   = g_new0 (gboolean,  n_chunks);
+      cache->serials = g_new0 (guint,     n_chunks);
+
+      priv->cache = cache;
+    }
+
+  n_chunks = cache->n_chunks_x * cache->n_chunks_y;
+
+  context->incremental   = TRUE;
+  context->n_chunks      = 0;
+  context->chunk_indices = g_new  (gint,          n_chunks);
+  context->chunk_serials = g_new  (guint,         n_chunks);
+  context->chunk_rects   = g_new  (GeglRectangle, n_chunks);
+  context->chunk_values  = g_new0 (gdouble *,     n_chunks);
+
+  for (i = 0; i < n_chunks; i++)
+    {
+      gint x = (i % cache->n_chunks_x) * cache->chunk_size;
+      gint y = (i / cache->n_chunks_x) * cache->chunk_size;
+      gint n = context->n_chunks;
+
+      if (cache->valid[i])
+        continue;
+
+      context->chunk_indices[n] = i;
+      context->chunk_serials[n] = cache->serials[i];
+      context->chunk_rects[n]   = *GEGL_RECTANGLE (
+        cache->buffer_rect.x + x,
+        cache->buffer_rect.y + y,
+        MIN (cache->chunk_size, cache->buffer_rect.width  - x),
+        MIN (cache->chunk_size, cache->buffer_rect.height - y));
+
+      context->n_chunks++;
+    }
+}
+
+/*  called in the main thread, after calculating the histogram.  moves
+ *  the recalculated chunks to the cache, and sums all the chunks into
+ *  the histogram values.
+ */
+static void
+gimp_histogram_update_chunks (GimpHistogram    *histogram,
+                              CalculateContext *context)
+{
+  ChunkCache *cache = histogram->priv->cache;
+  gdouble    *values;
+  gint        n_chunks;
+  gint        i;
+
+  g_return_if_fail (cache != NULL);
+
+  cache->n_values = (context->n_components + N_DERIVED_CHANNELS) *
+                    context->n_bins;
+
+  for (i = 0; i < context->n_chunks; i++)
+    {
+      gint index = context->chunk_indices[i];
+
+      if (! context->chunk_values[i])
+        continue;
+
+      g_free (cache->chunks[index]);
+      cache->chunks[index]     = context->chunk_values[i];
+      context->chunk_values[i] = NULL;
+
+      /*  the chunk might have been invalidated while it was calculated  */
+      cache->valid[index] = (cache->serials[index] ==
+                             context->chunk_serials[i]);
+    }
+
+  n_chunks = cache->n_chunks_x * cache->n_chunks_y;
+  values   = NULL;
+
+  for (i = 0; i < n_chunks; i++)
+    {
+      const gdouble *chunk = cache->chunks[i];
+      gint           j;
+
+      if (! chunk)
+        continue;
+
+      if (! values)
+        {
+          values = g_memdup2 (chunk, cache->n_values * sizeof (gdouble));
+        }
+      else
+        {
+          for (j = 0; j < cache->n_values; j++)
+            values[j] += chunk[j];
+        }
+    }
+
+  context->values = values;
+}
+
+static void
+gimp_histogram_free_chunks (CalculateContext *context)
+{
+  gint i;
+
+  if (! context->incremental)
+    return;
+
+  for (i = 0; i < context->n_chunks; i++)
+    g_free (context->chunk_values[i]);
+
+  g_clear_pointer (&context->chunk_indices, g_free);
+  g_clear_pointer (&context->chunk_serials, g_free);
+  g_clear_pointer (&context->chunk_rects,   g_free);
+  g_clear_pointer (&context->chunk_values,  g_free);
+}
+
 static void
 gimp_histogram_calculate_internal (GimpAsync        *async,
                                    CalculateContext *context)
 {
-  CalculateData         data;
   GimpHistogramPrivate *priv;
   const Babl           *format;
   const Babl           *space;
@@ -924,13 +1322,49 @@ gimp_histogram_calculate_internal (GimpAsync        *async,
 
   context->n_components = babl_format_get_n_components (format);
 
+  if (context->incremental)
+    {
+      gint i;
+
+      for (i = 0; i < context->n_chunks; i++)
+        {
+          context->chunk_values[i] = gimp_histogram_calculate_rect (
+            async, context, format, &context->chunk_rects[i]);
+
+          if (async && gimp_async_is_canceled (async))
+            break;
+        }
+    }
+  else
+    {
+      context->values = gimp_histogram_calculate_rect (
+        async, context, format, &context->buffer_rect);
+    }
+
+  if (async)
+    {
+      if (! gimp_async_is_canceled (async))
+        gimp_async_finish (async, NULL);
+      else
+        gimp_async_abort (async);
+    }
+}
+
+static gdouble *
+gimp_histogram_calculate_rect (GimpAsync           *async,
+                               CalculateContext    *context,
+                               const Babl          *format,
+                               const GeglRectangle *rect)
+{
+  CalculateData data;
+
   data.async       = async;
   data.context     = context;
   data.format      = format;
   data.values_list = NULL;
 
   gegl_parallel_distribute_area (
-    &context->buffer_rect, PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
+    rect, PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
     (GeglParallelDistributeAreaFunc) gimp_histogram_calculate_area,
     &data);
 
@@ -962,17 +1396,17 @@ gimp_histogram_calculate_internal (GimpAsync        *async,
 
       g_slist_free (data.values_list);
 
-      context->values = total_values;
+      /*  an empty chunk still has an (empty) histogram  */
+      if (! total_values && context->incremental)
+        total_values = g_new0 (gdouble, n_values);
 
-      if (async)
-        gimp_async_finish (async, NULL);
+      return total_values;
     }
   else
     {
       g_slist_free_full (data.values_list, g_free);
 
-      if (async)
-        gimp_async_abort (async);
+      return NULL;
     }
 }
 
@@ -1215,10 +1649,19 @@ gimp_histogram_calculate_async_callback (GimpAsync        *async,
 
   if (gimp_async_is_finished (async))
     {
+      if (context->incremental)
+        gimp_histogram_update_chunks (context->histogram, context);
+
       gimp_histogram_set_values (context->histogram,
                                  context->n_components, context->n_bins,
                                  context->values);
     }
+  else
+    {
+      g_free (context->values);
+    }
+
+  gimp_histogram_free_chunks (context);
 
   g_object_unref (context->buffer);
   if (context->mask)
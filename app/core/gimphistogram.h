@@ -68,6 +68,12 @@ GimpAsync     * gimp_histogram_calculate_async (GimpHistogram        *histogram,
 void            gimp_histogram_clear_values    (GimpHistogram        *histogram,
                                                 gint                  n_components);
 
+void            gimp_histogram_set_incremental (GimpHistogram        *histogram,
+                                                gboolean              incremental);
+gboolean        gimp_histogram_get_incremental (GimpHistogram        *histogram);
+void            gimp_histogram_invalidate      (GimpHistogram        *histogram,
+                                                const GeglRectangle  *rect);
+
 gdouble         gimp_histogram_get_maximum     (GimpHistogram        *histogram,
                                                 GimpHistogramChannel  channel);
 gdouble         gimp_histogram_get_count       (GimpHistogram        *histogram,
@@ -147,6 +147,7 @@
 #include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
+#include "gimp-atomic.h"
 #include "gimpcontainer.h"
 #include "gimpdrawable.h"
 #include "gimperror.h"
@@ -180,6 +181,19 @@
 
 #define BITS_IN_SAMPLE 8
 
+#define PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
+
+/* each thread of the rgb histogram zeroes and merges a histogram of
+ * its own, touching each of its cells twice
+ */
+#define HISTOGRAM_PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ \
+   2.0 * HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS /* pixels */)
+
+/* the threads' histograms are summed up by slices of this many cells */
+#define HISTOGRAM_CELLS_PER_THREAD (64 * 1024)
+
 #define R_SHIFT  (BITS_IN_SAMPLE-PRECISION_R)
 #define G_SHIFT  (BITS_IN_SAMPLE-PRECISION_G)
 #define B_SHIFT  (BITS_IN_SAMPLE-PRECISION_B)
@@ -318,20 +332,12 @@ static const Babl *rgb_to_lab_fish = NULL;
 static const Babl *lab_to_rgb_fish = NULL;
 
 static inline void
-rgb_to_unshifted_lin (const guchar  r,
-                      const guchar  g,
-                      const guchar  b,
+lab_to_unshifted_lin (const gfloat *lab,
                       gint         *hr,
                       gint         *hg,
                       gint         *hb)
 {
-  gint   or, og, ob;
-  gfloat rgb[3] = { r / 255.0, g / 255.0, b / 255.0 };
-  gfloat lab[3];
-
-  babl_process (rgb_to_lab_fish, rgb, lab, 1);
-
-  /* fprintf(stderr, " %d-%d-%d -> %0.3f,%0.3f,%0.3f ", r, g, b, sL, sa, sb);*/
+  gint or, og, ob;
 
   or = RINT(lab[0] * LRAT);
   og = RINT((lab[1] - LOWA) * ARAT);
@@ -344,6 +350,24 @@ rgb_to_unshifted_lin (const guchar  r,
   /*  fprintf(stderr, " %d:%d:%d ", *hr, *hg, *hb); */
 }
 
+static inline void
+rgb_to_unshifted_lin (const guchar  r,
+                      const guchar  g,
+                      const guchar  b,
+                      gint         *hr,
+                      gint         *hg,
+                      gint         *hb)
+{
+  gfloat rgb[3] = { r / 255.0, g / 255.0, b / 255.0 };
+  gfloat lab[3];
+
+  babl_process (rgb_to_lab_fish, rgb, lab, 1);
+
+  /* fprintf(stderr, " %d-%d-%d -> %0.3f,%0.3f,%0.3f ", r, g, b, sL, sa, sb);*/
+
+  lab_to_unshifted_lin (lab, hr, hg, hb);
+}
+
 
 static inline void
 rgb_to_lin (const guchar  r,
@@ -428,6 +452,47 @@ HIST_RGB (ColorFreq  *hist_ptr,
 }
 
 
+/* Converts a run of @n pixels to the indexes of their histogram
+ * cells, using a single babl conversion, which is a lot faster than
+ * calling rgb_to_lin() for each pixel.  @buf must have room for
+ * 6 * @n floats.
+ */
+static void
+rgb_to_lin_cells (const guchar *src,
+                  gint          bpp,
+                  gint          red_pix,
+                  gint          green_pix,
+                  gint          blue_pix,
+                  gint          n,
+                  gfloat       *buf,
+                  gint         *cells)
+{
+  gfloat *rgb = buf;
+  gfloat *lab = buf + 3 * n;
+  gint    i;
+
+  for (i = 0; i < n; i++)
+    {
+      rgb[3 * i + 0] = src[red_pix]   / 255.0;
+      rgb[3 * i + 1] = src[green_pix] / 255.0;
+      rgb[3 * i + 2] = src[blue_pix]  / 255.0;
+
+      src += bpp;
+    }
+
+  babl_process (rgb_to_lab_fish, rgb, lab, n);
+
+  for (i = 0; i < n; i++)
+    {
+      gint hr, hg, hb;
+
+      lab_to_unshifted_lin (lab + 3 * i, &hr, &hg, &hb);
+
+      cells[i] = REF_FUNC (RSDF (hr), GSDF (hg), BSDF (hb));
+    }
+}
+
+
 static inline void
 lin_to_rgb (const gdouble  hr,
             const gdouble  hg,
@@ -515,6 +580,39 @@ typedef struct
 
 } box, *boxptr;
 
+typedef struct
+{
+  GeglBuffer  *buffer;
+  const Babl  *format;
+  CFHistogram  histogram;
+  gint         offsetx;
+  gint         offsety;
+  gboolean     dither_alpha;
+  GMutex       mutex;
+  GSList      *histograms;
+  gint         had_white;
+  gint         had_black;
+} HistogramContext;
+
+typedef struct _Pass2Context Pass2Context;
+
+typedef void (* Pass2AreaFunc) (const Pass2Context  *context,
+                                const GeglRectangle *area,
+                                guint64             *index_used_count);
+
+struct _Pass2Context
+{
+  QuantizeObj   *quantobj;
+  GeglBuffer    *src_buffer;
+  const Babl    *src_format;
+  GeglBuffer    *dest_buffer;
+  gint           offsetx;
+  gint           offsety;
+  gboolean       is_gray;
+  Pass2AreaFunc  func;
+  GMutex         mutex;
+};
+
 
 static void          zero_histogram_gray     (CFHistogram   histogram);
 static void          zero_histogram_rgb      (CFHistogram   histogram);
@@ -542,6 +640,7 @@ static void          compute_color_lin8      (QuantizeObj           *quantobj,
 
 
 static guchar    found_cols[MAXNUMCOLORS][3];
+static guint64   found_counts[MAXNUMCOLORS];
 static gint      num_found_cols;
 static gboolean  needs_quantize;
 static gboolean  had_white;
@@ -858,6 +957,7 @@ gimp_image_convert_indexed (GimpImage               *image,
       had_black = FALSE;
       had_white = FALSE;
       num_found_cols = 0;
+      memset (found_counts, 0, sizeof (found_counts));
 
       /*  Build the histogram  */
       for (list = all_layers;
@@ -1120,25 +1220,20 @@ zero_histogram_rgb (CFHistogram histogram)
 
 
 static void
-generate_histogram_gray (CFHistogram  histogram,
-                         GimpLayer   *layer,
-                         gboolean     dither_alpha)
+generate_histogram_gray_area (const GeglRectangle *area,
+                              HistogramContext    *context)
 {
   GeglBufferIterator *iter;
-  const Babl         *format;
+  ColorFreq           histogram[256] = { 0, };
   gint                bpp;
   gboolean            has_alpha;
+  gint                i;
 
-  format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
+  bpp       = babl_format_get_bytes_per_pixel (context->format);
+  has_alpha = babl_format_has_alpha (context->format);
 
-  g_return_if_fail (format == babl_format_with_space ("Y' u8", format) ||
-                    format == babl_format_with_space ("Y'A u8", format));
-
-  bpp       = babl_format_get_bytes_per_pixel (format);
-  has_alpha = babl_format_has_alpha (format);
-
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, format,
+  iter = gegl_buffer_iterator_new (context->buffer,
+                                   area, 0, context->format,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
 
   while (gegl_buffer_iterator_next (iter))
@@ -1166,6 +1261,41 @@ generate_histogram_gray (CFHistogram  histogram,
             }
         }
     }
+
+  g_mutex_lock (&context->mutex);
+
+  for (i = 0; i < 256; i++)
+    context->histogram[i] += histogram[i];
+
+  g_mutex_unlock (&context->mutex);
+}
+
+static void
+generate_histogram_gray (CFHistogram  histogram,
+                         GimpLayer   *layer,
+                         gboolean     dither_alpha)
+{
+  HistogramContext  context = { 0, };
+  const Babl       *format;
+
+  format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
+
+  g_return_if_fail (format == babl_format_with_space ("Y' u8", format) ||
+                    format == babl_format_with_space ("Y'A u8", format));
+
+  context.buffer    = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  context.format    = format;
+  context.histogram = histogram;
+
+  g_mutex_init (&context.mutex);
+
+  gegl_parallel_distribute_area (
+    gegl_buffer_get_extent (context.buffer),
+    PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) generate_histogram_gray_area,
+    &context);
+
+  g_mutex_clear (&context.mutex);
 }
 
 static void
@@ -1181,17 +1311,23 @@ check_white_or_black (const guchar *data)
     had_black = TRUE;
 }
 
+/* Collects the distinct colors of the layer into found_cols[], and the
+ * number of pixels of each into found_counts[], for as long as there
+ * are no more than col_limit of them.  As soon as there are more, sets
+ * needs_quantize and gives up on the layer, which then has to go
+ * through generate_histogram_rgb_area().
+ */
 static void
-generate_histogram_rgb (CFHistogram   histogram,
-                        GimpLayer    *layer,
-                        gint          col_limit,
-                        gboolean      dither_alpha,
-                        GimpProgress *progress)
+find_colors_rgb (GimpLayer    *layer,
+                 gint          col_limit,
+                 gboolean      dither_alpha,
+                 GimpProgress *progress)
 {
   GeglBufferIterator *iter;
   const Babl         *format;
   GeglRectangle      *roi;
-  ColorFreq          *colfreq;
+  guint64             counts[MAXNUMCOLORS] = { 0, };
+  gint                last   = -1;
   gint                nfc_iter;
   gint                row, col, coledge;
   gint                offsetx, offsety;
@@ -1203,9 +1339,6 @@ generate_histogram_rgb (CFHistogram   histogram,
 
   format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
 
-  g_return_if_fail (format == babl_format_with_space ("R'G'B' u8", format) ||
-                    format == babl_format_with_space ("R'G'B'A u8", format));
-
   bpp       = babl_format_get_bytes_per_pixel (format);
   has_alpha = babl_format_has_alpha (format);
 
@@ -1214,8 +1347,6 @@ generate_histogram_rgb (CFHistogram   histogram,
   layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
                 gimp_item_get_height (GIMP_ITEM (layer)));
 
-  /*  g_printerr ("col_limit = %d, nfc = %d\n", col_limit, num_found_cols); */
-
   iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
                                    NULL, 0, format,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
@@ -1231,160 +1362,278 @@ generate_histogram_rgb (CFHistogram   histogram,
 
       total_size += length;
 
-      /* g_printerr (" [%d,%d - %d,%d]", srcPR.x, src_roi->y, offsetx, offsety); */
+      /* if alpha-dithering, we need to be deterministic w.r.t. offsets */
+      col = roi->x + offsetx;
+      coledge = col + roi->width;
+      row = roi->y + offsety;
 
-      if (needs_quantize)
+      while (length--)
         {
-          if (dither_alpha)
-            {
-              /* if alpha-dithering,
-                 we need to be deterministic w.r.t. offsets */
-
-              col = roi->x + offsetx;
-              coledge = col + roi->width;
-              row = roi->y + offsety;
+          gboolean transparent = FALSE;
 
-              while (length--)
+          if (has_alpha)
+            {
+              if (dither_alpha)
                 {
-                  gboolean transparent = FALSE;
-
-                  if (has_alpha &&
-                      data[ALPHA] <
+                  if (data[ALPHA] <
                       DM[col & DM_WIDTHMASK][row & DM_HEIGHTMASK])
                     transparent = TRUE;
-
-                  if (! transparent)
-                    {
-                      colfreq = HIST_RGB (histogram,
-                                          data[RED],
-                                          data[GREEN],
-                                          data[BLUE]);
-                      check_white_or_black (data);
-                      (*colfreq)++;
-                    }
-
-                  col++;
-                  if (col == coledge)
-                    {
-                      col = roi->x + offsetx;
-                      row++;
-                    }
-
-                  data += bpp;
+                }
+              else
+                {
+                  if (data[ALPHA] <= 127)
+                    transparent = TRUE;
                 }
             }
-          else
+
+          if (! transparent)
             {
-              while (length--)
+              /* most images have runs of the same color */
+              if (last >= 0                          &&
+                  data[RED]   == found_cols[last][0] &&
+                  data[GREEN] == found_cols[last][1] &&
+                  data[BLUE]  == found_cols[last][2])
+                goto already_found;
+
+              for (nfc_iter = 0;
+                   nfc_iter < num_found_cols;
+                   nfc_iter++)
                 {
-                  if ((has_alpha && ((data[ALPHA] > 127)))
-                      || (!has_alpha))
+                  if ((data[RED]   == found_cols[nfc_iter][0]) &&
+                      (data[GREEN] == found_cols[nfc_iter][1]) &&
+                      (data[BLUE]  == found_cols[nfc_iter][2]))
                     {
-                      colfreq = HIST_RGB (histogram,
-                                          data[RED],
-                                          data[GREEN],
-                                          data[BLUE]);
-                      check_white_or_black (data);
-                      (*colfreq)++;
+                      last = nfc_iter;
+                      goto already_found;
                     }
+                }
+
+              /* Color was not in the table of
+               * existing colors
+               */
+
+              if (num_found_cols == col_limit)
+                {
+                  /* There are more colors in the image than
+                   *  were allowed.  We switch to plain
+                   *  histogram calculation with a view to
+                   *  quantizing at a later stage.
+                   */
+                  needs_quantize = TRUE;
+                  /* g_print ("\nmax colors exceeded - needs quantize.\n");*/
+
+                  gegl_buffer_iterator_stop (iter);
 
-                  data += bpp;
+                  return;
                 }
+
+              /* Remember the new color we just found.
+               */
+              last = num_found_cols++;
+
+              found_cols[last][0] = data[RED];
+              found_cols[last][1] = data[GREEN];
+              found_cols[last][2] = data[BLUE];
+
+              check_white_or_black (data);
+
+            already_found:
+
+              counts[last]++;
             }
+
+          col++;
+          if (col == coledge)
+            {
+              col = roi->x + offsetx;
+              row++;
+            }
+
+          data += bpp;
         }
-      else
+
+      if (progress && (count % 16 == 0))
+        gimp_progress_set_value (progress,
+                                 (gdouble) total_size / (gdouble) layer_size);
+    }
+
+  for (nfc_iter = 0; nfc_iter < num_found_cols; nfc_iter++)
+    found_counts[nfc_iter] += counts[nfc_iter];
+}
+
+static void
+generate_histogram_rgb_area (const GeglRectangle *area,
+                             HistogramContext    *context)
+{
+  GeglBufferIterator *iter;
+  GeglRectangle      *roi;
+  CFHistogram         histogram;
+  gfloat             *buf;
+  gint               *cells;
+  gint                bpp;
+  gboolean            has_alpha;
+  gboolean            white = FALSE;
+  gboolean            black = FALSE;
+
+  bpp       = babl_format_get_bytes_per_pixel (context->format);
+  has_alpha = babl_format_has_alpha (context->format);
+
+  histogram = g_new0 (ColorFreq, HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS);
+  buf       = g_new (gfloat, 6 * area->width);
+  cells     = g_new (gint, area->width);
+
+  iter = gegl_buffer_iterator_new (context->buffer,
+                                   area, 0, context->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+  roi = &iter->items[0].roi;
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const guchar *data = iter->items[0].data;
+      gint          row;
+
+      for (row = 0; row < roi->height; row++)
         {
           /* if alpha-dithering, we need to be deterministic w.r.t. offsets */
-          col = roi->x + offsetx;
-          coledge = col + roi->width;
-          row = roi->y + offsety;
+          gint dither_y = (roi->y + row + context->offsety) & DM_HEIGHTMASK;
+          gint col;
 
-          while (length--)
-            {
-              gboolean transparent = FALSE;
+          rgb_to_lin_cells (data, bpp, RED, GREEN, BLUE, roi->width,
+                            buf, cells);
 
+          for (col = 0; col < roi->width; col++, data += bpp)
+            {
               if (has_alpha)
                 {
-                  if (dither_alpha)
+                  if (context->dither_alpha)
                     {
-                      if (data[ALPHA] <
-                          DM[col & DM_WIDTHMASK][row & DM_HEIGHTMASK])
-                        transparent = TRUE;
+                      gint dither_x = (roi->x + col + context->offsetx) &
+                                      DM_WIDTHMASK;
+
+                      if (data[ALPHA] < DM[dither_x][dither_y])
+                        continue;
                     }
                   else
                     {
                       if (data[ALPHA] <= 127)
-                        transparent = TRUE;
+                        continue;
                     }
                 }
 
-              if (! transparent)
+              histogram[cells[col]]++;
+
+              if (data[RED] == data[GREEN] && data[GREEN] == data[BLUE])
                 {
-                  colfreq = HIST_RGB (histogram,
-                                      data[RED],
-                                      data[GREEN],
-                                      data[BLUE]);
-                  (*colfreq)++;
+                  if (data[RED] == 255)
+                    white = TRUE;
+                  else if (data[RED] == 0)
+                    black = TRUE;
+                }
+            }
+        }
+    }
 
-                  if (!needs_quantize)
-                    {
-                      for (nfc_iter = 0;
-                           nfc_iter < num_found_cols;
-                           nfc_iter++)
-                        {
-                          if ((data[RED]   == found_cols[nfc_iter][0]) &&
-                              (data[GREEN] == found_cols[nfc_iter][1]) &&
-                              (data[BLUE]  == found_cols[nfc_iter][2]))
-                            goto already_found;
-                        }
+  g_free (cells);
+  g_free (buf);
 
-                      /* Color was not in the table of
-                       * existing colors
-                       */
+  if (white)
+    g_atomic_int_set (&context->had_white, TRUE);
+  if (black)
+    g_atomic_int_set (&context->had_black, TRUE);
 
-                      num_found_cols++;
+  gimp_atomic_slist_push_head (&context->histograms, histogram);
+}
 
-                      if (num_found_cols > col_limit)
-                        {
-                          /* There are more colors in the image than
-                           *  were allowed.  We switch to plain
-                           *  histogram calculation with a view to
-                           *  quantizing at a later stage.
-                           */
-                          needs_quantize = TRUE;
-                          /* g_print ("\nmax colors exceeded - needs quantize.\n");*/
-                          goto already_found;
-                        }
-                      else
-                        {
-                          /* Remember the new color we just found.
-                           */
-                          found_cols[num_found_cols-1][0] = data[RED];
-                          found_cols[num_found_cols-1][1] = data[GREEN];
-                          found_cols[num_found_cols-1][2] = data[BLUE];
+static void
+merge_histograms_rgb_range (gsize             offset,
+                            gsize             size,
+                            HistogramContext *context)
+{
+  GSList *list;
 
-                          check_white_or_black (data);
-                        }
-                    }
-                }
-            already_found:
+  for (list = context->histograms; list; list = g_slist_next (list))
+    {
+      const ColorFreq *histogram = list->data;
+      gsize            i;
 
-              col++;
-              if (col == coledge)
-                {
-                  col = roi->x + offsetx;
-                  row++;
-                }
+      for (i = offset; i < offset + size; i++)
+        context->histogram[i] += histogram[i];
+    }
+}
 
-              data += bpp;
-            }
-        }
+static void
+generate_histogram_rgb (CFHistogram   histogram,
+                        GimpLayer    *layer,
+                        gint          col_limit,
+                        gboolean      dither_alpha,
+                        GimpProgress *progress)
+{
+  HistogramContext  context = { 0, };
+  const Babl       *format;
 
-      if (progress && (count % 16 == 0))
-        gimp_progress_set_value (progress,
-                                 (gdouble) total_size / (gdouble) layer_size);
+  format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
+
+  g_return_if_fail (format == babl_format_with_space ("R'G'B' u8", format) ||
+                    format == babl_format_with_space ("R'G'B'A u8", format));
+
+  /*  g_printerr ("col_limit = %d, nfc = %d\n", col_limit, num_found_cols); */
+
+  if (! needs_quantize)
+    {
+      gint i;
+
+      find_colors_rgb (layer, col_limit, dither_alpha, progress);
+
+      if (! needs_quantize)
+        return;
+
+      /*  We just ran out of colors.  The layers we are done with
+       *  contain only the colors we found, so their histogram is
+       *  known already, and this layer starts over below.
+       */
+      for (i = 0; i < num_found_cols; i++)
+        {
+          *HIST_RGB (histogram,
+                     found_cols[i][0],
+                     found_cols[i][1],
+                     found_cols[i][2]) += found_counts[i];
+        }
     }
 
+  /*  Each thread accumulates a histogram of its own, so that we don't
+   *  need to synchronize per pixel.  They are summed up at the end, by
+   *  slices of the histogram, so that the threads don't need to
+   *  synchronize either.
+   */
+  context.buffer       = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  context.format       = format;
+  context.histogram    = histogram;
+  context.dither_alpha = dither_alpha;
+
+  gimp_item_get_offset (GIMP_ITEM (layer),
+                        &context.offsetx, &context.offsety);
+
+  gegl_parallel_distribute_area (
+    gegl_buffer_get_extent (context.buffer),
+    HISTOGRAM_PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) generate_histogram_rgb_area,
+    &context);
+
+  gegl_parallel_distribute_range (
+    HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS, HISTOGRAM_CELLS_PER_THREAD,
+    (GeglParallelDistributeRangeFunc) merge_histograms_rgb_range,
+    &context);
+
+  g_slist_free_full (context.histograms, g_free);
+
+  if (context.had_white)
+    had_white = TRUE;
+  if (context.had_black)
+    had_black = TRUE;
+
+  if (progress)
+    gimp_progress_set_value (progress, 1.0);
+
 /*  g_print ("O: col_limit = %d, nfc = %d\n", col_limit, num_found_cols);*/
 }
 
@@ -2349,7 +2598,10 @@ select_colors_rgb (QuantizeObj *quantobj,
  * is cleared to zeroes before starting the mapping pass.  When we find the
  * nearest color for a cell, its colormap index plus one is recorded in the
  * cache for future use.  The pass2 scanning routines call fill_inverse_cmap
- * when they need to use an unfilled entry in the cache.
+ * when they need to use an unfilled entry in the cache.  The pass2 routines
+ * which run in parallel can't do that; for them, the whole cache is filled
+ * up front by fill_inverse_cmap_rgb_all(), which is cheap enough to do in a
+ * few threads.
  *
  * Our method of efficiently finding nearest colors is based on the "locally
  * sorted search" idea described by Heckbert and on the incremental distance
@@ -2775,6 +3027,101 @@ fill_inverse_cmap_rgb (QuantizeObj *quantobj,
 }
 
 
+/* Fill the inverse-colormap entries of all cells in the R range
+ * [offset, offset + size), by brute force.  The distances to all the
+ * cells of a G row are updated in a single loop over B, which doesn't
+ * branch, and is easily vectorized by the compiler.  The result is the
+ * same as that of fill_inverse_cmap_rgb().
+ */
+static void
+fill_inverse_cmap_rgb_range (gint         offset,
+                             gint         size,
+                             QuantizeObj *quantobj)
+{
+  CFHistogram  histogram = quantobj->histogram;
+  gint         numcolors = quantobj->actual_number_of_colors;
+  gint        *distB;
+  gint         bestdist[HIST_B_ELEMS];
+  gint         bestcolor[HIST_B_ELEMS];
+  gint         R, G, B;
+  gint         i;
+
+  /* The B distances of each colormap entry to each cell of a row */
+  distB = g_new (gint, numcolors * HIST_B_ELEMS);
+
+  for (i = 0; i < numcolors; i++)
+    {
+      for (B = 0; B < HIST_B_ELEMS; B++)
+        {
+          gint centerB = (B << B_SHIFT) + ((1 << B_SHIFT) >> 1);
+          gint inB     = (centerB - quantobj->clin[i].blue) * B_SCALE;
+
+          distB[i * HIST_B_ELEMS + B] = inB * inB;
+        }
+    }
+
+  for (R = offset; R < offset + size; R++)
+    {
+      gint centerR = (R << R_SHIFT) + ((1 << R_SHIFT) >> 1);
+
+      for (G = 0; G < HIST_G_ELEMS; G++)
+        {
+          gint       centerG = (G << G_SHIFT) + ((1 << G_SHIFT) >> 1);
+          ColorFreq *cells;
+
+          for (B = 0; B < HIST_B_ELEMS; B++)
+            {
+              bestdist[B]  = G_MAXINT;
+              bestcolor[B] = 0;
+            }
+
+          for (i = 0; i < numcolors; i++)
+            {
+              const gint *dist = distB + i * HIST_B_ELEMS;
+              gint        inR  = (centerR - quantobj->clin[i].red)   * R_SCALE;
+              gint        inG  = (centerG - quantobj->clin[i].green) * G_SCALE;
+              gint        dist0 = inR * inR + inG * inG;
+
+              for (B = 0; B < HIST_B_ELEMS; B++)
+                {
+                  gint dist2 = dist0 + dist[B];
+
+                  /* ties go to the lower index, like in find_best_colors() */
+                  bestcolor[B] = dist2 < bestdist[B] ? i : bestcolor[B];
+                  bestdist[B]  = MIN (dist2, bestdist[B]);
+                }
+            }
+
+          /* B is in the lowest bits of the cell index, so a row of
+           * cells is contiguous
+           */
+          cells = HIST_LIN (histogram, R, G, 0);
+
+          for (B = 0; B < HIST_B_ELEMS; B++)
+            cells[B] = bestcolor[B] + 1;
+        }
+    }
+
+  g_free (distB);
+}
+
+/* Fill the inverse-colormap entries of all the histogram cells, in
+ * parallel, so that the second pass can use the cache from several
+ * threads without filling it on demand.
+ */
+static void
+fill_inverse_cmap_rgb_all (QuantizeObj *quantobj)
+{
+  if (quantobj->actual_number_of_colors <= 0)
+    return;
+
+  gegl_parallel_distribute_range (
+    HIST_R_ELEMS, 8,
+    (GeglParallelDistributeRangeFunc) fill_inverse_cmap_rgb_range,
+    quantobj);
+}
+
+
 /*  This is pass 1  */
 
 static void
@@ -2909,10 +3256,64 @@ custompal_pass1 (QuantizeObj *quantobj)
  */
 
 static void
-median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
-                                 GimpLayer   *layer,
-                                 GeglBuffer  *new_buffer)
+median_cut_pass2_area (const GeglRectangle *area,
+                       Pass2Context        *context)
 {
+  guint64 index_used_count[256] = { 0, };
+  gint    i;
+
+  context->func (context, area, index_used_count);
+
+  g_mutex_lock (&context->mutex);
+
+  for (i = 0; i < 256; i++)
+    context->quantobj->index_used_count[i] += index_used_count[i];
+
+  g_mutex_unlock (&context->mutex);
+}
+
+/* Runs a second pass which maps each pixel independently of the others
+ * over the layer, in parallel.  The inverse colormap must have been
+ * filled completely by second_pass_init().
+ */
+static void
+median_cut_pass2_distribute (QuantizeObj   *quantobj,
+                             GimpLayer     *layer,
+                             GeglBuffer    *new_buffer,
+                             Pass2AreaFunc  func)
+{
+  Pass2Context context = { 0, };
+
+  context.quantobj    = quantobj;
+  context.src_buffer  = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  context.src_format  = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
+  context.dest_buffer = new_buffer;
+  context.is_gray     = gimp_drawable_is_gray (GIMP_DRAWABLE (layer));
+  context.func        = func;
+
+  gimp_item_get_offset (GIMP_ITEM (layer),
+                        &context.offsetx, &context.offsety);
+
+  g_mutex_init (&context.mutex);
+
+  gegl_parallel_distribute_area (
+    gegl_buffer_get_extent (context.src_buffer),
+    PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) median_cut_pass2_area,
+    &context);
+
+  g_mutex_clear (&context.mutex);
+
+  if (quantobj->progress)
+    gimp_progress_set_value (quantobj->progress, 1.0);
+}
+
+static void
+median_cut_pass2_no_dither_gray_area (const Pass2Context  *context,
+                                      const GeglRectangle *area,
+                                      guint64             *index_used_count)
+{
+  QuantizeObj        *quantobj  = context->quantobj;
   GeglBufferIterator *iter;
   CFHistogram         histogram = quantobj->histogram;
   ColorFreq          *cachep;
@@ -2922,27 +3323,25 @@ median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
   gint                src_bpp;
   gint                dest_bpp;
   gint                has_alpha;
-  guint64            *index_used_count = quantobj->index_used_count;
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
-  gint                offsetx, offsety;
-
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
+  gint                offsetx          = context->offsetx;
+  gint                offsety          = context->offsety;
 
-  src_format  = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
-  dest_format = gegl_buffer_get_format (new_buffer);
+  src_format  = context->src_format;
+  dest_format = gegl_buffer_get_format (context->dest_buffer);
 
   src_bpp  = babl_format_get_bytes_per_pixel (src_format);
   dest_bpp = babl_format_get_bytes_per_pixel (dest_format);
 
   has_alpha = babl_format_has_alpha (src_format);
 
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+  iter = gegl_buffer_iterator_new (context->src_buffer,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
   src_roi = &iter->items[0].roi;
 
-  gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+  gegl_buffer_iterator_add (iter, context->dest_buffer,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -2961,11 +3360,6 @@ median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
               gint pixel = src[GRAY];
 
               cachep = &histogram[pixel];
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_gray (quantobj, histogram, pixel);
 
               if (has_alpha)
                 {
@@ -3009,10 +3403,20 @@ median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
 }
 
 static void
-median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
-                                    GimpLayer   *layer,
-                                    GeglBuffer  *new_buffer)
+median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
+                                 GimpLayer   *layer,
+                                 GeglBuffer  *new_buffer)
 {
+  median_cut_pass2_distribute (quantobj, layer, new_buffer,
+                               median_cut_pass2_no_dither_gray_area);
+}
+
+static void
+median_cut_pass2_fixed_dither_gray_area (const Pass2Context  *context,
+                                         const GeglRectangle *area,
+                                         guint64             *index_used_count)
+{
+  QuantizeObj        *quantobj  = context->quantobj;
   GeglBufferIterator *iter;
   CFHistogram         histogram = quantobj->histogram;
   ColorFreq          *cachep;
@@ -3028,27 +3432,25 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
   gint                err2;
   Color              *color1;
   Color              *color2;
-  guint64            *index_used_count = quantobj->index_used_count;
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
-  gint                offsetx, offsety;
-
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
+  gint                offsetx          = context->offsetx;
+  gint                offsety          = context->offsety;
 
-  src_format  = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
-  dest_format = gegl_buffer_get_format (new_buffer);
+  src_format  = context->src_format;
+  dest_format = gegl_buffer_get_format (context->dest_buffer);
 
   src_bpp  = babl_format_get_bytes_per_pixel (src_format);
   dest_bpp = babl_format_get_bytes_per_pixel (dest_format);
 
   has_alpha = babl_format_has_alpha (src_format);
 
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+  iter = gegl_buffer_iterator_new (context->src_buffer,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
   src_roi = &iter->items[0].roi;
 
-  gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+  gegl_buffer_iterator_add (iter, context->dest_buffer,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -3072,11 +3474,6 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
               pixel = src[GRAY];
 
               cachep = &histogram[pixel];
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_gray (quantobj, histogram, pixel);
 
               pixval1 = *cachep - 1;
               color1 = &quantobj->cmap[pixval1];
@@ -3091,11 +3488,6 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
                       const gint R = CLAMP0255 (RV);
 
                       cachep = &histogram[R];
-                      /* If we have not seen this color before, find
-                       * nearest colormap entry and update the cache
-                       */
-                      if (*cachep == 0)
-                        fill_inverse_cmap_gray (quantobj, histogram, R);
 
                       pixval2 = *cachep - 1;
                       RV += re;
@@ -3177,10 +3569,20 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
 }
 
 static void
-median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
-                                GimpLayer   *layer,
-                                GeglBuffer  *new_buffer)
+median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
+                                    GimpLayer   *layer,
+                                    GeglBuffer  *new_buffer)
 {
+  median_cut_pass2_distribute (quantobj, layer, new_buffer,
+                               median_cut_pass2_fixed_dither_gray_area);
+}
+
+static void
+median_cut_pass2_no_dither_rgb_area (const Pass2Context  *context,
+                                     const GeglRectangle *area,
+                                     guint64             *index_used_count)
+{
+  QuantizeObj        *quantobj  = context->quantobj;
   GeglBufferIterator *iter;
   CFHistogram         histogram = quantobj->histogram;
   ColorFreq          *cachep;
@@ -3190,22 +3592,18 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
   gint                src_bpp;
   gint                dest_bpp;
   gint                has_alpha;
-  gint                R, G, B;
+  gfloat             *buf;
+  gint               *cells;
   gint                red_pix          = RED;
   gint                green_pix        = GREEN;
   gint                blue_pix         = BLUE;
   gint                alpha_pix        = ALPHA;
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
-  gint                offsetx, offsety;
-  guint64            *index_used_count = quantobj->index_used_count;
-  gint64              total_size       = 0;
-  gint64              layer_size;
-  gint                count            = 0;
+  gint                offsetx          = context->offsetx;
+  gint                offsety          = context->offsety;
 
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
-
-  src_format  = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
-  dest_format = gegl_buffer_get_format (new_buffer);
+  src_format  = context->src_format;
+  dest_format = gegl_buffer_get_format (context->dest_buffer);
 
   src_bpp  = babl_format_get_bytes_per_pixel (src_format);
   dest_bpp = babl_format_get_bytes_per_pixel (dest_format);
@@ -3215,23 +3613,23 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
   /*  In the case of web/mono palettes, we actually force
    *   grayscale drawables through the rgb pass2 functions
    */
-  if (gimp_drawable_is_gray (GIMP_DRAWABLE (layer)))
+  if (context->is_gray)
     {
       red_pix = green_pix = blue_pix = GRAY;
       alpha_pix = ALPHA_G;
     }
 
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+  iter = gegl_buffer_iterator_new (context->src_buffer,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
   src_roi = &iter->items[0].roi;
 
-  gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+  gegl_buffer_iterator_add (iter, context->dest_buffer,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
-                gimp_item_get_height (GIMP_ITEM (layer)));
+  buf   = g_new (gfloat, 6 * area->width);
+  cells = g_new (gint, area->width);
 
   while (gegl_buffer_iterator_next (iter))
     {
@@ -3239,12 +3637,14 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
       guchar       *dest = iter->items[1].data;
       gint          row;
 
-      total_size += src_roi->height * src_roi->width;
-
       for (row = 0; row < src_roi->height; row++)
         {
           gint col;
 
+          /* get the pixel values' indices into the cache */
+          rgb_to_lin_cells (src, src_bpp, red_pix, green_pix, blue_pix,
+                            src_roi->width, buf, cells);
+
           for (col = 0; col < src_roi->width; col++)
             {
               if (has_alpha)
@@ -3276,16 +3676,7 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
                     }
                 }
 
-              /* get pixel value and index into the cache */
-              rgb_to_lin (src[red_pix], src[green_pix], src[blue_pix],
-                          &R, &G, &B);
-
-              cachep = HIST_LIN (histogram, R, G, B);
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
+              cachep = &histogram[cells[col]];
 
               /* Now emit the colormap index for this cell, barfbarf */
               index_used_count[dest[INDEXED] = *cachep - 1]++;
@@ -3296,18 +3687,27 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
               dest += dest_bpp;
             }
         }
-
-      if (quantobj->progress && (count % 16 == 0))
-         gimp_progress_set_value (quantobj->progress,
-                                  (gdouble) total_size / (gdouble) layer_size);
     }
+
+  g_free (cells);
+  g_free (buf);
 }
 
 static void
-median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
-                                   GimpLayer   *layer,
-                                   GeglBuffer  *new_buffer)
+median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
+                                GimpLayer   *layer,
+                                GeglBuffer  *new_buffer)
 {
+  median_cut_pass2_distribute (quantobj, layer, new_buffer,
+                               median_cut_pass2_no_dither_rgb_area);
+}
+
+static void
+median_cut_pass2_fixed_dither_rgb_area (const Pass2Context  *context,
+                                        const GeglRectangle *area,
+                                        guint64             *index_used_count)
+{
+  QuantizeObj        *quantobj  = context->quantobj;
   GeglBufferIterator *iter;
   CFHistogram         histogram = quantobj->histogram;
   ColorFreq          *cachep;
@@ -3329,16 +3729,11 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
   gint                blue_pix         = BLUE;
   gint                alpha_pix        = ALPHA;
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
-  gint                offsetx, offsety;
-  guint64            *index_used_count = quantobj->index_used_count;
-  gint64              total_size       = 0;
-  gint64              layer_size;
-  gint                count            = 0;
+  gint                offsetx          = context->offsetx;
+  gint                offsety          = context->offsety;
 
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
-
-  src_format  = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
-  dest_format = gegl_buffer_get_format (new_buffer);
+  src_format  = context->src_format;
+  dest_format = gegl_buffer_get_format (context->dest_buffer);
 
   src_bpp  = babl_format_get_bytes_per_pixel (src_format);
   dest_bpp = babl_format_get_bytes_per_pixel (dest_format);
@@ -3348,32 +3743,27 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
   /*  In the case of web/mono palettes, we actually force
    *   grayscale drawables through the rgb pass2 functions
    */
-  if (gimp_drawable_is_gray (GIMP_DRAWABLE (layer)))
+  if (context->is_gray)
     {
       red_pix = green_pix = blue_pix = GRAY;
       alpha_pix = ALPHA_G;
     }
 
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+  iter = gegl_buffer_iterator_new (context->src_buffer,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
   src_roi = &iter->items[0].roi;
 
-  gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+  gegl_buffer_iterator_add (iter, context->dest_buffer,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
-                gimp_item_get_height (GIMP_ITEM (layer)));
-
   while (gegl_buffer_iterator_next (iter))
     {
       const guchar *src  = iter->items[0].data;
       guchar       *dest = iter->items[1].data;
       gint          row;
 
-      total_size += src_roi->height * src_roi->width;
-
       for (row = 0; row < src_roi->height; row++)
         {
           gint col;
@@ -3415,11 +3805,6 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                           &R, &G, &B);
 
               cachep = HIST_LIN (histogram, R, G, B);
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
 
               /* We now try to find a color which, when mixed in some
                * fashion with the closest match, yields something
@@ -3450,11 +3835,6 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                                   &R, &G, &B);
 
                       cachep = HIST_LIN (histogram, R, G, B);
-                      /* If we have not seen this color before, find
-                       * nearest colormap entry and update the cache
-                       */
-                      if (*cachep == 0)
-                        fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
 
                       pixval2 = *cachep - 1;
                       RV += re;  GV += ge;  BV += be;
@@ -3528,13 +3908,18 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
               dest += dest_bpp;
             }
         }
-
-      if (quantobj->progress && (count % 16 == 0))
-        gimp_progress_set_value (quantobj->progress,
-                                 (gdouble) total_size / (gdouble) layer_size);
     }
 }
 
+static void
+median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
+                                   GimpLayer   *layer,
+                                   GeglBuffer  *new_buffer)
+{
+  median_cut_pass2_distribute (quantobj, layer, new_buffer,
+                               median_cut_pass2_fixed_dither_rgb_area);
+}
+
 static void
 median_cut_pass2_nodestruct_dither_rgb (QuantizeObj *quantobj,
                                         GimpLayer   *layer,
@@ -3992,6 +4377,14 @@ median_cut_pass2_rgb_init (QuantizeObj *quantobj)
     }
 }
 
+static void
+median_cut_pass2_rgb_parallel_init (QuantizeObj *quantobj)
+{
+  median_cut_pass2_rgb_init (quantobj);
+
+  fill_inverse_cmap_rgb_all (quantobj);
+}
+
 static void
 median_cut_pass2_gray_init (QuantizeObj *quantobj)
 {
@@ -3999,6 +4392,17 @@ median_cut_pass2_gray_init (QuantizeObj *quantobj)
 
   /* Mark all indices as currently unused */
   memset (quantobj->index_used_count, 0, 256 * sizeof (guint64));
+
+  /* There are only 256 grays, fill the whole inverse colormap, so
+   * that the second pass can run in parallel
+   */
+  if (quantobj->actual_number_of_colors > 0)
+    {
+      gint pixel;
+
+      for (pixel = 0; pixel < 256; pixel++)
+        fill_inverse_cmap_gray (quantobj, quantobj->histogram, pixel);
+    }
 }
 
 static void
@@ -4467,7 +4871,7 @@ initialize_median_cut (GimpImageBaseType       type,
             default:
               g_warning("Uh-oh, bad dither type, W1");
             case GIMP_CONVERT_DITHER_NONE:
-              quantobj->second_pass_init = median_cut_pass2_rgb_init;
+              quantobj->second_pass_init = median_cut_pass2_rgb_parallel_init;
               quantobj->second_pass = median_cut_pass2_no_dither_rgb;
               break;
             case GIMP_CONVERT_DITHER_FS:
@@ -4481,7 +4885,7 @@ initialize_median_cut (GimpImageBaseType       type,
               quantobj->second_pass = median_cut_pass2_fs_dither_rgb;
               break;
             case GIMP_CONVERT_DITHER_FIXED:
-              quantobj->second_pass_init = median_cut_pass2_rgb_init;
+              quantobj->second_pass_init = median_cut_pass2_rgb_parallel_init;
               quantobj->second_pass = median_cut_pass2_fixed_dither_rgb;
               break;
             }
@@ -4537,7 +4941,7 @@ initialize_median_cut (GimpImageBaseType       type,
       switch (dither_type)
         {
         case GIMP_CONVERT_DITHER_NONE:
-          quantobj->second_pass_init = median_cut_pass2_rgb_init;
+          quantobj->second_pass_init = median_cut_pass2_rgb_parallel_init;
           quantobj->second_pass = median_cut_pass2_no_dither_rgb;
           break;
         case GIMP_CONVERT_DITHER_FS:
@@ -4555,7 +4959,7 @@ initialize_median_cut (GimpImageBaseType       type,
           quantobj->second_pass = median_cut_pass2_nodestruct_dither_rgb;
           break;
         case GIMP_CONVERT_DITHER_FIXED:
-          quantobj->second_pass_init = median_cut_pass2_rgb_init;
+          quantobj->second_pass_init = median_cut_pass2_rgb_parallel_init;
           quantobj->second_pass = median_cut_pass2_fixed_dither_rgb;
           break;
         }
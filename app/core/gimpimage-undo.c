@@ -30,7 +30,6 @@
 #include "gimpimage-private.h"
 #include "gimpimage-undo.h"
 #include "gimpitem.h"
-#include "gimplist.h"
 #include "gimpundostack.h"
 
 
@@ -479,7 +478,7 @@ gimp_image_undo_pop_stack (GimpImage     *image,
   if (undo)
     {
       if (GIMP_IS_UNDO_STACK (undo))
-        gimp_list_reverse (GIMP_LIST (GIMP_UNDO_STACK (undo)->undos));
+        gimp_undo_stack_reverse (GIMP_UNDO_STACK (undo));
 
       gimp_undo_stack_push_undo (redo_stack, undo);
 
@@ -537,7 +536,8 @@ gimp_image_undo_free_space (GimpImage *image)
   if (gimp_container_get_n_children (container) <= min_undo_levels)
     return;
 
-  while ((gimp_object_get_memsize (GIMP_OBJECT (container), NULL) > undo_size) ||
+  while ((gimp_undo_stack_get_undo_memsize (private->undo_stack,
+                                            NULL) > undo_size) ||
          (gimp_container_get_n_children (container) > max_undo_levels))
     {
       GimpUndo *freed = gimp_undo_stack_free_bottom (private->undo_stack,
@@ -286,6 +286,9 @@ static void     gimp_image_selected_vectors_notify  (GimpItemTree      *tree,
                                                      const GParamSpec  *pspec,
                                                      GimpImage         *image);
 
+static void     gimp_image_update_layer_caches   (GimpContainer     *stack,
+                                                  GimpItem          *item);
+
 static void     gimp_image_freeze_bounding_box   (GimpImage         *image);
 static void     gimp_image_thaw_bounding_box     (GimpImage         *image);
 static void     gimp_image_update_bounding_box   (GimpImage         *image);
@@ -1885,12 +1888,46 @@ gimp_image_selected_layers_notify (GimpItemTree     *tree,
       private->layer_stack = g_slist_prepend (private->layer_stack, g_list_copy (layers));
     }
 
+  /*  cache what is below the layer being worked on  */
+  gimp_image_update_layer_caches (gimp_image_get_layers (image),
+                                  (layers && ! layers->next) ?
+                                  layers->data : NULL);
+
   g_signal_emit (image, gimp_image_signals[SELECTED_LAYERS_CHANGED], 0);
 
   if (layers && gimp_image_get_selected_channels (image))
     gimp_image_set_selected_channels (image, NULL);
 }
 
+/*  makes each layer stack cache the composite below @item, or below
+ *  the group containing it, and drops the caches of all other stacks
+ */
+static void
+gimp_image_update_layer_caches (GimpContainer *stack,
+                                GimpItem      *item)
+{
+  GimpItem *cached = item;
+  GList    *list;
+
+  while (cached && gimp_item_get_container (cached) != stack)
+    cached = GIMP_ITEM (gimp_item_get_parent (cached));
+
+  gimp_filter_stack_set_cached_filter (GIMP_FILTER_STACK (stack),
+                                       GIMP_FILTER (cached));
+
+  for (list = GIMP_LIST (stack)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      GimpContainer *children;
+
+      children = gimp_viewable_get_children (list->data);
+
+      if (children)
+        gimp_image_update_layer_caches (children, item);
+    }
+}
+
 static void
 gimp_image_selected_channels_notify (GimpItemTree     *tree,
                                      const GParamSpec *pspec,
@@ -2796,7 +2833,7 @@ gimp_image_get_export_proc (GimpImage *image)
 
 gint
 gimp_image_get_xcf_version (GimpImage    *image,
-                            gboolean      zlib_compression,
+                            gboolean      compression,
                             gint         *gimp_version,
                             const gchar **version_string,
                             gchar       **version_reason)
@@ -3026,12 +3063,26 @@ gimp_image_get_xcf_version (GimpImage    *image,
       version = MAX (12, version);
     }
 
-  /* need version 8 for zlib compression */
-  if (zlib_compression)
+  /* need version 8 for zlib compression, and version 19 for zstd
+   * compression
+   */
+  if (compression)
     {
-      ADD_REASON (g_strdup_printf (_("Internal zlib compression was "
-                                     "added in %s"), "GIMP 2.10"));
-      version = MAX (8, version);
+#ifdef HAVE_ZSTD
+      if (GIMP_CORE_CONFIG (image->gimp->config)->xcf_compression_codec ==
+          GIMP_XCF_COMPRESSION_CODEC_ZSTD)
+        {
+          ADD_REASON (g_strdup_printf (_("Internal zstd compression was "
+                                         "added in %s"), "GIMP 3.2"));
+          version = MAX (19, version);
+        }
+      else
+#endif
+        {
+          ADD_REASON (g_strdup_printf (_("Internal zlib compression was "
+                                         "added in %s"), "GIMP 2.10"));
+          version = MAX (8, version);
+        }
     }
 
   /* if version is 10 (lots of new layer modes), go to version 11 with
@@ -3130,6 +3181,10 @@ gimp_image_get_xcf_version (GimpImage    *image,
       if (gimp_version)   *gimp_version   = 300;
       if (version_string) *version_string = "GIMP 3.0";
       break;
+    case 19:
+      if (gimp_version)   *gimp_version   = 302;
+      if (version_string) *version_string = "GIMP 3.2";
+      break;
     }
 
   if (version_reason && reasons)
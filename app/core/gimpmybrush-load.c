@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
@@ -28,6 +30,7 @@
 
 #include "core-types.h"
 
+#include "gimpdataloaderfactory.h"
 #include "gimpmybrush.h"
 #include "gimpmybrush-load.h"
 #include "gimpmybrush-private.h"
@@ -35,6 +38,11 @@
 #include "gimp-intl.h"
 
 
+static gboolean   gimp_mybrush_load_index_double (GDataInputStream  *input,
+                                                  gdouble           *value,
+                                                  GError           **error);
+
+
 /*  public functions  */
 
 GList *
@@ -104,7 +112,9 @@ gimp_mybrush_load (GimpContext   *context,
   g_free (basename);
 
   pixbuf = gdk_pixbuf_new_from_file_at_size (preview_filename,
-                                             48, 48, error);
+                                             GIMP_MYBRUSH_ICON_SIZE,
+                                             GIMP_MYBRUSH_ICON_SIZE,
+                                             error);
   g_free (preview_filename);
 
   basename = g_path_get_basename (gimp_file_get_utf8_name (file));
@@ -151,3 +161,122 @@ gimp_mybrush_load (GimpContext   *context,
 
   return g_list_prepend (NULL, brush);
 }
+
+GimpData *
+gimp_mybrush_load_index (GDataInputStream  *input,
+                         GError           **error)
+{
+  GimpMybrush *brush      = NULL;
+  GdkPixbuf   *pixbuf     = NULL;
+  gchar       *name       = NULL;
+  gchar       *brush_json = NULL;
+  gdouble      radius;
+  gdouble      opaque;
+  gdouble      hardness;
+  gdouble      offset_by_random;
+  guint32      eraser;
+  guint32      width;
+  guint32      height;
+  guint32      has_alpha;
+
+  g_return_val_if_fail (G_IS_DATA_INPUT_STREAM (input), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (! (name       = gimp_data_index_read_string (input, error)) ||
+      ! (brush_json = gimp_data_index_read_string (input, error)))
+    {
+      goto out;
+    }
+
+  if (! gimp_mybrush_load_index_double (input, &radius,           error) ||
+      ! gimp_mybrush_load_index_double (input, &opaque,           error) ||
+      ! gimp_mybrush_load_index_double (input, &hardness,         error) ||
+      ! gimp_mybrush_load_index_double (input, &offset_by_random, error) ||
+      ! gimp_data_index_read_uint32    (input, &eraser,           error) ||
+      ! gimp_data_index_read_uint32    (input, &width,            error) ||
+      ! gimp_data_index_read_uint32    (input, &height,           error) ||
+      ! gimp_data_index_read_uint32    (input, &has_alpha,        error))
+    {
+      goto out;
+    }
+
+  if (! brush_json[0]                                 ||
+      eraser > 1 || has_alpha > 1                     ||
+      width  > GIMP_MYBRUSH_ICON_SIZE                 ||
+      height > GIMP_MYBRUSH_ICON_SIZE                 ||
+      (width == 0) != (height == 0))
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   _("Invalid MyPaint brush index entry."));
+      goto out;
+    }
+
+  if (width > 0)
+    {
+      gint    rowstride;
+      gsize   row_size;
+      guchar *pixels;
+      guint32 y;
+
+      pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, has_alpha, 8,
+                               width, height);
+
+      pixels    = gdk_pixbuf_get_pixels (pixbuf);
+      rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+      row_size  = width * gdk_pixbuf_get_n_channels (pixbuf);
+
+      for (y = 0; y < height; y++)
+        {
+          if (! gimp_data_index_read (input,
+                                      pixels + y * rowstride, row_size,
+                                      error))
+            {
+              goto out;
+            }
+        }
+    }
+
+  brush = g_object_new (GIMP_TYPE_MYBRUSH,
+                        "name",        name,
+                        "mime-type",   "image/x-gimp-myb",
+                        "icon-pixbuf", pixbuf,
+                        NULL);
+
+  brush->priv->brush_json       = g_steal_pointer (&brush_json);
+  brush->priv->radius           = radius;
+  brush->priv->opaque           = opaque;
+  brush->priv->hardness         = hardness;
+  brush->priv->eraser           = eraser;
+  brush->priv->offset_by_random = offset_by_random;
+
+ out:
+  g_clear_object (&pixbuf);
+  g_free (name);
+  g_free (brush_json);
+
+  return (GimpData *) brush;
+}
+
+
+/*  private functions  */
+
+static gboolean
+gimp_mybrush_load_index_double (GDataInputStream  *input,
+                                gdouble           *value,
+                                GError           **error)
+{
+  GError  *my_error = NULL;
+  guint64  bits;
+
+  bits = g_data_input_stream_read_uint64 (input, NULL, &my_error);
+
+  if (my_error)
+    {
+      g_propagate_error (error, my_error);
+      return FALSE;
+    }
+
+  memcpy (value, &bits, sizeof (bits));
+
+  return TRUE;
+}
@@ -22,12 +22,16 @@
 
 
 #define GIMP_MYBRUSH_FILE_EXTENSION ".myb"
+#define GIMP_MYBRUSH_ICON_SIZE      48
 
 
-GList * gimp_mybrush_load (GimpContext   *context,
-                           GFile         *file,
-                           GInputStream  *input,
-                           GError       **error);
+GList    * gimp_mybrush_load       (GimpContext       *context,
+                                    GFile             *file,
+                                    GInputStream      *input,
+                                    GError           **error);
+
+GimpData * gimp_mybrush_load_index (GDataInputStream  *input,
+                                    GError           **error);
 
 
 #endif /* __GIMP_MYBRUSH_LOAD_H__ */
@@ -0,0 +1,124 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpmybrush-save.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "core-types.h"
+
+#include "gimpdataloaderfactory.h"
+#include "gimpmybrush.h"
+#include "gimpmybrush-private.h"
+#include "gimpmybrush-save.h"
+
+
+static gboolean   gimp_mybrush_save_index_double (GDataOutputStream  *output,
+                                                  gdouble             value,
+                                                  GError            **error);
+
+
+/*  public functions  */
+
+/*  MyPaint brushes are small, and are stored whole; restoring them
+ *  from the index saves parsing their JSON and decoding their preview
+ */
+gboolean
+gimp_mybrush_save_index (GimpData           *data,
+                         GDataOutputStream  *output,
+                         GError            **error)
+{
+  GimpMybrush *brush  = GIMP_MYBRUSH (data);
+  GdkPixbuf   *pixbuf = NULL;
+  gint         width  = 0;
+  gint         height = 0;
+  gboolean     has_alpha = FALSE;
+  gboolean     success;
+
+  g_object_get (brush,
+                "icon-pixbuf", &pixbuf,
+                NULL);
+
+  if (pixbuf)
+    {
+      if (gdk_pixbuf_get_colorspace (pixbuf)      != GDK_COLORSPACE_RGB ||
+          gdk_pixbuf_get_bits_per_sample (pixbuf) != 8)
+        {
+          g_object_unref (pixbuf);
+          return FALSE;
+        }
+
+      width     = gdk_pixbuf_get_width     (pixbuf);
+      height    = gdk_pixbuf_get_height    (pixbuf);
+      has_alpha = gdk_pixbuf_get_has_alpha (pixbuf);
+    }
+
+  success =
+    gimp_data_index_write_string (output, gimp_object_get_name (brush),
+                                  error)                                     &&
+    gimp_data_index_write_string (output, brush->priv->brush_json, error)    &&
+    gimp_mybrush_save_index_double (output, brush->priv->radius,   error)    &&
+    gimp_mybrush_save_index_double (output, brush->priv->opaque,   error)    &&
+    gimp_mybrush_save_index_double (output, brush->priv->hardness, error)    &&
+    gimp_mybrush_save_index_double (output, brush->priv->offset_by_random,
+                                    error)                                   &&
+    g_data_output_stream_put_uint32 (output, brush->priv->eraser,
+                                     NULL, error)                            &&
+    g_data_output_stream_put_uint32 (output, width,     NULL, error)         &&
+    g_data_output_stream_put_uint32 (output, height,    NULL, error)         &&
+    g_data_output_stream_put_uint32 (output, has_alpha, NULL, error);
+
+  if (pixbuf)
+    {
+      const guchar *pixels    = gdk_pixbuf_read_pixels (pixbuf);
+      gint          rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+      gsize         row_size  = width * gdk_pixbuf_get_n_channels (pixbuf);
+      gint          y;
+
+      for (y = 0; success && y < height; y++)
+        {
+          success = g_output_stream_write_all (G_OUTPUT_STREAM (output),
+                                               pixels + y * rowstride,
+                                               row_size,
+                                               NULL, NULL, error);
+        }
+
+      g_object_unref (pixbuf);
+    }
+
+  return success;
+}
+
+
+/*  private functions  */
+
+static gboolean
+gimp_mybrush_save_index_double (GDataOutputStream  *output,
+                                gdouble             value,
+                                GError            **error)
+{
+  guint64 bits;
+
+  memcpy (&bits, &value, sizeof (bits));
+
+  return g_data_output_stream_put_uint64 (output, bits, NULL, error);
+}
@@ -26,6 +26,7 @@
 
 #include "core-types.h"
 
+#include "gimpdataloaderfactory.h"
 #include "gimppattern.h"
 #include "gimppattern-header.h"
 #include "gimppattern-load.h"
@@ -34,6 +35,8 @@
 #include "gimp-intl.h"
 
 
+/*  public functions  */
+
 GList *
 gimp_pattern_load (GimpContext   *context,
                    GFile         *file,
@@ -218,3 +221,90 @@ gimp_pattern_load_pixbuf (GimpContext   *context,
 
   return g_list_prepend (NULL, pattern);
 }
+
+/*  restores a pattern written by gimp_pattern_save_index(), without
+ *  its mask, unless the pattern is small enough to be stored whole
+ */
+GimpData *
+gimp_pattern_load_index (GDataInputStream  *input,
+                         GError           **error)
+{
+  GimpPattern *pattern     = NULL;
+  const Babl  *format;
+  gchar       *name        = NULL;
+  gchar       *mime_type   = NULL;
+  gchar       *format_name = NULL;
+  gchar       *checksum    = NULL;
+  guint32      width;
+  guint32      height;
+  guint32      thumb_width;
+  guint32      thumb_height;
+  GimpTempBuf *thumbnail;
+
+  g_return_val_if_fail (G_IS_DATA_INPUT_STREAM (input), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (! (name        = gimp_data_index_read_string (input, error)) ||
+      ! (mime_type   = gimp_data_index_read_string (input, error)) ||
+      ! (format_name = gimp_data_index_read_string (input, error)) ||
+      ! (checksum    = gimp_data_index_read_string (input, error)))
+    {
+      goto out;
+    }
+
+  if (! gimp_data_index_read_uint32 (input, &width,        error) ||
+      ! gimp_data_index_read_uint32 (input, &height,       error) ||
+      ! gimp_data_index_read_uint32 (input, &thumb_width,  error) ||
+      ! gimp_data_index_read_uint32 (input, &thumb_height, error))
+    {
+      goto out;
+    }
+
+  if (! babl_format_exists (format_name)                          ||
+      width  < 1 || width  > GIMP_PATTERN_MAX_SIZE                ||
+      height < 1 || height > GIMP_PATTERN_MAX_SIZE                ||
+      thumb_width  < 1 || thumb_width  > width                    ||
+      thumb_height < 1 || thumb_height > height)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   _("Invalid pattern index entry."));
+      goto out;
+    }
+
+  format    = babl_format (format_name);
+  thumbnail = gimp_temp_buf_new (thumb_width, thumb_height, format);
+
+  if (! gimp_data_index_read (input,
+                              gimp_temp_buf_get_data (thumbnail),
+                              gimp_temp_buf_get_data_size (thumbnail),
+                              error))
+    {
+      gimp_temp_buf_unref (thumbnail);
+      goto out;
+    }
+
+  pattern = g_object_new (GIMP_TYPE_PATTERN,
+                          "name",      name,
+                          "mime-type", mime_type[0] ? mime_type : NULL,
+                          NULL);
+
+  if (thumb_width == width && thumb_height == height)
+    {
+      pattern->mask = thumbnail;
+    }
+  else
+    {
+      pattern->width     = width;
+      pattern->height    = height;
+      pattern->thumbnail = thumbnail;
+      pattern->checksum  = g_steal_pointer (&checksum);
+    }
+
+ out:
+  g_free (name);
+  g_free (mime_type);
+  g_free (format_name);
+  g_free (checksum);
+
+  return (GimpData *) pattern;
+}
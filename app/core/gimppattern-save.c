@@ -18,17 +18,26 @@
 #include "config.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
 
 #include "core-types.h"
 
+#include "gimpdataloaderfactory.h"
 #include "gimppattern.h"
 #include "gimppattern-header.h"
 #include "gimppattern-save.h"
+#include "gimptagged.h"
 #include "gimptempbuf.h"
 
 #include "gimp-intl.h"
 
 
+/*  the size of the thumbnails kept in the data index, large enough for
+ *  the views of the pattern dialogs
+ */
+#define THUMBNAIL_SIZE 64
+
+
 gboolean
 gimp_pattern_save (GimpData       *data,
                    GOutputStream  *output,
@@ -85,3 +94,76 @@ gimp_pattern_save (GimpData       *data,
 
   return TRUE;
 }
+
+gboolean
+gimp_pattern_save_index (GimpData           *data,
+                         GDataOutputStream  *output,
+                         GError            **error)
+{
+  GimpPattern *pattern = GIMP_PATTERN (data);
+  GimpTempBuf *mask    = gimp_pattern_get_mask (pattern);
+  const Babl  *format  = gimp_temp_buf_get_format (mask);
+  GimpTempBuf *thumbnail;
+  const gchar *name;
+  const gchar *mime_type;
+  const gchar *format_name;
+  gchar       *checksum;
+  gint         width;
+  gint         height;
+  gboolean     success;
+
+  name        = gimp_object_get_name (pattern);
+  mime_type   = gimp_data_get_mime_type (data);
+  format_name = babl_get_name (format);
+  checksum    = gimp_tagged_get_checksum (GIMP_TAGGED (pattern));
+  width       = gimp_temp_buf_get_width  (mask);
+  height      = gimp_temp_buf_get_height (mask);
+
+  if (width <= THUMBNAIL_SIZE && height <= THUMBNAIL_SIZE)
+    {
+      /*  small patterns are stored whole, and restored loaded  */
+      thumbnail = gimp_temp_buf_ref (mask);
+    }
+  else
+    {
+      GeglBuffer *buffer = gimp_temp_buf_create_buffer (mask);
+      gdouble     scale  = MIN ((gdouble) THUMBNAIL_SIZE / width,
+                                (gdouble) THUMBNAIL_SIZE / height);
+
+      thumbnail = gimp_temp_buf_new (MAX (1, width  * scale),
+                                     MAX (1, height * scale),
+                                     format);
+
+      gegl_buffer_get (buffer,
+                       GEGL_RECTANGLE (0, 0,
+                                       gimp_temp_buf_get_width  (thumbnail),
+                                       gimp_temp_buf_get_height (thumbnail)),
+                       scale, format, gimp_temp_buf_get_data (thumbnail),
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+
+      g_object_unref (buffer);
+    }
+
+  success =
+    gimp_data_index_write_string (output, name,        error)                &&
+    gimp_data_index_write_string (output, mime_type,   error)                &&
+    gimp_data_index_write_string (output, format_name, error)                &&
+    gimp_data_index_write_string (output, checksum,    error)                &&
+    g_data_output_stream_put_uint32 (output, width,  NULL, error)            &&
+    g_data_output_stream_put_uint32 (output, height, NULL, error)            &&
+    g_data_output_stream_put_uint32 (output,
+                                     gimp_temp_buf_get_width (thumbnail),
+                                     NULL, error)                            &&
+    g_data_output_stream_put_uint32 (output,
+                                     gimp_temp_buf_get_height (thumbnail),
+                                     NULL, error)                            &&
+    g_output_stream_write_all (G_OUTPUT_STREAM (output),
+                               gimp_temp_buf_get_data (thumbnail),
+                               gimp_temp_buf_get_data_size (thumbnail),
+                               NULL, NULL, error);
+
+  gimp_temp_buf_unref (thumbnail);
+  g_free (checksum);
+
+  return success;
+}
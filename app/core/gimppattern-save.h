@@ -20,9 +20,13 @@
 
 
 /*  don't call this function directly, use gimp_data_save() instead  */
-gboolean   gimp_pattern_save (GimpData       *data,
-                              GOutputStream  *output,
-                              GError        **error);
+gboolean   gimp_pattern_save       (GimpData           *data,
+                                    GOutputStream      *output,
+                                    GError            **error);
+
+gboolean   gimp_pattern_save_index (GimpData           *data,
+                                    GDataOutputStream  *output,
+                                    GError            **error);
 
 
 #endif  /*  __GIMP_PATTERN_SAVE_H__  */
@@ -28,6 +28,8 @@
 
 #include "gegl/gimp-gegl-loops.h"
 
+#include "gimp-memsize.h"
+#include "gimp-utils.h"
 #include "gimppattern.h"
 #include "gimppattern-load.h"
 #include "gimppattern-save.h"
@@ -59,6 +61,8 @@ static void          gimp_pattern_copy              (GimpData             *data,
 
 static gchar       * gimp_pattern_get_checksum      (GimpTagged           *tagged);
 
+static void          gimp_pattern_load_mask         (GimpPattern          *pattern);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpPattern, gimp_pattern, GIMP_TYPE_DATA,
                          G_IMPLEMENT_INTERFACE (GIMP_TYPE_TAGGED,
@@ -99,6 +103,8 @@ static void
 gimp_pattern_init (GimpPattern *pattern)
 {
   pattern->mask = NULL;
+
+  g_mutex_init (&pattern->mask_mutex);
 }
 
 static void
@@ -106,7 +112,11 @@ gimp_pattern_finalize (GObject *object)
 {
   GimpPattern *pattern = GIMP_PATTERN (object);
 
-  g_clear_pointer (&pattern->mask, gimp_temp_buf_unref);
+  g_clear_pointer (&pattern->mask,      gimp_temp_buf_unref);
+  g_clear_pointer (&pattern->thumbnail, gimp_temp_buf_unref);
+  g_clear_pointer (&pattern->checksum,  g_free);
+
+  g_mutex_clear (&pattern->mask_mutex);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -118,7 +128,13 @@ gimp_pattern_get_memsize (GimpObject *object,
   GimpPattern *pattern = GIMP_PATTERN (object);
   gint64       memsize = 0;
 
+  g_mutex_lock (&pattern->mask_mutex);
+
   memsize += gimp_temp_buf_get_memsize (pattern->mask);
+  memsize += gimp_temp_buf_get_memsize (pattern->thumbnail);
+  memsize += gimp_string_get_memsize (pattern->checksum);
+
+  g_mutex_unlock (&pattern->mask_mutex);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -131,8 +147,20 @@ gimp_pattern_get_size (GimpViewable *viewable,
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
 
-  *width  = gimp_temp_buf_get_width  (pattern->mask);
-  *height = gimp_temp_buf_get_height (pattern->mask);
+  g_mutex_lock (&pattern->mask_mutex);
+
+  if (pattern->mask)
+    {
+      *width  = gimp_temp_buf_get_width  (pattern->mask);
+      *height = gimp_temp_buf_get_height (pattern->mask);
+    }
+  else
+    {
+      *width  = pattern->width;
+      *height = pattern->height;
+    }
+
+  g_mutex_unlock (&pattern->mask_mutex);
 
   return TRUE;
 }
@@ -144,6 +172,7 @@ gimp_pattern_get_new_preview (GimpViewable *viewable,
                               gint          height)
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
+  GimpTempBuf *src     = NULL;
   GimpTempBuf *temp_buf;
   GeglBuffer  *src_buffer;
   gint         true_width;
@@ -151,12 +180,38 @@ gimp_pattern_get_new_preview (GimpViewable *viewable,
   gint         copy_width;
   gint         copy_height;
 
-  true_width  = gimp_temp_buf_get_width (pattern->mask);
-  true_height = gimp_temp_buf_get_height (pattern->mask);
+  /*  the thumbnail is enough for previews no larger than itself.  the
+   *  mask may be loaded, and the thumbnail dropped, by another thread
+   *  while we're using them, so keep our own references
+   */
+  g_mutex_lock (&pattern->mask_mutex);
+
+  if (pattern->mask)
+    {
+      src = gimp_temp_buf_ref (pattern->mask);
+    }
+  else if (pattern->thumbnail &&
+           MIN ((gdouble) width  / pattern->width,
+                (gdouble) height / pattern->height) <=
+           MIN ((gdouble) gimp_temp_buf_get_width  (pattern->thumbnail) /
+                pattern->width,
+                (gdouble) gimp_temp_buf_get_height (pattern->thumbnail) /
+                pattern->height))
+    {
+      src = gimp_temp_buf_ref (pattern->thumbnail);
+    }
+
+  g_mutex_unlock (&pattern->mask_mutex);
+
+  if (! src)
+    src = gimp_temp_buf_ref (gimp_pattern_get_mask (pattern));
+
+  true_width  = gimp_temp_buf_get_width (src);
+  true_height = gimp_temp_buf_get_height (src);
   copy_width  = MIN (width, true_width);
   copy_height = MIN (height, true_height);
 
-  src_buffer = gimp_temp_buf_create_buffer (pattern->mask);
+  src_buffer = gimp_temp_buf_create_buffer (src);
 
   if (true_width > width || true_height > height)
     {
@@ -172,7 +227,7 @@ gimp_pattern_get_new_preview (GimpViewable *viewable,
         copy_width = copy_height * aspect;
 
       temp_buf = gimp_temp_buf_new (copy_width, copy_height,
-                                    gimp_temp_buf_get_format (pattern->mask));
+                                    gimp_temp_buf_get_format (src));
 
       gegl_buffer_get (src_buffer,
                        GEGL_RECTANGLE (0, 0, copy_width, copy_height),
@@ -185,7 +240,7 @@ gimp_pattern_get_new_preview (GimpViewable *viewable,
       GeglBuffer *dest_buffer;
 
       temp_buf = gimp_temp_buf_new (copy_width, copy_height,
-                                    gimp_temp_buf_get_format (pattern->mask));
+                                    gimp_temp_buf_get_format (src));
 
       dest_buffer = gimp_temp_buf_create_buffer (temp_buf);
 
@@ -198,6 +253,7 @@ gimp_pattern_get_new_preview (GimpViewable *viewable,
     }
 
   g_object_unref (src_buffer);
+  gimp_temp_buf_unref (src);
 
   return temp_buf;
 }
@@ -207,11 +263,14 @@ gimp_pattern_get_description (GimpViewable  *viewable,
                               gchar        **tooltip)
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
+  gint         width;
+  gint         height;
+
+  gimp_pattern_get_size (viewable, &width, &height);
 
   return g_strdup_printf ("%s (%d × %d)",
                           gimp_object_get_name (pattern),
-                          gimp_temp_buf_get_width  (pattern->mask),
-                          gimp_temp_buf_get_height (pattern->mask));
+                          width, height);
 }
 
 static const gchar *
@@ -226,9 +285,19 @@ gimp_pattern_copy (GimpData *data,
 {
   GimpPattern *pattern     = GIMP_PATTERN (data);
   GimpPattern *src_pattern = GIMP_PATTERN (src_data);
+  GimpTempBuf *mask;
+
+  mask = gimp_temp_buf_copy (gimp_pattern_get_mask (src_pattern));
+
+  g_mutex_lock (&pattern->mask_mutex);
 
-  g_clear_pointer (&pattern->mask, gimp_temp_buf_unref);
-  pattern->mask = gimp_temp_buf_copy (src_pattern->mask);
+  g_clear_pointer (&pattern->mask,      gimp_temp_buf_unref);
+  g_clear_pointer (&pattern->thumbnail, gimp_temp_buf_unref);
+  g_clear_pointer (&pattern->checksum,  g_free);
+
+  pattern->mask = mask;
+
+  g_mutex_unlock (&pattern->mask_mutex);
 
   gimp_data_dirty (data);
 }
@@ -239,6 +308,8 @@ gimp_pattern_get_checksum (GimpTagged *tagged)
   GimpPattern *pattern         = GIMP_PATTERN (tagged);
   gchar       *checksum_string = NULL;
 
+  g_mutex_lock (&pattern->mask_mutex);
+
   if (pattern->mask)
     {
       GChecksum *checksum = g_checksum_new (G_CHECKSUM_MD5);
@@ -250,10 +321,74 @@ gimp_pattern_get_checksum (GimpTagged *tagged)
 
       g_checksum_free (checksum);
     }
+  else if (pattern->checksum)
+    {
+      checksum_string = g_strdup (pattern->checksum);
+    }
+
+  g_mutex_unlock (&pattern->mask_mutex);
 
   return checksum_string;
 }
 
+/*  called with mask_mutex locked  */
+static void
+gimp_pattern_load_mask (GimpPattern *pattern)
+{
+  GFile  *file;
+  GList  *list  = NULL;
+  GError *error = NULL;
+
+  file = gimp_data_get_file (GIMP_DATA (pattern));
+
+  if (file)
+    {
+      GInputStream *input = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+
+      if (input)
+        {
+          GInputStream *buffered = g_buffered_input_stream_new (input);
+
+          if (gimp_file_has_extension (file, GIMP_PATTERN_FILE_EXTENSION))
+            list = gimp_pattern_load (NULL, file, buffered, &error);
+          else
+            list = gimp_pattern_load_pixbuf (NULL, file, buffered, &error);
+
+          g_object_unref (buffered);
+          g_object_unref (input);
+        }
+    }
+
+  if (list)
+    {
+      GimpPattern *loaded = list->data;
+
+      pattern->mask = gimp_temp_buf_ref (loaded->mask);
+    }
+  else
+    {
+      /*  the file went away or changed since the index was written,
+       *  keep going with an empty pattern of the same size
+       */
+      g_warning ("%s: failed to load pattern '%s' from '%s': %s",
+                 G_STRFUNC,
+                 gimp_object_get_name (pattern),
+                 file ? gimp_file_get_utf8_name (file) : "(none)",
+                 error ? error->message : "no data");
+
+      pattern->mask =
+        gimp_temp_buf_new (MAX (pattern->width,  1),
+                           MAX (pattern->height, 1),
+                           gimp_temp_buf_get_format (pattern->thumbnail));
+      gimp_temp_buf_data_clear (pattern->mask);
+    }
+
+  g_list_free_full (list, g_object_unref);
+  g_clear_error (&error);
+
+  g_clear_pointer (&pattern->thumbnail, gimp_temp_buf_unref);
+}
+
 GimpData *
 gimp_pattern_new (GimpContext *context,
                   const gchar *name)
@@ -303,9 +438,21 @@ gimp_pattern_get_standard (GimpContext *context)
 GimpTempBuf *
 gimp_pattern_get_mask (GimpPattern *pattern)
 {
+  GimpTempBuf *mask;
+
   g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
 
-  return pattern->mask;
+  /*  patterns can be used by the paint thread  */
+  g_mutex_lock (&pattern->mask_mutex);
+
+  if (! pattern->mask)
+    gimp_pattern_load_mask (pattern);
+
+  mask = pattern->mask;
+
+  g_mutex_unlock (&pattern->mask_mutex);
+
+  return mask;
 }
 
 GeglBuffer *
@@ -313,5 +460,5 @@ gimp_pattern_create_buffer (GimpPattern *pattern)
 {
   g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
 
-  return gimp_temp_buf_create_buffer (pattern->mask);
+  return gimp_temp_buf_create_buffer (gimp_pattern_get_mask (pattern));
 }
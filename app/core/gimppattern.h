@@ -37,6 +37,17 @@ struct _GimpPattern
   GimpData     parent_instance;
 
   GimpTempBuf *mask;
+
+  /*  patterns restored from the data index have no mask until it's
+   *  first needed, only their size, a thumbnail and the mask's
+   *  checksum.  mask_mutex protects mask and thumbnail, which are
+   *  swapped when the mask is loaded, possibly by the paint thread.
+   */
+  gint         width;
+  gint         height;
+  GimpTempBuf *thumbnail;
+  gchar       *checksum;
+  GMutex       mask_mutex;
 };
 
 struct _GimpPatternClass
@@ -51,6 +51,9 @@
 #define GIMP_PROJECTION_UPDATE_CHUNK_WIDTH  32
 #define GIMP_PROJECTION_UPDATE_CHUNK_HEIGHT 32
 
+/*  maximal number of chunks rendered per batch  */
+#define GIMP_PROJECTION_MAX_N_CHUNKS        64
+
 
 enum
 {
@@ -76,6 +79,7 @@ struct _GimpProjectionPrivate
 
   cairo_region_t            *update_region;
   GeglRectangle              priority_rect;
+  gint                       render_level;
   GimpChunkIterator         *iter;
   guint                      idle_id;
 
@@ -141,6 +145,9 @@ static void        gimp_projection_chunk_render_stop     (GimpProjection  *proj,
                                                           gboolean         merge);
 static gboolean    gimp_projection_chunk_render_callback (GimpProjection  *proj);
 static gboolean    gimp_projection_chunk_render_iteration(GimpProjection  *proj);
+static void        gimp_projection_paint_rects           (GimpProjection  *proj,
+                                                          GeglRectangle   *rects,
+                                                          gint             n_rects);
 static void        gimp_projection_paint_area            (GimpProjection  *proj,
                                                           gboolean         now,
                                                           gint             x,
@@ -519,6 +526,58 @@ gimp_projection_set_priority_rect (GimpProjection *proj,
   gimp_projection_update_priority_rect (proj);
 }
 
+void
+gimp_projection_set_render_level (GimpProjection *proj,
+                                  gint            level)
+{
+  g_return_if_fail (GIMP_IS_PROJECTION (proj));
+
+  level = CLAMP (level, 0, GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL);
+
+  if (level == proj->priv->render_level)
+    return;
+
+  /*  areas rendered only at a coarser level are still dirty at the finer
+   *  levels.  queue them for rendering, so that they don't get validated
+   *  on demand while drawing.
+   */
+  if (level < proj->priv->render_level && proj->priv->validate_handler)
+    {
+      cairo_region_t *region = proj->priv->validate_handler->dirty_region;
+      gint            n_rects;
+      gint            i;
+
+      n_rects = cairo_region_num_rectangles (region);
+
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_rectangle_int_t rect;
+
+          cairo_region_get_rectangle (region, i, &rect);
+
+          gimp_projection_add_update_area (proj,
+                                           rect.x,     rect.y,
+                                           rect.width, rect.height);
+        }
+    }
+
+  proj->priv->render_level = level;
+
+  /*  restart rendering, to align the chunks to the new level's tiles  */
+  if (proj->priv->iter)
+    gimp_projection_chunk_render_stop (proj, TRUE);
+
+  gimp_projection_flush (proj);
+}
+
+gint
+gimp_projection_get_render_level (GimpProjection *proj)
+{
+  g_return_val_if_fail (GIMP_IS_PROJECTION (proj), 0);
+
+  return proj->priv->render_level;
+}
+
 void
 gimp_projection_stop_rendering (GimpProjection *proj)
 {
@@ -751,6 +810,23 @@ gimp_projection_chunk_render_start (GimpProjection *proj)
     {
       proj->priv->iter = gimp_chunk_iterator_new (region);
 
+      if (proj->priv->render_level > 0)
+        {
+          gint tile_width;
+          gint tile_height;
+
+          g_object_get (gegl_config (),
+                        "tile-width",  &tile_width,
+                        "tile-height", &tile_height,
+                        NULL);
+
+          gimp_chunk_iterator_set_tile_rect (
+            proj->priv->iter,
+            GEGL_RECTANGLE (0, 0,
+                            tile_width  << proj->priv->render_level,
+                            tile_height << proj->priv->render_level));
+        }
+
       gimp_projection_update_priority_rect (proj);
 
       if (! proj->priv->idle_id)
@@ -842,14 +918,25 @@ gimp_projection_chunk_render_iteration (GimpProjection *proj)
 {
   if (gimp_chunk_iterator_next (proj->priv->iter))
     {
-      GeglRectangle rect;
+      GeglRectangle rects[GIMP_PROJECTION_MAX_N_CHUNKS];
+      gint          max_n_rects;
+      gint          n_rects;
+
+      /*  render as many chunks per batch as there are threads, so that
+       *  writing them to the buffer can be spread over the threads
+       */
+      g_object_get (gegl_config (),
+                    "threads", &max_n_rects,
+                    NULL);
+
+      max_n_rects = CLAMP (max_n_rects, 1, GIMP_PROJECTION_MAX_N_CHUNKS);
 
       gimp_tile_handler_validate_begin_validate (proj->priv->validate_handler);
 
-      while (gimp_chunk_iterator_get_rect (proj->priv->iter, &rect))
+      while ((n_rects = gimp_chunk_iterator_get_rects (proj->priv->iter,
+                                                       rects, max_n_rects)))
         {
-          gimp_projection_paint_area (proj, TRUE,
-                                      rect.x, rect.y, rect.width, rect.height);
+          gimp_projection_paint_rects (proj, rects, n_rects);
         }
 
       gimp_tile_handler_validate_end_validate (proj->priv->validate_handler);
@@ -876,6 +963,71 @@ gimp_projection_chunk_render_iteration (GimpProjection *proj)
     }
 }
 
+static void
+gimp_projection_paint_rects (GimpProjection *proj,
+                             GeglRectangle  *rects,
+                             gint            n_rects)
+{
+  gint          off_x, off_y;
+  GeglRectangle bounding_box;
+  gint          n_valid_rects = 0;
+  gint          i;
+
+  if (n_rects == 1 && proj->priv->render_level == 0)
+    {
+      gimp_projection_paint_area (proj, TRUE,
+                                  rects[0].x,     rects[0].y,
+                                  rects[0].width, rects[0].height);
+
+      return;
+    }
+
+  gimp_projectable_get_offset (proj->priv->projectable, &off_x, &off_y);
+  bounding_box = gimp_projectable_get_bounding_box (proj->priv->projectable);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      if (gegl_rectangle_intersect (&rects[n_valid_rects],
+                                    &rects[i], &bounding_box))
+        {
+          n_valid_rects++;
+        }
+    }
+
+  if (proj->priv->render_level > 0)
+    {
+      /*  render the chunks at the current level only; the finer levels
+       *  are validated on demand.  the chunks are aligned to the level's
+       *  tiles, which gegl fetches serially anyway.
+       */
+      for (i = 0; i < n_valid_rects; i++)
+        {
+          gimp_tile_handler_validate_validate_level (
+            proj->priv->validate_handler,
+            proj->priv->buffer,
+            &rects[i],
+            proj->priv->render_level);
+        }
+    }
+  else
+    {
+      /*  the chunks are disjoint, so they can be written concurrently  */
+      gimp_tile_handler_validate_validate_rects (proj->priv->validate_handler,
+                                                 proj->priv->buffer,
+                                                 rects, n_valid_rects);
+    }
+
+  for (i = 0; i < n_valid_rects; i++)
+    {
+      g_signal_emit (proj, projection_signals[UPDATE], 0,
+                     TRUE,
+                     rects[i].x + off_x,
+                     rects[i].y + off_y,
+                     rects[i].width,
+                     rects[i].height);
+    }
+}
+
 static void
 gimp_projection_paint_area (GimpProjection *proj,
                             gboolean        now,
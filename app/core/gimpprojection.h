@@ -67,6 +67,10 @@ void             gimp_projection_set_priority_rect (GimpProjection    *proj,
                                                     gint               width,
                                                     gint               height);
 
+void             gimp_projection_set_render_level  (GimpProjection    *proj,
+                                                    gint               level);
+gint             gimp_projection_get_render_level  (GimpProjection    *proj);
+
 void             gimp_projection_stop_rendering    (GimpProjection    *proj);
 
 void             gimp_projection_flush             (GimpProjection    *proj);
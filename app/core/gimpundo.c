@@ -379,6 +379,19 @@ gimp_undo_free (GimpUndo     *undo,
   g_signal_emit (undo, undo_signals[FREE], 0, undo_mode);
 }
 
+/*  called when the undo got old enough to be stored in a more compact,
+ *  but slower to pop, form.  implementations may do so asynchronously,
+ *  and call gimp_undo_stack_update_memsize() once they are done.
+ */
+void
+gimp_undo_compress (GimpUndo *undo)
+{
+  g_return_if_fail (GIMP_IS_UNDO (undo));
+
+  if (GIMP_UNDO_GET_CLASS (undo)->compress)
+    GIMP_UNDO_GET_CLASS (undo)->compress (undo);
+}
+
 typedef struct _GimpUndoIdle GimpUndoIdle;
 
 struct _GimpUndoIdle
@@ -493,6 +506,11 @@ gimp_undo_create_preview_private (GimpUndo    *undo,
   undo->preview = gimp_viewable_get_new_preview (preview_viewable, context,
                                                  width, height);
 
+  /*  previews count towards the gui size of the stack the undo is on  */
+  if (undo->stack)
+    gimp_undo_stack_update_memsize (undo->stack, undo, 0,
+                                    gimp_temp_buf_get_memsize (undo->preview));
+
   gimp_viewable_invalidate_preview (GIMP_VIEWABLE (undo));
 }
 
@@ -508,6 +526,11 @@ gimp_undo_refresh_preview (GimpUndo    *undo,
 
   if (undo->preview)
     {
+      gint64 gui_size = gimp_temp_buf_get_memsize (undo->preview);
+
+      if (undo->stack)
+        gimp_undo_stack_update_memsize (undo->stack, undo, 0, -gui_size);
+
       g_clear_pointer (&undo->preview, gimp_temp_buf_unref);
       gimp_undo_create_preview (undo, context, FALSE);
     }
@@ -61,17 +61,22 @@ struct _GimpUndo
 
   GimpTempBuf      *preview;
   guint             preview_idle_id;
+
+  GimpUndoStack    *stack;          /* the stack the undo is on           */
+  gint64            memsize;        /* size when it stopped being on top  */
+  gint64            gui_size;       /* its gui size, updated with preview */
 };
 
 struct _GimpUndoClass
 {
   GimpViewableClass  parent_class;
 
-  void (* pop)  (GimpUndo            *undo,
-                 GimpUndoMode         undo_mode,
-                 GimpUndoAccumulator *accum);
-  void (* free) (GimpUndo            *undo,
-                 GimpUndoMode         undo_mode);
+  void (* pop)      (GimpUndo            *undo,
+                     GimpUndoMode         undo_mode,
+                     GimpUndoAccumulator *accum);
+  void (* free)     (GimpUndo            *undo,
+                     GimpUndoMode         undo_mode);
+  void (* compress) (GimpUndo            *undo);
 };
 
 
@@ -82,6 +87,7 @@ void          gimp_undo_pop             (GimpUndo            *undo,
                                          GimpUndoAccumulator *accum);
 void          gimp_undo_free            (GimpUndo            *undo,
                                          GimpUndoMode         undo_mode);
+void          gimp_undo_compress        (GimpUndo            *undo);
 
 void          gimp_undo_create_preview  (GimpUndo            *undo,
                                          GimpContext         *context,
@@ -23,11 +23,16 @@
 #include "core-types.h"
 
 #include "gimpimage.h"
+#include "gimpimage-undo.h"
 #include "gimplist.h"
 #include "gimpundo.h"
 #include "gimpundostack.h"
 
 
+/*  the number of undos on top of a stack which are kept uncompressed  */
+#define N_HOT_UNDOS 2
+
+
 static void    gimp_undo_stack_finalize    (GObject             *object);
 
 static gint64  gimp_undo_stack_get_memsize (GimpObject          *object,
@@ -38,6 +43,7 @@ static void    gimp_undo_stack_pop         (GimpUndo            *undo,
                                             GimpUndoAccumulator *accum);
 static void    gimp_undo_stack_free        (GimpUndo            *undo,
                                             GimpUndoMode         undo_mode);
+static void    gimp_undo_stack_compress    (GimpUndo            *undo);
 
 
 G_DEFINE_TYPE (GimpUndoStack, gimp_undo_stack, GIMP_TYPE_UNDO)
@@ -58,6 +64,7 @@ gimp_undo_stack_class_init (GimpUndoStackClass *klass)
 
   undo_class->pop                = gimp_undo_stack_pop;
   undo_class->free               = gimp_undo_stack_free;
+  undo_class->compress           = gimp_undo_stack_compress;
 }
 
 static void
@@ -125,6 +132,25 @@ gimp_undo_stack_free (GimpUndo     *undo,
     }
 
   gimp_container_clear (stack->undos);
+
+  stack->memsize  = 0;
+  stack->gui_size = 0;
+}
+
+static void
+gimp_undo_stack_compress (GimpUndo *undo)
+{
+  GimpUndoStack *stack = GIMP_UNDO_STACK (undo);
+  GList         *list;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo *child = list->data;
+
+      gimp_undo_compress (child);
+    }
 }
 
 GimpUndoStack *
@@ -141,10 +167,42 @@ void
 gimp_undo_stack_push_undo (GimpUndoStack *stack,
                            GimpUndo      *undo)
 {
+  GimpUndo *top;
+
   g_return_if_fail (GIMP_IS_UNDO_STACK (stack));
   g_return_if_fail (GIMP_IS_UNDO (undo));
 
+  /*  the old top undo can't change any longer, remember its size  */
+  top = gimp_undo_stack_peek (stack);
+
+  if (top)
+    {
+      top->memsize = gimp_object_get_memsize (GIMP_OBJECT (top),
+                                              &top->gui_size);
+
+      stack->memsize  += top->memsize;
+      stack->gui_size += top->gui_size;
+    }
+
   gimp_container_add (stack->undos, GIMP_OBJECT (undo));
+
+  undo->stack = stack;
+
+  /*  keep the most recent undos hot, and compress the ones below.  only
+   *  steps on the image's undo stack are compressed: the steps of an
+   *  open undo group are compressed with the group, and steps on the
+   *  redo stack are likely to be redone soon.
+   */
+  if (stack == gimp_image_get_undo_stack (GIMP_UNDO (stack)->image) &&
+      gimp_container_get_n_children (stack->undos) > N_HOT_UNDOS)
+    {
+      GimpUndo *old;
+
+      old = GIMP_UNDO (gimp_container_get_child_by_index (stack->undos,
+                                                          N_HOT_UNDOS));
+
+      gimp_undo_compress (old);
+    }
 }
 
 GimpUndo *
@@ -161,9 +219,21 @@ gimp_undo_stack_pop_undo (GimpUndoStack       *stack,
 
   if (undo)
     {
+      GimpUndo *top;
+
       gimp_container_remove (stack->undos, GIMP_OBJECT (undo));
+      undo->stack = NULL;
+
       gimp_undo_pop (undo, undo_mode, accum);
 
+      top = gimp_undo_stack_peek (stack);
+
+      if (top)
+        {
+          stack->memsize  -= top->memsize;
+          stack->gui_size -= top->gui_size;
+        }
+
       return undo;
     }
 
@@ -182,7 +252,15 @@ gimp_undo_stack_free_bottom (GimpUndoStack *stack,
 
   if (undo)
     {
+      if (undo != gimp_undo_stack_peek (stack))
+        {
+          stack->memsize  -= undo->memsize;
+          stack->gui_size -= undo->gui_size;
+        }
+
       gimp_container_remove (stack->undos, GIMP_OBJECT (undo));
+      undo->stack = NULL;
+
       gimp_undo_free (undo, undo_mode);
 
       return undo;
@@ -206,3 +284,91 @@ gimp_undo_stack_get_depth (GimpUndoStack *stack)
 
   return gimp_container_get_n_children (stack->undos);
 }
+
+void
+gimp_undo_stack_reverse (GimpUndoStack *stack)
+{
+  GimpUndo *top;
+
+  g_return_if_fail (GIMP_IS_UNDO_STACK (stack));
+
+  top = gimp_undo_stack_peek (stack);
+
+  if (top)
+    {
+      GimpUndo *bottom;
+
+      top->memsize = gimp_object_get_memsize (GIMP_OBJECT (top),
+                                              &top->gui_size);
+
+      stack->memsize  += top->memsize;
+      stack->gui_size += top->gui_size;
+
+      gimp_list_reverse (GIMP_LIST (stack->undos));
+
+      bottom = gimp_undo_stack_peek (stack);
+
+      stack->memsize  -= bottom->memsize;
+      stack->gui_size -= bottom->gui_size;
+    }
+}
+
+/*  the size of the undos on the stack, like gimp_object_get_memsize()
+ *  would return for its container, but only measuring the top undo
+ */
+gint64
+gimp_undo_stack_get_undo_memsize (GimpUndoStack *stack,
+                                  gint64        *gui_size)
+{
+  GimpUndo *top;
+  gint64    memsize      = 0;
+  gint64    top_gui_size = 0;
+
+  g_return_val_if_fail (GIMP_IS_UNDO_STACK (stack), 0);
+
+  top = gimp_undo_stack_peek (stack);
+
+  if (top)
+    {
+      memsize = stack->memsize +
+                gimp_object_get_memsize (GIMP_OBJECT (top), &top_gui_size);
+
+      top_gui_size += stack->gui_size;
+    }
+
+  if (gui_size)
+    *gui_size = top_gui_size;
+
+  return memsize;
+}
+
+/*  records that the size of an undo on @stack changed by @difference,
+ *  and its gui size by @gui_difference, after it was pushed, e.g.
+ *  because it got compressed or its preview was created, and passes
+ *  the change on to the stacks @stack is on
+ */
+void
+gimp_undo_stack_update_memsize (GimpUndoStack *stack,
+                                GimpUndo      *undo,
+                                gint64         difference,
+                                gint64         gui_difference)
+{
+  g_return_if_fail (GIMP_IS_UNDO_STACK (stack));
+  g_return_if_fail (GIMP_IS_UNDO (undo));
+  g_return_if_fail (undo->stack == stack);
+
+  while (stack)
+    {
+      /*  the top undo is measured on demand  */
+      if (undo != gimp_undo_stack_peek (stack))
+        {
+          undo->memsize   += difference;
+          undo->gui_size  += gui_difference;
+          stack->memsize  += difference;
+          stack->gui_size += gui_difference;
+        }
+
+      undo  = GIMP_UNDO (stack);
+      stack = undo->stack;
+    }
+}
@@ -37,6 +37,10 @@ struct _GimpUndoStack
   GimpUndo       parent_instance;
 
   GimpContainer *undos;
+
+  /*  the size of all undos below the top one, which can still change  */
+  gint64         memsize;
+  gint64         gui_size;
 };
 
 struct _GimpUndoStackClass
@@ -60,5 +64,16 @@ GimpUndo      * gimp_undo_stack_free_bottom (GimpUndoStack       *stack,
 GimpUndo      * gimp_undo_stack_peek        (GimpUndoStack       *stack);
 gint            gimp_undo_stack_get_depth   (GimpUndoStack       *stack);
 
+void            gimp_undo_stack_reverse     (GimpUndoStack       *stack);
+
+gint64          gimp_undo_stack_get_undo_memsize
+                                            (GimpUndoStack       *stack,
+                                             gint64              *gui_size);
+void            gimp_undo_stack_update_memsize
+                                            (GimpUndoStack       *stack,
+                                             GimpUndo            *undo,
+                                             gint64               difference,
+                                             gint64               gui_difference);
+
 
 #endif /* __GIMP_UNDO_STACK_H__ */
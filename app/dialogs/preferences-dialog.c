@@ -1642,6 +1642,24 @@ prefs_dialog_new (Gimp       *gimp,
                             _("Default export file t_ype:"),
                             GTK_GRID (grid), 0, size_group);
 
+  /*  XCF Files  */
+  vbox2 = prefs_frame_new (_("XCF Files"), GTK_CONTAINER (vbox), FALSE);
+  grid = prefs_grid_new (GTK_CONTAINER (vbox2));
+
+#ifdef HAVE_ZSTD
+  /*  without zstd support, XCF files are always compressed with zlib  */
+  prefs_enum_combo_box_add (object, "xcf-compression-codec", 0, 0,
+                            _("Compression _codec:"),
+                            GTK_GRID (grid), 0, size_group);
+  prefs_spin_button_add (object, "xcf-zstd-level", 1.0, 3.0, 0,
+                         _("Zstandard compression _level:"),
+                         GTK_GRID (grid), 1, size_group);
+#endif
+
+  prefs_check_button_add (object, "xcf-lazy-loading",
+                          _("Load layer pixels _on demand"),
+                          GTK_BOX (vbox2));
+
   /*  Raw Image Importer  */
   vbox2 = prefs_frame_new (_("Raw Image Importer"),
                            GTK_CONTAINER (vbox), TRUE);
@@ -1187,6 +1187,13 @@ gimp_display_shell_quality_notify_handler (GObject          *config,
                                            GParamSpec       *param_spec,
                                            GimpDisplayShell *shell)
 {
+  GimpContext *user_context;
+
+  user_context = gimp_get_user_context (shell->display->gimp);
+
+  if (shell->display == gimp_context_get_display (user_context))
+    gimp_display_shell_update_priority_rect (shell);
+
   gimp_display_shell_expose_full (shell);
   gimp_display_shell_render_invalidate_full (shell);
 }
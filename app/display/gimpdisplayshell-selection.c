@@ -67,6 +67,9 @@ static void      selection_undraw         (Selection          *selection);
 
 static void      selection_render_mask    (Selection          *selection);
 
+static GimpBoundSeg * selection_cull_segs (Selection          *selection,
+                                           const GimpBoundSeg *segs,
+                                           gint               *n_segs);
 static void      selection_zoom_segs      (Selection          *selection,
                                            const GimpBoundSeg *src_segs,
                                            GimpSegment        *dest_segs,
@@ -344,6 +347,43 @@ selection_render_mask (Selection *selection)
   cairo_surface_destroy (surface);
 }
 
+static GimpBoundSeg *
+selection_cull_segs (Selection          *selection,
+                     const GimpBoundSeg *segs,
+                     gint               *n_segs)
+{
+  GimpBoundSeg *visible_segs;
+  gint          n_visible_segs = 0;
+  gint          x1, y1, x2, y2;
+  gint          i;
+
+  /*  only the segments inside the viewport need to be drawn  */
+  gimp_display_shell_untransform_viewport (selection->shell, FALSE,
+                                           &x1, &y1, &x2, &y2);
+
+  x1 -= 1;
+  y1 -= 1;
+  x2 += x1 + 2;
+  y2 += y1 + 2;
+
+  visible_segs = g_new (GimpBoundSeg, *n_segs);
+
+  for (i = 0; i < *n_segs; i++)
+    {
+      if (MAX (segs[i].x1, segs[i].x2) >= x1 &&
+          MIN (segs[i].x1, segs[i].x2) <= x2 &&
+          MAX (segs[i].y1, segs[i].y2) >= y1 &&
+          MIN (segs[i].y1, segs[i].y2) <= y2)
+        {
+          visible_segs[n_visible_segs++] = segs[i];
+        }
+    }
+
+  *n_segs = n_visible_segs;
+
+  return visible_segs;
+}
+
 static void
 selection_zoom_segs (Selection          *selection,
                      const GimpBoundSeg *src_segs,
@@ -399,6 +439,7 @@ selection_generate_segs (Selection *selection)
   GimpImage          *image = gimp_display_get_image (selection->shell->display);
   const GimpBoundSeg *segs_in;
   const GimpBoundSeg *segs_out;
+  GimpBoundSeg       *visible_segs;
   gint                canvas_offset_x = 0;
   gint                canvas_offset_y = 0;
 
@@ -414,21 +455,37 @@ selection_generate_segs (Selection *selection)
 
   if (selection->n_segs_in)
     {
-      selection->segs_in = g_new (GimpSegment, selection->n_segs_in);
-      selection_zoom_segs (selection, segs_in,
-                           selection->segs_in, selection->n_segs_in,
-                           canvas_offset_x, canvas_offset_y);
+      visible_segs = selection_cull_segs (selection, segs_in,
+                                          &selection->n_segs_in);
+
+      if (selection->n_segs_in)
+        {
+          selection->segs_in = g_new (GimpSegment, selection->n_segs_in);
+          selection_zoom_segs (selection, visible_segs,
+                               selection->segs_in, selection->n_segs_in,
+                               canvas_offset_x, canvas_offset_y);
+
+          selection_render_mask (selection);
+        }
 
-      selection_render_mask (selection);
+      g_free (visible_segs);
     }
 
   /*  Possible secondary boundary representation  */
   if (selection->n_segs_out)
     {
-      selection->segs_out = g_new (GimpSegment, selection->n_segs_out);
-      selection_zoom_segs (selection, segs_out,
-                           selection->segs_out, selection->n_segs_out,
-                           canvas_offset_x, canvas_offset_y);
+      visible_segs = selection_cull_segs (selection, segs_out,
+                                          &selection->n_segs_out);
+
+      if (selection->n_segs_out)
+        {
+          selection->segs_out = g_new (GimpSegment, selection->n_segs_out);
+          selection_zoom_segs (selection, visible_segs,
+                               selection->segs_out, selection->n_segs_out,
+                               canvas_offset_x, canvas_offset_y);
+        }
+
+      g_free (visible_segs);
     }
 }
 
@@ -1956,10 +1956,29 @@ gimp_display_shell_update_priority_rect (GimpDisplayShell *shell)
       GimpProjection *projection = gimp_image_get_projection (image);
       gint            x, y;
       gint            width, height;
+      gint            level = 0;
 
       gimp_display_shell_untransform_viewport (shell, ! shell->show_all,
                                                &x, &y, &width, &height);
       gimp_projection_set_priority_rect (projection, x, y, width, height);
+
+      /*  when zoomed out, let the projection render at the mipmap level
+       *  the display samples from, see gimp_display_shell_render().  with
+       *  nearest-neighbor sampling, full-resolution pixels are needed.
+       */
+      if (shell->display->config->zoom_quality == GIMP_ZOOM_QUALITY_HIGH)
+        {
+          gdouble scale = shell->render_scale *
+                          MAX (shell->scale_x, shell->scale_y);
+
+          while (scale <= 0.5)
+            {
+              scale *= 2.0;
+              level++;
+            }
+        }
+
+      gimp_projection_set_render_level (projection, level);
     }
 }
 
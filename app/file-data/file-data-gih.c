@@ -169,6 +169,8 @@ file_gih_pipe_to_image (Gimp          *gimp,
   gchar              spacing[8];
   gint               i;
 
+  gimp_brush_load_pixels (GIMP_BRUSH (pipe));
+
   if (gimp_brush_get_pixmap (pipe->current))
     base_type = GIMP_RGB;
   else
@@ -0,0 +1,375 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-gegl-mask-dilate.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gegl.h>
+
+#include "gimp-gegl-types.h"
+
+#include "gimp-gegl-mask-dilate.h"
+
+
+/* Dilation (and erosion) of a binary mask by a structuring element that is
+ * symmetric, and whose column at horizontal offset dx spans the vertical
+ * offsets [-half_heights[|dx|], half_heights[|dx|]], where half_heights[] is
+ * non-increasing.  this is the shape used by the grow and shrink
+ * operations.
+ *
+ * the structuring element is separable in the following sense:  a pixel is
+ * covered iff, for some column x', the vertical distance v from the pixel's
+ * row to the nearest seed pixel in column x' satisfies
+ * half_heights[|x - x'|] >= v, i.e., iff |x - x'| <= widths[v], where
+ * widths[v] is the largest offset whose column reaches at least v rows.
+ *
+ * we therefore first compute the vertical distance to the nearest seed of
+ * each pixel, using a linear pass in each direction, and then cover each
+ * row with the interval [x' - widths[v], x' + widths[v]] of each of its
+ * pixels, using a running sum.  both passes take constant time per pixel,
+ * regardless of the radius, and the result is exact.
+ *
+ * the mask is processed in horizontal bands, in parallel.  each band is
+ * processed in sub-bands, so that the distances kept for it don't grow
+ * with its area, and each sub-band reads radius_y rows of context above
+ * and below it.
+ */
+
+
+/* the minimal number of rows to process per thread */
+#define MIN_BAND_HEIGHT 64
+
+/* the number of rows to read or write at once */
+#define CHUNK_HEIGHT    64
+
+/* the minimal number of rows of a sub-band.  sub-bands are at least
+ * radius_y rows high, so that the context they read is at most twice
+ * their size.
+ */
+#define MIN_SUB_BAND_HEIGHT 256
+
+
+typedef struct
+{
+  GeglBuffer    *src_buffer;
+  GeglRectangle  src_rect;
+  GeglBuffer    *dest_buffer;
+  GeglRectangle  dest_rect;
+  gint           radius_y;
+  gint          *widths;
+  gboolean       erode;
+  gboolean       outside_seed;
+} DilateData;
+
+
+/*  local function prototypes  */
+
+static void   gimp_gegl_mask_dilate_band (gint        offset,
+                                          gint        size,
+                                          DilateData *data);
+static void   gimp_gegl_mask_dilate_rows (DilateData *data,
+                                          gint        y0,
+                                          gint        y1,
+                                          gfloat     *rows,
+                                          guint16    *above,
+                                          guint16    *below,
+                                          gint       *cover);
+
+
+/*  private functions  */
+
+static inline gboolean
+is_seed (gfloat   value,
+         gboolean erode)
+{
+  /* when dilating, selected pixels spread; when eroding, unselected ones do */
+  return erode ? value < 0.5f : value >= 0.5f;
+}
+
+static inline void
+update_dist (guint16       *dist,
+             const gfloat  *row,
+             gint           width,
+             gboolean       erode,
+             guint16        inf)
+{
+  gint x;
+
+  for (x = 0; x < width; x++)
+    {
+      if (is_seed (row[x], erode))
+        dist[x] = 0;
+      else if (dist[x] < inf)
+        dist[x]++;
+    }
+}
+
+static void
+gimp_gegl_mask_dilate_band (gint        offset,
+                            gint        size,
+                            DilateData *data)
+{
+  gint     width      = data->src_rect.width;
+  gint     sub_height = MIN (size, MAX (MIN_SUB_BAND_HEIGHT, data->radius_y));
+  gfloat  *rows;
+  guint16 *above;
+  guint16 *below;
+  gint    *cover;
+  gint     y;
+
+  rows  = g_new  (gfloat,  (gsize) CHUNK_HEIGHT * width);
+  above = g_new  (guint16, (gsize) sub_height * width);
+  below = g_new  (guint16, width);
+  cover = g_new0 (gint,    width + 1);
+
+  for (y = offset; y < offset + size; y += sub_height)
+    {
+      gimp_gegl_mask_dilate_rows (data,
+                                  y, MIN (y + sub_height, offset + size),
+                                  rows, above, below, cover);
+    }
+
+  g_free (cover);
+  g_free (below);
+  g_free (above);
+  g_free (rows);
+}
+
+/*  dilates rows [y0, y1) of the mask.  @above must hold the distances of
+ *  all of them.
+ */
+static void
+gimp_gegl_mask_dilate_rows (DilateData *data,
+                            gint        y0,
+                            gint        y1,
+                            gfloat     *rows,
+                            guint16    *above,
+                            guint16    *below,
+                            gint       *cover)
+{
+  const Babl *format   = babl_format ("Y float");
+  gint        width    = data->src_rect.width;
+  gint        height   = data->src_rect.height;
+  gint        radius_y = data->radius_y;
+  guint16     inf      = radius_y + 1;
+  gint        top      = MAX (y0 - radius_y, 0);
+  gint        bottom   = MIN (y1 + radius_y, height);
+  gint        y;
+
+  /*  the vertical distance from each pixel of the rows to the nearest seed
+   *  above it, or at it.  rows farther than radius_y above them can't
+   *  reach them.
+   */
+  for (y = 0; y < width; y++)
+    below[y] = (top == 0 && data->outside_seed) ? 0 : inf;
+
+  for (y = top; y < y1; y += CHUNK_HEIGHT)
+    {
+      gint n = MIN (CHUNK_HEIGHT, y1 - y);
+      gint i;
+
+      gegl_buffer_get (data->src_buffer,
+                       GEGL_RECTANGLE (data->src_rect.x,
+                                       data->src_rect.y + y,
+                                       width, n),
+                       1.0, format, rows,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (i = 0; i < n; i++)
+        {
+          update_dist (below, rows + i * width, width, data->erode, inf);
+
+          if (y + i >= y0)
+            {
+              memcpy (above + (gsize) (y + i - y0) * width, below,
+                      width * sizeof (guint16));
+            }
+        }
+    }
+
+  /*  the vertical distance from the last of the rows to the nearest seed
+   *  below it
+   */
+  for (y = 0; y < width; y++)
+    below[y] = (bottom == height && data->outside_seed) ? 0 : inf;
+
+  for (y = bottom; y > y1; y -= CHUNK_HEIGHT)
+    {
+      gint n = MIN (CHUNK_HEIGHT, y - y1);
+      gint i;
+
+      gegl_buffer_get (data->src_buffer,
+                       GEGL_RECTANGLE (data->src_rect.x,
+                                       data->src_rect.y + y - n,
+                                       width, n),
+                       1.0, format, rows,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (i = n - 1; i >= 0; i--)
+        update_dist (below, rows + i * width, width, data->erode, inf);
+    }
+
+  /*  render the rows bottom-up, completing the vertical distances, and
+   *  covering each row with the horizontal reach of its pixels
+   */
+  for (y = y1; y > y0; y -= CHUNK_HEIGHT)
+    {
+      gint n = MIN (CHUNK_HEIGHT, y - y0);
+      gint i;
+
+      for (i = n - 1; i >= 0; i--)
+        {
+          const guint16 *dist = above + (gsize) (y - n + i - y0) * width;
+          gfloat        *out  = rows + i * width;
+          gint           sum  = 0;
+          gint           x;
+
+          memset (cover, 0, (width + 1) * sizeof (gint));
+
+          if (data->outside_seed)
+            {
+              /*  the columns to the left and to the right of the mask are
+               *  seeds at every row
+               */
+              cover[0]++;
+              cover[MIN (data->widths[0], width)]--;
+
+              cover[MAX (width - data->widths[0], 0)]++;
+              cover[width]--;
+            }
+
+          for (x = 0; x < width; x++)
+            {
+              guint16 v;
+
+              if (dist[x] == 0)
+                below[x] = 0;
+              else if (below[x] < inf)
+                below[x]++;
+
+              v = MIN (dist[x], below[x]);
+
+              if (v <= radius_y)
+                {
+                  gint w = data->widths[v];
+
+                  cover[MAX (x - w,     0)]++;
+                  cover[MIN (x + w + 1, width)]--;
+                }
+            }
+
+          for (x = 0; x < width; x++)
+            {
+              sum += cover[x];
+
+              out[x] = (sum > 0) != data->erode ? 1.0f : 0.0f;
+            }
+        }
+
+      gegl_buffer_set (data->dest_buffer,
+                       GEGL_RECTANGLE (data->dest_rect.x,
+                                       data->dest_rect.y + y - n,
+                                       width, n),
+                       0, format, rows,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+}
+
+
+/*  public functions  */
+
+/**
+ * gimp_gegl_mask_dilate:
+ * @src_buffer:       a binary mask
+ * @src_rect:         the area of @src_buffer to process
+ * @dest_buffer:      the output buffer
+ * @dest_rect:        the area of @dest_buffer to write, of the same size as
+ *                    @src_rect
+ * @half_heights:     the vertical half-extent of each column of the
+ *                    structuring element, for horizontal offsets in the
+ *                    range [0, @radius_x].  must be non-increasing.
+ * @radius_x:         the horizontal radius of the structuring element
+ * @erode:            whether to erode the mask, instead of dilating it
+ * @outside_selected: whether pixels outside of @src_rect are considered
+ *                    selected
+ *
+ * Dilates or erodes the binary mask in @src_rect, in time linear in its
+ * area, independently of the size of the structuring element.
+ **/
+void
+gimp_gegl_mask_dilate (GeglBuffer          *src_buffer,
+                       const GeglRectangle *src_rect,
+                       GeglBuffer          *dest_buffer,
+                       const GeglRectangle *dest_rect,
+                       const gint          *half_heights,
+                       gint                 radius_x,
+                       gboolean             erode,
+                       gboolean             outside_selected)
+{
+  DilateData data;
+  gint       v;
+  gint       x;
+
+  g_return_if_fail (GEGL_IS_BUFFER (src_buffer));
+  g_return_if_fail (GEGL_IS_BUFFER (dest_buffer));
+  g_return_if_fail (half_heights != NULL);
+  g_return_if_fail (radius_x >= 0);
+
+  if (! src_rect)
+    src_rect = gegl_buffer_get_extent (src_buffer);
+
+  if (! dest_rect)
+    dest_rect = src_rect;
+
+  g_return_if_fail (src_rect->width  == dest_rect->width &&
+                    src_rect->height == dest_rect->height);
+
+  if (gegl_rectangle_is_empty (src_rect))
+    return;
+
+  data.src_buffer   = src_buffer;
+  data.src_rect     = *src_rect;
+  data.dest_buffer  = dest_buffer;
+  data.dest_rect    = *dest_rect;
+  data.radius_y     = half_heights[0];
+  data.erode        = erode;
+  data.outside_seed = (! outside_selected) == erode;
+
+  /*  widths[v] is the largest horizontal offset whose column reaches v
+   *  rows.  since the first column reaches half_heights[0] rows, it's
+   *  defined for all v in [0, radius_y].
+   */
+  data.widths = g_new (gint, data.radius_y + 1);
+
+  for (v = 0, x = radius_x; v <= data.radius_y; v++)
+    {
+      while (half_heights[x] < v)
+        x--;
+
+      data.widths[v] = x;
+    }
+
+  gegl_parallel_distribute_range (
+    src_rect->height, MAX (MIN_BAND_HEIGHT, 2 * data.radius_y),
+    (GeglParallelDistributeRangeFunc) gimp_gegl_mask_dilate_band,
+    &data);
+
+  g_free (data.widths);
+}
@@ -251,3 +251,33 @@ gimp_gegl_mask_is_empty (GeglBuffer *buffer)
 
   return TRUE;
 }
+
+gboolean
+gimp_gegl_mask_is_binary (GeglBuffer          *buffer,
+                          const GeglRectangle *rect)
+{
+  GeglBufferIterator *iter;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), FALSE);
+
+  iter = gegl_buffer_iterator_new (buffer, rect, 0, babl_format ("Y float"),
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const gfloat *data = iter->items[0].data;
+      gint          i;
+
+      for (i = 0; i < iter->length; i++)
+        {
+          if (data[i] != 0.0f && data[i] != 1.0f)
+            {
+              gegl_buffer_iterator_stop (iter);
+
+              return FALSE;
+            }
+        }
+    }
+
+  return TRUE;
+}
@@ -19,12 +19,14 @@
 #define __GIMP_GEGL_MASK_H__
 
 
-gboolean   gimp_gegl_mask_bounds   (GeglBuffer *buffer,
-                                    gint        *x1,
-                                    gint        *y1,
-                                    gint        *x2,
-                                    gint        *y2);
-gboolean   gimp_gegl_mask_is_empty (GeglBuffer *buffer);
+gboolean   gimp_gegl_mask_bounds    (GeglBuffer          *buffer,
+                                     gint                *x1,
+                                     gint                *y1,
+                                     gint                *x2,
+                                     gint                *y2);
+gboolean   gimp_gegl_mask_is_empty  (GeglBuffer          *buffer);
+gboolean   gimp_gegl_mask_is_binary (GeglBuffer          *buffer,
+                                     const GeglRectangle *rect);
 
 
 #endif /* __GIMP_GEGL_MASK_H__ */
@@ -0,0 +1,402 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <zlib.h>
+
+#include <gio/gio.h>
+#include <gegl.h>
+
+#include "gimp-gegl-types.h"
+
+#include "gimptilebackendcompressed.h"
+
+
+typedef struct _CompressedTile CompressedTile;
+
+struct _CompressedTile
+{
+  gint    size;     /* the size of data, equal to the tile size if the
+                     * tile didn't compress and is stored as is
+                     */
+  guchar  data[];
+};
+
+
+struct _GimpTileBackendCompressedPrivate
+{
+  GMutex           mutex;
+
+  gint             tile_size;
+  gint             first_col;
+  gint             first_row;
+  gint             n_cols;
+  gint             n_rows;
+  CompressedTile **tiles;
+
+  gint64           memsize;
+};
+
+
+static void       gimp_tile_backend_compressed_finalize (GObject         *object);
+
+static gpointer   gimp_tile_backend_compressed_command  (GeglTileSource  *tile_store,
+                                                         GeglTileCommand  command,
+                                                         gint             x,
+                                                         gint             y,
+                                                         gint             z,
+                                                         gpointer         data);
+
+static CompressedTile ** gimp_tile_backend_compressed_lookup
+                                     (GimpTileBackendCompressed *backend,
+                                      gint                       x,
+                                      gint                       y);
+static GeglTile * gimp_tile_backend_compressed_read
+                                     (GimpTileBackendCompressed *backend,
+                                      gint                       x,
+                                      gint                       y);
+static void       gimp_tile_backend_compressed_write
+                                     (GimpTileBackendCompressed *backend,
+                                      gint                       x,
+                                      gint                       y,
+                                      GeglTile                  *tile);
+static void       gimp_tile_backend_compressed_void
+                                     (GimpTileBackendCompressed *backend,
+                                      gint                       x,
+                                      gint                       y);
+
+
+G_DEFINE_TYPE_WITH_PRIVATE (GimpTileBackendCompressed,
+                            gimp_tile_backend_compressed,
+                            GEGL_TYPE_TILE_BACKEND)
+
+#define parent_class gimp_tile_backend_compressed_parent_class
+
+
+static void
+gimp_tile_backend_compressed_class_init (GimpTileBackendCompressedClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gimp_tile_backend_compressed_finalize;
+}
+
+static void
+gimp_tile_backend_compressed_init (GimpTileBackendCompressed *backend)
+{
+  GeglTileSource *source = GEGL_TILE_SOURCE (backend);
+
+  backend->priv = gimp_tile_backend_compressed_get_instance_private (backend);
+
+  g_mutex_init (&backend->priv->mutex);
+
+  source->command = gimp_tile_backend_compressed_command;
+}
+
+static void
+gimp_tile_backend_compressed_finalize (GObject *object)
+{
+  GimpTileBackendCompressed *backend = GIMP_TILE_BACKEND_COMPRESSED (object);
+  gint                       i;
+
+  for (i = 0; i < backend->priv->n_cols * backend->priv->n_rows; i++)
+    g_free (backend->priv->tiles[i]);
+
+  g_clear_pointer (&backend->priv->tiles, g_free);
+
+  g_mutex_clear (&backend->priv->mutex);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gpointer
+gimp_tile_backend_compressed_command (GeglTileSource  *tile_store,
+                                      GeglTileCommand  command,
+                                      gint             x,
+                                      gint             y,
+                                      gint             z,
+                                      gpointer         data)
+{
+  GimpTileBackendCompressed *backend = GIMP_TILE_BACKEND_COMPRESSED (tile_store);
+  gpointer                   result  = NULL;
+
+  switch (command)
+    {
+    case GEGL_TILE_GET:
+      /*  mipmap levels are rendered from level 0 above us  */
+      if (z == 0)
+        {
+          g_mutex_lock (&backend->priv->mutex);
+
+          result = gimp_tile_backend_compressed_read (backend, x, y);
+
+          g_mutex_unlock (&backend->priv->mutex);
+        }
+      break;
+
+    case GEGL_TILE_SET:
+      if (z == 0)
+        {
+          g_mutex_lock (&backend->priv->mutex);
+
+          gimp_tile_backend_compressed_write (backend, x, y, data);
+
+          g_mutex_unlock (&backend->priv->mutex);
+        }
+
+      gegl_tile_mark_as_stored (data);
+      break;
+
+    case GEGL_TILE_VOID:
+      if (z == 0)
+        {
+          g_mutex_lock (&backend->priv->mutex);
+
+          gimp_tile_backend_compressed_void (backend, x, y);
+
+          g_mutex_unlock (&backend->priv->mutex);
+        }
+      break;
+
+    case GEGL_TILE_EXIST:
+      if (z == 0)
+        {
+          CompressedTile **tile;
+
+          g_mutex_lock (&backend->priv->mutex);
+
+          tile = gimp_tile_backend_compressed_lookup (backend, x, y);
+
+          result = GINT_TO_POINTER (tile && *tile);
+
+          g_mutex_unlock (&backend->priv->mutex);
+        }
+      break;
+
+    case GEGL_TILE_FLUSH:
+      break;
+
+    default:
+      result = gegl_tile_backend_command (GEGL_TILE_BACKEND (tile_store),
+                                          command, x, y, z, data);
+      break;
+    }
+
+  return result;
+}
+
+static CompressedTile **
+gimp_tile_backend_compressed_lookup (GimpTileBackendCompressed *backend,
+                                     gint                       x,
+                                     gint                       y)
+{
+  GimpTileBackendCompressedPrivate *priv = backend->priv;
+
+  x -= priv->first_col;
+  y -= priv->first_row;
+
+  if (x < 0 || x >= priv->n_cols ||
+      y < 0 || y >= priv->n_rows)
+    {
+      return NULL;
+    }
+
+  return &priv->tiles[y * priv->n_cols + x];
+}
+
+static GeglTile *
+gimp_tile_backend_compressed_read (GimpTileBackendCompressed *backend,
+                                   gint                       x,
+                                   gint                       y)
+{
+  GimpTileBackendCompressedPrivate  *priv = backend->priv;
+  CompressedTile                   **compressed;
+  GeglTile                          *tile;
+  guchar                            *tile_data;
+  uLongf                             length;
+
+  compressed = gimp_tile_backend_compressed_lookup (backend, x, y);
+
+  if (! compressed || ! *compressed)
+    return NULL;
+
+  tile      = gegl_tile_new (priv->tile_size);
+  tile_data = gegl_tile_get_data (tile);
+
+  if ((*compressed)->size == priv->tile_size)
+    {
+      memcpy (tile_data, (*compressed)->data, priv->tile_size);
+    }
+  else
+    {
+      length = priv->tile_size;
+
+      if (uncompress (tile_data, &length,
+                      (*compressed)->data, (*compressed)->size) != Z_OK ||
+          length != priv->tile_size)
+        {
+          g_warning ("%s: failed to decompress tile (%d, %d)",
+                     G_STRFUNC, x, y);
+
+          memset (tile_data, 0, priv->tile_size);
+        }
+    }
+
+  return tile;
+}
+
+static void
+gimp_tile_backend_compressed_write (GimpTileBackendCompressed *backend,
+                                    gint                       x,
+                                    gint                       y,
+                                    GeglTile                  *tile)
+{
+  GimpTileBackendCompressedPrivate  *priv = backend->priv;
+  CompressedTile                   **compressed;
+  CompressedTile                    *new_compressed;
+  guchar                            *buf;
+  uLongf                             length;
+
+  compressed = gimp_tile_backend_compressed_lookup (backend, x, y);
+
+  if (! compressed)
+    return;
+
+  length = compressBound (priv->tile_size);
+  buf    = g_malloc (length);
+
+  if (compress2 (buf, &length,
+                 gegl_tile_get_data (tile), priv->tile_size,
+                 Z_BEST_SPEED) != Z_OK ||
+      length >= priv->tile_size)
+    {
+      /*  store tiles that don't compress as they are  */
+      length = priv->tile_size;
+
+      memcpy (buf, gegl_tile_get_data (tile), length);
+    }
+
+  new_compressed = g_malloc (sizeof (CompressedTile) + length);
+
+  new_compressed->size = length;
+  memcpy (new_compressed->data, buf, length);
+
+  g_free (buf);
+
+  gimp_tile_backend_compressed_void (backend, x, y);
+
+  *compressed = new_compressed;
+
+  priv->memsize += sizeof (CompressedTile) + length;
+}
+
+static void
+gimp_tile_backend_compressed_void (GimpTileBackendCompressed *backend,
+                                   gint                       x,
+                                   gint                       y)
+{
+  GimpTileBackendCompressedPrivate  *priv = backend->priv;
+  CompressedTile                   **compressed;
+
+  compressed = gimp_tile_backend_compressed_lookup (backend, x, y);
+
+  if (compressed && *compressed)
+    {
+      priv->memsize -= sizeof (CompressedTile) + (*compressed)->size;
+
+      g_clear_pointer (compressed, g_free);
+    }
+}
+
+
+/*  public functions  */
+
+GeglTileBackend *
+gimp_tile_backend_compressed_new (const GeglRectangle *extent,
+                                  gint                 tile_width,
+                                  gint                 tile_height,
+                                  const Babl          *format)
+{
+  GeglTileBackend           *backend;
+  GimpTileBackendCompressed *backend_compressed;
+  gint                       last_col;
+  gint                       last_row;
+
+  g_return_val_if_fail (extent != NULL, NULL);
+  g_return_val_if_fail (tile_width > 0 && tile_height > 0, NULL);
+  g_return_val_if_fail (format != NULL, NULL);
+
+  backend = g_object_new (GIMP_TYPE_TILE_BACKEND_COMPRESSED,
+                          "tile-width",  tile_width,
+                          "tile-height", tile_height,
+                          "format",      format,
+                          NULL);
+
+  backend_compressed = GIMP_TILE_BACKEND_COMPRESSED (backend);
+
+  backend_compressed->priv->tile_size =
+    gegl_tile_backend_get_tile_size (backend);
+
+  if (! gegl_rectangle_is_empty (extent))
+    {
+      backend_compressed->priv->first_col =
+        (gint) floor ((gdouble) extent->x / tile_width);
+      backend_compressed->priv->first_row =
+        (gint) floor ((gdouble) extent->y / tile_height);
+
+      last_col = (gint) floor ((gdouble) (extent->x + extent->width  - 1) /
+                               tile_width);
+      last_row = (gint) floor ((gdouble) (extent->y + extent->height - 1) /
+                               tile_height);
+
+      backend_compressed->priv->n_cols =
+        last_col - backend_compressed->priv->first_col + 1;
+      backend_compressed->priv->n_rows =
+        last_row - backend_compressed->priv->first_row + 1;
+
+      backend_compressed->priv->tiles =
+        g_new0 (CompressedTile *,
+                backend_compressed->priv->n_cols *
+                backend_compressed->priv->n_rows);
+    }
+
+  gegl_tile_backend_set_extent (backend, extent);
+
+  return backend;
+}
+
+gint64
+gimp_tile_backend_compressed_get_memsize (GimpTileBackendCompressed *backend)
+{
+  gint64 memsize;
+
+  g_return_val_if_fail (GIMP_IS_TILE_BACKEND_COMPRESSED (backend), 0);
+
+  g_mutex_lock (&backend->priv->mutex);
+
+  memsize = backend->priv->memsize +
+            backend->priv->n_cols * backend->priv->n_rows *
+            sizeof (CompressedTile *);
+
+  g_mutex_unlock (&backend->priv->mutex);
+
+  return memsize;
+}
@@ -0,0 +1,66 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_TILE_BACKEND_COMPRESSED_H__
+#define __GIMP_TILE_BACKEND_COMPRESSED_H__
+
+
+#include <gegl-buffer-backend.h>
+
+
+/***
+ * GimpTileBackendCompressed is a GeglTileBackend that keeps its tiles
+ * zlib-compressed in memory, and decompresses them one by one when
+ * they are read.
+ */
+
+#define GIMP_TYPE_TILE_BACKEND_COMPRESSED            (gimp_tile_backend_compressed_get_type ())
+#define GIMP_TILE_BACKEND_COMPRESSED(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_TILE_BACKEND_COMPRESSED, GimpTileBackendCompressed))
+#define GIMP_TILE_BACKEND_COMPRESSED_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GIMP_TYPE_TILE_BACKEND_COMPRESSED, GimpTileBackendCompressedClass))
+#define GIMP_IS_TILE_BACKEND_COMPRESSED(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_TILE_BACKEND_COMPRESSED))
+#define GIMP_IS_TILE_BACKEND_COMPRESSED_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GIMP_TYPE_TILE_BACKEND_COMPRESSED))
+#define GIMP_TILE_BACKEND_COMPRESSED_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GIMP_TYPE_TILE_BACKEND_COMPRESSED, GimpTileBackendCompressedClass))
+
+
+typedef struct _GimpTileBackendCompressed        GimpTileBackendCompressed;
+typedef struct _GimpTileBackendCompressedClass   GimpTileBackendCompressedClass;
+typedef struct _GimpTileBackendCompressedPrivate GimpTileBackendCompressedPrivate;
+
+struct _GimpTileBackendCompressed
+{
+  GeglTileBackend                   parent_instance;
+
+  GimpTileBackendCompressedPrivate *priv;
+};
+
+struct _GimpTileBackendCompressedClass
+{
+  GeglTileBackendClass  parent_class;
+};
+
+
+GType             gimp_tile_backend_compressed_get_type    (void) G_GNUC_CONST;
+
+GeglTileBackend * gimp_tile_backend_compressed_new         (const GeglRectangle       *extent,
+                                                            gint                       tile_width,
+                                                            gint                       tile_height,
+                                                            const Babl                *format);
+
+gint64            gimp_tile_backend_compressed_get_memsize (GimpTileBackendCompressed *backend);
+
+
+#endif /* __GIMP_TILE_BACKEND_COMPRESSED_H__ */
@@ -48,6 +48,17 @@ enum
 };
 
 
+typedef struct
+{
+  GeglBuffer              *buffer;
+  const Babl              *format;
+  gint                     bpp;
+  const GeglRectangle     *rects;
+  guchar                 **bufs;
+  gint                     n_rects;
+} ValidateRectsData;
+
+
 static void     gimp_tile_handler_validate_finalize             (GObject         *object);
 static void     gimp_tile_handler_validate_set_property         (GObject         *object,
                                                                  guint            property_id,
@@ -69,6 +80,13 @@ static void     gimp_tile_handler_validate_real_validate_buffer (GimpTileHandler
                                                                  const GeglRectangle     *rect,
                                                                  GeglBuffer              *buffer);
 
+static void     gimp_tile_handler_validate_mark_dirty           (GimpTileHandlerValidate *validate,
+                                                                 const GeglRectangle     *rect);
+
+static void     gimp_tile_handler_validate_validate_rects_func  (gint                     i,
+                                                                 gint                     n,
+                                                                 ValidateRectsData       *data);
+
 static gpointer gimp_tile_handler_validate_command              (GeglTileSource  *source,
                                                                  GeglTileCommand  command,
                                                                  gint             x,
@@ -146,10 +164,14 @@ static void
 gimp_tile_handler_validate_finalize (GObject *object)
 {
   GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (object);
+  gint                     i;
 
   g_clear_object (&validate->graph);
   g_clear_pointer (&validate->dirty_region, cairo_region_destroy);
 
+  for (i = 0; i < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL; i++)
+    g_clear_pointer (&validate->level_valid_region[i], cairo_region_destroy);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -271,6 +293,43 @@ gimp_tile_handler_validate_real_validate_buffer (GimpTileHandlerValidate *valida
     }
 }
 
+static void
+gimp_tile_handler_validate_mark_dirty (GimpTileHandlerValidate *validate,
+                                       const GeglRectangle     *rect)
+{
+  gint i;
+
+  cairo_region_union_rectangle (validate->dirty_region,
+                                (cairo_rectangle_int_t *) rect);
+
+  for (i = 0; i < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL; i++)
+    {
+      if (validate->level_valid_region[i])
+        {
+          cairo_region_subtract_rectangle (validate->level_valid_region[i],
+                                           (cairo_rectangle_int_t *) rect);
+        }
+    }
+
+  gegl_tile_handler_damage_rect (GEGL_TILE_HANDLER (validate), rect);
+}
+
+static void
+gimp_tile_handler_validate_validate_rects_func (gint               i,
+                                                gint               n,
+                                                ValidateRectsData *data)
+{
+  gint j;
+
+  for (j = i; j < data->n_rects; j += n)
+    {
+      const GeglRectangle *rect = &data->rects[j];
+
+      gegl_buffer_set (data->buffer, rect, 0, data->format,
+                       data->bufs[j], rect->width * data->bpp);
+    }
+}
+
 static GeglTile *
 gimp_tile_handler_validate_validate_tile (GeglTileSource *source,
                                           gint            x,
@@ -408,6 +467,84 @@ gimp_tile_handler_validate_validate_tile (GeglTileSource *source,
   return tile;
 }
 
+static GeglTile *
+gimp_tile_handler_validate_validate_level_tile (GeglTileSource *source,
+                                                gint            x,
+                                                gint            y,
+                                                gint            z)
+{
+  GimpTileHandlerValidate  *validate = GIMP_TILE_HANDLER_VALIDATE (source);
+  cairo_region_t          **valid_region;
+  GeglTile                 *tile;
+  cairo_rectangle_int_t     footprint;
+  gint                      tile_bpp;
+  gint                      tile_stride;
+
+  /*  mipmap tiles are normally built by gegl from the level below, which
+   *  validates the entire footprint of the tile at full resolution.  when
+   *  the footprint is dirty, render the graph at the tile's level directly
+   *  instead, and remember that we did, until the footprint is invalidated
+   *  again.  this is only possible when the tiles are rendered from the
+   *  graph, and not by a subclass.
+   */
+  if (validate->suspend_validate                             ||
+      cairo_region_is_empty (validate->dirty_region)            ||
+      GIMP_TILE_HANDLER_VALIDATE_GET_CLASS (validate)->validate !=
+      gimp_tile_handler_validate_real_validate)
+    {
+      return gegl_tile_handler_source_command (source,
+                                               GEGL_TILE_GET, x, y, z, NULL);
+    }
+
+  footprint.width  = validate->tile_width  << z;
+  footprint.height = validate->tile_height << z;
+  footprint.x      = x * footprint.width;
+  footprint.y      = y * footprint.height;
+
+  valid_region = &validate->level_valid_region[z - 1];
+
+  if (cairo_region_contains_rectangle (validate->dirty_region,
+                                       &footprint) ==
+      CAIRO_REGION_OVERLAP_OUT ||
+      (*valid_region &&
+       cairo_region_contains_rectangle (*valid_region, &footprint) ==
+       CAIRO_REGION_OVERLAP_IN))
+    {
+      return gegl_tile_handler_source_command (source,
+                                               GEGL_TILE_GET, x, y, z, NULL);
+    }
+
+  if (*valid_region)
+    cairo_region_union_rectangle (*valid_region, &footprint);
+  else
+    *valid_region = cairo_region_create_rectangle (&footprint);
+
+  tile_bpp    = babl_format_get_bytes_per_pixel (validate->format);
+  tile_stride = tile_bpp * validate->tile_width;
+
+  tile = gegl_tile_handler_get_source_tile (GEGL_TILE_HANDLER (source),
+                                            x, y, z, FALSE);
+
+  gimp_tile_handler_validate_begin_validate (validate);
+
+  gegl_tile_lock (tile);
+
+  gegl_node_blit (validate->graph, 1.0 / (1 << z),
+                  GEGL_RECTANGLE (x * validate->tile_width,
+                                  y * validate->tile_height,
+                                  validate->tile_width,
+                                  validate->tile_height),
+                  validate->format,
+                  gegl_tile_get_data (tile), tile_stride,
+                  GEGL_BLIT_DEFAULT);
+
+  gegl_tile_unlock (tile);
+
+  gimp_tile_handler_validate_end_validate (validate);
+
+  return tile;
+}
+
 static gpointer
 gimp_tile_handler_validate_command (GeglTileSource  *source,
                                     GeglTileCommand  command,
@@ -416,8 +553,13 @@ gimp_tile_handler_validate_command (GeglTileSource  *source,
                                     gint             z,
                                     gpointer         data)
 {
-  if (command == GEGL_TILE_GET && z == 0)
-    return gimp_tile_handler_validate_validate_tile (source, x, y);
+  if (command == GEGL_TILE_GET)
+    {
+      if (z == 0)
+        return gimp_tile_handler_validate_validate_tile (source, x, y);
+      else if (z <= GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL)
+        return gimp_tile_handler_validate_validate_level_tile (source, x, y, z);
+    }
 
   return gegl_tile_handler_source_command (source, command, x, y, z, data);
 }
@@ -489,10 +631,7 @@ gimp_tile_handler_validate_invalidate (GimpTileHandlerValidate *validate,
   g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
   g_return_if_fail (rect != NULL);
 
-  cairo_region_union_rectangle (validate->dirty_region,
-                                (cairo_rectangle_int_t *) rect);
-
-  gegl_tile_handler_damage_rect (GEGL_TILE_HANDLER (validate), rect);
+  gimp_tile_handler_validate_mark_dirty (validate, rect);
 
   g_signal_emit (validate, gimp_tile_handler_validate_signals[INVALIDATED],
                  0, rect, NULL);
@@ -623,6 +762,158 @@ gimp_tile_handler_validate_validate (GimpTileHandlerValidate *validate,
     }
 }
 
+void
+gimp_tile_handler_validate_validate_rects (GimpTileHandlerValidate *validate,
+                                           GeglBuffer              *buffer,
+                                           const GeglRectangle     *rects,
+                                           gint                     n_rects)
+{
+  GimpTileHandlerValidateClass *klass;
+  gint                          i;
+
+  g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
+  g_return_if_fail (gimp_tile_handler_validate_get_assigned (buffer) ==
+                    validate);
+  g_return_if_fail (rects != NULL || n_rects == 0);
+
+  if (n_rects <= 0)
+    return;
+
+  klass = GIMP_TILE_HANDLER_VALIDATE_GET_CLASS (validate);
+
+  gimp_tile_handler_validate_begin_validate (validate);
+
+  if (n_rects == 1 ||
+      klass->validate_buffer !=
+      gimp_tile_handler_validate_real_validate_buffer)
+    {
+      for (i = 0; i < n_rects; i++)
+        klass->validate_buffer (validate, &rects[i], buffer);
+    }
+  else
+    {
+      ValidateRectsData data;
+
+      data.buffer  = buffer;
+      data.format  = gegl_buffer_get_format (buffer);
+      data.bpp     = babl_format_get_bytes_per_pixel (data.format);
+      data.rects   = rects;
+      data.bufs    = g_new (guchar *, n_rects);
+      data.n_rects = n_rects;
+
+      /* the graph can only be processed by one thread at a time, so render
+       * the rects here, where GEGL can use its own threads for each of
+       * them, and only write the results to the buffer in parallel.
+       */
+      for (i = 0; i < n_rects; i++)
+        {
+          gint stride = rects[i].width * data.bpp;
+
+          data.bufs[i] = g_malloc ((gsize) stride * rects[i].height);
+
+          klass->validate (validate, &rects[i], data.format,
+                           data.bufs[i], stride);
+        }
+
+      gegl_parallel_distribute (
+        n_rects,
+        (GeglParallelDistributeFunc) gimp_tile_handler_validate_validate_rects_func,
+        &data);
+
+      for (i = 0; i < n_rects; i++)
+        g_free (data.bufs[i]);
+
+      g_free (data.bufs);
+    }
+
+  gimp_tile_handler_validate_end_validate (validate);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_region_subtract_rectangle (
+        validate->dirty_region,
+        (const cairo_rectangle_int_t *) &rects[i]);
+    }
+}
+
+void
+gimp_tile_handler_validate_validate_level (GimpTileHandlerValidate *validate,
+                                           GeglBuffer              *buffer,
+                                           const GeglRectangle     *rect,
+                                           gint                     level)
+{
+  GeglBufferIterator *iter;
+  GeglRectangle       level_rect;
+  cairo_region_t     *region;
+  gint                n_rects;
+  gint                suspend_validate;
+  gint                i;
+
+  g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
+  g_return_if_fail (gimp_tile_handler_validate_get_assigned (buffer) ==
+                    validate);
+  g_return_if_fail (level >= 0 &&
+                    level <= GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL);
+
+  if (! rect)
+    rect = gegl_buffer_get_extent (buffer);
+
+  if (level == 0)
+    {
+      gimp_tile_handler_validate_validate (validate, buffer, rect,
+                                           FALSE, FALSE);
+
+      return;
+    }
+
+  level_rect.x      = rect->x >> level;
+  level_rect.y      = rect->y >> level;
+  level_rect.width  = ((rect->x + rect->width  + (1 << level) - 1) >> level) -
+                      level_rect.x;
+  level_rect.height = ((rect->y + rect->height + (1 << level) - 1) >> level) -
+                      level_rect.y;
+
+  /*  the rect is only rendered at @level, so its invalid parts stay dirty
+   *  at the finer levels, while its valid parts stay valid.  this isn't a
+   *  change of the graph's output, so don't emit "invalidated", whose
+   *  handlers would queue the rect for rendering again.
+   */
+  region = cairo_region_create_rectangle ((const cairo_rectangle_int_t *) rect);
+
+  cairo_region_intersect (region, validate->dirty_region);
+
+  n_rects = cairo_region_num_rectangles (region);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t dirty_rect;
+
+      cairo_region_get_rectangle (region, i, &dirty_rect);
+
+      gimp_tile_handler_validate_mark_dirty (validate,
+                                             (const GeglRectangle *) &dirty_rect);
+    }
+
+  cairo_region_destroy (region);
+
+  /*  merely fetching the tiles of the level validates them, see
+   *  gimp_tile_handler_validate_validate_level_tile().  the caller may
+   *  have suspended validation using
+   *  gimp_tile_handler_validate_begin_validate(), so lift the suspension
+   *  while fetching them.
+   */
+  suspend_validate           = validate->suspend_validate;
+  validate->suspend_validate = 0;
+
+  iter = gegl_buffer_iterator_new (buffer, &level_rect, level,
+                                   validate->format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter));
+
+  validate->suspend_validate = suspend_validate;
+}
+
 gboolean
 gimp_tile_handler_validate_buffer_set_extent (GeglBuffer          *buffer,
                                               const GeglRectangle *extent)
@@ -27,6 +27,9 @@
 
 G_BEGIN_DECLS
 
+/*  the highest mipmap level the graph may be rendered at directly  */
+#define GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL 8
+
 #define GIMP_TYPE_TILE_HANDLER_VALIDATE            (gimp_tile_handler_validate_get_type ())
 #define GIMP_TILE_HANDLER_VALIDATE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_TILE_HANDLER_VALIDATE, GimpTileHandlerValidate))
 #define GIMP_TILE_HANDLER_VALIDATE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GIMP_TYPE_TILE_HANDLER_VALIDATE, GimpTileHandlerValidateClass))
@@ -44,6 +47,7 @@ struct _GimpTileHandlerValidate
 
   GeglNode        *graph;
   cairo_region_t  *dirty_region;
+  cairo_region_t  *level_valid_region[GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL];
   const Babl      *format;
   gint             tile_width;
   gint             tile_height;
@@ -97,6 +101,14 @@ void                      gimp_tile_handler_validate_validate          (GimpTile
                                                                         const GeglRectangle     *rect,
                                                                         gboolean                 intersect,
                                                                         gboolean                 chunked);
+void                      gimp_tile_handler_validate_validate_rects    (GimpTileHandlerValidate *validate,
+                                                                        GeglBuffer              *buffer,
+                                                                        const GeglRectangle     *rects,
+                                                                        gint                     n_rects);
+void                      gimp_tile_handler_validate_validate_level    (GimpTileHandlerValidate *validate,
+                                                                        GeglBuffer              *buffer,
+                                                                        const GeglRectangle     *rect,
+                                                                        gint                     level);
 
 gboolean                  gimp_tile_handler_validate_buffer_set_extent (GeglBuffer              *buffer,
                                                                         const GeglRectangle     *extent);
@@ -30,6 +30,7 @@
 
 
 static GHashTable *class_hash = NULL;
+static GMutex      class_hash_mutex;
 
 
 void
@@ -54,6 +55,11 @@ gimp_debug_add_instance (GObject      *instance,
 
       type_name = g_type_name (G_TYPE_FROM_CLASS (klass));
 
+      /*  objects can be created by worker threads, e.g. when data
+       *  files are loaded in parallel
+       */
+      g_mutex_lock (&class_hash_mutex);
+
       instance_hash = g_hash_table_lookup (class_hash, type_name);
 
       if (! instance_hash)
@@ -64,6 +70,8 @@ gimp_debug_add_instance (GObject      *instance,
         }
 
       g_hash_table_insert (instance_hash, instance, instance);
+
+      g_mutex_unlock (&class_hash_mutex);
     }
 }
 
@@ -77,6 +85,8 @@ gimp_debug_remove_instance (GObject *instance)
 
       type_name = g_type_name (G_OBJECT_TYPE (instance));
 
+      g_mutex_lock (&class_hash_mutex);
+
       instance_hash = g_hash_table_lookup (class_hash, type_name);
 
       if (instance_hash)
@@ -86,6 +96,8 @@ gimp_debug_remove_instance (GObject *instance)
           if (g_hash_table_size (instance_hash) == 0)
             g_hash_table_remove (class_hash, type_name);
         }
+
+      g_mutex_unlock (&class_hash_mutex);
     }
 }
 
@@ -29,6 +29,9 @@
 
 #include "operations-types.h"
 
+#include "gegl/gimp-gegl-mask.h"
+#include "gegl/gimp-gegl-mask-dilate.h"
+
 #include "gimpoperationgrow.h"
 
 
@@ -247,6 +250,29 @@ gimp_operation_grow_process (GeglOperation       *operation,
   gint16             last_index;
   gfloat            *buffer;
 
+  if (gimp_gegl_mask_is_binary (input, roi))
+    {
+      /* binary masks are dilated exactly, in linear time and in parallel;
+       * the scanline code below is only used for antialiased masks
+       */
+      gint *half_heights = g_new (gint, self->radius_x + 1);
+
+      circ = g_new (gint16, 2 * self->radius_x + 1);
+      compute_border (circ, self->radius_x, self->radius_y);
+
+      for (i = 0; i <= self->radius_x; i++)
+        half_heights[i] = circ[self->radius_x + i];
+
+      gimp_gegl_mask_dilate (input, roi, output, roi,
+                             half_heights, self->radius_x,
+                             FALSE, FALSE);
+
+      g_free (half_heights);
+      g_free (circ);
+
+      return TRUE;
+    }
+
   max = g_new (gfloat *, roi->width + 2 * self->radius_x);
   buf = g_new (gfloat *, self->radius_y + 1);
 
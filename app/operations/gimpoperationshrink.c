@@ -29,6 +29,9 @@
 
 #include "operations-types.h"
 
+#include "gegl/gimp-gegl-mask.h"
+#include "gegl/gimp-gegl-mask-dilate.h"
+
 #include "gimpoperationshrink.h"
 
 
@@ -269,6 +272,29 @@ gimp_operation_shrink_process (GeglOperation       *operation,
   gfloat              *buffer;
   gint                 buffer_size;
 
+  if (gimp_gegl_mask_is_binary (input, roi))
+    {
+      /* binary masks are eroded exactly, in linear time and in parallel;
+       * the scanline code below is only used for antialiased masks
+       */
+      gint *half_heights = g_new (gint, self->radius_x + 1);
+
+      circ = g_new (gint16, 2 * self->radius_x + 1);
+      compute_border (circ, self->radius_x, self->radius_y);
+
+      for (i = 0; i <= self->radius_x; i++)
+        half_heights[i] = circ[self->radius_x + i];
+
+      gimp_gegl_mask_dilate (input, roi, output, roi,
+                             half_heights, self->radius_x,
+                             TRUE, self->edge_lock);
+
+      g_free (half_heights);
+      g_free (circ);
+
+      return TRUE;
+    }
+
   max = g_new (gfloat *, roi->width + 2 * self->radius_x);
   buf = g_new (gfloat *, self->radius_y + 1);
 
@@ -44,6 +44,149 @@ extern "C"
 
 #define EPSILON 1e-6
 
+/*  the number of transformed brush masks whose subsampled or solidified
+ *  masks are kept, in addition to the current one, and the total size
+ *  of the kept masks, including the transformed ones
+ */
+#define MAX_SAVED_CACHES     64
+#define MAX_SAVED_CACHE_SIZE (32 * 1024 * 1024)
+
+
+struct SavedCache
+{
+  const GimpTempBuf  *mask;
+  GimpTempBuf       **brushes;
+  gsize               memsize;
+};
+
+
+static void
+saved_cache_free (SavedCache *cache,
+                  gint        n_brushes)
+{
+  gint i;
+
+  for (i = 0; i < n_brushes; i++)
+    {
+      if (cache->brushes[i])
+        gimp_temp_buf_unref (cache->brushes[i]);
+    }
+
+  gimp_temp_buf_unref (cache->mask);
+
+  g_free (cache->brushes);
+  g_slice_free (SavedCache, cache);
+}
+
+static void
+clear_cache (GQueue             *saved_caches,
+             GimpTempBuf       **brushes,
+             gint                n_brushes,
+             const GimpTempBuf **last_mask)
+{
+  SavedCache *cache;
+  gint        i;
+
+  while ((cache = (SavedCache *) g_queue_pop_head (saved_caches)))
+    saved_cache_free (cache, n_brushes);
+
+  for (i = 0; i < n_brushes; i++)
+    g_clear_pointer (&brushes[i], gimp_temp_buf_unref);
+
+  g_clear_pointer (last_mask, gimp_temp_buf_unref);
+}
+
+/*  makes the derived masks of @mask current, saving the ones of the
+ *  current mask.  when painting with symmetry, each stroke uses a
+ *  different transformed mask, and would otherwise throw away the
+ *  derived masks of the others on each dab.
+ *
+ *  the saved masks keep a reference to their transformed mask, so that
+ *  it can't be freed, and its address reused by another mask.
+ */
+static void
+switch_cache (GQueue             *saved_caches,
+              GimpTempBuf       **brushes,
+              gint                n_brushes,
+              const GimpTempBuf **last_mask,
+              const GimpTempBuf  *mask)
+{
+  SavedCache *cache = NULL;
+  GList      *iter;
+  gsize       memsize;
+  gint        n;
+  gint        i;
+
+  if (*last_mask)
+    {
+      cache = g_slice_new (SavedCache);
+
+      cache->mask    = *last_mask;
+      cache->brushes = (GimpTempBuf **) g_memdup2 (brushes,
+                                                   n_brushes *
+                                                   sizeof (GimpTempBuf *));
+      cache->memsize = gimp_temp_buf_get_memsize (cache->mask);
+
+      for (i = 0; i < n_brushes; i++)
+        {
+          if (brushes[i])
+            cache->memsize += gimp_temp_buf_get_memsize (brushes[i]);
+        }
+
+      g_queue_push_head (saved_caches, cache);
+
+      cache = NULL;
+    }
+
+  for (iter = saved_caches->head; iter; iter = g_list_next (iter))
+    {
+      if (((SavedCache *) iter->data)->mask == mask)
+        {
+          cache = (SavedCache *) iter->data;
+
+          g_queue_delete_link (saved_caches, iter);
+
+          break;
+        }
+    }
+
+  if (cache)
+    {
+      memcpy (brushes, cache->brushes, n_brushes * sizeof (GimpTempBuf *));
+      *last_mask = cache->mask;
+
+      g_free (cache->brushes);
+      g_slice_free (SavedCache, cache);
+    }
+  else
+    {
+      memset (brushes, 0, n_brushes * sizeof (GimpTempBuf *));
+      *last_mask = gimp_temp_buf_ref (mask);
+    }
+
+  /*  evict the least recently used masks  */
+  memsize = 0;
+  n       = 0;
+
+  for (iter = saved_caches->head; iter; iter = g_list_next (iter))
+    {
+      memsize += ((SavedCache *) iter->data)->memsize;
+      n++;
+
+      if (n > MAX_SAVED_CACHES || memsize > MAX_SAVED_CACHE_SIZE)
+        break;
+    }
+
+  while (iter)
+    {
+      GList *next = g_list_next (iter);
+
+      saved_cache_free ((SavedCache *) iter->data, n_brushes);
+      g_queue_delete_link (saved_caches, iter);
+
+      iter = next;
+    }
+}
 
 static void
 clear_edges (GimpTempBuf *buf,
@@ -267,14 +410,24 @@ gimp_brush_core_subsample_mask (GimpBrushCore     *core,
     }
   else
     {
-      gint i, j;
+      if (core->subsample_cache_invalid)
+        {
+          clear_cache (&core->saved_subsample_caches,
+                       &core->subsample_brushes[0][0],
+                       SQR (KERNEL_SUBSAMPLE + 1),
+                       &core->last_subsample_brush_mask);
 
-      for (i = 0; i < KERNEL_SUBSAMPLE + 1; i++)
-        for (j = 0; j < KERNEL_SUBSAMPLE + 1; j++)
-          g_clear_pointer (&core->subsample_brushes[i][j], gimp_temp_buf_unref);
+          core->subsample_cache_invalid = FALSE;
+        }
+
+      switch_cache (&core->saved_subsample_caches,
+                    &core->subsample_brushes[0][0],
+                    SQR (KERNEL_SUBSAMPLE + 1),
+                    &core->last_subsample_brush_mask,
+                    mask);
 
-      core->last_subsample_brush_mask = mask;
-      core->subsample_cache_invalid   = FALSE;
+      if (core->subsample_brushes[index2][index1])
+        return core->subsample_brushes[index2][index1];
     }
 
   mask_format = gimp_temp_buf_get_format (mask);
@@ -607,14 +760,24 @@ gimp_brush_core_solidify_mask (GimpBrushCore     *core,
     }
   else
     {
-      gint i, j;
+      if (core->solid_cache_invalid)
+        {
+          clear_cache (&core->saved_solid_caches,
+                       &core->solid_brushes[0][0],
+                       SQR (BRUSH_CORE_SOLID_SUBSAMPLE),
+                       &core->last_solid_brush_mask);
+
+          core->solid_cache_invalid = FALSE;
+        }
 
-      for (i = 0; i < BRUSH_CORE_SOLID_SUBSAMPLE; i++)
-        for (j = 0; j < BRUSH_CORE_SOLID_SUBSAMPLE; j++)
-          g_clear_pointer (&core->solid_brushes[i][j], gimp_temp_buf_unref);
+      switch_cache (&core->saved_solid_caches,
+                    &core->solid_brushes[0][0],
+                    SQR (BRUSH_CORE_SOLID_SUBSAMPLE),
+                    &core->last_solid_brush_mask,
+                    brush_mask);
 
-      core->last_solid_brush_mask = brush_mask;
-      core->solid_cache_invalid   = FALSE;
+      if (core->solid_brushes[dest_offset_y][dest_offset_x])
+        return core->solid_brushes[dest_offset_y][dest_offset_x];
     }
 
   brush_mask_format = gimp_temp_buf_get_format (brush_mask);
@@ -645,3 +808,17 @@ gimp_brush_core_solidify_mask (GimpBrushCore     *core,
 
   return dest;
 }
+
+void
+gimp_brush_core_clear_mask_caches (GimpBrushCore *core)
+{
+  clear_cache (&core->saved_subsample_caches,
+               &core->subsample_brushes[0][0],
+               SQR (KERNEL_SUBSAMPLE + 1),
+               &core->last_subsample_brush_mask);
+
+  clear_cache (&core->saved_solid_caches,
+               &core->solid_brushes[0][0],
+               SQR (BRUSH_CORE_SOLID_SUBSAMPLE),
+               &core->last_solid_brush_mask);
+}
@@ -33,5 +33,7 @@ const GimpTempBuf * gimp_brush_core_solidify_mask   (GimpBrushCore     *core,
                                                      gdouble            x,
                                                      gdouble            y);
 
+void          gimp_brush_core_clear_mask_caches     (GimpBrushCore     *core);
+
 
 #endif  /*  __GIMP_BRUSH_CORE_LOOPS_H__  */
@@ -179,12 +179,14 @@ gimp_brush_core_init (GimpBrushCore *core)
 
   core->last_solid_brush_mask        = NULL;
   core->solid_cache_invalid          = FALSE;
+  g_queue_init (&core->saved_solid_caches);
 
   core->transform_brush              = NULL;
   core->transform_pixmap             = NULL;
 
   core->last_subsample_brush_mask    = NULL;
   core->subsample_cache_invalid      = FALSE;
+  g_queue_init (&core->saved_subsample_caches);
 
   core->rand                         = g_rand_new ();
 
@@ -219,20 +221,13 @@ static void
 gimp_brush_core_finalize (GObject *object)
 {
   GimpBrushCore *core = GIMP_BRUSH_CORE (object);
-  gint           i, j;
 
   g_clear_pointer (&core->pressure_brush, gimp_temp_buf_unref);
 
-  for (i = 0; i < BRUSH_CORE_SOLID_SUBSAMPLE; i++)
-    for (j = 0; j < BRUSH_CORE_SOLID_SUBSAMPLE; j++)
-      g_clear_pointer (&core->solid_brushes[i][j], gimp_temp_buf_unref);
+  gimp_brush_core_clear_mask_caches (core);
 
   g_clear_pointer (&core->rand, g_rand_free);
 
-  for (i = 0; i < KERNEL_SUBSAMPLE + 1; i++)
-    for (j = 0; j < KERNEL_SUBSAMPLE + 1; j++)
-      g_clear_pointer (&core->subsample_brushes[i][j], gimp_temp_buf_unref);
-
   if (core->main_brush)
     {
       g_signal_handlers_disconnect_by_func (core->main_brush,
@@ -1085,9 +1080,7 @@ gimp_brush_core_transform_mask (GimpBrushCore *core,
   if (mask == core->transform_brush)
     return mask;
 
-  core->transform_brush         = mask;
-  core->subsample_cache_invalid = TRUE;
-  core->solid_cache_invalid     = TRUE;
+  core->transform_brush = mask;
 
   return core->transform_brush;
 }
@@ -1151,8 +1144,7 @@ gimp_brush_core_get_brush_pixmap (GimpBrushCore *core)
   if (pixmap == core->transform_pixmap)
     return pixmap;
 
-  core->transform_pixmap        = pixmap;
-  core->subsample_cache_invalid = TRUE;
+  core->transform_pixmap = pixmap;
 
   return core->transform_pixmap;
 }
@@ -60,6 +60,7 @@ struct _GimpBrushCore
   GimpTempBuf       *solid_brushes[BRUSH_CORE_SOLID_SUBSAMPLE][BRUSH_CORE_SOLID_SUBSAMPLE];
   const GimpTempBuf *last_solid_brush_mask;
   gboolean           solid_cache_invalid;
+  GQueue             saved_solid_caches;
 
   const GimpTempBuf *transform_brush;
   const GimpTempBuf *transform_pixmap;
@@ -67,6 +68,7 @@ struct _GimpBrushCore
   GimpTempBuf       *subsample_brushes[BRUSH_CORE_SUBSAMPLE + 1][BRUSH_CORE_SUBSAMPLE + 1];
   const GimpTempBuf *last_subsample_brush_mask;
   gboolean           subsample_cache_invalid;
+  GQueue             saved_subsample_caches;
 
   gdouble            jitter;
   gdouble            jitter_lut_x[BRUSH_CORE_JITTER_LUTSIZE];
@@ -57,9 +57,11 @@
  * but subtract them I2 = I0 - I1, where I0 is the sample image to be
  * corrected, I1 is the reference pattern. Then we solve DeltaI=0
  * (Laplace) with I2 Dirichlet conditions at the borders of the
- * mask. The solver is a red/black checker Gauss-Seidel with over-relaxation.
- * It could benefit from a multi-grid evaluation of an initial solution
- * before the main iteration loop.
+ * mask. The solver is multigrid: the initial solution is interpolated from
+ * the same problem solved at half the resolution, and then corrected by
+ * V-cycles, which use red/black checker Gauss-Seidel as the smoother.
+ * Grids which are too small to be halved are solved by Gauss-Seidel with
+ * over-relaxation alone.
  *
  * I reduced the convergence criteria to 0.1% (0.001) as we are
  * dealing here with RGB integer components, more is overkill.
@@ -271,13 +273,88 @@ gimp_heal_add (GeglBuffer          *first_buffer,
     }
 }
 
+/* Tolerate a total deviation-from-smoothness of 0.1 LSBs at 8bit depth. */
+#define EPSILON  (0.1/255)
+#define MAX_ITER 500
+
+/* Don't go down to grids smaller than this. */
+#define MIN_COARSE_SIZE 16
+
+/* The number of smoothing iterations before and after each coarse grid
+ * correction.
+ */
+#define N_SMOOTH 2
+
+/* The minimal number of cells a thread updates in one iteration. */
+#define MIN_PARALLEL_SUB_SIZE 8192
+
+
+typedef struct _HealLevel HealLevel;
+
+struct _HealLevel
+{
+  gint       width;
+  gint       height;
+  gint       depth;
+
+  guchar    *mask;
+  gfloat    *pixels;
+  gfloat    *rhs;     /* the right hand side of the equation, or NULL if
+                       * it is zero
+                       */
+
+  gfloat    *Adiag;
+  gint      *Aidx;
+  gint       nmask;
+  gint       nred;
+
+  HealLevel *coarse;
+
+  gpointer   mask_alloc;
+  gpointer   pixels_alloc;
+  gpointer   rhs_alloc;
+};
+
+typedef struct
+{
+  HealLevel *level;
+  gfloat     w;
+  gint       offset;
+
+  GMutex     mutex;
+  gfloat     err;
+} HealIterationData;
+
+
+static void   gimp_heal_laplace_loop (gfloat *pixels,
+                                      gint    height,
+                                      gint    depth,
+                                      gint    width,
+                                      guchar *mask);
+
+
+/* Allocate room for the pixels of a level, plus an empty pixel, 16-byte
+ * aligned for the SSE code path.
+ */
+static gfloat *
+gimp_heal_pixels_new (gint      width,
+                      gint      height,
+                      gint      depth,
+                      gpointer *alloc)
+{
+  *alloc = g_new0 (gfloat, 4 + (width * height + 1) * depth);
+
+  return (gfloat*)(((uintptr_t)*alloc + 15) & ~15);
+}
+
 #if defined(__SSE__) && defined(__GNUC__) && __GNUC__ >= 4
 static float
 gimp_heal_laplace_iteration_sse (gfloat *pixels,
                                  gfloat *Adiag,
                                  gint   *Aidx,
                                  gfloat  w,
-                                 gint    nmask)
+                                 gint    start,
+                                 gint    end)
 {
   typedef float v4sf __attribute__((vector_size(16)));
   gint i;
@@ -287,40 +364,46 @@ gimp_heal_laplace_iteration_sse (gfloat *pixels,
 
 #define Xv(j) (*(v4sf*)&pixels[Aidx[i * 5 + j]])
 
-  for (i = 0; i < nmask; i++)
+  for (i = start; i < end; i++)
     {
       v4sf a    = { Adiag[i], Adiag[i], Adiag[i], Adiag[i] };
-      v4sf diff = a * Xv(0) - wv * (Xv(1) + Xv(2) + Xv(3) + Xv(4));
+      v4sf diff = wv * (a * Xv(0) - (Xv(1) + Xv(2) + Xv(3) + Xv(4)));
 
       Xv(0) -= diff;
       err += diff * diff;
     }
 
+#undef Xv
+
   erru.v = err;
 
   return erru.f[0] + erru.f[1] + erru.f[2] + erru.f[3];
 }
 #endif
 
-/* Perform one iteration of Gauss-Seidel, and return the sum squared residual.
+/* Perform one Gauss-Seidel pass over the cells from start to end, and
+ * return the sum squared residual.
  */
 static float
 gimp_heal_laplace_iteration (gfloat *pixels,
+                             gfloat *rhs,
                              gfloat *Adiag,
                              gint   *Aidx,
                              gfloat  w,
-                             gint    nmask,
+                             gint    start,
+                             gint    end,
                              gint    depth)
 {
   gint   i, k;
   gfloat err = 0;
 
 #if defined(__SSE__) && defined(__GNUC__) && __GNUC__ >= 4
-  if (depth == 4)
-    return gimp_heal_laplace_iteration_sse (pixels, Adiag, Aidx, w, nmask);
+  if (depth == 4 && ! rhs)
+    return gimp_heal_laplace_iteration_sse (pixels, Adiag, Aidx, w,
+                                            start, end);
 #endif
 
-  for (i = 0; i < nmask; i++)
+  for (i = start; i < end; i++)
     {
       gint   j0 = Aidx[i * 5 + 0];
       gint   j1 = Aidx[i * 5 + 1];
@@ -331,12 +414,15 @@ gimp_heal_laplace_iteration (gfloat *pixels,
 
       for (k = 0; k < depth; k++)
         {
-          gfloat diff = (a * pixels[j0 + k] -
-                         w * (pixels[j1 + k] +
+          gfloat diff = w * (a * pixels[j0 + k] -
+                             (pixels[j1 + k] +
                               pixels[j2 + k] +
                               pixels[j3 + k] +
                               pixels[j4 + k]));
 
+          if (rhs)
+            diff -= w * rhs[j0 + k];
+
           pixels[j0 + k] -= diff;
           err += diff * diff;
         }
@@ -345,26 +431,83 @@ gimp_heal_laplace_iteration (gfloat *pixels,
   return err;
 }
 
-/* Solve the laplace equation for pixels and store the result in-place.
- */
 static void
-gimp_heal_laplace_loop (gfloat *pixels,
-                        gint    height,
-                        gint    depth,
-                        gint    width,
-                        guchar *mask)
+gimp_heal_laplace_iteration_range (gsize              offset,
+                                   gsize              size,
+                                   HealIterationData *data)
 {
-  /* Tolerate a total deviation-from-smoothness of 0.1 LSBs at 8bit depth. */
-#define EPSILON  (0.1/255)
-#define MAX_ITER 500
+  HealLevel *level = data->level;
+  gfloat     err;
 
-  gint    i, j, iter, parity, nmask, zero;
-  gfloat *Adiag;
-  gint   *Aidx;
-  gfloat  w;
+  err = gimp_heal_laplace_iteration (level->pixels, level->rhs,
+                                     level->Adiag, level->Aidx,
+                                     data->w,
+                                     data->offset + offset,
+                                     data->offset + offset + size,
+                                     level->depth);
 
-  Adiag = g_new (gfloat, width * height);
-  Aidx  = g_new (gint, 5 * width * height);
+  g_mutex_lock (&data->mutex);
+
+  data->err += err;
+
+  g_mutex_unlock (&data->mutex);
+}
+
+/* Perform one iteration of red/black Gauss-Seidel with relaxation
+ * factor 4 * w, and return the sum squared residual.  Cells of the same
+ * color don't depend on each other, so each half of the iteration is
+ * distributed across threads.
+ */
+static float
+gimp_heal_laplace_smooth (HealLevel *level,
+                          gfloat     w)
+{
+  HealIterationData data;
+
+  data.level = level;
+  data.w     = w;
+  data.err   = 0;
+
+  g_mutex_init (&data.mutex);
+
+  data.offset = 0;
+
+  if (level->nred > 0)
+    {
+      gegl_parallel_distribute_range (
+        level->nred, MIN_PARALLEL_SUB_SIZE,
+        (GeglParallelDistributeRangeFunc) gimp_heal_laplace_iteration_range,
+        &data);
+    }
+
+  data.offset = level->nred;
+
+  if (level->nmask > level->nred)
+    {
+      gegl_parallel_distribute_range (
+        level->nmask - level->nred, MIN_PARALLEL_SUB_SIZE,
+        (GeglParallelDistributeRangeFunc) gimp_heal_laplace_iteration_range,
+        &data);
+    }
+
+  g_mutex_clear (&data.mutex);
+
+  return data.err;
+}
+
+/* Construct the system of equations of a level.
+ */
+static void
+gimp_heal_level_init (HealLevel *level)
+{
+  gint  width  = level->width;
+  gint  height = level->height;
+  gint  depth  = level->depth;
+  gint  i, j, parity, nmask, zero;
+  gint *Aidx;
+
+  level->Adiag = g_new (gfloat, width * height);
+  level->Aidx  = Aidx = g_new (gint, 5 * width * height);
 
   /* All off-diagonal elements of A are either -1 or 0. We could store it as a
    * general-purpose sparse matrix, but that adds some unnecessary overhead to
@@ -373,56 +516,394 @@ gimp_heal_laplace_loop (gfloat *pixels,
    * coefs can put them in a dummy column to be multiplied by an empty pixel.
    */
   zero = depth * width * height;
-  memset (pixels + zero, 0, depth * sizeof (gfloat));
+  memset (level->pixels + zero, 0, depth * sizeof (gfloat));
 
-  /* Construct the system of equations.
-   * Arrange Aidx in checkerboard order, so that a single linear pass over that
+  /* Arrange Aidx in checkerboard order, so that a single linear pass over that
    * array results updating all of the red cells and then all of the black cells.
    */
   nmask = 0;
   for (parity = 0; parity < 2; parity++)
-    for (i = 0; i < height; i++)
-      for (j = (i&1)^parity; j < width; j+=2)
-        if (mask[j + i * width])
-          {
+    {
+      for (i = 0; i < height; i++)
+        for (j = (i&1)^parity; j < width; j+=2)
+          if (level->mask[j + i * width])
+            {
 #define A_NEIGHBOR(o,di,dj) \
-            if ((dj<0 && j==0) || (dj>0 && j==width-1) || (di<0 && i==0) || (di>0 && i==height-1)) \
-              Aidx[o + nmask * 5] = zero; \
-            else                                               \
-              Aidx[o + nmask * 5] = ((i + di) * width + (j + dj)) * depth;
-
-            /* Omit Dirichlet conditions for any neighbors off the
-             * edge of the canvas.
-             */
-            Adiag[nmask] = 4 - (i==0) - (j==0) - (i==height-1) - (j==width-1);
-            A_NEIGHBOR (0,  0,  0);
-            A_NEIGHBOR (1,  0,  1);
-            A_NEIGHBOR (2,  1,  0);
-            A_NEIGHBOR (3,  0, -1);
-            A_NEIGHBOR (4, -1,  0);
-            nmask++;
+              if ((dj<0 && j==0) || (dj>0 && j==width-1) || (di<0 && i==0) || (di>0 && i==height-1)) \
+                Aidx[o + nmask * 5] = zero; \
+              else                                               \
+                Aidx[o + nmask * 5] = ((i + di) * width + (j + dj)) * depth;
+
+              /* Omit Dirichlet conditions for any neighbors off the
+               * edge of the canvas.
+               */
+              level->Adiag[nmask] = 4 - (i==0) - (j==0) - (i==height-1) - (j==width-1);
+              A_NEIGHBOR (0,  0,  0);
+              A_NEIGHBOR (1,  0,  1);
+              A_NEIGHBOR (2,  1,  0);
+              A_NEIGHBOR (3,  0, -1);
+              A_NEIGHBOR (4, -1,  0);
+              nmask++;
+
+#undef A_NEIGHBOR
+            }
+
+      if (parity == 0)
+        level->nred = nmask;
+    }
+
+  level->nmask = nmask;
+
+  /* Add a grid of half the resolution for the coarse grid corrections.
+   * A coarse cell is solved for if all its fine cells are, the others
+   * are fixed to a zero correction.
+   */
+  if (width  >= 2 * MIN_COARSE_SIZE &&
+      height >= 2 * MIN_COARSE_SIZE)
+    {
+      HealLevel *coarse = g_slice_new0 (HealLevel);
+
+      coarse->width  = (width  + 1) / 2;
+      coarse->height = (height + 1) / 2;
+      coarse->depth  = depth;
+
+      coarse->mask = coarse->mask_alloc =
+        g_new (guchar, coarse->width * coarse->height);
+
+      for (i = 0; i < coarse->height; i++)
+        for (j = 0; j < coarse->width; j++)
+          {
+            gboolean solved = TRUE;
+            gint     di, dj;
+
+            for (di = 0; di < 2 && 2 * i + di < height; di++)
+              for (dj = 0; dj < 2 && 2 * j + dj < width; dj++)
+                solved &= level->mask[(2 * i + di) * width + (2 * j + dj)] != 0;
+
+            coarse->mask[i * coarse->width + j] = solved;
           }
 
+      coarse->pixels = gimp_heal_pixels_new (coarse->width, coarse->height,
+                                             depth, &coarse->pixels_alloc);
+      coarse->rhs    = gimp_heal_pixels_new (coarse->width, coarse->height,
+                                             depth, &coarse->rhs_alloc);
+
+      gimp_heal_level_init (coarse);
+
+      level->coarse = coarse;
+    }
+}
+
+static void
+gimp_heal_level_free (HealLevel *level)
+{
+  if (level->coarse)
+    {
+      gimp_heal_level_free (level->coarse);
+
+      g_free (level->coarse->mask_alloc);
+      g_free (level->coarse->pixels_alloc);
+      g_free (level->coarse->rhs_alloc);
+
+      g_slice_free (HealLevel, level->coarse);
+    }
+
+  g_free (level->Adiag);
+  g_free (level->Aidx);
+}
+
+/* Restrict the residual of a level to the right hand side of the coarse
+ * grid correction, whose fine cells are all solved for.
+ */
+static void
+gimp_heal_level_restrict (HealLevel *level)
+{
+  HealLevel *coarse = level->coarse;
+  gint       depth  = level->depth;
+  gint       i, k;
+
+  memset (coarse->pixels, 0,
+          coarse->width * coarse->height * depth * sizeof (gfloat));
+  memset (coarse->rhs, 0,
+          coarse->width * coarse->height * depth * sizeof (gfloat));
+
+  for (i = 0; i < level->nmask; i++)
+    {
+      gint    j0 = level->Aidx[i * 5 + 0];
+      gint    x  = (j0 / depth) % level->width;
+      gint    y  = (j0 / depth) / level->width;
+      gint    c  = (y / 2) * coarse->width + (x / 2);
+      gfloat *r  = coarse->rhs + c * depth;
+      gfloat  a  = level->Adiag[i];
+
+      if (! coarse->mask[c])
+        continue;
+
+      /* the residual on the coarse grid is 4 times as large, since its
+       * cells are twice as far apart
+       */
+      for (k = 0; k < depth; k++)
+        {
+          gfloat residual = (level->pixels[level->Aidx[i * 5 + 1] + k] +
+                             level->pixels[level->Aidx[i * 5 + 2] + k] +
+                             level->pixels[level->Aidx[i * 5 + 3] + k] +
+                             level->pixels[level->Aidx[i * 5 + 4] + k]) -
+                            a * level->pixels[j0 + k];
+
+          if (level->rhs)
+            residual += level->rhs[j0 + k];
+
+          r[k] += residual;
+        }
+    }
+}
+
+/* Bilinearly interpolate the coarse pixels, and add them to the solved
+ * pixels of a level.
+ */
+static void
+gimp_heal_level_prolong (HealLevel *level,
+                         gfloat    *coarse_pixels,
+                         gint       coarse_width,
+                         gint       coarse_height,
+                         gboolean   add)
+{
+  gint width  = level->width;
+  gint height = level->height;
+  gint depth  = level->depth;
+  gint i, j, k;
+
+  for (i = 0; i < height; i++)
+    {
+      gfloat y  = CLAMP ((i - 0.5f) / 2.0f, 0.0f, coarse_height - 1);
+      gint   i0 = (gint) y;
+      gint   i1 = MIN (i0 + 1, coarse_height - 1);
+      gfloat fy = y - i0;
+
+      for (j = 0; j < width; j++)
+        {
+          gfloat        x;
+          gint          j0, j1;
+          gfloat        fx;
+          const gfloat *p00, *p01, *p10, *p11;
+          gfloat       *p;
+
+          if (! level->mask[i * width + j])
+            continue;
+
+          x  = CLAMP ((j - 0.5f) / 2.0f, 0.0f, coarse_width - 1);
+          j0 = (gint) x;
+          j1 = MIN (j0 + 1, coarse_width - 1);
+          fx = x - j0;
+
+          p00 = coarse_pixels + (i0 * coarse_width + j0) * depth;
+          p01 = coarse_pixels + (i0 * coarse_width + j1) * depth;
+          p10 = coarse_pixels + (i1 * coarse_width + j0) * depth;
+          p11 = coarse_pixels + (i1 * coarse_width + j1) * depth;
+
+          p = level->pixels + (i * width + j) * depth;
+
+          for (k = 0; k < depth; k++)
+            {
+              gfloat value = (1.0f - fy) * ((1.0f - fx) * p00[k] + fx * p01[k]) +
+                             fy          * ((1.0f - fx) * p10[k] + fx * p11[k]);
+
+              if (add)
+                p[k] += value;
+              else
+                p[k] = value;
+            }
+        }
+    }
+}
+
+/* Solve a level on its own, using Gauss-Seidel with successive
+ * over-relaxation.
+ */
+static void
+gimp_heal_level_solve (HealLevel *level)
+{
+  gfloat w;
+  gint   iter;
+
   /* Empirically optimal over-relaxation factor. (Benchmarked on
    * round brushes, at least. I don't know whether aspect ratio
    * affects it.)
    */
-  w = 2.0 - 1.0 / (0.1575 * sqrt (nmask) + 0.8);
+  w = 2.0 - 1.0 / (0.1575 * sqrt (level->nmask) + 0.8);
   w *= 0.25;
-  for (i = 0; i < nmask; i++)
-    Adiag[i] *= w;
 
-  /* Gauss-Seidel with successive over-relaxation */
   for (iter = 0; iter < MAX_ITER; iter++)
     {
-      gfloat err = gimp_heal_laplace_iteration (pixels, Adiag, Aidx,
-                                                w, nmask, depth);
+      gfloat err = gimp_heal_laplace_smooth (level, w);
+
       if (err < EPSILON * EPSILON * w * w)
         break;
     }
+}
+
+/* Perform one multigrid V-cycle on a level, and return the sum squared
+ * residual of its last smoothing iteration.
+ */
+static gfloat
+gimp_heal_level_v_cycle (HealLevel *level)
+{
+  gfloat err = 0;
+  gint   i;
+
+  if (! level->coarse)
+    {
+      gimp_heal_level_solve (level);
+
+      return 0;
+    }
+
+  for (i = 0; i < N_SMOOTH; i++)
+    gimp_heal_laplace_smooth (level, 0.25);
+
+  gimp_heal_level_restrict (level);
+
+  gimp_heal_level_v_cycle (level->coarse);
+
+  gimp_heal_level_prolong (level,
+                           level->coarse->pixels,
+                           level->coarse->width,
+                           level->coarse->height,
+                           TRUE);
+
+  for (i = 0; i < N_SMOOTH; i++)
+    err = gimp_heal_laplace_smooth (level, 0.25);
+
+  return err;
+}
+
+/* Solve the equation with fixed pixels averaged on a grid of half the
+ * resolution, and use the interpolated solution as the starting point
+ * for the solved pixels.
+ */
+static void
+gimp_heal_laplace_init_coarse (gfloat *pixels,
+                               gint    height,
+                               gint    depth,
+                               gint    width,
+                               guchar *mask)
+{
+  HealLevel  level         = { 0, };
+  gint       coarse_width  = (width  + 1) / 2;
+  gint       coarse_height = (height + 1) / 2;
+  gfloat    *coarse;
+  gpointer   coarse_alloc;
+  guchar    *coarse_mask;
+  gfloat     sum[4];
+  gint       i, j, k;
+
+  coarse      = gimp_heal_pixels_new (coarse_width, coarse_height, depth,
+                                      &coarse_alloc);
+  coarse_mask = g_new (guchar, coarse_width * coarse_height);
+
+  /* A coarse pixel is solved for if all its fine pixels are.  Otherwise,
+   * it is fixed to the average of the fine pixels which are fixed.
+   */
+  for (i = 0; i < coarse_height; i++)
+    for (j = 0; j < coarse_width; j++)
+      {
+        gint n       = 0;
+        gint n_fixed = 0;
+        gint di, dj;
+
+        memset (sum, 0, sizeof (sum));
+
+        for (di = 0; di < 2 && 2 * i + di < height; di++)
+          for (dj = 0; dj < 2 && 2 * j + dj < width; dj++)
+            {
+              gint    f     = (2 * i + di) * width + (2 * j + dj);
+              gfloat *pixel = pixels + f * depth;
+
+              if (mask[f])
+                {
+                  if (n_fixed == 0)
+                    for (k = 0; k < depth; k++)
+                      sum[k] += pixel[k];
+
+                  n++;
+                }
+              else
+                {
+                  if (n_fixed == 0)
+                    memset (sum, 0, sizeof (sum));
+
+                  for (k = 0; k < depth; k++)
+                    sum[k] += pixel[k];
+
+                  n_fixed++;
+                }
+            }
+
+        coarse_mask[i * coarse_width + j] = (n_fixed == 0);
+
+        for (k = 0; k < depth; k++)
+          coarse[(i * coarse_width + j) * depth + k] =
+            sum[k] / (n_fixed ? n_fixed : n);
+      }
+
+  gimp_heal_laplace_loop (coarse, coarse_height, depth, coarse_width,
+                          coarse_mask);
+
+  level.width  = width;
+  level.height = height;
+  level.depth  = depth;
+  level.mask   = mask;
+  level.pixels = pixels;
+
+  gimp_heal_level_prolong (&level, coarse, coarse_width, coarse_height,
+                           FALSE);
+
+  g_free (coarse_mask);
+  g_free (coarse_alloc);
+}
+
+/* Solve the laplace equation for pixels and store the result in-place.
+ * pixels must have room for an additional empty pixel.
+ */
+static void
+gimp_heal_laplace_loop (gfloat *pixels,
+                        gint    height,
+                        gint    depth,
+                        gint    width,
+                        guchar *mask)
+{
+  HealLevel level = { 0, };
+  gint      iter;
+
+  level.width  = width;
+  level.height = height;
+  level.depth  = depth;
+  level.mask   = mask;
+  level.pixels = pixels;
+
+  gimp_heal_level_init (&level);
+
+  if (! level.coarse)
+    {
+      gimp_heal_level_solve (&level);
+    }
+  else
+    {
+      /* start from the solution of the coarser problem, and then correct
+       * it using multigrid V-cycles
+       */
+      gimp_heal_laplace_init_coarse (pixels, height, depth, width, mask);
+
+      for (iter = 0; iter < MAX_ITER; iter++)
+        {
+          gfloat err = gimp_heal_level_v_cycle (&level);
+
+          if (err < EPSILON * EPSILON * 0.25 * 0.25)
+            break;
+        }
+    }
 
-  g_free (Adiag);
-  g_free (Aidx);
+  gimp_heal_level_free (&level);
 }
 
 /* Original Algorithm Design:
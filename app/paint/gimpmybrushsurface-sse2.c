@@ -0,0 +1,110 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpmybrushsurface-sse2.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "gimpmybrushsurface-sse2.h"
+
+
+#if COMPILE_SSE2_INTRINISICS
+
+#include <emmintrin.h>
+
+
+/* computes the opacity of a dab over @count consecutive pixels of a row.
+ * @xx and @yy are the offsets of the center of the first pixel from the
+ * center of the dab.  see gimp_mypaint_surface_dab_row() for the scalar
+ * version.
+ */
+void
+gimp_mypaint_surface_dab_row_sse2 (gfloat *alpha,
+                                   gint    count,
+                                   gfloat  xx,
+                                   gfloat  yy,
+                                   gfloat  aspect_ratio,
+                                   gfloat  sn,
+                                   gfloat  cs,
+                                   gfloat  one_over_radius2,
+                                   gfloat  hardness,
+                                   gfloat  slope1,
+                                   gfloat  slope2)
+{
+  const __m128 v_yy_cs    = _mm_set1_ps (yy * cs);
+  const __m128 v_yy_sn    = _mm_set1_ps (yy * sn);
+  const __m128 v_sn       = _mm_set1_ps (sn);
+  const __m128 v_cs       = _mm_set1_ps (cs);
+  const __m128 v_aspect   = _mm_set1_ps (aspect_ratio);
+  const __m128 v_scale    = _mm_set1_ps (one_over_radius2);
+  const __m128 v_hardness = _mm_set1_ps (hardness);
+  const __m128 v_slope1   = _mm_set1_ps (slope1);
+  const __m128 v_slope2   = _mm_set1_ps (slope2);
+  const __m128 v_one      = _mm_set1_ps (1.0f);
+  const __m128 v_four     = _mm_set1_ps (4.0f);
+  __m128       v_xx       = _mm_add_ps (_mm_set1_ps (xx),
+                                        _mm_set_ps (3.0f, 2.0f, 1.0f, 0.0f));
+  gint         i;
+
+  for (i = 0; i + 4 <= count; i += 4)
+    {
+      __m128 v_yyr;
+      __m128 v_xxr;
+      __m128 v_rr;
+      __m128 v_hard;
+      __m128 v_inside;
+      __m128 v_alpha;
+
+      v_yyr = _mm_mul_ps (_mm_sub_ps (v_yy_cs, _mm_mul_ps (v_xx, v_sn)),
+                          v_aspect);
+      v_xxr = _mm_add_ps (v_yy_sn, _mm_mul_ps (v_xx, v_cs));
+      v_rr  = _mm_mul_ps (_mm_add_ps (_mm_mul_ps (v_yyr, v_yyr),
+                                      _mm_mul_ps (v_xxr, v_xxr)),
+                          v_scale);
+
+      v_hard   = _mm_cmple_ps (v_rr, v_hardness);
+      v_inside = _mm_cmple_ps (v_rr, v_one);
+
+      v_alpha = _mm_or_ps (
+        _mm_and_ps    (v_hard, _mm_add_ps (v_one, _mm_mul_ps (v_rr, v_slope1))),
+        _mm_andnot_ps (v_hard, _mm_sub_ps (_mm_mul_ps (v_rr, v_slope2),
+                                           v_slope2)));
+
+      _mm_storeu_ps (alpha + i, _mm_and_ps (v_inside, v_alpha));
+
+      v_xx = _mm_add_ps (v_xx, v_four);
+    }
+
+  for (; i < count; i++)
+    {
+      gfloat x   = xx + i;
+      gfloat yyr = (yy * cs - x * sn) * aspect_ratio;
+      gfloat xxr = yy * sn + x * cs;
+      gfloat rr  = (yyr * yyr + xxr * xxr) * one_over_radius2;
+
+      if (rr > 1.0f)
+        alpha[i] = 0.0f;
+      else if (rr <= hardness)
+        alpha[i] = 1.0f + rr * slope1;
+      else
+        alpha[i] = rr * slope2 - slope2;
+    }
+}
+
+#endif /* COMPILE_SSE2_INTRINISICS */
@@ -22,6 +22,7 @@
 
 #include "paint-types.h"
 
+#include "libgimpbase/gimpbase.h"
 #include "libgimpmath/gimpmath.h"
 
 #include <cairo.h>
@@ -30,8 +31,47 @@
 
 #include "gimpmybrushoptions.h"
 #include "gimpmybrushsurface.h"
+#include "gimpmybrushsurface-sse2.h"
 
 
+/* dabs are not drawn right away, but are accumulated, and drawn tile by
+ * tile when the surface is read, or when the atomic section ends.  each
+ * tile is read and written once, regardless of the number of dabs
+ * covering it, and different tiles are drawn concurrently.
+ */
+#define DAB_TILE_SIZE        64
+#define MAX_PENDING_DABS     1024
+#define DAB_TILES_PER_THREAD 2
+
+
+typedef struct
+{
+  GeglRectangle roi;
+  float         x;
+  float         y;
+  float         color_r;
+  float         color_g;
+  float         color_b;
+  float         color_a;
+  float         normal_mode;
+  float         colorize;
+  float         hardness;
+  float         segment1_slope;
+  float         segment2_slope;
+  float         aspect_ratio;
+  float         sn;
+  float         cs;
+  float         one_over_radius2;
+  float         r_aa_start;
+  gboolean      antialiased;
+} GimpMybrushDab;
+
+typedef struct
+{
+  GeglRectangle  rect;
+  GArray        *dabs;
+} GimpMybrushDabTile;
+
 struct _GimpMybrushSurface
 {
   MyPaintSurface surface;
@@ -42,6 +82,11 @@ struct _GimpMybrushSurface
   GeglRectangle dirty;
   GimpComponentMask component_mask;
   GimpMybrushOptions *options;
+
+  GArray        *dabs;
+  GeglRectangle  dabs_bounds;
+  GArray        *dab_tiles;
+  gboolean       sse2;
 };
 
 /* --- Taken from mypaint-tiled-surface.c --- */
@@ -229,6 +274,321 @@ calculate_dab_roi (float x,
   return *GEGL_RECTANGLE (x0, y0, x1 - x0, y1 - y0);
 }
 
+/* computes the opacity of @dab over @count pixels of row @iy, starting
+ * at column @ix.
+ */
+static void
+gimp_mypaint_surface_dab_row (GimpMybrushSurface   *surface,
+                              const GimpMybrushDab *dab,
+                              int                   ix,
+                              int                   iy,
+                              int                   count,
+                              float                *alpha)
+{
+  const float xx = ix + 0.5f - dab->x;
+  const float yy = iy + 0.5f - dab->y;
+  int         i;
+
+  if (dab->antialiased)
+    {
+      for (i = 0; i < count; i++)
+        {
+          float rr = calculate_rr_antialiased (ix + i, iy, dab->x, dab->y,
+                                               dab->aspect_ratio,
+                                               dab->sn, dab->cs,
+                                               dab->one_over_radius2,
+                                               dab->r_aa_start);
+
+          alpha[i] = calculate_alpha_for_rr (rr, dab->hardness,
+                                             dab->segment1_slope,
+                                             dab->segment2_slope);
+        }
+
+      return;
+    }
+
+#if COMPILE_SSE2_INTRINISICS
+  if (surface->sse2)
+    {
+      gimp_mypaint_surface_dab_row_sse2 (alpha, count, xx, yy,
+                                         dab->aspect_ratio,
+                                         dab->sn, dab->cs,
+                                         dab->one_over_radius2,
+                                         dab->hardness,
+                                         dab->segment1_slope,
+                                         dab->segment2_slope);
+
+      return;
+    }
+#endif
+
+  for (i = 0; i < count; i++)
+    {
+      const float x   = xx + i;
+      const float yyr = (yy * dab->cs - x * dab->sn) * dab->aspect_ratio;
+      const float xxr = yy * dab->sn + x * dab->cs;
+      const float rr  = (yyr * yyr + xxr * xxr) * dab->one_over_radius2;
+
+      alpha[i] = calculate_alpha_for_rr (rr, dab->hardness,
+                                         dab->segment1_slope,
+                                         dab->segment2_slope);
+    }
+}
+
+static inline void
+gimp_mypaint_surface_blend_pixel (GimpMybrushSurface   *surface,
+                                  const GimpMybrushDab *dab,
+                                  float                *pixel,
+                                  float                 base_alpha,
+                                  float                 mask)
+{
+  GimpComponentMask component_mask = surface->component_mask;
+  float             alpha, dst_alpha, r, g, b, a;
+
+  alpha = base_alpha * dab->normal_mode * mask;
+  dst_alpha = pixel[ALPHA];
+  /* a = alpha * color_a + dst_alpha * (1.0f - alpha);
+   * which converts to: */
+  a = alpha * (dab->color_a - dst_alpha) + dst_alpha;
+  r = pixel[RED];
+  g = pixel[GREEN];
+  b = pixel[BLUE];
+
+  if (a > 0.0f)
+    {
+      /* By definition the ratio between each color[] and pixel[] component in a non-pre-multipled blend always sums to 1.0f.
+       * Originally this would have been "(color[n] * alpha * color_a + pixel[n] * dst_alpha * (1.0f - alpha)) / a",
+       * instead we only calculate the cheaper term. */
+      float src_term = (alpha * dab->color_a) / a;
+      float dst_term = 1.0f - src_term;
+      r = dab->color_r * src_term + r * dst_term;
+      g = dab->color_g * src_term + g * dst_term;
+      b = dab->color_b * src_term + b * dst_term;
+    }
+
+  if (dab->colorize > 0.0f && base_alpha > 0.0f)
+    {
+      alpha = base_alpha * dab->colorize;
+      a = alpha + dst_alpha - alpha * dst_alpha;
+      if (a > 0.0f)
+        {
+          GimpHSL pixel_hsl, out_hsl;
+          GimpRGB pixel_rgb = {dab->color_r, dab->color_g, dab->color_b};
+          GimpRGB out_rgb   = {r, g, b};
+          float src_term = alpha / a;
+          float dst_term = 1.0f - src_term;
+
+          gimp_rgb_to_hsl (&pixel_rgb, &pixel_hsl);
+          gimp_rgb_to_hsl (&out_rgb, &out_hsl);
+
+          out_hsl.h = pixel_hsl.h;
+          out_hsl.s = pixel_hsl.s;
+          gimp_hsl_to_rgb (&out_hsl, &out_rgb);
+
+          r = (float)out_rgb.r * src_term + r * dst_term;
+          g = (float)out_rgb.g * src_term + g * dst_term;
+          b = (float)out_rgb.b * src_term + b * dst_term;
+        }
+    }
+
+  if (surface->options->no_erasing)
+    a = MAX (a, pixel[ALPHA]);
+
+  if (component_mask != GIMP_COMPONENT_MASK_ALL)
+    {
+      if (component_mask & GIMP_COMPONENT_MASK_RED)
+        pixel[RED]   = r;
+      if (component_mask & GIMP_COMPONENT_MASK_GREEN)
+        pixel[GREEN] = g;
+      if (component_mask & GIMP_COMPONENT_MASK_BLUE)
+        pixel[BLUE]  = b;
+      if (component_mask & GIMP_COMPONENT_MASK_ALPHA)
+        pixel[ALPHA] = a;
+    }
+  else
+    {
+      pixel[RED]   = r;
+      pixel[GREEN] = g;
+      pixel[BLUE]  = b;
+      pixel[ALPHA] = a;
+    }
+}
+
+static void
+gimp_mypaint_surface_draw_tiles (gint                offset,
+                                 gint                size,
+                                 GimpMybrushSurface *surface)
+{
+  const GimpMybrushDab *dabs = (const GimpMybrushDab *) surface->dabs->data;
+  float                *pixels;
+  float                *mask = NULL;
+  float                *alpha;
+  gint                  i;
+
+  pixels = g_new (float, 4 * DAB_TILE_SIZE * DAB_TILE_SIZE);
+  alpha  = g_new (float, DAB_TILE_SIZE);
+
+  if (surface->paint_mask)
+    mask = g_new (float, DAB_TILE_SIZE * DAB_TILE_SIZE);
+
+  for (i = offset; i < offset + size; i++)
+    {
+      GimpMybrushDabTile *tile = &g_array_index (surface->dab_tiles,
+                                                 GimpMybrushDabTile, i);
+      const GeglRectangle *rect = &tile->rect;
+      guint                j;
+
+      gegl_buffer_get (surface->buffer, rect, 1.0,
+                       babl_format ("R'G'B'A float"), pixels,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      if (mask)
+        {
+          gegl_buffer_get (surface->paint_mask,
+                           GEGL_RECTANGLE (rect->x - surface->paint_mask_x,
+                                           rect->y - surface->paint_mask_y,
+                                           rect->width, rect->height),
+                           1.0, babl_format ("Y float"), mask,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+        }
+
+      /*  the dabs are drawn in the order they were made, so that
+       *  overlapping dabs are composited the same as when drawn one at a
+       *  time
+       */
+      for (j = 0; j < tile->dabs->len; j++)
+        {
+          const GimpMybrushDab *dab;
+          GeglRectangle         area;
+          int                   iy;
+
+          dab = &dabs[g_array_index (tile->dabs, guint, j)];
+
+          gegl_rectangle_intersect (&area, &dab->roi, rect);
+
+          for (iy = area.y; iy < area.y + area.height; iy++)
+            {
+              gint   row   = (iy - rect->y) * rect->width + (area.x - rect->x);
+              float *pixel = pixels + 4 * row;
+              int    ix;
+
+              gimp_mypaint_surface_dab_row (surface, dab,
+                                            area.x, iy, area.width, alpha);
+
+              for (ix = 0; ix < area.width; ix++)
+                {
+                  /*  a dab has no effect where its opacity is 0  */
+                  if (alpha[ix] != 0.0f)
+                    {
+                      gimp_mypaint_surface_blend_pixel (
+                        surface, dab, pixel + 4 * ix, alpha[ix],
+                        mask ? mask[row + ix] : 1.0f);
+                    }
+                }
+            }
+        }
+
+      gegl_buffer_set (surface->buffer, rect, 0,
+                       babl_format ("R'G'B'A float"), pixels,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_free (mask);
+  g_free (alpha);
+  g_free (pixels);
+}
+
+static void
+gimp_mypaint_surface_flush_dabs (GimpMybrushSurface *surface)
+{
+  const GeglRectangle *bounds = &surface->dabs_bounds;
+  GArray             **tiles;
+  gint                 tile_x0;
+  gint                 tile_y0;
+  gint                 n_tiles_x;
+  gint                 n_tiles_y;
+  guint                i;
+  gint                 j;
+
+  if (surface->dabs->len == 0)
+    return;
+
+  tile_x0   = floor ((gdouble) bounds->x / DAB_TILE_SIZE);
+  tile_y0   = floor ((gdouble) bounds->y / DAB_TILE_SIZE);
+  n_tiles_x = ceil ((gdouble) (bounds->x + bounds->width) / DAB_TILE_SIZE) -
+              tile_x0;
+  n_tiles_y = ceil ((gdouble) (bounds->y + bounds->height) / DAB_TILE_SIZE) -
+              tile_y0;
+
+  tiles = g_new0 (GArray *, n_tiles_x * n_tiles_y);
+
+  /*  bin the dabs by the tiles they cover  */
+  for (i = 0; i < surface->dabs->len; i++)
+    {
+      const GimpMybrushDab *dab = &g_array_index (surface->dabs,
+                                                  GimpMybrushDab, i);
+      gint                  x0, y0, x1, y1;
+      gint                  x, y;
+
+      x0 = floor ((gdouble) dab->roi.x / DAB_TILE_SIZE) - tile_x0;
+      y0 = floor ((gdouble) dab->roi.y / DAB_TILE_SIZE) - tile_y0;
+      x1 = ceil ((gdouble) (dab->roi.x + dab->roi.width) / DAB_TILE_SIZE) -
+           tile_x0;
+      y1 = ceil ((gdouble) (dab->roi.y + dab->roi.height) / DAB_TILE_SIZE) -
+           tile_y0;
+
+      for (y = y0; y < y1; y++)
+        {
+          for (x = x0; x < x1; x++)
+            {
+              GArray **dabs = &tiles[y * n_tiles_x + x];
+
+              if (! *dabs)
+                *dabs = g_array_new (FALSE, FALSE, sizeof (guint));
+
+              g_array_append_val (*dabs, i);
+            }
+        }
+    }
+
+  g_array_set_size (surface->dab_tiles, 0);
+
+  for (j = 0; j < n_tiles_x * n_tiles_y; j++)
+    {
+      GimpMybrushDabTile tile;
+
+      if (! tiles[j])
+        continue;
+
+      tile.rect = *GEGL_RECTANGLE ((tile_x0 + j % n_tiles_x) * DAB_TILE_SIZE,
+                                   (tile_y0 + j / n_tiles_x) * DAB_TILE_SIZE,
+                                   DAB_TILE_SIZE, DAB_TILE_SIZE);
+      tile.dabs = tiles[j];
+
+      gegl_rectangle_intersect (&tile.rect, &tile.rect, bounds);
+
+      g_array_append_val (surface->dab_tiles, tile);
+    }
+
+  gegl_parallel_distribute_range (
+    surface->dab_tiles->len, DAB_TILES_PER_THREAD,
+    (GeglParallelDistributeRangeFunc) gimp_mypaint_surface_draw_tiles,
+    surface);
+
+  for (i = 0; i < surface->dab_tiles->len; i++)
+    {
+      g_array_free (g_array_index (surface->dab_tiles,
+                                   GimpMybrushDabTile, i).dabs,
+                    TRUE);
+    }
+
+  g_array_set_size (surface->dab_tiles, 0);
+  g_array_set_size (surface->dabs, 0);
+  surface->dabs_bounds = *GEGL_RECTANGLE (0, 0, 0, 0);
+
+  g_free (tiles);
+}
+
 static void
 gimp_mypaint_surface_get_color (MyPaintSurface *base_surface,
                                 float           x,
@@ -242,6 +602,9 @@ gimp_mypaint_surface_get_color (MyPaintSurface *base_surface,
   GimpMybrushSurface *surface = (GimpMybrushSurface *)base_surface;
   GeglRectangle dabRect;
 
+  /*  the pending dabs must be drawn before sampling the surface  */
+  gimp_mypaint_surface_flush_dabs (surface);
+
   if (radius < 1.0f)
     radius = 1.0f;
 
@@ -254,7 +617,9 @@ gimp_mypaint_surface_get_color (MyPaintSurface *base_surface,
 
   if (dabRect.width > 0 || dabRect.height > 0)
   {
-    const float one_over_radius2 = 1.0f / (radius * radius);
+    /* pixel_weight == a standard dab with hardness = 0.5, aspect_ratio = 1.0, and angle = 0.0 */
+    GimpMybrushDab dab = { 0, };
+    float *weights;
     float sum_weight = 0.0f;
     float sum_r = 0.0f;
     float sum_g = 0.0f;
@@ -276,6 +641,18 @@ gimp_mypaint_surface_get_color (MyPaintSurface *base_surface,
                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
       }
 
+    dab.x                = x;
+    dab.y                = y;
+    dab.hardness         = 0.5f;
+    dab.segment1_slope   = -1.0f;
+    dab.segment2_slope   = -1.0f;
+    dab.aspect_ratio     = 1.0f;
+    dab.sn               = 0.0f;
+    dab.cs               = 1.0f;
+    dab.one_over_radius2 = 1.0f / (radius * radius);
+
+    weights = g_new (float, dabRect.width);
+
     while (gegl_buffer_iterator_next (iter))
       {
         float *pixel = (float *)iter->items[0].data;
@@ -289,15 +666,13 @@ gimp_mypaint_surface_get_color (MyPaintSurface *base_surface,
 
         for (iy = iter->items[0].roi.y; iy < iter->items[0].roi.y + iter->items[0].roi.height; iy++)
           {
-            float yy = (iy + 0.5f - y);
-            for (ix = iter->items[0].roi.x; ix < iter->items[0].roi.x +  iter->items[0].roi.width; ix++)
+            gimp_mypaint_surface_dab_row (surface, &dab,
+                                          iter->items[0].roi.x, iy,
+                                          iter->items[0].roi.width, weights);
+
+            for (ix = 0; ix < iter->items[0].roi.width; ix++)
               {
-                /* pixel_weight == a standard dab with hardness = 0.5, aspect_ratio = 1.0, and angle = 0.0 */
-                float xx = (ix + 0.5f - x);
-                float rr = (yy * yy + xx * xx) * one_over_radius2;
-                float pixel_weight = 0.0f;
-                if (rr <= 1.0f)
-                  pixel_weight = 1.0f - rr;
+                float pixel_weight = weights[ix];
                 if (mask)
                   pixel_weight *= *mask;
 
@@ -314,6 +689,8 @@ gimp_mypaint_surface_get_color (MyPaintSurface *base_surface,
           }
       }
 
+    g_free (weights);
+
     if (sum_a > 0.0f && sum_weight > 0.0f)
       {
         sum_r /= sum_weight;
@@ -352,151 +729,51 @@ gimp_mypaint_surface_draw_dab (MyPaintSurface *base_surface,
                                float           colorize)
 {
   GimpMybrushSurface *surface = (GimpMybrushSurface *)base_surface;
-  GeglBufferIterator *iter;
-  GeglRectangle       dabRect;
-  GimpComponentMask   component_mask = surface->component_mask;
+  GimpMybrushDab      dab;
 
-  const float one_over_radius2 = 1.0f / (radius * radius);
   const double angle_rad = angle / 360 * 2 * M_PI;
-  const float cs = cos(angle_rad);
-  const float sn = sin(angle_rad);
-  float normal_mode;
-  float segment1_slope;
-  float segment2_slope;
-  float r_aa_start;
 
   hardness = CLAMP (hardness, 0.0f, 1.0f);
-  segment1_slope = -(1.0f / hardness - 1.0f);
-  segment2_slope = -hardness / (1.0f - hardness);
   aspect_ratio = MAX (1.0f, aspect_ratio);
 
-  r_aa_start = radius - 1.0f;
-  r_aa_start = MAX (r_aa_start, 0);
-  r_aa_start = (r_aa_start * r_aa_start) / aspect_ratio;
-
-  normal_mode = opaque * (1.0f - colorize);
-  colorize = opaque * colorize;
+  dab.x                = x;
+  dab.y                = y;
+  dab.color_r          = color_r;
+  dab.color_g          = color_g;
+  dab.color_b          = color_b;
+  dab.color_a          = color_a;
+  dab.hardness         = hardness;
+  dab.segment1_slope   = -(1.0f / hardness - 1.0f);
+  dab.segment2_slope   = -hardness / (1.0f - hardness);
+  dab.aspect_ratio     = aspect_ratio;
+  dab.sn               = sin (angle_rad);
+  dab.cs               = cos (angle_rad);
+  dab.one_over_radius2 = 1.0f / (radius * radius);
+  dab.antialiased      = radius < 3.0f;
+
+  dab.r_aa_start = radius - 1.0f;
+  dab.r_aa_start = MAX (dab.r_aa_start, 0);
+  dab.r_aa_start = (dab.r_aa_start * dab.r_aa_start) / aspect_ratio;
+
+  dab.normal_mode = opaque * (1.0f - colorize);
+  dab.colorize    = opaque * colorize;
 
   /* FIXME: This should use the real matrix values to trim aspect_ratio dabs */
-  dabRect = calculate_dab_roi (x, y, radius);
-  gegl_rectangle_intersect (&dabRect, &dabRect, gegl_buffer_get_extent (surface->buffer));
+  dab.roi = calculate_dab_roi (x, y, radius);
+  gegl_rectangle_intersect (&dab.roi, &dab.roi, gegl_buffer_get_extent (surface->buffer));
 
-  if (dabRect.width <= 0 || dabRect.height <= 0)
+  if (dab.roi.width <= 0 || dab.roi.height <= 0)
     return 0;
 
-  gegl_rectangle_bounding_box (&surface->dirty, &surface->dirty, &dabRect);
+  gegl_rectangle_bounding_box (&surface->dirty, &surface->dirty, &dab.roi);
 
-  iter = gegl_buffer_iterator_new (surface->buffer, &dabRect, 0,
-                                   babl_format ("R'G'B'A float"),
-                                   GEGL_BUFFER_READWRITE,
-                                   GEGL_ABYSS_NONE, 2);
-  if (surface->paint_mask)
-    {
-      GeglRectangle mask_roi = dabRect;
-      mask_roi.x -= surface->paint_mask_x;
-      mask_roi.y -= surface->paint_mask_y;
-      gegl_buffer_iterator_add (iter, surface->paint_mask, &mask_roi, 0,
-                                babl_format ("Y float"),
-                                GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-    }
+  if (surface->dabs->len >= MAX_PENDING_DABS)
+    gimp_mypaint_surface_flush_dabs (surface);
 
-  while (gegl_buffer_iterator_next (iter))
-    {
-      float *pixel = (float *)iter->items[0].data;
-      float *mask;
-      int iy, ix;
+  gegl_rectangle_bounding_box (&surface->dabs_bounds,
+                               &surface->dabs_bounds, &dab.roi);
 
-      if (surface->paint_mask)
-        mask = iter->items[1].data;
-      else
-        mask = NULL;
-
-      for (iy = iter->items[0].roi.y; iy < iter->items[0].roi.y + iter->items[0].roi.height; iy++)
-        {
-          for (ix = iter->items[0].roi.x; ix < iter->items[0].roi.x +  iter->items[0].roi.width; ix++)
-            {
-              float rr, base_alpha, alpha, dst_alpha, r, g, b, a;
-              if (radius < 3.0f)
-                rr = calculate_rr_antialiased (ix, iy, x, y, aspect_ratio, sn, cs, one_over_radius2, r_aa_start);
-              else
-                rr = calculate_rr (ix, iy, x, y, aspect_ratio, sn, cs, one_over_radius2);
-              base_alpha = calculate_alpha_for_rr (rr, hardness, segment1_slope, segment2_slope);
-              alpha = base_alpha * normal_mode;
-              if (mask)
-                alpha *= *mask;
-              dst_alpha = pixel[ALPHA];
-              /* a = alpha * color_a + dst_alpha * (1.0f - alpha);
-               * which converts to: */
-              a = alpha * (color_a - dst_alpha) + dst_alpha;
-              r = pixel[RED];
-              g = pixel[GREEN];
-              b = pixel[BLUE];
-
-              if (a > 0.0f)
-                {
-                  /* By definition the ratio between each color[] and pixel[] component in a non-pre-multipled blend always sums to 1.0f.
-                   * Originally this would have been "(color[n] * alpha * color_a + pixel[n] * dst_alpha * (1.0f - alpha)) / a",
-                   * instead we only calculate the cheaper term. */
-                  float src_term = (alpha * color_a) / a;
-                  float dst_term = 1.0f - src_term;
-                  r = color_r * src_term + r * dst_term;
-                  g = color_g * src_term + g * dst_term;
-                  b = color_b * src_term + b * dst_term;
-                }
-
-              if (colorize > 0.0f && base_alpha > 0.0f)
-                {
-                  alpha = base_alpha * colorize;
-                  a = alpha + dst_alpha - alpha * dst_alpha;
-                  if (a > 0.0f)
-                    {
-                      GimpHSL pixel_hsl, out_hsl;
-                      GimpRGB pixel_rgb = {color_r, color_g, color_b};
-                      GimpRGB out_rgb   = {r, g, b};
-                      float src_term = alpha / a;
-                      float dst_term = 1.0f - src_term;
-
-                      gimp_rgb_to_hsl (&pixel_rgb, &pixel_hsl);
-                      gimp_rgb_to_hsl (&out_rgb, &out_hsl);
-
-                      out_hsl.h = pixel_hsl.h;
-                      out_hsl.s = pixel_hsl.s;
-                      gimp_hsl_to_rgb (&out_hsl, &out_rgb);
-
-                      r = (float)out_rgb.r * src_term + r * dst_term;
-                      g = (float)out_rgb.g * src_term + g * dst_term;
-                      b = (float)out_rgb.b * src_term + b * dst_term;
-                    }
-                }
-
-              if (surface->options->no_erasing)
-                a = MAX (a, pixel[ALPHA]);
-
-              if (component_mask != GIMP_COMPONENT_MASK_ALL)
-                {
-                  if (component_mask & GIMP_COMPONENT_MASK_RED)
-                    pixel[RED]   = r;
-                  if (component_mask & GIMP_COMPONENT_MASK_GREEN)
-                    pixel[GREEN] = g;
-                  if (component_mask & GIMP_COMPONENT_MASK_BLUE)
-                    pixel[BLUE]  = b;
-                  if (component_mask & GIMP_COMPONENT_MASK_ALPHA)
-                    pixel[ALPHA] = a;
-                }
-              else
-                {
-                  pixel[RED]   = r;
-                  pixel[GREEN] = g;
-                  pixel[BLUE]  = b;
-                  pixel[ALPHA] = a;
-                }
-
-              pixel += 4;
-              if (mask)
-                mask += 1;
-            }
-        }
-    }
+  g_array_append_val (surface->dabs, dab);
 
   return 1;
 }
@@ -513,6 +790,8 @@ gimp_mypaint_surface_end_atomic (MyPaintSurface   *base_surface,
 {
   GimpMybrushSurface *surface = (GimpMybrushSurface *)base_surface;
 
+  gimp_mypaint_surface_flush_dabs (surface);
+
   roi->x         = surface->dirty.x;
   roi->y         = surface->dirty.y;
   roi->width     = surface->dirty.width;
@@ -525,6 +804,10 @@ gimp_mypaint_surface_destroy (MyPaintSurface *base_surface)
 {
   GimpMybrushSurface *surface = (GimpMybrushSurface *)base_surface;
 
+  gimp_mypaint_surface_flush_dabs (surface);
+
+  g_array_free (surface->dabs, TRUE);
+  g_array_free (surface->dab_tiles, TRUE);
   g_clear_object (&surface->buffer);
   g_clear_object (&surface->paint_mask);
   g_free (surface);
@@ -557,5 +840,15 @@ gimp_mypaint_surface_new (GeglBuffer         *buffer,
   surface->paint_mask_y         = paint_mask_y;
   surface->dirty                = *GEGL_RECTANGLE (0, 0, 0, 0);
 
+  surface->dabs        = g_array_new (FALSE, FALSE, sizeof (GimpMybrushDab));
+  surface->dabs_bounds = *GEGL_RECTANGLE (0, 0, 0, 0);
+  surface->dab_tiles   = g_array_new (FALSE, FALSE,
+                                      sizeof (GimpMybrushDabTile));
+
+#if COMPILE_SSE2_INTRINISICS
+  surface->sse2 = (gimp_cpu_accel_get_support () &
+                   GIMP_CPU_ACCEL_X86_SSE2) != 0;
+#endif
+
   return surface;
 }
@@ -272,6 +272,11 @@ _gimp_paintbrush_motion (GimpPaintCore    *paint_core,
                                                fade_point);
 
   n_strokes = gimp_symmetry_get_size (sym);
+
+  /*  paint the symmetry strokes which don't overlap concurrently  */
+  if (n_strokes > 1)
+    gimp_paint_core_begin_paste_batch (paint_core);
+
   for (i = 0; i < n_strokes; i++)
     {
       GimpLayerMode             paint_mode;
@@ -383,4 +388,7 @@ _gimp_paintbrush_motion (GimpPaintCore    *paint_core,
                                     force,
                                     paint_appl_mode);
     }
+
+  if (n_strokes > 1)
+    gimp_paint_core_end_paste_batch (paint_core);
 }
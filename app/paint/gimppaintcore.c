@@ -60,6 +60,15 @@
 
 #define STROKE_BUFFER_INIT_SIZE 2000
 
+
+typedef struct
+{
+  GimpDrawable                *drawable;
+  GimpPaintCoreLoopsParams     params;
+  GimpPaintCoreLoopsAlgorithm  algorithms;
+  GeglRectangle                rect;
+} GimpPaintCorePaste;
+
 enum
 {
   PROP_0,
@@ -114,6 +123,15 @@ static GeglBuffer *
                                                       gint             *paint_buffer_y,
                                                       gint             *paint_width,
                                                       gint             *paint_height);
+static void      gimp_paint_core_queue_paste         (GimpPaintCore                  *core,
+                                                      GimpDrawable                   *drawable,
+                                                      const GimpPaintCoreLoopsParams *params,
+                                                      GimpPaintCoreLoopsAlgorithm     algorithms);
+static void      gimp_paint_core_flush_paste_batch   (GimpPaintCore    *core);
+static void      gimp_paint_core_paste_batch_func    (gint              i,
+                                                      gint              n,
+                                                      GArray           *batch);
+
 static GimpUndo* gimp_paint_core_real_push_undo      (GimpPaintCore    *core,
                                                       GimpImage        *image,
                                                       const gchar      *undo_desc);
@@ -175,6 +193,9 @@ gimp_paint_core_finalize (GObject *object)
       core->stroke_buffer = NULL;
     }
 
+  if (core->paste_batch)
+    gimp_paint_core_end_paste_batch (core);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -296,6 +317,106 @@ gimp_paint_core_real_push_undo (GimpPaintCore *core,
                                NULL);
 }
 
+static void
+gimp_paint_core_queue_paste (GimpPaintCore                  *core,
+                             GimpDrawable                   *drawable,
+                             const GimpPaintCoreLoopsParams *params,
+                             GimpPaintCoreLoopsAlgorithm     algorithms)
+{
+  GimpPaintCorePaste paste;
+  gint               i;
+
+  paste.drawable   = drawable;
+  paste.params     = *params;
+  paste.algorithms = algorithms;
+
+  gegl_rectangle_set (&paste.rect,
+                      params->paint_buf_offset_x,
+                      params->paint_buf_offset_y,
+                      gimp_temp_buf_get_width  (params->paint_buf),
+                      gimp_temp_buf_get_height (params->paint_buf));
+
+  /*  overlapping pastes have to be applied in order  */
+  for (i = 0; i < core->paste_batch->len; i++)
+    {
+      const GimpPaintCorePaste *other;
+
+      other = &g_array_index (core->paste_batch, GimpPaintCorePaste, i);
+
+      if (gegl_rectangle_intersect (NULL, &paste.rect, &other->rect))
+        {
+          gimp_paint_core_flush_paste_batch (core);
+
+          break;
+        }
+    }
+
+  /*  the paint buffer and the paint mask are reused by the next paste  */
+  paste.params.paint_buf = gimp_temp_buf_copy (params->paint_buf);
+
+  if (params->paint_mask)
+    paste.params.paint_mask = gimp_temp_buf_ref (params->paint_mask);
+
+  g_array_append_val (core->paste_batch, paste);
+}
+
+static void
+gimp_paint_core_flush_paste_batch (GimpPaintCore *core)
+{
+  gint i;
+
+  if (! core->paste_batch || core->paste_batch->len == 0)
+    return;
+
+  if (core->paste_batch->len == 1)
+    {
+      gimp_paint_core_paste_batch_func (0, 1, core->paste_batch);
+    }
+  else
+    {
+      gegl_parallel_distribute (
+        core->paste_batch->len,
+        (GeglParallelDistributeFunc) gimp_paint_core_paste_batch_func,
+        core->paste_batch);
+    }
+
+  for (i = 0; i < core->paste_batch->len; i++)
+    {
+      GimpPaintCorePaste *paste;
+
+      paste = &g_array_index (core->paste_batch, GimpPaintCorePaste, i);
+
+      gimp_temp_buf_unref (paste->params.paint_buf);
+
+      if (paste->params.paint_mask)
+        gimp_temp_buf_unref (paste->params.paint_mask);
+
+      gimp_drawable_update (paste->drawable,
+                            paste->rect.x,     paste->rect.y,
+                            paste->rect.width, paste->rect.height);
+    }
+
+  g_array_set_size (core->paste_batch, 0);
+}
+
+static void
+gimp_paint_core_paste_batch_func (gint    i,
+                                  gint    n,
+                                  GArray *batch)
+{
+  /*  the queued pastes don't overlap, so they can be applied in any
+   *  order
+   */
+  for (; i < batch->len; i += n)
+    {
+      const GimpPaintCorePaste *paste;
+
+      paste = &g_array_index (batch, GimpPaintCorePaste, i);
+
+      gimp_paint_core_loops_process (&paste->params, paste->algorithms);
+    }
+}
+
 
 /*  public functions  */
 
@@ -859,6 +980,7 @@ gimp_paint_core_paste (GimpPaintCore            *core,
   gint               height = gegl_buffer_get_height (core->paint_buffer);
   GimpComponentMask  affect = gimp_drawable_get_active_mask (drawable);
   GeglBuffer        *undo_buffer;
+  gboolean           queued = FALSE;
 
   undo_buffer = g_hash_table_lookup (core->undo_buffers, drawable);
 
@@ -871,6 +993,8 @@ gimp_paint_core_paste (GimpPaintCore            *core,
 
       applicator = g_hash_table_lookup (core->applicators, drawable);
 
+      gimp_paint_core_flush_paste_batch (core);
+
       /*  If the mode is CONSTANT:
        *   combine the canvas buffer and the paint mask to the paint buffer
        */
@@ -1020,7 +1144,16 @@ gimp_paint_core_paste (GimpPaintCore            *core,
           algorithms |= GIMP_PAINT_CORE_LOOPS_ALGORITHM_MASK_COMPONENTS;
         }
 
-      gimp_paint_core_loops_process (&params, algorithms);
+      if (core->paste_batch)
+        {
+          gimp_paint_core_queue_paste (core, drawable, &params, algorithms);
+
+          queued = TRUE;
+        }
+      else
+        {
+          gimp_paint_core_loops_process (&params, algorithms);
+        }
     }
 
   /*  Update the undo extents  */
@@ -1029,11 +1162,16 @@ gimp_paint_core_paste (GimpPaintCore            *core,
   core->x2 = MAX (core->x2, core->paint_buffer_x + width);
   core->y2 = MAX (core->y2, core->paint_buffer_y + height);
 
-  /*  Update the drawable  */
-  gimp_drawable_update (drawable,
-                        core->paint_buffer_x,
-                        core->paint_buffer_y,
-                        width, height);
+  /*  Update the drawable, unless the paste was queued, in which case it's
+   *  updated once applied
+   */
+  if (! queued)
+    {
+      gimp_drawable_update (drawable,
+                            core->paint_buffer_x,
+                            core->paint_buffer_y,
+                            width, height);
+    }
 }
 
 /* This works similarly to gimp_paint_core_paste. However, instead of
@@ -1071,6 +1209,8 @@ gimp_paint_core_replace (GimpPaintCore            *core,
       return;
     }
 
+  gimp_paint_core_flush_paste_batch (core);
+
   width  = gegl_buffer_get_width  (core->paint_buffer);
   height = gegl_buffer_get_height (core->paint_buffer);
 
@@ -1235,6 +1375,38 @@ gimp_paint_core_replace (GimpPaintCore            *core,
                         width, height);
 }
 
+/**
+ * gimp_paint_core_begin_paste_batch:
+ * @core: a #GimpPaintCore
+ *
+ * Starts queuing the pastes of @core, so that consecutive pastes that
+ * don't overlap, such as the strokes of a symmetry, are applied
+ * concurrently.  Overlapping pastes are still applied in order, so the
+ * result is the same as when pasting directly.
+ *
+ * The queued pastes are applied by gimp_paint_core_end_paste_batch().
+ * Pastes that go through an applicator are never queued.
+ */
+void
+gimp_paint_core_begin_paste_batch (GimpPaintCore *core)
+{
+  g_return_if_fail (GIMP_IS_PAINT_CORE (core));
+  g_return_if_fail (core->paste_batch == NULL);
+
+  core->paste_batch = g_array_new (FALSE, FALSE, sizeof (GimpPaintCorePaste));
+}
+
+void
+gimp_paint_core_end_paste_batch (GimpPaintCore *core)
+{
+  g_return_if_fail (GIMP_IS_PAINT_CORE (core));
+  g_return_if_fail (core->paste_batch != NULL);
+
+  gimp_paint_core_flush_paste_batch (core);
+
+  g_clear_pointer (&core->paste_batch, g_array_unref);
+}
+
 /**
  * Smooth and store coords in the stroke buffer
  */
@@ -71,6 +71,8 @@ struct _GimpPaintCore
   GHashTable     *applicators;
 
   GArray         *stroke_buffer;
+
+  GArray         *paste_batch;       /*  pastes waiting to be applied        */
 };
 
 struct _GimpPaintCoreClass
@@ -207,6 +209,9 @@ void      gimp_paint_core_replace           (GimpPaintCore            *core,
                                              gdouble                   image_opacity,
                                              GimpPaintApplicationMode  mode);
 
+void      gimp_paint_core_begin_paste_batch         (GimpPaintCore    *core);
+void      gimp_paint_core_end_paste_batch           (GimpPaintCore    *core);
+
 void      gimp_paint_core_smooth_coords             (GimpPaintCore    *core,
                                                      GimpPaintOptions *paint_options,
                                                      GimpCoords       *coords);
@@ -56,6 +56,20 @@
 
 /*  local function prototypes  */
 
+static GeglBuffer * gimp_plug_in_get_tile_buffer (GimpPlugIn    *plug_in,
+                                                    gint32         drawable_id,
+                                                    gboolean       shadow,
+                                                    gboolean       write);
+static gboolean gimp_plug_in_get_tiles_length    (GeglBuffer      *buffer,
+                                                  guint32          first_tile,
+                                                  guint32          n_tiles,
+                                                  gsize           *length);
+static void gimp_plug_in_copy_tiles              (GeglBuffer      *buffer,
+                                                  guint32          first_tile,
+                                                  guint32          n_tiles,
+                                                  guchar          *data,
+                                                  gboolean         write);
+
 static void gimp_plug_in_handle_quit             (GimpPlugIn      *plug_in);
 static void gimp_plug_in_handle_tile_request     (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
@@ -63,6 +77,14 @@ static void gimp_plug_in_handle_tile_put         (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
 static void gimp_plug_in_handle_tile_get         (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
+static void gimp_plug_in_handle_tiles_request    (GimpPlugIn      *plug_in,
+                                                  GPTilesReq      *request);
+static void gimp_plug_in_handle_tiles_put        (GimpPlugIn      *plug_in,
+                                                  GPTilesReq      *request);
+static void gimp_plug_in_handle_tiles_get        (GimpPlugIn      *plug_in,
+                                                  GPTilesReq      *request);
+static void gimp_plug_in_handle_tiles_map        (GimpPlugIn      *plug_in,
+                                                  GPTilesMapReq   *request);
 static void gimp_plug_in_handle_proc_run         (GimpPlugIn      *plug_in,
                                                   GPProcRun       *proc_run);
 static void gimp_plug_in_handle_proc_return      (GimpPlugIn      *plug_in,
@@ -160,12 +182,122 @@ gimp_plug_in_handle_message (GimpPlugIn      *plug_in,
     case GP_HAS_INIT:
       gimp_plug_in_handle_has_init (plug_in);
       break;
+
+    case GP_TILES_REQ:
+      gimp_plug_in_handle_tiles_request (plug_in, msg->data);
+      break;
+
+    case GP_TILES_DATA:
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "sent a TILES_DATA message.  This should not happen.",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+      break;
+
+    case GP_TILES_MAP_REQ:
+      gimp_plug_in_handle_tiles_map (plug_in, msg->data);
+      break;
+
+    case GP_TILES_MAP:
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "sent a TILES_MAP message.  This should not happen.",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+      break;
     }
 }
 
 
 /*  private functions  */
 
+static GeglBuffer *
+gimp_plug_in_get_tile_buffer (GimpPlugIn *plug_in,
+                              gint32      drawable_id,
+                              gboolean    shadow,
+                              gboolean    write)
+{
+  GimpDrawable *drawable;
+  GeglBuffer   *buffer;
+
+  drawable = (GimpDrawable *) gimp_item_get_by_id (plug_in->manager->gimp,
+                                                   drawable_id);
+
+  if (! GIMP_IS_DRAWABLE (drawable))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried %s invalid drawable %d (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    write ? "writing to" : "reading from",
+                    drawable_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried %s drawable %d which was removed "
+                    "from the image (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    write ? "writing to" : "reading from",
+                    drawable_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+
+  if (shadow)
+    {
+      /*  don't check whether the drawable is a group or locked here,
+       *  the plugin will get a proper error message when it tries to
+       *  merge the shadow tiles, which is much better than just
+       *  killing it.
+       */
+      buffer = gimp_drawable_get_shadow_buffer (drawable);
+
+      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
+    }
+  else if (write)
+    {
+      if (gimp_item_is_content_locked (GIMP_ITEM (drawable), NULL))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-in \"%s\"\n(%s)\n\n"
+                        "tried writing to a locked drawable %d (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file),
+                        drawable_id);
+          gimp_plug_in_close (plug_in, TRUE);
+          return NULL;
+        }
+      else if (gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-in \"%s\"\n(%s)\n\n"
+                        "tried writing to a group layer %d (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file),
+                        drawable_id);
+          gimp_plug_in_close (plug_in, TRUE);
+          return NULL;
+        }
+
+      buffer = gimp_drawable_get_buffer (drawable);
+    }
+  else
+    {
+      buffer = gimp_drawable_get_buffer (drawable);
+    }
+
+  return buffer;
+}
+
 static void
 gimp_plug_in_handle_quit (GimpPlugIn *plug_in)
 {
@@ -191,7 +323,6 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
   GPTileData       tile_data;
   GPTileData      *tile_info;
   GimpWireMessage  msg;
-  GimpDrawable    *drawable;
   GeglBuffer      *buffer;
   const Babl      *format;
   GeglRectangle    tile_rect;
@@ -231,72 +362,13 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
 
   tile_info = msg.data;
 
-  drawable = (GimpDrawable *) gimp_item_get_by_id (plug_in->manager->gimp,
-                                                   tile_info->drawable_id);
+  buffer = gimp_plug_in_get_tile_buffer (plug_in,
+                                         tile_info->drawable_id,
+                                         tile_info->shadow,
+                                         TRUE);
 
-  if (! GIMP_IS_DRAWABLE (drawable))
-    {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried writing to invalid drawable %d (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    tile_info->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
-      return;
-    }
-  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
-    {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried writing to drawable %d which was removed "
-                    "from the image (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    tile_info->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
-      return;
-    }
-
-  if (tile_info->shadow)
-    {
-
-      /*  don't check whether the drawable is a group or locked here,
-       *  the plugin will get a proper error message when it tries to
-       *  merge the shadow tiles, which is much better than just
-       *  killing it.
-       */
-      buffer = gimp_drawable_get_shadow_buffer (drawable);
-
-      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
-    }
-  else
-    {
-      if (gimp_item_is_content_locked (GIMP_ITEM (drawable), NULL))
-        {
-          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                        "Plug-in \"%s\"\n(%s)\n\n"
-                        "tried writing to a locked drawable %d (killing)",
-                        gimp_object_get_name (plug_in),
-                        gimp_file_get_utf8_name (plug_in->file),
-                        tile_info->drawable_id);
-          gimp_plug_in_close (plug_in, TRUE);
-          return;
-        }
-      else if (gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
-        {
-          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                        "Plug-in \"%s\"\n(%s)\n\n"
-                        "tried writing to a group layer %d (killing)",
-                        gimp_object_get_name (plug_in),
-                        gimp_file_get_utf8_name (plug_in->file),
-                        tile_info->drawable_id);
-          gimp_plug_in_close (plug_in, TRUE);
-          return;
-        }
-
-      buffer = gimp_drawable_get_buffer (drawable);
-    }
+  if (! buffer)
+    return;
 
   if (! gimp_gegl_buffer_get_tile_rect (buffer,
                                         GIMP_PLUG_IN_TILE_WIDTH,
@@ -346,49 +418,18 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
 {
   GPTileData       tile_data;
   GimpWireMessage  msg;
-  GimpDrawable    *drawable;
   GeglBuffer      *buffer;
   const Babl      *format;
   GeglRectangle    tile_rect;
   gint             tile_size;
 
-  drawable = (GimpDrawable *) gimp_item_get_by_id (plug_in->manager->gimp,
-                                                   request->drawable_id);
-
-  if (! GIMP_IS_DRAWABLE (drawable))
-    {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried reading from invalid drawable %d (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    request->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
-      return;
-    }
-  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
-    {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried reading from drawable %d which was removed "
-                    "from the image (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    request->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
-      return;
-    }
+  buffer = gimp_plug_in_get_tile_buffer (plug_in,
+                                         request->drawable_id,
+                                         request->shadow,
+                                         FALSE);
 
-  if (request->shadow)
-    {
-      buffer = gimp_drawable_get_shadow_buffer (drawable);
-
-      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
-    }
-  else
-    {
-      buffer = gimp_drawable_get_buffer (drawable);
-    }
+  if (! buffer)
+    return;
 
   if (! gimp_gegl_buffer_get_tile_rect (buffer,
                                         GIMP_PLUG_IN_TILE_WIDTH,
@@ -461,6 +502,344 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
   gimp_wire_destroy (&msg);
 }
 
+static gboolean
+gimp_plug_in_get_tiles_length (GeglBuffer *buffer,
+                               guint32     first_tile,
+                               guint32     n_tiles,
+                               gsize      *length)
+{
+  const Babl *format = gegl_buffer_get_format (buffer);
+  gint        bpp    = babl_format_get_bytes_per_pixel (format);
+  guint64     total  = 0;
+  guint32     i;
+
+  if (n_tiles == 0 || first_tile > G_MAXINT || n_tiles > G_MAXINT - first_tile)
+    return FALSE;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      GeglRectangle tile_rect;
+
+      if (! gimp_gegl_buffer_get_tile_rect (buffer,
+                                            GIMP_PLUG_IN_TILE_WIDTH,
+                                            GIMP_PLUG_IN_TILE_HEIGHT,
+                                            first_tile + i,
+                                            &tile_rect))
+        {
+          return FALSE;
+        }
+
+      total += (guint64) tile_rect.width * tile_rect.height * bpp;
+    }
+
+  if (total > G_MAXUINT32)
+    return FALSE;
+
+  *length = total;
+
+  return TRUE;
+}
+
+static void
+gimp_plug_in_copy_tiles (GeglBuffer *buffer,
+                         guint32     first_tile,
+                         guint32     n_tiles,
+                         guchar     *data,
+                         gboolean    write)
+{
+  const Babl *format = gegl_buffer_get_format (buffer);
+  gint        bpp    = babl_format_get_bytes_per_pixel (format);
+  guint32     i;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      GeglRectangle tile_rect;
+
+      gimp_gegl_buffer_get_tile_rect (buffer,
+                                      GIMP_PLUG_IN_TILE_WIDTH,
+                                      GIMP_PLUG_IN_TILE_HEIGHT,
+                                      first_tile + i,
+                                      &tile_rect);
+
+      if (write)
+        {
+          gegl_buffer_set (buffer, &tile_rect, 0, format,
+                           data, GEGL_AUTO_ROWSTRIDE);
+        }
+      else
+        {
+          gegl_buffer_get (buffer, &tile_rect, 1.0, format,
+                           data, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+        }
+
+      data += tile_rect.width * tile_rect.height * bpp;
+    }
+}
+
+static void
+gimp_plug_in_handle_tiles_request (GimpPlugIn *plug_in,
+                                   GPTilesReq *request)
+{
+  g_return_if_fail (request != NULL);
+
+  if (request->drawable_id == -1)
+    gimp_plug_in_handle_tiles_put (plug_in, request);
+  else
+    gimp_plug_in_handle_tiles_get (plug_in, request);
+}
+
+static void
+gimp_plug_in_handle_tiles_put (GimpPlugIn *plug_in,
+                               GPTilesReq *request)
+{
+  GPTilesData      tiles_data = { 0, };
+  GPTilesData     *tiles_info;
+  GimpWireMessage  msg;
+  GeglBuffer      *buffer;
+  const Babl      *format;
+  gsize            length;
+
+  tiles_data.drawable_id = -1;
+  tiles_data.use_shm     = (plug_in->manager->shm != NULL);
+
+  if (! gp_tiles_data_write (plug_in->my_write, &tiles_data, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (msg.type != GP_TILES_DATA)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "expected tiles data and received: %d", msg.type);
+      gimp_wire_destroy (&msg);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  tiles_info = msg.data;
+
+  buffer = gimp_plug_in_get_tile_buffer (plug_in,
+                                         tiles_info->drawable_id,
+                                         tiles_info->shadow,
+                                         TRUE);
+
+  if (! buffer)
+    {
+      gimp_wire_destroy (&msg);
+      return;
+    }
+
+  format = gegl_buffer_get_format (buffer);
+
+  if (! gimp_plug_in_get_tiles_length (buffer,
+                                       tiles_info->first_tile,
+                                       tiles_info->n_tiles,
+                                       &length)                       ||
+      length != tiles_info->length                                    ||
+      tiles_info->bpp != babl_format_get_bytes_per_pixel (format)     ||
+      (tiles_info->use_shm                                            &&
+       (! plug_in->manager->shm                                       ||
+        length > gimp_plug_in_shm_get_size (plug_in->manager->shm))))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "requested invalid tiles #%u-%u for writing (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    tiles_info->first_tile,
+                    tiles_info->first_tile + tiles_info->n_tiles - 1);
+      gimp_wire_destroy (&msg);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (tiles_info->use_shm)
+    {
+      gimp_plug_in_copy_tiles (buffer,
+                               tiles_info->first_tile, tiles_info->n_tiles,
+                               gimp_plug_in_shm_get_addr (plug_in->manager->shm),
+                               TRUE);
+    }
+  else
+    {
+      gimp_plug_in_copy_tiles (buffer,
+                               tiles_info->first_tile, tiles_info->n_tiles,
+                               tiles_info->data,
+                               TRUE);
+    }
+
+  gimp_wire_destroy (&msg);
+
+  if (! gp_tile_ack_write (plug_in->my_write, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+}
+
+static void
+gimp_plug_in_handle_tiles_get (GimpPlugIn *plug_in,
+                               GPTilesReq *request)
+{
+  GPTilesData      tiles_data = { 0, };
+  GimpWireMessage  msg;
+  GeglBuffer      *buffer;
+  gsize            length;
+
+  buffer = gimp_plug_in_get_tile_buffer (plug_in,
+                                         request->drawable_id,
+                                         request->shadow,
+                                         FALSE);
+
+  if (! buffer)
+    return;
+
+  if (! gimp_plug_in_get_tiles_length (buffer,
+                                       request->first_tile,
+                                       request->n_tiles,
+                                       &length))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "requested invalid tiles #%u-%u for reading (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    request->first_tile,
+                    request->first_tile + request->n_tiles - 1);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  tiles_data.drawable_id = request->drawable_id;
+  tiles_data.first_tile  = request->first_tile;
+  tiles_data.n_tiles     = request->n_tiles;
+  tiles_data.shadow      = request->shadow;
+  tiles_data.bpp         = babl_format_get_bytes_per_pixel (
+                             gegl_buffer_get_format (buffer));
+  tiles_data.length      = length;
+
+  /*  fall back to the pipe when the run doesn't fit into shared memory  */
+  tiles_data.use_shm = (plug_in->manager->shm != NULL &&
+                        length <= gimp_plug_in_shm_get_size (plug_in->manager->shm));
+
+  if (tiles_data.use_shm)
+    {
+      gimp_plug_in_copy_tiles (buffer,
+                               request->first_tile, request->n_tiles,
+                               gimp_plug_in_shm_get_addr (plug_in->manager->shm),
+                               FALSE);
+    }
+  else
+    {
+      tiles_data.data = g_malloc (length);
+
+      gimp_plug_in_copy_tiles (buffer,
+                               request->first_tile, request->n_tiles,
+                               tiles_data.data,
+                               FALSE);
+    }
+
+  if (! gp_tiles_data_write (plug_in->my_write, &tiles_data, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      g_free (tiles_data.data);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  g_free (tiles_data.data);
+
+  if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (msg.type != GP_TILE_ACK)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "expected tile ack and received: %d", msg.type);
+      gimp_wire_destroy (&msg);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  gimp_wire_destroy (&msg);
+}
+
+static void
+gimp_plug_in_handle_tiles_map (GimpPlugIn    *plug_in,
+                               GPTilesMapReq *request)
+{
+  GPTilesMap       tiles_map;
+  GimpWireMessage  msg;
+  GeglBuffer      *buffer;
+  gboolean         success = TRUE;
+
+  g_return_if_fail (request != NULL);
+
+  buffer = gimp_plug_in_get_tile_buffer (plug_in,
+                                         request->drawable_id,
+                                         request->shadow,
+                                         FALSE);
+
+  if (! buffer)
+    return;
+
+  tiles_map.drawable_id = request->drawable_id;
+  tiles_map.shadow      = request->shadow;
+  tiles_map.bpp         = babl_format_get_bytes_per_pixel (
+                            gegl_buffer_get_format (buffer));
+  tiles_map.name        = gimp_plug_in_shm_export_buffer (buffer);
+
+  /*  the plug-in acks once it has mapped the tiles, after which we
+   *  can remove the name
+   */
+  if (! gp_tiles_map_write (plug_in->my_write, &tiles_map, plug_in) ||
+      ! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      success = FALSE;
+    }
+  else
+    {
+      if (msg.type != GP_TILE_ACK)
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "expected tile ack and received: %d", msg.type);
+          success = FALSE;
+        }
+
+      gimp_wire_destroy (&msg);
+    }
+
+  if (tiles_map.name)
+    {
+      gimp_plug_in_shm_unexport_buffer (tiles_map.name);
+      g_free (tiles_map.name);
+    }
+
+  if (! success)
+    gimp_plug_in_close (plug_in, TRUE);
+}
+
 static void
 gimp_plug_in_handle_proc_error (GimpPlugIn          *plug_in,
                                 GimpPlugInProcFrame *proc_frame,
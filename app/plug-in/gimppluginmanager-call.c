@@ -55,6 +55,24 @@
 #include "gimp-intl.h"
 
 
+/*  the maximal number of plug-ins to query or initialize at once  */
+#define MAX_STARTUP_PLUG_INS 8
+
+
+/*  local function prototypes  */
+
+static void       gimp_plug_in_manager_call_startup   (GimpPlugInManager  *manager,
+                                                       GimpContext        *context,
+                                                       GimpPlugInCallMode  call_mode,
+                                                       GSList             *plug_in_defs,
+                                                       GimpInitStatusFunc  status_callback);
+static gboolean   gimp_plug_in_manager_startup_recv   (GIOChannel         *channel,
+                                                       GIOCondition        cond,
+                                                       GimpPlugIn         *plug_in);
+
+
+/*  private functions  */
+
 static void
 gimp_allow_set_foreground_window (GimpPlugIn *plug_in)
 {
@@ -63,87 +81,176 @@ gimp_allow_set_foreground_window (GimpPlugIn *plug_in)
 #endif
 }
 
-
-/*  public functions  */
-
-void
-gimp_plug_in_manager_call_query (GimpPlugInManager *manager,
-                                 GimpContext       *context,
-                                 GimpPlugInDef     *plug_in_def)
+/*  Runs the query() or init() function of each plug-in in @plug_in_defs.
+ *  Up to MAX_STARTUP_PLUG_INS plug-ins run at once; their messages are
+ *  dispatched from a private main context, so nothing else runs in
+ *  between.  Each plug-in only modifies its own GimpPlugInDef, so the
+ *  result doesn't depend on the order in which they finish.
+ */
+static void
+gimp_plug_in_manager_call_startup (GimpPlugInManager  *manager,
+                                   GimpContext        *context,
+                                   GimpPlugInCallMode  call_mode,
+                                   GSList             *plug_in_defs,
+                                   GimpInitStatusFunc  status_callback)
 {
-  GimpPlugIn *plug_in;
+  GMainContext *main_context;
+  GList        *running   = NULL;
+  gint          n_running = 0;
+  gint          max_running;
+  gint          n_plugins;
+  gint          nth;
 
-  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
-  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
-  g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
+  /*  plug-ins wrapped in a debugger are run one by one  */
+  if (manager->debug)
+    max_running = 1;
+  else
+    max_running = CLAMP (g_get_num_processors (), 1, MAX_STARTUP_PLUG_INS);
 
-  plug_in = gimp_plug_in_new (manager, context, NULL,
-                              NULL, plug_in_def->file);
+  main_context = g_main_context_new ();
 
-  if (plug_in)
+  n_plugins = g_slist_length (plug_in_defs);
+  nth       = 0;
+
+  while (plug_in_defs || running)
     {
-      plug_in->plug_in_def = plug_in_def;
+      GList *list;
 
-      if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_QUERY, TRUE))
+      while (plug_in_defs && n_running < max_running)
         {
-          while (plug_in->open)
+          GimpPlugInDef *plug_in_def = plug_in_defs->data;
+          GimpPlugIn    *plug_in;
+          gchar         *basename;
+
+          plug_in_defs = g_slist_next (plug_in_defs);
+
+          basename =
+            g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
+          status_callback (NULL, basename,
+                           (gdouble) nth++ / (gdouble) n_plugins);
+          g_free (basename);
+
+          if (manager->gimp->be_verbose)
+            g_print (call_mode == GIMP_PLUG_IN_CALL_QUERY ?
+                     "Querying plug-in: '%s'\n" :
+                     "Initializing plug-in: '%s'\n",
+                     gimp_file_get_utf8_name (plug_in_def->file));
+
+          plug_in = gimp_plug_in_new (manager, context, NULL,
+                                      NULL, plug_in_def->file);
+
+          if (! plug_in)
+            continue;
+
+          plug_in->plug_in_def = plug_in_def;
+
+          if (gimp_plug_in_open (plug_in, call_mode, TRUE))
             {
-              GimpWireMessage msg;
-
-              if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
-                {
-                  gimp_plug_in_close (plug_in, TRUE);
-                }
-              else
-                {
-                  gimp_plug_in_handle_message (plug_in, &msg);
-                  gimp_wire_destroy (&msg);
-                }
+              GSource *source;
+
+              source = g_io_create_watch (plug_in->my_read,
+                                          G_IO_IN  | G_IO_PRI |
+                                          G_IO_ERR | G_IO_HUP);
+
+              g_source_set_callback (source,
+                                     (GSourceFunc) gimp_plug_in_manager_startup_recv,
+                                     g_object_ref (plug_in),
+                                     (GDestroyNotify) g_object_unref);
+
+              g_source_attach (source, main_context);
+              g_source_unref (source);
+
+              running = g_list_prepend (running, plug_in);
+              n_running++;
+            }
+          else
+            {
+              g_object_unref (plug_in);
             }
         }
 
-      g_object_unref (plug_in);
+      if (! running)
+        continue;
+
+      g_main_context_iteration (main_context, TRUE);
+
+      for (list = running; list; )
+        {
+          GimpPlugIn *plug_in = list->data;
+          GList      *next    = g_list_next (list);
+
+          if (! plug_in->open)
+            {
+              running = g_list_delete_link (running, list);
+              n_running--;
+
+              g_object_unref (plug_in);
+            }
+
+          list = next;
+        }
     }
+
+  g_main_context_unref (main_context);
 }
 
-void
-gimp_plug_in_manager_call_init (GimpPlugInManager *manager,
-                                GimpContext       *context,
-                                GimpPlugInDef     *plug_in_def)
+static gboolean
+gimp_plug_in_manager_startup_recv (GIOChannel   *channel,
+                                   GIOCondition  cond,
+                                   GimpPlugIn   *plug_in)
 {
-  GimpPlugIn *plug_in;
+  if (plug_in->open)
+    {
+      GimpWireMessage msg;
+
+      /*  on G_IO_HUP, reading fails and closes the plug-in, like the
+       *  blocking loop of a synchronous call would
+       */
+      if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+        {
+          gimp_plug_in_close (plug_in, TRUE);
+        }
+      else
+        {
+          gimp_plug_in_handle_message (plug_in, &msg);
+          gimp_wire_destroy (&msg);
+        }
+    }
 
+  return plug_in->open ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+
+/*  public functions  */
+
+void
+gimp_plug_in_manager_call_query (GimpPlugInManager  *manager,
+                                 GimpContext        *context,
+                                 GSList             *plug_in_defs,
+                                 GimpInitStatusFunc  status_callback)
+{
   g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
   g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
-  g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
+  g_return_if_fail (status_callback != NULL);
 
-  plug_in = gimp_plug_in_new (manager, context, NULL,
-                              NULL, plug_in_def->file);
-
-  if (plug_in)
-    {
-      plug_in->plug_in_def = plug_in_def;
+  gimp_plug_in_manager_call_startup (manager, context,
+                                     GIMP_PLUG_IN_CALL_QUERY,
+                                     plug_in_defs, status_callback);
+}
 
-      if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_INIT, TRUE))
-        {
-          while (plug_in->open)
-            {
-              GimpWireMessage msg;
-
-              if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
-                {
-                  gimp_plug_in_close (plug_in, TRUE);
-                }
-              else
-                {
-                  gimp_plug_in_handle_message (plug_in, &msg);
-                  gimp_wire_destroy (&msg);
-                }
-            }
-        }
+void
+gimp_plug_in_manager_call_init (GimpPlugInManager  *manager,
+                                GimpContext        *context,
+                                GSList             *plug_in_defs,
+                                GimpInitStatusFunc  status_callback)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
+  g_return_if_fail (status_callback != NULL);
 
-      g_object_unref (plug_in);
-    }
+  gimp_plug_in_manager_call_startup (manager, context,
+                                     GIMP_PLUG_IN_CALL_INIT,
+                                     plug_in_defs, status_callback);
 }
 
 GimpValueArray *
@@ -208,6 +315,9 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
       config.shm_id               = (manager->shm ?
                                      gimp_plug_in_shm_get_id (manager->shm) :
                                      -1);
+      config.shm_size             = (manager->shm ?
+                                     gimp_plug_in_shm_get_size (manager->shm) :
+                                     0);
       config.check_size           = display_config->transparency_size;
       config.check_type           = display_config->transparency_type;
       config.check_custom_color1  = display_config->transparency_custom_color1;
@@ -443,11 +443,11 @@ gimp_plug_in_manager_query_new (GimpPlugInManager  *manager,
                                 GimpInitStatusFunc  status_callback)
 {
   GSList *list;
-  gint    n_plugins;
+  GSList *plug_in_defs = NULL;
 
   status_callback (_("Querying new Plug-ins"), "", 0.0);
 
-  for (list = manager->plug_in_defs, n_plugins = 0; list; list = list->next)
+  for (list = manager->plug_in_defs; list; list = list->next)
     {
       GimpPlugInDef *plug_in_def = list->data;
 
@@ -455,36 +455,22 @@ gimp_plug_in_manager_query_new (GimpPlugInManager  *manager,
         gimp_plug_in_def_set_needs_query (plug_in_def, TRUE);
 
       if (plug_in_def->needs_query)
-        n_plugins++;
+        plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
     }
 
-  if (n_plugins)
+  if (plug_in_defs)
     {
-      gint nth;
-
       manager->write_pluginrc = TRUE;
 
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
-        {
-          GimpPlugInDef *plug_in_def = list->data;
-
-          if (plug_in_def->needs_query)
-            {
-              gchar *basename;
-
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
+      /*  the plug-ins run concurrently, but each one only fills its
+       *  own plug-in def, which keeps its place in manager->plug_in_defs
+       */
+      plug_in_defs = g_slist_reverse (plug_in_defs);
 
-              if (manager->gimp->be_verbose)
-                g_print ("Querying plug-in: '%s'\n",
-                         gimp_file_get_utf8_name (plug_in_def->file));
+      gimp_plug_in_manager_call_query (manager, context, plug_in_defs,
+                                       status_callback);
 
-              gimp_plug_in_manager_call_query (manager, context, plug_in_def);
-            }
-        }
+      g_slist_free (plug_in_defs);
     }
 
   status_callback (NULL, "", 1.0);
@@ -497,43 +483,26 @@ gimp_plug_in_manager_init_plug_ins (GimpPlugInManager  *manager,
                                     GimpInitStatusFunc  status_callback)
 {
   GSList *list;
-  gint    n_plugins;
+  GSList *plug_in_defs = NULL;
 
   status_callback (_("Initializing Plug-ins"), "", 0.0);
 
-  for (list = manager->plug_in_defs, n_plugins = 0; list; list = list->next)
+  for (list = manager->plug_in_defs; list; list = list->next)
     {
       GimpPlugInDef *plug_in_def = list->data;
 
       if (plug_in_def->has_init)
-        n_plugins++;
+        plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
     }
 
-  if (n_plugins)
+  if (plug_in_defs)
     {
-      gint nth;
-
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
-        {
-          GimpPlugInDef *plug_in_def = list->data;
-
-          if (plug_in_def->has_init)
-            {
-              gchar *basename;
-
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
+      plug_in_defs = g_slist_reverse (plug_in_defs);
 
-              if (manager->gimp->be_verbose)
-                g_print ("Initializing plug-in: '%s'\n",
-                         gimp_file_get_utf8_name (plug_in_def->file));
+      gimp_plug_in_manager_call_init (manager, context, plug_in_defs,
+                                      status_callback);
 
-              gimp_plug_in_manager_call_init (manager, context, plug_in_def);
-            }
-        }
+      g_slist_free (plug_in_defs);
     }
 
   status_callback (NULL, "", 1.0);
@@ -64,6 +64,8 @@
 
 #include "plug-in-types.h"
 
+#include "gegl/gimp-gegl-tile-compat.h"
+
 #include "core/gimp-utils.h"
 
 #include "gimppluginshm.h"
@@ -71,7 +73,10 @@
 #include "gimp-log.h"
 
 
-#define TILE_MAP_SIZE (GIMP_PLUG_IN_TILE_WIDTH * GIMP_PLUG_IN_TILE_HEIGHT * 32)
+/* room for a run of 16 tiles of the largest pixel size, so that runs
+ * of tiles can be transferred in one go, see GP_TILES_REQ
+ */
+#define TILE_MAP_SIZE (GIMP_PLUG_IN_TILE_WIDTH * GIMP_PLUG_IN_TILE_HEIGHT * 32 * 16)
 
 #define ERRMSG_SHM_DISABLE "Disabling shared memory tile transport"
 
@@ -305,3 +310,137 @@ gimp_plug_in_shm_get_addr (GimpPlugInShm *shm)
 
   return shm->shm_addr;
 }
+
+gsize
+gimp_plug_in_shm_get_size (GimpPlugInShm *shm)
+{
+  g_return_val_if_fail (shm != NULL, 0);
+
+  return TILE_MAP_SIZE;
+}
+
+/*  copies all of @buffer's tiles into a new shared memory object the
+ *  plug-in can map, and returns its name, or NULL if that's not
+ *  supported.  the object must be removed with
+ *  gimp_plug_in_shm_unexport_buffer() once the plug-in mapped it.
+ */
+gchar *
+gimp_plug_in_shm_export_buffer (GeglBuffer *buffer)
+{
+#if defined(USE_POSIX_SHM)
+
+  static gint  export_id = 0;
+  const Babl  *format;
+  gchar       *name;
+  gint         n_tiles;
+  gsize        tile_size;
+  gsize        size;
+  gint         shm_fd;
+  guchar      *addr;
+  gint         i;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+
+  format    = gegl_buffer_get_format (buffer);
+  n_tiles   = gimp_gegl_buffer_get_n_tile_rows (buffer, GIMP_PLUG_IN_TILE_HEIGHT) *
+              gimp_gegl_buffer_get_n_tile_cols (buffer, GIMP_PLUG_IN_TILE_WIDTH);
+  tile_size = (gsize) GIMP_PLUG_IN_TILE_WIDTH * GIMP_PLUG_IN_TILE_HEIGHT *
+              babl_format_get_bytes_per_pixel (format);
+  size      = n_tiles * tile_size;
+
+  if (size == 0)
+    return NULL;
+
+  name = g_strdup_printf ("/gimp-shm-%d-%d",
+                          gimp_get_pid (), g_atomic_int_add (&export_id, 1));
+
+  shm_fd = shm_open (name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+  if (shm_fd == -1)
+    {
+      g_printerr ("shm_open() failed: %s\n", g_strerror (errno));
+      g_free (name);
+
+      return NULL;
+    }
+
+#ifdef HAVE_POSIX_FALLOCATE
+  /*  actually reserve the memory, so that running out of it makes us
+   *  fall back to sending the tiles over the wire, instead of the
+   *  writes below raising SIGBUS.
+   */
+  if ((errno = posix_fallocate (shm_fd, 0, size)) != 0)
+    {
+      g_printerr ("posix_fallocate() failed: %s\n", g_strerror (errno));
+      close (shm_fd);
+      shm_unlink (name);
+      g_free (name);
+
+      return NULL;
+    }
+#else
+  if (ftruncate (shm_fd, size) == -1)
+    {
+      g_printerr ("ftruncate() failed: %s\n", g_strerror (errno));
+      close (shm_fd);
+      shm_unlink (name);
+      g_free (name);
+
+      return NULL;
+    }
+#endif
+
+  addr = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+
+  close (shm_fd);
+
+  if (addr == MAP_FAILED)
+    {
+      g_printerr ("mmap() failed: %s\n", g_strerror (errno));
+      shm_unlink (name);
+      g_free (name);
+
+      return NULL;
+    }
+
+  /*  lay the tiles out like the plug-in's GEGL tiles, so it can use
+   *  them in place
+   */
+  for (i = 0; i < n_tiles; i++)
+    {
+      GeglRectangle tile_rect;
+
+      gimp_gegl_buffer_get_tile_rect (buffer,
+                                      GIMP_PLUG_IN_TILE_WIDTH,
+                                      GIMP_PLUG_IN_TILE_HEIGHT,
+                                      i, &tile_rect);
+
+      gegl_buffer_get (buffer, &tile_rect, 1.0, format,
+                       addr + i * tile_size,
+                       GIMP_PLUG_IN_TILE_WIDTH *
+                       babl_format_get_bytes_per_pixel (format),
+                       GEGL_ABYSS_NONE);
+    }
+
+  munmap (addr, size);
+
+  GIMP_LOG (SHM, "exported buffer %p as %s", buffer, name);
+
+  return name;
+
+#else
+
+  return NULL;
+
+#endif
+}
+
+void
+gimp_plug_in_shm_unexport_buffer (const gchar *name)
+{
+  g_return_if_fail (name != NULL);
+
+#if defined(USE_POSIX_SHM)
+  shm_unlink (name);
+#endif
+}
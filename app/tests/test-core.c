@@ -15,21 +15,47 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
+#include <string.h>
+
 #include <gegl.h>
 #include <gtk/gtk.h>
 
+#include "libgimpconfig/gimpconfig.h"
+
 #include "widgets/widgets-types.h"
 
 #include "widgets/gimpuimanager.h"
 
+#include "gegl/gimp-gegl-apply-operation.h"
+#include "gegl/gimptilebackendcompressed.h"
+
 #include "core/gimp.h"
+#include "core/gimpboundary.h"
+#include "core/gimpasync.h"
 #include "core/gimpcontext.h"
+#include "core/gimphistogram.h"
 #include "core/gimpimage.h"
+#include "core/gimpimage-symmetry.h"
+#include "core/gimpimage-undo.h"
 #include "core/gimplayer.h"
 #include "core/gimplayer-new.h"
+#include "core/gimplist.h"
+#include "core/gimppaintinfo.h"
+#include "core/gimpsymmetry.h"
+#include "core/gimpsymmetry-mirror.h"
+#include "core/gimpundo.h"
+#include "core/gimpundostack.h"
+#include "core/gimpwaitable.h"
 
 #include "operations/gimplevelsconfig.h"
 
+#include "paint/paint-types.h"
+
+#include "paint/gimppaintcore.h"
+#include "paint/gimppaintcore-stroke.h"
+#include "paint/gimppaintoptions.h"
+
 #include "tests.h"
 
 #include "gimp-app-test-utils.h"
@@ -225,6 +251,687 @@ remove_layer (GimpTestFixture *fixture,
   g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
 }
 
+static void
+undo_stack_check_memsize (GimpUndoStack *stack)
+{
+  GList  *list;
+  gint64  memsize  = 0;
+  gint64  gui_size = 0;
+  gint64  undo_memsize;
+  gint64  undo_gui_size;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      gint64 child_gui_size;
+
+      memsize  += gimp_object_get_memsize (list->data, &child_gui_size);
+      gui_size += child_gui_size;
+    }
+
+  undo_memsize = gimp_undo_stack_get_undo_memsize (stack, &undo_gui_size);
+
+  g_assert_cmpint (undo_memsize,  ==, memsize);
+  g_assert_cmpint (undo_gui_size, ==, gui_size);
+}
+
+/**
+ * undo_memsize:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the running size of the undo and redo stacks matches
+ * the size of the undo steps on them, across pushing, undoing and
+ * redoing, and creating the steps' previews after they were pushed.
+ **/
+static void
+undo_memsize (GimpTestFixture *fixture,
+              gconstpointer    data)
+{
+  GimpImage     *image      = fixture->image;
+  GimpContext   *context    = gimp_get_user_context (image->gimp);
+  GimpUndoStack *undo_stack = gimp_image_get_undo_stack (image);
+  GimpUndoStack *redo_stack = gimp_image_get_redo_stack (image);
+  GList         *list;
+  gint           i;
+
+  for (i = 0; i < 4; i++)
+    {
+      GimpLayer *layer;
+
+      layer = gimp_layer_new (image,
+                              GIMP_TEST_IMAGE_SIZE,
+                              GIMP_TEST_IMAGE_SIZE,
+                              babl_format ("R'G'B'A u8"),
+                              "Test Layer",
+                              GIMP_OPACITY_OPAQUE,
+                              GIMP_LAYER_MODE_NORMAL);
+
+      gimp_image_add_layer (image,
+                            layer,
+                            GIMP_IMAGE_ACTIVE_PARENT,
+                            0,
+                            TRUE);
+
+      undo_stack_check_memsize (undo_stack);
+    }
+
+  for (list = GIMP_LIST (undo_stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      gimp_undo_create_preview (list->data, context, TRUE);
+    }
+
+  undo_stack_check_memsize (undo_stack);
+
+  gimp_image_undo (image);
+  gimp_image_undo (image);
+
+  undo_stack_check_memsize (undo_stack);
+  undo_stack_check_memsize (redo_stack);
+
+  for (list = GIMP_LIST (undo_stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      gimp_undo_refresh_preview (list->data, context);
+    }
+
+  undo_stack_check_memsize (undo_stack);
+
+  gimp_image_redo (image);
+
+  undo_stack_check_memsize (undo_stack);
+  undo_stack_check_memsize (redo_stack);
+}
+
+/**
+ * compressed_tile_backend:
+ * @data:
+ *
+ * Makes sure a buffer stored in a GimpTileBackendCompressed reads back
+ * the same pixels it was given, including partial edge tiles, and that
+ * its memsize reflects the compressed size of its tiles.
+ **/
+static void
+compressed_tile_backend (GimpTestFixture *fixture,
+                         gconstpointer    data)
+{
+  const Babl      *format = babl_format ("R'G'B'A u8");
+  GeglRectangle    extent = { 0, 0, 300, 200 };
+  GeglTileBackend *backend;
+  GeglBuffer      *buffer;
+  GeglBuffer      *compressed;
+  guchar          *pixels;
+  guchar          *compressed_pixels;
+  gint64           memsize;
+  gint             size;
+  gint             i;
+
+  size = extent.width * extent.height * 4;
+
+  /* Mix compressible runs with noise */
+  pixels = g_malloc (size);
+
+  for (i = 0; i < size; i++)
+    pixels[i] = (i / 64) % 3 ? (i / 256) & 0xff : g_test_rand_int () & 0xff;
+
+  buffer = gegl_buffer_new (&extent, format);
+
+  gegl_buffer_set (buffer, &extent, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+
+  backend = gimp_tile_backend_compressed_new (&extent, 64, 64, format);
+  g_assert_cmpint (gimp_tile_backend_compressed_get_memsize (
+                     GIMP_TILE_BACKEND_COMPRESSED (backend)), ==, 0);
+
+  compressed = gegl_buffer_new_for_backend (&extent, backend);
+
+  gegl_buffer_copy (buffer, &extent, GEGL_ABYSS_NONE, compressed, &extent);
+  gegl_buffer_flush (compressed);
+
+  memsize = gimp_tile_backend_compressed_get_memsize (
+              GIMP_TILE_BACKEND_COMPRESSED (backend));
+
+  g_assert_cmpint (memsize, >, 0);
+  g_assert_cmpint (memsize, <, size);
+
+  /* Drop the cached tiles, so that they are decompressed again */
+  g_object_unref (buffer);
+  g_object_unref (compressed);
+
+  compressed = gegl_buffer_new_for_backend (&extent, backend);
+
+  g_object_unref (backend);
+
+  compressed_pixels = g_malloc (size);
+
+  gegl_buffer_get (compressed, &extent, 1.0, format, compressed_pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_assert (memcmp (pixels, compressed_pixels, size) == 0);
+
+  g_assert_cmpint (gimp_tile_backend_compressed_get_memsize (
+                     GIMP_TILE_BACKEND_COMPRESSED (backend)), ==, memsize);
+
+  g_free (compressed_pixels);
+  g_free (pixels);
+
+  g_object_unref (compressed);
+}
+
+static gfloat *
+mask_grow_shrink (const gfloat *mask,
+                  gint          width,
+                  gint          height,
+                  gboolean      shrink,
+                  gint          radius_x,
+                  gint          radius_y,
+                  gboolean      edge_lock)
+{
+  const Babl    *format = babl_format ("Y float");
+  GeglRectangle  rect   = { 0, 0, width, height };
+  GeglBuffer    *src_buffer;
+  GeglBuffer    *dest_buffer;
+  gfloat        *result;
+
+  src_buffer  = gegl_buffer_new (&rect, format);
+  dest_buffer = gegl_buffer_new (&rect, format);
+
+  gegl_buffer_set (src_buffer, &rect, 0, format, mask, GEGL_AUTO_ROWSTRIDE);
+
+  if (shrink)
+    gimp_gegl_apply_shrink (src_buffer, NULL, NULL, dest_buffer, &rect,
+                            radius_x, radius_y, edge_lock);
+  else
+    gimp_gegl_apply_grow (src_buffer, NULL, NULL, dest_buffer, &rect,
+                          radius_x, radius_y);
+
+  result = g_new (gfloat, width * height);
+
+  gegl_buffer_get (dest_buffer, &rect, 1.0, format, result,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (dest_buffer);
+  g_object_unref (src_buffer);
+
+  return result;
+}
+
+/**
+ * mask_dilate:
+ * @data:
+ *
+ * Makes sure growing and shrinking a binary mask, which uses
+ * gimp_gegl_mask_dilate(), selects the same pixels as the scanline
+ * code used for antialiased masks.  The scanline code is fed the same
+ * mask with its selected pixels at 0.75, so that it isn't binary, and
+ * its result is thresholded.
+ **/
+static void
+mask_dilate (GimpTestFixture *fixture,
+             gconstpointer    data)
+{
+  /* taller than a sub-band of gimp_gegl_mask_dilate() */
+  const gint width  = 300;
+  const gint height = 300;
+  const struct
+  {
+    gint radius_x;
+    gint radius_y;
+  } radii[] = { { 1, 1 }, { 5, 3 }, { 2, 9 }, { 1, 4 }, { 20, 20 } };
+  gfloat *mask;
+  gfloat *scaled_mask;
+  gint    i;
+
+  mask        = g_new (gfloat, width * height);
+  scaled_mask = g_new (gfloat, width * height);
+
+  for (i = 0; i < width * height; i++)
+    {
+      gint x = i % width;
+      gint y = i / width;
+
+      mask[i] = (((x / 13 + y / 7) % 3 == 0) !=
+                 (g_test_rand_int_range (0, 50) == 0)) ? 1.0f : 0.0f;
+
+      scaled_mask[i] = mask[i] * 0.75f;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (radii) * 3; i++)
+    {
+      gboolean  shrink    = i % 3 != 0;
+      gboolean  edge_lock = i % 3 == 2;
+      gfloat   *binary;
+      gfloat   *scanline;
+      gint      j;
+
+      binary   = mask_grow_shrink (mask, width, height, shrink,
+                                   radii[i / 3].radius_x,
+                                   radii[i / 3].radius_y,
+                                   edge_lock);
+      scanline = mask_grow_shrink (scaled_mask, width, height, shrink,
+                                   radii[i / 3].radius_x,
+                                   radii[i / 3].radius_y,
+                                   edge_lock);
+
+      for (j = 0; j < width * height; j++)
+        g_assert_cmpint (binary[j] >= 0.5f, ==, scanline[j] >= 0.5f);
+
+      g_free (scanline);
+      g_free (binary);
+    }
+
+  g_free (scaled_mask);
+  g_free (mask);
+}
+
+static gint
+boundary_seg_compare (const GimpBoundSeg *seg1,
+                      const GimpBoundSeg *seg2)
+{
+  gboolean vertical1 = seg1->x1 == seg1->x2;
+  gboolean vertical2 = seg2->x1 == seg2->x2;
+
+  if (vertical1 != vertical2)
+    return vertical1 - vertical2;
+
+  if (vertical1)
+    {
+      if (seg1->x1 != seg2->x1)
+        return seg1->x1 - seg2->x1;
+
+      return seg1->y1 - seg2->y1;
+    }
+  else
+    {
+      if (seg1->y1 != seg2->y1)
+        return seg1->y1 - seg2->y1;
+
+      return seg1->x1 - seg2->x1;
+    }
+}
+
+/*  returns @segs in a canonical order, with the segments which continue
+ *  each other merged
+ */
+static GArray *
+boundary_normalize (const GimpBoundSeg *segs,
+                    gint                num_segs)
+{
+  GArray *array = g_array_new (FALSE, FALSE, sizeof (GimpBoundSeg));
+  gint    i;
+  gint    j;
+
+  for (i = 0; i < num_segs; i++)
+    {
+      GimpBoundSeg seg = segs[i];
+
+      seg.x1      = MIN (segs[i].x1, segs[i].x2);
+      seg.x2      = MAX (segs[i].x1, segs[i].x2);
+      seg.y1      = MIN (segs[i].y1, segs[i].y2);
+      seg.y2      = MAX (segs[i].y1, segs[i].y2);
+      seg.visited = FALSE;
+
+      g_array_append_val (array, seg);
+    }
+
+  g_array_sort (array, (GCompareFunc) boundary_seg_compare);
+
+  for (i = 0, j = 1; j < array->len; j++)
+    {
+      GimpBoundSeg *prev = &g_array_index (array, GimpBoundSeg, i);
+      GimpBoundSeg *seg  = &g_array_index (array, GimpBoundSeg, j);
+
+      if (prev->open == seg->open   &&
+          prev->x2   == seg->x1     &&
+          prev->y2   == seg->y1     &&
+          (prev->x1 == prev->x2) == (seg->x1 == seg->x2))
+        {
+          prev->x2 = seg->x2;
+          prev->y2 = seg->y2;
+        }
+      else
+        {
+          g_array_index (array, GimpBoundSeg, ++i) = *seg;
+        }
+    }
+
+  if (array->len)
+    g_array_set_size (array, i + 1);
+
+  return array;
+}
+
+/**
+ * boundary_find_area:
+ * @data:
+ *
+ * Makes sure the outlines traced by gimp_boundary_find_area() for a
+ * partition of the bounds of a mask are the same, segment for
+ * segment once the segments split at the area edges are merged, as
+ * the outline traced by gimp_boundary_find().
+ **/
+static void
+boundary_find_area (GimpTestFixture *fixture,
+                    gconstpointer    data)
+{
+  const Babl    *format = babl_format ("Y float");
+  GeglRectangle  rect   = { 0, 0, 300, 200 };
+  GeglRectangle  bounds = { 10, 5, 270, 190 };
+  const gint     area_sizes[] = { 1000, 64, 37 };
+  GeglBuffer    *buffer;
+  gfloat        *mask;
+  GimpBoundSeg  *segs;
+  gint           num_segs;
+  GArray        *expected;
+  gint           i;
+
+  mask = g_new (gfloat, rect.width * rect.height);
+
+  for (i = 0; i < rect.width * rect.height; i++)
+    {
+      gint x = i % rect.width;
+      gint y = i / rect.width;
+
+      mask[i] = (((x / 11 + y / 9) % 4 == 0) !=
+                 (g_test_rand_int_range (0, 20) == 0)) ? 1.0f : 0.0f;
+    }
+
+  buffer = gegl_buffer_new (&rect, format);
+
+  gegl_buffer_set (buffer, &rect, 0, format, mask, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (mask);
+
+  segs = gimp_boundary_find (buffer, NULL, format,
+                             GIMP_BOUNDARY_WITHIN_BOUNDS,
+                             bounds.x,
+                             bounds.y,
+                             bounds.x + bounds.width,
+                             bounds.y + bounds.height,
+                             GIMP_BOUNDARY_HALF_WAY,
+                             &num_segs);
+
+  g_assert_cmpint (num_segs, >, 0);
+
+  expected = boundary_normalize (segs, num_segs);
+
+  g_free (segs);
+
+  for (i = 0; i < G_N_ELEMENTS (area_sizes); i++)
+    {
+      GArray *all_segs = g_array_new (FALSE, FALSE, sizeof (GimpBoundSeg));
+      GArray *result;
+      gint    x, y;
+
+      for (y = 0; y < rect.height; y += area_sizes[i])
+        for (x = 0; x < rect.width; x += area_sizes[i])
+          {
+            GeglRectangle area = { x, y, area_sizes[i], area_sizes[i] };
+
+            segs = gimp_boundary_find_area (buffer, format, &bounds, &area,
+                                            GIMP_BOUNDARY_HALF_WAY,
+                                            &num_segs);
+
+            g_array_append_vals (all_segs, segs, num_segs);
+
+            g_free (segs);
+          }
+
+      result = boundary_normalize ((GimpBoundSeg *) all_segs->data,
+                                   all_segs->len);
+
+      g_assert_cmpint (result->len, ==, expected->len);
+
+      for (x = 0; x < expected->len; x++)
+        {
+          GimpBoundSeg *seg1 = &g_array_index (result,   GimpBoundSeg, x);
+          GimpBoundSeg *seg2 = &g_array_index (expected, GimpBoundSeg, x);
+
+          g_assert_cmpint (seg1->x1,   ==, seg2->x1);
+          g_assert_cmpint (seg1->y1,   ==, seg2->y1);
+          g_assert_cmpint (seg1->x2,   ==, seg2->x2);
+          g_assert_cmpint (seg1->y2,   ==, seg2->y2);
+          g_assert_cmpint (seg1->open, ==, seg2->open);
+        }
+
+      g_array_free (result, TRUE);
+      g_array_free (all_segs, TRUE);
+    }
+
+  g_array_free (expected, TRUE);
+
+  g_object_unref (buffer);
+}
+
+static void
+paint_dab (Gimp         *gimp,
+           GimpDrawable *drawable,
+           gdouble       x,
+           gdouble       y)
+{
+  GimpPaintInfo    *paint_info;
+  GimpPaintOptions *options;
+  GimpPaintCore    *core;
+  GimpCoords        coords = GIMP_COORDS_DEFAULT_VALUES;
+
+  paint_info = GIMP_PAINT_INFO (
+    gimp_container_get_child_by_name (gimp->paint_info_list,
+                                      "gimp-paintbrush"));
+
+  options = GIMP_PAINT_OPTIONS (
+    gimp_config_duplicate (GIMP_CONFIG (paint_info->paint_options)));
+
+  gimp_context_define_properties (GIMP_CONTEXT (options),
+                                  GIMP_CONTEXT_PROP_MASK_PAINT,
+                                  FALSE);
+  gimp_context_set_parent (GIMP_CONTEXT (options),
+                           gimp_get_user_context (gimp));
+
+  g_object_set (options,
+                "brush-size", 10.0,
+                NULL);
+
+  core = g_object_new (paint_info->paint_type, NULL);
+
+  coords.x = x;
+  coords.y = y;
+
+  g_assert (gimp_paint_core_stroke (core, drawable, options,
+                                    &coords, 1, FALSE, NULL));
+
+  g_object_unref (core);
+  g_object_unref (options);
+}
+
+/**
+ * paintbrush_symmetry:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure painting with a mirror symmetry, whose strokes are pasted
+ * in batches, concurrently when they don't overlap, gives the same
+ * pixels as painting each stroke on its own, one after the other.
+ **/
+static void
+paintbrush_symmetry (GimpTestFixture *fixture,
+                     gconstpointer    data)
+{
+  Gimp          *gimp  = GIMP (data);
+  GimpImage     *image = fixture->image;
+  GimpSymmetry  *sym;
+  GimpLayer     *layers[2];
+  GeglRectangle  rect  = { 0, 0, GIMP_TEST_IMAGE_SIZE, GIMP_TEST_IMAGE_SIZE };
+  /* dabs which don't overlap their mirror, and one which does */
+  const gdouble  dabs[][2] = { { 20.0, 10.0 }, { 60.0, 47.0 }, { 80.0, 30.0 } };
+  gfloat        *pixels[2];
+  gint           i;
+
+  for (i = 0; i < 2; i++)
+    {
+      layers[i] = gimp_layer_new (image,
+                                  GIMP_TEST_IMAGE_SIZE,
+                                  GIMP_TEST_IMAGE_SIZE,
+                                  babl_format ("RGBA float"),
+                                  "Test Layer",
+                                  GIMP_OPACITY_OPAQUE,
+                                  GIMP_LAYER_MODE_NORMAL);
+
+      gimp_image_add_layer (image, layers[i], GIMP_IMAGE_ACTIVE_PARENT, 0,
+                            FALSE);
+    }
+
+  /* the mirrored dabs use the same brush mask as the reference ones */
+  gimp_image_set_active_symmetry (image, GIMP_TYPE_MIRROR);
+  sym = gimp_image_get_active_symmetry (image);
+
+  g_object_set (sym,
+                "horizontal-symmetry",    TRUE,
+                "disable-transformation", TRUE,
+                "mirror-position-y",      GIMP_TEST_IMAGE_SIZE / 2.0,
+                NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (dabs); i++)
+    paint_dab (gimp, GIMP_DRAWABLE (layers[0]), dabs[i][0], dabs[i][1]);
+
+  gimp_image_set_active_symmetry (image, GIMP_TYPE_SYMMETRY);
+
+  for (i = 0; i < G_N_ELEMENTS (dabs); i++)
+    {
+      paint_dab (gimp, GIMP_DRAWABLE (layers[1]),
+                 dabs[i][0], dabs[i][1]);
+      paint_dab (gimp, GIMP_DRAWABLE (layers[1]),
+                 dabs[i][0], GIMP_TEST_IMAGE_SIZE - dabs[i][1]);
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      pixels[i] = g_new (gfloat, rect.width * rect.height * 4);
+
+      gegl_buffer_get (gimp_drawable_get_buffer (GIMP_DRAWABLE (layers[i])),
+                       &rect, 1.0, babl_format ("RGBA float"), pixels[i],
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+
+  for (i = 0; i < rect.width * rect.height * 4; i++)
+    g_assert_cmpfloat (fabs (pixels[0][i] - pixels[1][i]), <, 1e-4);
+
+  /* make sure something was painted at all */
+  g_assert_cmpfloat (pixels[0][(10 * rect.width + 20) * 4 + 3], >, 0.0);
+  g_assert_cmpfloat (pixels[0][(90 * rect.width + 20) * 4 + 3], >, 0.0);
+
+  g_free (pixels[0]);
+  g_free (pixels[1]);
+}
+
+static void
+histogram_assert_equal (GimpHistogram *histogram1,
+                        GimpHistogram *histogram2)
+{
+  gint n_bins = gimp_histogram_n_bins (histogram1);
+  gint channel;
+  gint i;
+
+  g_assert_cmpint (gimp_histogram_n_bins (histogram2), ==, n_bins);
+  g_assert_cmpint (gimp_histogram_n_components (histogram2), ==,
+                   gimp_histogram_n_components (histogram1));
+
+  for (channel = GIMP_HISTOGRAM_VALUE;
+       channel <= GIMP_HISTOGRAM_LUMINANCE;
+       channel++)
+    {
+      if (! gimp_histogram_has_channel (histogram1, channel))
+        continue;
+
+      for (i = 0; i < n_bins; i++)
+        {
+          g_assert_cmpfloat (gimp_histogram_get_value (histogram1, channel, i),
+                             ==,
+                             gimp_histogram_get_value (histogram2, channel, i));
+        }
+    }
+}
+
+/**
+ * histogram_incremental:
+ * @data:
+ *
+ * Makes sure an incremental histogram, recalculated after parts of its
+ * buffer changed and were invalidated, is the same as a histogram
+ * calculated from scratch, both synchronously and asynchronously.
+ **/
+static void
+histogram_incremental (GimpTestFixture *fixture,
+                       gconstpointer    data)
+{
+  const Babl    *format = babl_format ("R'G'B'A u8");
+  /* several chunks, with partial ones at the right and bottom */
+  GeglRectangle  rect   = { 0, 0, 700, 600 };
+  GeglRectangle  changes[] = { { 10, 20, 30, 40 }, { 250, 250, 20, 20 },
+                               { 600, 0, 100, 600 } };
+  GimpHistogram *incremental;
+  GimpHistogram *full;
+  GeglBuffer    *buffer;
+  guchar        *pixels;
+  gint           size;
+  gint           i;
+  gint           j;
+
+  size   = rect.width * rect.height * 4;
+  pixels = g_malloc (size);
+
+  for (i = 0; i < size; i++)
+    pixels[i] = g_test_rand_int () & 0xff;
+
+  buffer = gegl_buffer_new (&rect, format);
+
+  gegl_buffer_set (buffer, &rect, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+
+  incremental = gimp_histogram_new (GIMP_TRC_NON_LINEAR);
+  gimp_histogram_set_incremental (incremental, TRUE);
+
+  gimp_histogram_calculate (incremental, buffer, &rect, NULL, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (changes); i++)
+    {
+      GimpAsync *async;
+
+      for (j = 0; j < changes[i].width * changes[i].height * 4; j++)
+        pixels[j] = g_test_rand_int () & 0xff;
+
+      gegl_buffer_set (buffer, &changes[i], 0, format, pixels,
+                       GEGL_AUTO_ROWSTRIDE);
+
+      gimp_histogram_invalidate (incremental, &changes[i]);
+
+      if (i % 2)
+        {
+          async = gimp_histogram_calculate_async (incremental, buffer, &rect,
+                                                  NULL, NULL);
+
+          gimp_waitable_wait (GIMP_WAITABLE (async));
+        }
+      else
+        {
+          gimp_histogram_calculate (incremental, buffer, &rect, NULL, NULL);
+        }
+
+      full = gimp_histogram_new (GIMP_TRC_NON_LINEAR);
+
+      gimp_histogram_calculate (full, buffer, &rect, NULL, NULL);
+
+      histogram_assert_equal (incremental, full);
+
+      g_object_unref (full);
+    }
+
+  g_object_unref (incremental);
+  g_object_unref (buffer);
+  g_free (pixels);
+}
+
 /**
  * white_graypoint_in_red_levels:
  * @fixture:
@@ -277,6 +984,12 @@ main (int    argc,
   ADD_IMAGE_TEST (add_layer);
   ADD_IMAGE_TEST (remove_layer);
   ADD_IMAGE_TEST (rotate_non_overlapping);
+  ADD_IMAGE_TEST (undo_memsize);
+  ADD_IMAGE_TEST (paintbrush_symmetry);
+  ADD_TEST (compressed_tile_backend);
+  ADD_TEST (mask_dilate);
+  ADD_TEST (boundary_find_area);
+  ADD_TEST (histogram_incremental);
   ADD_TEST (white_graypoint_in_red_levels);
 
   /* Run the tests */
@@ -0,0 +1,719 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "widgets/widgets-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpbrush.h"
+#include "core/gimpbrush-load.h"
+#include "core/gimpbrush-private.h"
+#include "core/gimpbrush-save.h"
+#include "core/gimpcontainer.h"
+#include "core/gimpcontext.h"
+#include "core/gimpdataloaderfactory.h"
+#include "core/gimppattern.h"
+#include "core/gimppattern-load.h"
+#include "core/gimppattern-save.h"
+#include "core/gimptagged.h"
+#include "core/gimptempbuf.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define TEST_PATTERN_NAME   "Test Pattern"
+#define TEST_PATTERN_WIDTH  100
+#define TEST_PATTERN_HEIGHT 80
+#define TEST_INDEX_NAME     "test-patterns.index"
+
+#define TEST_BRUSH_NAME        "Test Brush"
+#define TEST_BRUSH_WIDTH       90
+#define TEST_BRUSH_HEIGHT      70
+#define TEST_BRUSH_INDEX_NAME  "test-brushes.index"
+
+#define ADD_TEST(function) \
+  g_test_add ("/gimp-data-index/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              gimp_test_data_index_setup, \
+              function, \
+              gimp_test_data_index_teardown);
+
+
+typedef struct
+{
+  GFile       *pattern_file;
+  GFile       *index_file;
+  GimpTempBuf *mask;
+
+  GFile       *brush_file;
+  GFile       *brush_index_file;
+  GimpTempBuf *brush_mask;
+} GimpTestFixture;
+
+
+static gchar *test_dir = NULL;
+
+
+static GimpTempBuf *
+create_mask (gint        width,
+             gint        height,
+             const Babl *format,
+             guint32     seed)
+{
+  GimpTempBuf *mask;
+  guchar      *data;
+  GRand       *rand;
+  gsize        i;
+
+  mask = gimp_temp_buf_new (width, height, format);
+  data = gimp_temp_buf_get_data (mask);
+  rand = g_rand_new_with_seed (seed);
+
+  for (i = 0; i < gimp_temp_buf_get_data_size (mask); i++)
+    data[i] = g_rand_int_range (rand, 0, 256);
+
+  g_rand_free (rand);
+
+  return mask;
+}
+
+static void
+write_pattern (GFile       *file,
+               GimpTempBuf *mask)
+{
+  GimpPattern   *pattern;
+  GOutputStream *output;
+  GError        *error = NULL;
+
+  pattern = g_object_new (GIMP_TYPE_PATTERN,
+                          "name", TEST_PATTERN_NAME,
+                          NULL);
+  pattern->mask = gimp_temp_buf_ref (mask);
+
+  output = G_OUTPUT_STREAM (g_file_replace (file,
+                                            NULL, FALSE, G_FILE_CREATE_NONE,
+                                            NULL, &error));
+  g_assert_no_error (error);
+
+  g_assert_true (gimp_pattern_save (GIMP_DATA (pattern), output, &error));
+  g_assert_no_error (error);
+
+  g_assert_true (g_output_stream_close (output, NULL, &error));
+  g_assert_no_error (error);
+
+  g_object_unref (output);
+  g_object_unref (pattern);
+}
+
+/*  loads the test directory with a new factory, like on startup, and
+ *  returns the test pattern; whether it has a mask tells if it was
+ *  restored from the index (it's larger than the index's thumbnails)
+ *  or loaded from its file
+ */
+static GimpPattern *
+load_pattern (Gimp *gimp)
+{
+  GimpDataFactory *factory;
+  GimpObject      *pattern;
+
+  factory = gimp_data_loader_factory_new (gimp,
+                                          GIMP_TYPE_PATTERN,
+                                          "pattern-path",
+                                          "pattern-path-writable",
+                                          "pattern-paths",
+                                          NULL,
+                                          gimp_pattern_get_standard);
+  gimp_data_loader_factory_set_parallel (factory, TRUE);
+  gimp_data_loader_factory_add_loader (factory,
+                                       "GIMP Pattern",
+                                       gimp_pattern_load,
+                                       GIMP_PATTERN_FILE_EXTENSION,
+                                       TRUE);
+  gimp_data_loader_factory_set_index (factory,
+                                      TEST_INDEX_NAME,
+                                      gimp_pattern_load_index,
+                                      gimp_pattern_save_index);
+
+  gimp_data_factory_data_init (factory, gimp_get_user_context (gimp), FALSE);
+
+  pattern = gimp_container_get_child_by_name (
+    gimp_data_factory_get_container (factory), TEST_PATTERN_NAME);
+
+  g_assert_nonnull (pattern);
+
+  g_object_ref (pattern);
+
+  gimp_data_factory_data_free (factory);
+  g_object_unref (factory);
+
+  return GIMP_PATTERN (pattern);
+}
+
+static void
+write_brush (GFile       *file,
+             GimpTempBuf *mask)
+{
+  GimpBrush     *brush;
+  GOutputStream *output;
+  GError        *error = NULL;
+
+  brush = g_object_new (GIMP_TYPE_BRUSH,
+                        "name",      TEST_BRUSH_NAME,
+                        "mime-type", "image/x-gimp-gbr",
+                        NULL);
+  brush->priv->mask = gimp_temp_buf_ref (mask);
+
+  output = G_OUTPUT_STREAM (g_file_replace (file,
+                                            NULL, FALSE, G_FILE_CREATE_NONE,
+                                            NULL, &error));
+  g_assert_no_error (error);
+
+  g_assert_true (gimp_brush_save (GIMP_DATA (brush), output, &error));
+  g_assert_no_error (error);
+
+  g_assert_true (g_output_stream_close (output, NULL, &error));
+  g_assert_no_error (error);
+
+  g_object_unref (output);
+  g_object_unref (brush);
+}
+
+/*  like load_pattern(), for the test brush  */
+static GimpBrush *
+load_brush (Gimp *gimp)
+{
+  GimpDataFactory *factory;
+  GimpObject      *brush;
+
+  factory = gimp_data_loader_factory_new (gimp,
+                                          GIMP_TYPE_BRUSH,
+                                          "brush-path",
+                                          "brush-path-writable",
+                                          "brush-paths",
+                                          NULL,
+                                          gimp_brush_get_standard);
+  gimp_data_loader_factory_set_parallel (factory, TRUE);
+  gimp_data_loader_factory_add_loader (factory,
+                                       "GIMP Brush",
+                                       gimp_brush_load,
+                                       GIMP_BRUSH_FILE_EXTENSION,
+                                       TRUE);
+  gimp_data_loader_factory_set_index (factory,
+                                      TEST_BRUSH_INDEX_NAME,
+                                      gimp_brush_load_index,
+                                      gimp_brush_save_index);
+
+  gimp_data_factory_data_init (factory, gimp_get_user_context (gimp), FALSE);
+
+  brush = gimp_container_get_child_by_name (
+    gimp_data_factory_get_container (factory), TEST_BRUSH_NAME);
+
+  g_assert_nonnull (brush);
+
+  g_object_ref (brush);
+
+  gimp_data_factory_data_free (factory);
+  g_object_unref (factory);
+
+  return GIMP_BRUSH (brush);
+}
+
+static void
+assert_mask_equal (GimpTempBuf *mask1,
+                   GimpTempBuf *mask2)
+{
+  g_assert_cmpint (gimp_temp_buf_get_width (mask1),
+                   ==,
+                   gimp_temp_buf_get_width (mask2));
+  g_assert_cmpint (gimp_temp_buf_get_height (mask1),
+                   ==,
+                   gimp_temp_buf_get_height (mask2));
+  g_assert_true (gimp_temp_buf_get_format (mask1) ==
+                 gimp_temp_buf_get_format (mask2));
+
+  g_assert_true (memcmp (gimp_temp_buf_get_data (mask1),
+                         gimp_temp_buf_get_data (mask2),
+                         gimp_temp_buf_get_data_size (mask1)) == 0);
+}
+
+static void
+assert_loaded_from_file (Gimp        *gimp,
+                         GimpTempBuf *mask)
+{
+  GimpPattern *pattern = load_pattern (gimp);
+
+  g_assert_nonnull (pattern->mask);
+  assert_mask_equal (pattern->mask, mask);
+
+  g_object_unref (pattern);
+}
+
+static void
+gimp_test_data_index_setup (GimpTestFixture *fixture,
+                            gconstpointer    data)
+{
+  gchar *path;
+
+  path = g_build_filename (test_dir, "patterns", "test.pat", NULL);
+  fixture->pattern_file = g_file_new_for_path (path);
+  g_free (path);
+
+  fixture->index_file = g_file_new_build_filename (gimp_cache_directory (),
+                                                   TEST_INDEX_NAME,
+                                                   NULL);
+  g_file_delete (fixture->index_file, NULL, NULL);
+
+  path = g_build_filename (test_dir, "brushes", "test.gbr", NULL);
+  fixture->brush_file = g_file_new_for_path (path);
+  g_free (path);
+
+  fixture->brush_index_file =
+    g_file_new_build_filename (gimp_cache_directory (),
+                               TEST_BRUSH_INDEX_NAME,
+                               NULL);
+  g_file_delete (fixture->brush_index_file, NULL, NULL);
+
+  fixture->mask = create_mask (TEST_PATTERN_WIDTH, TEST_PATTERN_HEIGHT,
+                               babl_format ("R'G'B' u8"), 1);
+
+  write_pattern (fixture->pattern_file, fixture->mask);
+
+  fixture->brush_mask = create_mask (TEST_BRUSH_WIDTH, TEST_BRUSH_HEIGHT,
+                                     babl_format ("Y u8"), 4);
+
+  write_brush (fixture->brush_file, fixture->brush_mask);
+}
+
+static void
+gimp_test_data_index_teardown (GimpTestFixture *fixture,
+                               gconstpointer    data)
+{
+  g_file_delete (fixture->pattern_file, NULL, NULL);
+  g_file_delete (fixture->index_file,   NULL, NULL);
+  g_file_delete (fixture->brush_file,       NULL, NULL);
+  g_file_delete (fixture->brush_index_file, NULL, NULL);
+
+  g_clear_object (&fixture->pattern_file);
+  g_clear_object (&fixture->index_file);
+  g_clear_pointer (&fixture->mask, gimp_temp_buf_unref);
+  g_clear_object (&fixture->brush_file);
+  g_clear_object (&fixture->brush_index_file);
+  g_clear_pointer (&fixture->brush_mask, gimp_temp_buf_unref);
+}
+
+/**
+ * round_trip:
+ * @fixture:
+ * @data:
+ *
+ * Make sure that a pattern is loaded from its file when there is no
+ * index, and restored from the index written then on the next load,
+ * without its mask, and that the mask which is loaded on first use
+ * has the same pixels as the eagerly loaded one.
+ **/
+static void
+round_trip (GimpTestFixture *fixture,
+            gconstpointer    data)
+{
+  Gimp        *gimp    = GIMP (data);
+  GimpContext *context = gimp_get_user_context (gimp);
+  GimpPattern *eager;
+  GimpPattern *lazy;
+  GimpTempBuf *preview;
+  gchar       *eager_checksum;
+  gchar       *lazy_checksum;
+  gint         width;
+  gint         height;
+
+  eager = load_pattern (gimp);
+
+  g_assert_nonnull (eager->mask);
+  g_assert_true (g_file_query_exists (fixture->index_file, NULL));
+
+  lazy = load_pattern (gimp);
+
+  g_assert_null (lazy->mask);
+  g_assert_nonnull (lazy->thumbnail);
+
+  g_assert_cmpstr (gimp_object_get_name (lazy),
+                   ==,
+                   gimp_object_get_name (eager));
+
+  gimp_viewable_get_size (GIMP_VIEWABLE (lazy), &width, &height);
+  g_assert_cmpint (width,  ==, TEST_PATTERN_WIDTH);
+  g_assert_cmpint (height, ==, TEST_PATTERN_HEIGHT);
+
+  eager_checksum = gimp_tagged_get_checksum (GIMP_TAGGED (eager));
+  lazy_checksum  = gimp_tagged_get_checksum (GIMP_TAGGED (lazy));
+  g_assert_cmpstr (lazy_checksum, ==, eager_checksum);
+  g_free (eager_checksum);
+  g_free (lazy_checksum);
+
+  /*  small previews are made from the thumbnail  */
+  preview = gimp_viewable_get_new_preview (GIMP_VIEWABLE (lazy), context,
+                                           32, 32);
+  g_assert_nonnull (preview);
+  g_assert_null (lazy->mask);
+  gimp_temp_buf_unref (preview);
+
+  assert_mask_equal (gimp_pattern_get_mask (lazy), eager->mask);
+  assert_mask_equal (gimp_pattern_get_mask (lazy), fixture->mask);
+
+  preview = gimp_viewable_get_new_preview (GIMP_VIEWABLE (lazy), context,
+                                           32, 32);
+  g_assert_nonnull (preview);
+  gimp_temp_buf_unref (preview);
+
+  g_object_unref (lazy);
+  g_object_unref (eager);
+}
+
+/**
+ * brush_round_trip:
+ * @fixture:
+ * @data:
+ *
+ * Make sure that a brush is restored from the index without its mask,
+ * like a pattern, and that the mask which is loaded on first use has
+ * the same pixels as the eagerly loaded one.
+ **/
+static void
+brush_round_trip (GimpTestFixture *fixture,
+                  gconstpointer    data)
+{
+  Gimp        *gimp    = GIMP (data);
+  GimpContext *context = gimp_get_user_context (gimp);
+  GimpBrush   *eager;
+  GimpBrush   *lazy;
+  GimpTempBuf *preview;
+  gchar       *eager_checksum;
+  gchar       *lazy_checksum;
+
+  eager = load_brush (gimp);
+
+  g_assert_nonnull (eager->priv->mask);
+  g_assert_true (g_file_query_exists (fixture->brush_index_file, NULL));
+
+  lazy = load_brush (gimp);
+
+  g_assert_null (lazy->priv->mask);
+  g_assert_nonnull (lazy->priv->thumbnail);
+
+  g_assert_cmpint (gimp_brush_get_width  (lazy), ==, TEST_BRUSH_WIDTH);
+  g_assert_cmpint (gimp_brush_get_height (lazy), ==, TEST_BRUSH_HEIGHT);
+  g_assert_cmpint (gimp_brush_get_spacing (lazy),
+                   ==,
+                   gimp_brush_get_spacing (eager));
+
+  eager_checksum = gimp_tagged_get_checksum (GIMP_TAGGED (eager));
+  lazy_checksum  = gimp_tagged_get_checksum (GIMP_TAGGED (lazy));
+  g_assert_cmpstr (lazy_checksum, ==, eager_checksum);
+  g_free (eager_checksum);
+  g_free (lazy_checksum);
+
+  /*  small previews are made from the thumbnail  */
+  preview = gimp_viewable_get_new_preview (GIMP_VIEWABLE (lazy), context,
+                                           32, 32);
+  g_assert_nonnull (preview);
+  g_assert_null (lazy->priv->mask);
+  gimp_temp_buf_unref (preview);
+
+  assert_mask_equal (gimp_brush_get_mask (lazy), eager->priv->mask);
+  assert_mask_equal (gimp_brush_get_mask (lazy), fixture->brush_mask);
+  g_assert_null (lazy->priv->thumbnail);
+
+  g_object_unref (lazy);
+  g_object_unref (eager);
+}
+
+/**
+ * corrupt_index:
+ * @fixture:
+ * @data:
+ *
+ * Make sure that a truncated or corrupt index is ignored, and
+ * rewritten, and that the pattern is loaded from its file instead.
+ **/
+static void
+corrupt_index (GimpTestFixture *fixture,
+               gconstpointer    data)
+{
+  Gimp    *gimp = GIMP (data);
+  gchar   *contents;
+  gsize    length;
+  gsize    truncated[5];
+  guint32  value;
+  gsize    offset;
+  gint     i;
+  GError  *error = NULL;
+
+  g_object_unref (load_pattern (gimp));
+
+  g_assert_true (g_file_load_contents (fixture->index_file, NULL,
+                                       &contents, &length, NULL, &error));
+  g_assert_no_error (error);
+
+  truncated[0] = 0;
+  truncated[1] = 6;
+  truncated[2] = 3 * sizeof (guint32);
+  truncated[3] = length / 2;
+  truncated[4] = length - 1;
+
+  for (i = 0; i < G_N_ELEMENTS (truncated); i++)
+    {
+      gchar *rewritten;
+      gsize  rewritten_length;
+
+      g_assert_true (g_file_replace_contents (fixture->index_file,
+                                              contents, truncated[i],
+                                              NULL, FALSE, G_FILE_CREATE_NONE,
+                                              NULL, NULL, &error));
+      g_assert_no_error (error);
+
+      assert_loaded_from_file (gimp, fixture->mask);
+
+      g_assert_true (g_file_load_contents (fixture->index_file, NULL,
+                                           &rewritten, &rewritten_length,
+                                           NULL, &error));
+      g_assert_no_error (error);
+      g_assert_cmpuint (rewritten_length, ==, length);
+      g_free (rewritten);
+    }
+
+  /*  a huge URI length  */
+  offset = 3 * sizeof (guint32);
+  value  = G_MAXUINT32;
+  memcpy (contents + offset, &value, sizeof (value));
+
+  g_assert_true (g_file_replace_contents (fixture->index_file,
+                                          contents, length,
+                                          NULL, FALSE, G_FILE_CREATE_NONE,
+                                          NULL, NULL, &error));
+  g_assert_no_error (error);
+
+  assert_loaded_from_file (gimp, fixture->mask);
+
+  /*  an entry length beyond the end of the file  */
+  g_free (contents);
+  g_assert_true (g_file_load_contents (fixture->index_file, NULL,
+                                       &contents, &length, NULL, &error));
+  g_assert_no_error (error);
+
+  memcpy (&value, contents + offset, sizeof (value));
+  offset += sizeof (guint32) + GUINT32_FROM_BE (value) +
+            2 * sizeof (guint64) + sizeof (guint32);
+  value   = GUINT32_TO_BE (length);
+  memcpy (contents + offset, &value, sizeof (value));
+
+  g_assert_true (g_file_replace_contents (fixture->index_file,
+                                          contents, length,
+                                          NULL, FALSE, G_FILE_CREATE_NONE,
+                                          NULL, NULL, &error));
+  g_assert_no_error (error);
+
+  assert_loaded_from_file (gimp, fixture->mask);
+
+  g_free (contents);
+}
+
+/**
+ * changed_file:
+ * @fixture:
+ * @data:
+ *
+ * Make sure that a pattern file which changed after it was indexed is
+ * loaded from the file, when only the sub-second part of its
+ * modification time changed, and when only its size changed.
+ **/
+static void
+changed_file (GimpTestFixture *fixture,
+              gconstpointer    data)
+{
+  Gimp        *gimp = GIMP (data);
+  GimpTempBuf *mask;
+  GFileInfo   *info;
+  GFileInfo   *new_info;
+  guint64      mtime;
+  guint32      mtime_usec;
+  GError      *error = NULL;
+
+  g_object_unref (load_pattern (gimp));
+
+  info = g_file_query_info (fixture->pattern_file,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                            G_FILE_QUERY_INFO_NONE, NULL, &error);
+  g_assert_no_error (error);
+
+  mtime      = g_file_info_get_attribute_uint64 (info,
+                                                 G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  mtime_usec = g_file_info_get_attribute_uint32 (info,
+                                                 G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+  /*  same size and seconds, different microseconds  */
+  mask = create_mask (TEST_PATTERN_WIDTH, TEST_PATTERN_HEIGHT,
+                      babl_format ("R'G'B' u8"), 2);
+  write_pattern (fixture->pattern_file, mask);
+
+  g_file_info_set_attribute_uint32 (info,
+                                    G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                    (mtime_usec + 500000) % 1000000);
+  g_file_set_attributes_from_info (fixture->pattern_file, info,
+                                   G_FILE_QUERY_INFO_NONE, NULL, NULL);
+
+  new_info = g_file_query_info (fixture->pattern_file,
+                                G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                G_FILE_QUERY_INFO_NONE, NULL, &error);
+  g_assert_no_error (error);
+
+  if (g_file_info_get_attribute_uint64 (new_info,
+                                        G_FILE_ATTRIBUTE_TIME_MODIFIED) == mtime &&
+      g_file_info_get_attribute_uint32 (new_info,
+                                        G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC) !=
+      mtime_usec)
+    {
+      assert_loaded_from_file (gimp, mask);
+    }
+  else
+    {
+      g_test_message ("no sub-second modification times, "
+                      "skipping the microseconds check");
+    }
+
+  g_object_unref (new_info);
+  gimp_temp_buf_unref (mask);
+
+  /*  same modification time, different size  */
+  g_object_unref (load_pattern (gimp));
+
+  g_object_unref (info);
+  info = g_file_query_info (fixture->pattern_file,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                            G_FILE_QUERY_INFO_NONE, NULL, &error);
+  g_assert_no_error (error);
+
+  mask = create_mask (TEST_PATTERN_WIDTH, TEST_PATTERN_HEIGHT + 1,
+                      babl_format ("R'G'B' u8"), 3);
+  write_pattern (fixture->pattern_file, mask);
+
+  g_file_set_attributes_from_info (fixture->pattern_file, info,
+                                   G_FILE_QUERY_INFO_NONE, NULL, &error);
+  g_assert_no_error (error);
+
+  assert_loaded_from_file (gimp, mask);
+
+  gimp_temp_buf_unref (mask);
+  g_object_unref (info);
+}
+
+static void
+remove_dir (const gchar *path)
+{
+  GDir        *dir = g_dir_open (path, 0, NULL);
+  const gchar *name;
+
+  if (! dir)
+    return;
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      gchar *child = g_build_filename (path, name, NULL);
+
+      if (g_file_test (child, G_FILE_TEST_IS_DIR))
+        remove_dir (child);
+      else
+        g_remove (child);
+
+      g_free (child);
+    }
+
+  g_dir_close (dir);
+
+  g_rmdir (path);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp  *gimp;
+  gchar *path;
+  int    result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  test_dir = g_dir_make_tmp ("gimp-test-data-index-XXXXXX", NULL);
+  g_assert_nonnull (test_dir);
+
+  /*  keep the index out of the user's cache directory  */
+  path = g_build_filename (test_dir, "cache", NULL);
+  g_setenv ("GIMP3_CACHEDIR", path, TRUE);
+  g_free (path);
+
+  path = g_build_filename (test_dir, "patterns", NULL);
+  g_mkdir_with_parents (path, 0700);
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  g_object_set (gimp->config,
+                "pattern-path", path,
+                NULL);
+  g_free (path);
+
+  path = g_build_filename (test_dir, "brushes", NULL);
+  g_mkdir_with_parents (path, 0700);
+
+  g_object_set (gimp->config,
+                "brush-path", path,
+                NULL);
+  g_free (path);
+
+  /* Add tests */
+  ADD_TEST (round_trip);
+  ADD_TEST (brush_round_trip);
+  ADD_TEST (corrupt_index);
+  ADD_TEST (changed_file);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  remove_dir (test_dir);
+  g_free (test_dir);
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
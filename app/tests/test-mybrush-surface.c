@@ -0,0 +1,274 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include <mypaint-surface.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "paint/paint-types.h"
+
+#include "core/gimp.h"
+
+#include "paint/gimpmybrushoptions.h"
+#include "paint/gimpmybrushsurface.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define BUFFER_SIZE   512
+#define DAB_RADIUS    6.0f
+#define N_BENCH_DABS  200000
+
+#define ADD_TEST(function) \
+  g_test_add ("/gimp-mybrush-surface/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              gimp_test_mybrush_surface_setup, \
+              function, \
+              gimp_test_mybrush_surface_teardown);
+
+
+typedef struct
+{
+  GeglBuffer         *buffer;
+  GimpMybrushOptions *options;
+  MyPaintSurface     *surface;
+} GimpTestFixture;
+
+
+static void
+gimp_test_mybrush_surface_setup (GimpTestFixture *fixture,
+                                 gconstpointer    data)
+{
+  Gimp *gimp = GIMP (data);
+
+  fixture->buffer  = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                                      BUFFER_SIZE,
+                                                      BUFFER_SIZE),
+                                      babl_format ("R'G'B'A float"));
+  fixture->options = g_object_new (GIMP_TYPE_MYBRUSH_OPTIONS,
+                                   "gimp", gimp,
+                                   NULL);
+  fixture->surface = (MyPaintSurface *)
+    gimp_mypaint_surface_new (fixture->buffer, GIMP_COMPONENT_MASK_ALL,
+                              NULL, 0, 0, fixture->options);
+}
+
+static void
+gimp_test_mybrush_surface_teardown (GimpTestFixture *fixture,
+                                    gconstpointer    data)
+{
+  mypaint_surface_unref (fixture->surface);
+  g_object_unref (fixture->options);
+  g_object_unref (fixture->buffer);
+}
+
+static void
+draw_dab (MyPaintSurface *surface,
+          gfloat          x,
+          gfloat          y,
+          gfloat          radius,
+          gfloat          r,
+          gfloat          g,
+          gfloat          b)
+{
+  mypaint_surface_draw_dab (surface, x, y, radius,
+                            r, g, b,
+                            1.0f, /* opaque       */
+                            1.0f, /* hardness     */
+                            1.0f, /* alpha        */
+                            1.0f, /* aspect ratio */
+                            0.0f, /* angle        */
+                            0.0f, /* lock alpha   */
+                            0.0f  /* colorize     */);
+}
+
+static void
+get_pixel (GeglBuffer *buffer,
+           gint        x,
+           gint        y,
+           gfloat     *pixel)
+{
+  gegl_buffer_get (buffer, GEGL_RECTANGLE (x, y, 1, 1), 1.0,
+                   babl_format ("R'G'B'A float"), pixel,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+}
+
+/**
+ * single_dab:
+ *
+ * Test that a hard dab covers its center, and leaves the surface
+ * outside of its radius untouched.
+ **/
+static void
+single_dab (GimpTestFixture *fixture,
+            gconstpointer    data)
+{
+  MyPaintRectangle roi;
+  gfloat           pixel[4];
+
+  mypaint_surface_begin_atomic (fixture->surface);
+  draw_dab (fixture->surface, 100.0f, 100.0f, DAB_RADIUS, 1.0f, 0.0f, 0.0f);
+  mypaint_surface_end_atomic (fixture->surface, &roi);
+
+  g_assert_cmpint (roi.width,  >, 0);
+  g_assert_cmpint (roi.height, >, 0);
+
+  get_pixel (fixture->buffer, 100, 100, pixel);
+  g_assert_cmpfloat (pixel[0], ==, 1.0f);
+  g_assert_cmpfloat (pixel[3], ==, 1.0f);
+
+  get_pixel (fixture->buffer, 100 + 2 * DAB_RADIUS, 100, pixel);
+  g_assert_cmpfloat (pixel[3], ==, 0.0f);
+}
+
+/**
+ * overlapping_dabs:
+ *
+ * Test that overlapping dabs are composited in the order they were
+ * made, including across tile boundaries.
+ **/
+static void
+overlapping_dabs (GimpTestFixture *fixture,
+                  gconstpointer    data)
+{
+  MyPaintRectangle roi;
+  gfloat           pixel[4];
+
+  mypaint_surface_begin_atomic (fixture->surface);
+  draw_dab (fixture->surface, 64.0f, 64.0f, DAB_RADIUS, 1.0f, 0.0f, 0.0f);
+  draw_dab (fixture->surface, 64.0f, 64.0f, DAB_RADIUS, 0.0f, 1.0f, 0.0f);
+  draw_dab (fixture->surface, 64.0f, 64.0f, DAB_RADIUS, 0.0f, 0.0f, 1.0f);
+  mypaint_surface_end_atomic (fixture->surface, &roi);
+
+  get_pixel (fixture->buffer, 63, 63, pixel);
+  g_assert_cmpfloat (pixel[0], ==, 0.0f);
+  g_assert_cmpfloat (pixel[1], ==, 0.0f);
+  g_assert_cmpfloat (pixel[2], ==, 1.0f);
+
+  get_pixel (fixture->buffer, 64, 64, pixel);
+  g_assert_cmpfloat (pixel[0], ==, 0.0f);
+  g_assert_cmpfloat (pixel[1], ==, 0.0f);
+  g_assert_cmpfloat (pixel[2], ==, 1.0f);
+}
+
+/**
+ * get_color:
+ *
+ * Test that sampling the surface sees the dabs drawn before, in the
+ * same atomic section.
+ **/
+static void
+get_color (GimpTestFixture *fixture,
+           gconstpointer    data)
+{
+  MyPaintRectangle roi;
+  gfloat           r, g, b, a;
+
+  mypaint_surface_begin_atomic (fixture->surface);
+  draw_dab (fixture->surface, 200.0f, 200.0f, 4 * DAB_RADIUS,
+            0.0f, 1.0f, 0.0f);
+  mypaint_surface_get_color (fixture->surface, 200.0f, 200.0f, DAB_RADIUS,
+                             &r, &g, &b, &a);
+  mypaint_surface_end_atomic (fixture->surface, &roi);
+
+  g_assert_cmpfloat (r, ==, 0.0f);
+  g_assert_cmpfloat (g, ==, 1.0f);
+  g_assert_cmpfloat (b, ==, 0.0f);
+  g_assert_cmpfloat (a, ==, 1.0f);
+}
+
+/**
+ * dab_throughput:
+ *
+ * Measure the number of dabs drawn per second, along a stroke.  Run
+ * with "-m perf" to draw a meaningful number of dabs.
+ **/
+static void
+dab_throughput (GimpTestFixture *fixture,
+                gconstpointer    data)
+{
+  MyPaintRectangle  roi;
+  GTimer           *timer;
+  gint              n_dabs = g_test_perf () ? N_BENCH_DABS : 1000;
+  gint              i;
+  gdouble           elapsed;
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < n_dabs; i++)
+    {
+      gfloat t = (gfloat) i / n_dabs;
+
+      /*  MyPaint delivers the dabs of a motion event in one atomic
+       *  section; emulate a few dozen dabs per event
+       */
+      if (i % 32 == 0)
+        mypaint_surface_begin_atomic (fixture->surface);
+
+      draw_dab (fixture->surface,
+                BUFFER_SIZE / 2 + (BUFFER_SIZE / 3) * cos (200.0 * t),
+                BUFFER_SIZE / 2 + (BUFFER_SIZE / 3) * sin (300.0 * t),
+                DAB_RADIUS, t, 1.0f - t, 0.5f);
+
+      if (i % 32 == 31 || i == n_dabs - 1)
+        mypaint_surface_end_atomic (fixture->surface, &roi);
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  g_timer_destroy (timer);
+
+  g_test_maximized_result (n_dabs / MAX (elapsed, 1e-6),
+                           "%g dabs/sec", n_dabs / MAX (elapsed, 1e-6));
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  gimp = gimp_init_for_testing ();
+
+  ADD_TEST (single_dab);
+  ADD_TEST (overlapping_dabs);
+  ADD_TEST (get_color);
+  ADD_TEST (dab_throughput);
+
+  result = g_test_run ();
+
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
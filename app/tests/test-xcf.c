@@ -151,16 +151,28 @@
                                           { 921.0, 922.0, /* pad zeroes */ },\
                                           { 931.0, 932.0, /* pad zeroes */ }, }
 
+#define GIMP_PIXELS_WIDTH    300
+#define GIMP_PIXELS_HEIGHT   200
+#define GIMP_PIXELS_NAME     "pixels"
+#define GIMP_PIXELS_N_LAYERS 2
+
 #define ADD_TEST(function) \
   g_test_add_data_func ("/gimp-xcf/" #function, gimp, function);
 
 
 GimpImage        * gimp_test_load_image                        (Gimp            *gimp,
                                                                 GFile           *file);
+static GFile     * gimp_test_save_image                        (GimpImage       *image);
+static void        gimp_write_and_read_pixels                  (Gimp            *gimp);
+static guchar    * gimp_get_test_pixels                        (GimpImage       *image,
+                                                                gint             n);
+static void        gimp_assert_test_pixels                     (GimpImage       *image,
+                                                                guchar         **pixels);
 static void        gimp_write_and_read_file                    (Gimp            *gimp,
                                                                 gboolean         with_unusual_stuff,
                                                                 gboolean         compat_paths,
-                                                                gboolean         use_gimp_2_8_features);
+                                                                gboolean         use_gimp_2_8_features,
+                                                                gboolean         xcf_compression);
 static GimpImage * gimp_create_mainimage                       (Gimp            *gimp,
                                                                 gboolean         with_unusual_stuff,
                                                                 gboolean         compat_paths,
@@ -186,7 +198,8 @@ write_and_read_gimp_2_6_format (gconstpointer data)
   gimp_write_and_read_file (gimp,
                             FALSE /*with_unusual_stuff*/,
                             FALSE /*compat_paths*/,
-                            FALSE /*use_gimp_2_8_features*/);
+                            FALSE /*use_gimp_2_8_features*/,
+                            FALSE /*xcf_compression*/);
 }
 
 /**
@@ -205,7 +218,8 @@ write_and_read_gimp_2_6_format_unusual (gconstpointer data)
   gimp_write_and_read_file (gimp,
                             TRUE /*with_unusual_stuff*/,
                             TRUE /*compat_paths*/,
-                            FALSE /*use_gimp_2_8_features*/);
+                            FALSE /*use_gimp_2_8_features*/,
+                            FALSE /*xcf_compression*/);
 }
 
 /**
@@ -259,7 +273,94 @@ write_and_read_gimp_2_8_format (gconstpointer data)
   gimp_write_and_read_file (gimp,
                             FALSE /*with_unusual_stuff*/,
                             FALSE /*compat_paths*/,
-                            TRUE /*use_gimp_2_8_features*/);
+                            TRUE /*use_gimp_2_8_features*/,
+                            FALSE /*xcf_compression*/);
+}
+
+/**
+ * write_and_read_zlib_compression:
+ * @data:
+ *
+ * Writes an XCF file using zlib tile compression, then reads the file
+ * and make sure no relevant information was lost.
+ **/
+static void
+write_and_read_zlib_compression (gconstpointer data)
+{
+  Gimp *gimp = GIMP (data);
+
+  g_object_set (gimp->config,
+                "xcf-compression-codec", GIMP_XCF_COMPRESSION_CODEC_ZLIB,
+                NULL);
+
+  gimp_write_and_read_file (gimp,
+                            FALSE /*with_unusual_stuff*/,
+                            FALSE /*compat_paths*/,
+                            TRUE /*use_gimp_2_8_features*/,
+                            TRUE /*xcf_compression*/);
+
+  gimp_write_and_read_pixels (gimp);
+}
+
+#ifdef HAVE_ZSTD
+/**
+ * write_and_read_zstd_compression:
+ * @data:
+ *
+ * Writes an XCF file using Zstandard tile compression, then reads the
+ * file and make sure no relevant information was lost.
+ **/
+static void
+write_and_read_zstd_compression (gconstpointer data)
+{
+  Gimp *gimp = GIMP (data);
+
+  g_object_set (gimp->config,
+                "xcf-compression-codec", GIMP_XCF_COMPRESSION_CODEC_ZSTD,
+                NULL);
+
+  gimp_write_and_read_file (gimp,
+                            FALSE /*with_unusual_stuff*/,
+                            FALSE /*compat_paths*/,
+                            TRUE /*use_gimp_2_8_features*/,
+                            TRUE /*xcf_compression*/);
+
+  gimp_write_and_read_pixels (gimp);
+
+  g_object_set (gimp->config,
+                "xcf-compression-codec", GIMP_XCF_COMPRESSION_CODEC_ZLIB,
+                NULL);
+}
+#endif
+
+/**
+ * write_and_read_lazy_loading:
+ * @data:
+ *
+ * Writes a compressed XCF file, then reads the file with lazy tile
+ * loading enabled and make sure no relevant information was lost,
+ * and that the pixels are the same as when loading eagerly.
+ **/
+static void
+write_and_read_lazy_loading (gconstpointer data)
+{
+  Gimp *gimp = GIMP (data);
+
+  g_object_set (gimp->config,
+                "xcf-lazy-loading", TRUE,
+                NULL);
+
+  gimp_write_and_read_file (gimp,
+                            FALSE /*with_unusual_stuff*/,
+                            FALSE /*compat_paths*/,
+                            TRUE /*use_gimp_2_8_features*/,
+                            TRUE /*xcf_compression*/);
+
+  gimp_write_and_read_pixels (gimp);
+
+  g_object_set (gimp->config,
+                "xcf-lazy-loading", FALSE,
+                NULL);
 }
 
 GimpImage *
@@ -289,39 +390,20 @@ gimp_test_load_image (Gimp  *gimp,
 }
 
 /**
- * gimp_write_and_read_file:
+ * gimp_test_save_image:
  *
- * Constructs the main test image and asserts its state, writes it to
- * a file, reads the image from the file, and asserts the state of the
- * loaded file. The function takes various parameters so the same
- * function can be used for different formats.
+ * Saves @image to a new temporary XCF file.
+ *
+ * Returns: The #GFile the image was saved to
  **/
-static void
-gimp_write_and_read_file (Gimp     *gimp,
-                          gboolean  with_unusual_stuff,
-                          gboolean  compat_paths,
-                          gboolean  use_gimp_2_8_features)
+static GFile *
+gimp_test_save_image (GimpImage *image)
 {
-  GimpImage           *image;
-  GimpImage           *loaded_image;
   GimpPlugInProcedure *proc;
   gchar               *filename = NULL;
   gint                 file_handle;
   GFile               *file;
 
-  /* Create the image */
-  image = gimp_create_mainimage (gimp,
-                                 with_unusual_stuff,
-                                 compat_paths,
-                                 use_gimp_2_8_features);
-
-  /* Assert valid state */
-  gimp_assert_mainimage (image,
-                         with_unusual_stuff,
-                         compat_paths,
-                         use_gimp_2_8_features);
-
-  /* Write to file */
   file_handle = g_file_open_tmp ("gimp-test-XXXXXX.xcf", &filename, NULL);
   g_assert (file_handle != -1);
   close (file_handle);
@@ -332,7 +414,7 @@ gimp_write_and_read_file (Gimp     *gimp,
                                                    GIMP_FILE_PROCEDURE_GROUP_SAVE,
                                                    file,
                                                    NULL /*error*/);
-  file_save (gimp,
+  file_save (image->gimp,
              image,
              NULL /*progress*/,
              file,
@@ -343,6 +425,221 @@ gimp_write_and_read_file (Gimp     *gimp,
              FALSE /*export_forward*/,
              NULL /*error*/);
 
+  return file;
+}
+
+/**
+ * gimp_get_test_pixels:
+ * @n: the index of the layer
+ *
+ * Returns: A newly allocated copy of the pixels of the @n-th layer
+ *          written by gimp_write_and_read_pixels().
+ **/
+static guchar *
+gimp_get_test_pixels (GimpImage *image,
+                      gint       n)
+{
+  GimpLayer *layer;
+  gchar     *name;
+  guchar    *pixels;
+
+  name  = g_strdup_printf ("%s %d", GIMP_PIXELS_NAME, n);
+  layer = gimp_image_get_layer_by_name (image, name);
+  g_assert (layer != NULL);
+  g_free (name);
+
+  pixels = g_malloc (GIMP_PIXELS_WIDTH * GIMP_PIXELS_HEIGHT * 4);
+
+  gegl_buffer_get (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+                   GEGL_RECTANGLE (0, 0, GIMP_PIXELS_WIDTH, GIMP_PIXELS_HEIGHT),
+                   1.0, babl_format ("R'G'B'A u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  return pixels;
+}
+
+/**
+ * gimp_assert_test_pixels:
+ *
+ * Asserts that all the layers written by gimp_write_and_read_pixels()
+ * have the expected pixels.
+ **/
+static void
+gimp_assert_test_pixels (GimpImage  *image,
+                         guchar    **pixels)
+{
+  gint n;
+
+  for (n = 0; n < GIMP_PIXELS_N_LAYERS; n++)
+    {
+      guchar *loaded_pixels = gimp_get_test_pixels (image, n);
+
+      g_assert (memcmp (pixels[n], loaded_pixels,
+                        GIMP_PIXELS_WIDTH * GIMP_PIXELS_HEIGHT * 4) == 0);
+
+      g_free (loaded_pixels);
+    }
+}
+
+/**
+ * gimp_write_and_read_pixels:
+ *
+ * Writes a compressed XCF file with several layers spanning several,
+ * partial, tiles, filled with varied pixels, then reads the file and
+ * makes sure the pixels are identical.  The main test image only has
+ * uniform layers, which would hide most tile decompression bugs.
+ * Since each layer is followed by its dummy levels, and by the next
+ * layer, the last tile of each level is followed by other data.
+ *
+ * With lazy loading enabled, the pixels are also compared with an
+ * eagerly loaded copy of the file, and a lazily loaded copy is read
+ * after truncating the file under it.
+ **/
+static void
+gimp_write_and_read_pixels (Gimp *gimp)
+{
+  GimpImage *image;
+  GimpImage *loaded_image;
+  GFile     *file;
+  guchar    *pixels[GIMP_PIXELS_N_LAYERS];
+  gboolean   lazy_loading;
+  gint       n;
+  gint       i;
+
+  g_object_get (gimp->config,
+                "xcf-lazy-loading", &lazy_loading,
+                NULL);
+
+  image = gimp_image_new (gimp,
+                          GIMP_PIXELS_WIDTH, GIMP_PIXELS_HEIGHT,
+                          GIMP_RGB, GIMP_PRECISION_U8_NON_LINEAR);
+
+  for (n = 0; n < GIMP_PIXELS_N_LAYERS; n++)
+    {
+      GimpLayer *layer;
+      gchar     *name;
+
+      name  = g_strdup_printf ("%s %d", GIMP_PIXELS_NAME, n);
+      layer = gimp_layer_new (image,
+                              GIMP_PIXELS_WIDTH, GIMP_PIXELS_HEIGHT,
+                              babl_format ("R'G'B'A u8"),
+                              name,
+                              GIMP_OPACITY_OPAQUE,
+                              GIMP_LAYER_MODE_NORMAL);
+      g_free (name);
+
+      gimp_image_add_layer (image, layer, NULL, -1, FALSE /*push_undo*/);
+
+      /* Mix compressible runs with noise */
+      pixels[n] = g_malloc (GIMP_PIXELS_WIDTH * GIMP_PIXELS_HEIGHT * 4);
+
+      for (i = 0; i < GIMP_PIXELS_WIDTH * GIMP_PIXELS_HEIGHT * 4; i++)
+        pixels[n][i] = (i / 64) % 3 ?
+                       ((i / 256) + n) & 0xff : g_test_rand_int () & 0xff;
+
+      gegl_buffer_set (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+                       GEGL_RECTANGLE (0, 0,
+                                       GIMP_PIXELS_WIDTH, GIMP_PIXELS_HEIGHT),
+                       0, babl_format ("R'G'B'A u8"), pixels[n],
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  gimp_image_set_xcf_compression (image, TRUE);
+
+  file = gimp_test_save_image (image);
+
+  loaded_image = gimp_test_load_image (gimp, file);
+  g_assert (loaded_image != NULL);
+
+  gimp_assert_test_pixels (loaded_image, pixels);
+
+  g_object_unref (loaded_image);
+
+  if (lazy_loading)
+    {
+      GFileIOStream *stream;
+      guchar        *loaded_pixels;
+
+      g_object_set (gimp->config,
+                    "xcf-lazy-loading", FALSE,
+                    NULL);
+
+      loaded_image = gimp_test_load_image (gimp, file);
+      g_assert (loaded_image != NULL);
+
+      g_object_set (gimp->config,
+                    "xcf-lazy-loading", TRUE,
+                    NULL);
+
+      gimp_assert_test_pixels (loaded_image, pixels);
+
+      g_object_unref (loaded_image);
+
+      /* Truncating the file under a lazily loaded image must only
+       * lose the tiles which were not loaded yet, not crash.
+       */
+      loaded_image = gimp_test_load_image (gimp, file);
+      g_assert (loaded_image != NULL);
+
+      stream = g_file_open_readwrite (file, NULL, NULL);
+      g_assert (stream != NULL);
+      g_assert (g_seekable_truncate (G_SEEKABLE (stream), 64, NULL, NULL));
+      g_object_unref (stream);
+
+      for (n = 0; n < GIMP_PIXELS_N_LAYERS; n++)
+        {
+          loaded_pixels = gimp_get_test_pixels (loaded_image, n);
+          g_free (loaded_pixels);
+        }
+
+      g_object_unref (loaded_image);
+    }
+
+  for (n = 0; n < GIMP_PIXELS_N_LAYERS; n++)
+    g_free (pixels[n]);
+
+  g_object_unref (image);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+/**
+ * gimp_write_and_read_file:
+ *
+ * Constructs the main test image and asserts its state, writes it to
+ * a file, reads the image from the file, and asserts the state of the
+ * loaded file. The function takes various parameters so the same
+ * function can be used for different formats.
+ **/
+static void
+gimp_write_and_read_file (Gimp     *gimp,
+                          gboolean  with_unusual_stuff,
+                          gboolean  compat_paths,
+                          gboolean  use_gimp_2_8_features,
+                          gboolean  xcf_compression)
+{
+  GimpImage *image;
+  GimpImage *loaded_image;
+  GFile     *file;
+
+  /* Create the image */
+  image = gimp_create_mainimage (gimp,
+                                 with_unusual_stuff,
+                                 compat_paths,
+                                 use_gimp_2_8_features);
+
+  /* Assert valid state */
+  gimp_assert_mainimage (image,
+                         with_unusual_stuff,
+                         compat_paths,
+                         use_gimp_2_8_features);
+
+  gimp_image_set_xcf_compression (image, xcf_compression);
+
+  /* Write to file */
+  file = gimp_test_save_image (image);
+
   /* Load from file */
   loaded_image = gimp_test_load_image (image->gimp, file);
 
@@ -1028,6 +1325,11 @@ main (int    argc,
   ADD_TEST (write_and_read_gimp_2_6_format_unusual);
   ADD_TEST (load_gimp_2_6_file);
   ADD_TEST (write_and_read_gimp_2_8_format);
+  ADD_TEST (write_and_read_zlib_compression);
+#ifdef HAVE_ZSTD
+  ADD_TEST (write_and_read_zstd_compression);
+#endif
+  ADD_TEST (write_and_read_lazy_loading);
 
   /* Don't write files to the source dir */
   gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
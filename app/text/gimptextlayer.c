@@ -70,7 +70,16 @@ enum
 
 struct _GimpTextLayerPrivate
 {
-  GimpTextDirection base_dir;
+  GimpTextDirection   base_dir;
+
+  /*  what the layer's pixels were last rendered from, used to
+   *  re-render only the lines that changed
+   */
+  GimpText           *render_text;
+  gdouble             render_xres;
+  gdouble             render_yres;
+  GimpColorTransform *render_transform;
+  GArray             *render_lines;
 };
 
 static void       gimp_text_layer_finalize       (GObject           *object);
@@ -118,9 +127,17 @@ static void       gimp_text_layer_convert_type   (GimpLayer         *layer,
 
 static void       gimp_text_layer_text_changed   (GimpTextLayer     *layer);
 static gboolean   gimp_text_layer_render         (GimpTextLayer     *layer);
-static void       gimp_text_layer_render_layout  (GimpTextLayer     *layer,
-                                                  GimpTextLayout    *layout);
-
+static void       gimp_text_layer_clear_render   (GimpTextLayer     *layer);
+static gboolean   gimp_text_layer_render_layout  (GimpTextLayer     *layer,
+                                                  GimpTextLayout    *layout,
+                                                  const GeglRectangle *area);
+
+static cairo_region_t *
+            gimp_text_layer_get_dirty_region (GimpTextLayer      *layer,
+                                              GArray             *lines,
+                                              gdouble             xres,
+                                              gdouble             yres,
+                                              GimpColorTransform *transform);
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpTextLayer, gimp_text_layer, GIMP_TYPE_LAYER)
 
@@ -203,6 +220,8 @@ gimp_text_layer_finalize (GObject *object)
 
   g_clear_object (&layer->text);
 
+  gimp_text_layer_clear_render (layer);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -250,6 +269,10 @@ gimp_text_layer_set_property (GObject      *object,
       break;
     case PROP_MODIFIED:
       text_layer->modified = g_value_get_boolean (value);
+
+      /*  the pixels are no longer what we rendered  */
+      if (text_layer->modified)
+        gimp_text_layer_clear_render (text_layer);
       break;
 
     default:
@@ -267,6 +290,12 @@ gimp_text_layer_get_memsize (GimpObject *object,
 
   memsize += gimp_object_get_memsize (GIMP_OBJECT (text_layer->text),
                                       gui_size);
+  memsize += gimp_object_get_memsize (GIMP_OBJECT (text_layer->private->render_text),
+                                      gui_size);
+
+  if (text_layer->private->render_lines)
+    memsize += text_layer->private->render_lines->len *
+               sizeof (GimpTextLayoutLine);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -338,6 +367,8 @@ gimp_text_layer_set_buffer (GimpDrawable        *drawable,
     gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_DRAWABLE_MOD,
                                  undo_desc);
 
+  gimp_text_layer_clear_render (layer);
+
   GIMP_DRAWABLE_CLASS (parent_class)->set_buffer (drawable,
                                                   push_undo, undo_desc,
                                                   buffer, bounds);
@@ -792,7 +823,68 @@ gimp_text_layer_render (GimpTextLayer *layer)
     }
 
   if (width > 0 && height > 0)
-    gimp_text_layer_render_layout (layer, layout);
+    {
+      GimpColorTransform *transform;
+      GArray             *lines;
+      cairo_region_t     *region;
+      gboolean            success = TRUE;
+
+      transform = gimp_image_get_color_transform_from_srgb_u8 (image);
+      lines     = gimp_text_layout_get_lines (layout, layer->text->base_dir);
+      region    = gimp_text_layer_get_dirty_region (layer, lines,
+                                                    xres, yres, transform);
+
+      if (region)
+        {
+          gint n_rects = cairo_region_num_rectangles (region);
+          gint i;
+
+          for (i = 0; success && i < n_rects; i++)
+            {
+              cairo_rectangle_int_t rect;
+
+              cairo_region_get_rectangle (region, i, &rect);
+
+              success = gimp_text_layer_render_layout (
+                layer, layout,
+                GEGL_RECTANGLE (rect.x, rect.y, rect.width, rect.height));
+            }
+
+          cairo_region_destroy (region);
+        }
+      else
+        {
+          success = gimp_text_layer_render_layout (
+            layer, layout,
+            GEGL_RECTANGLE (0, 0, width, height));
+        }
+
+      gimp_text_layer_clear_render (layer);
+
+      if (success && ! layer->modified && ! layer->convert_format)
+        {
+          GimpTextLayerPrivate *private = layer->private;
+
+          private->render_text = gimp_config_duplicate (GIMP_CONFIG (layer->text));
+          g_object_set (private->render_text,
+                        "text",   NULL,
+                        "markup", NULL,
+                        NULL);
+
+          private->render_xres      = xres;
+          private->render_yres      = yres;
+          private->render_transform = transform ? g_object_ref (transform) : NULL;
+          private->render_lines     = lines;
+        }
+      else
+        {
+          g_array_unref (lines);
+        }
+    }
+  else
+    {
+      gimp_text_layer_clear_render (layer);
+    }
 
   g_object_unref (layout);
 
@@ -917,8 +1009,155 @@ gimp_temp_buf_create_cairo_surface (GimpTempBuf *temp_buf)
 }
 
 static void
-gimp_text_layer_render_layout (GimpTextLayer  *layer,
-                               GimpTextLayout *layout)
+gimp_text_layer_clear_render (GimpTextLayer *layer)
+{
+  GimpTextLayerPrivate *private = layer->private;
+
+  g_clear_object (&private->render_text);
+  g_clear_object (&private->render_transform);
+  g_clear_pointer (&private->render_lines, g_array_unref);
+}
+
+/*  returns the area of the layer which changed since it was last
+ *  rendered, or NULL if the whole layer needs to be rendered
+ */
+static cairo_region_t *
+gimp_text_layer_get_dirty_region (GimpTextLayer      *layer,
+                                  GArray             *lines,
+                                  gdouble             xres,
+                                  gdouble             yres,
+                                  GimpColorTransform *transform)
+{
+  GimpTextLayerPrivate  *private = layer->private;
+  GimpItem              *item    = GIMP_ITEM (layer);
+  GeglBuffer            *buffer;
+  GimpText              *text;
+  GHashTable            *old_lines;
+  GHashTableIter         iter;
+  gpointer               value;
+  cairo_region_t        *dirty;
+  cairo_region_t        *region;
+  cairo_rectangle_int_t  bounds;
+  gboolean               equal;
+  gint                   n_rects;
+  gint                   i;
+
+  if (! private->render_lines             ||
+      layer->modified                     ||
+      layer->convert_format               ||
+      xres      != private->render_xres   ||
+      yres      != private->render_yres   ||
+      transform != private->render_transform)
+    {
+      return NULL;
+    }
+
+  /*  any change other than to the text itself affects the whole layer  */
+  text = gimp_config_duplicate (GIMP_CONFIG (layer->text));
+  g_object_set (text,
+                "text",   NULL,
+                "markup", NULL,
+                NULL);
+
+  equal = gimp_config_is_equal_to (GIMP_CONFIG (text),
+                                   GIMP_CONFIG (private->render_text));
+
+  g_object_unref (text);
+
+  if (! equal)
+    return NULL;
+
+  dirty = cairo_region_create ();
+
+  old_lines = g_hash_table_new (g_int64_hash, g_int64_equal);
+
+  for (i = 0; i < private->render_lines->len; i++)
+    {
+      GimpTextLayoutLine *line = &g_array_index (private->render_lines,
+                                                 GimpTextLayoutLine, i);
+      GimpTextLayoutLine *other;
+
+      other = g_hash_table_lookup (old_lines, &line->hash);
+
+      if (other)
+        cairo_region_union_rectangle (dirty, &other->extents);
+
+      g_hash_table_insert (old_lines, &line->hash, line);
+    }
+
+  /*  the lines which are not in the same place, with the same glyphs,
+   *  need to be erased and drawn again
+   */
+  for (i = 0; i < lines->len; i++)
+    {
+      GimpTextLayoutLine *line = &g_array_index (lines, GimpTextLayoutLine, i);
+      GimpTextLayoutLine *other;
+
+      other = g_hash_table_lookup (old_lines, &line->hash);
+
+      if (other &&
+          other->extents.x      == line->extents.x     &&
+          other->extents.y      == line->extents.y     &&
+          other->extents.width  == line->extents.width &&
+          other->extents.height == line->extents.height)
+        {
+          g_hash_table_remove (old_lines, &line->hash);
+        }
+      else
+        {
+          cairo_region_union_rectangle (dirty, &line->extents);
+        }
+    }
+
+  g_hash_table_iter_init (&iter, old_lines);
+
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      GimpTextLayoutLine *line = value;
+
+      cairo_region_union_rectangle (dirty, &line->extents);
+    }
+
+  g_hash_table_unref (old_lines);
+
+  /*  render whole tiles, which is as cheap as rendering parts of them  */
+  buffer  = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  region  = cairo_region_create ();
+  n_rects = cairo_region_num_rectangles (dirty);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t rect;
+      GeglRectangle         aligned;
+
+      cairo_region_get_rectangle (dirty, i, &rect);
+
+      gegl_rectangle_align_to_buffer (&aligned,
+                                      GEGL_RECTANGLE (rect.x,     rect.y,
+                                                      rect.width, rect.height),
+                                      buffer,
+                                      GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
+
+      cairo_region_union_rectangle (region,
+                                    (cairo_rectangle_int_t *) &aligned);
+    }
+
+  cairo_region_destroy (dirty);
+
+  bounds.x      = 0;
+  bounds.y      = 0;
+  bounds.width  = gimp_item_get_width  (item);
+  bounds.height = gimp_item_get_height (item);
+
+  cairo_region_intersect_rectangle (region, &bounds);
+
+  return region;
+}
+
+static gboolean
+gimp_text_layer_render_layout (GimpTextLayer       *layer,
+                               GimpTextLayout      *layout,
+                               const GeglRectangle *area)
 {
   GimpDrawable       *drawable = GIMP_DRAWABLE (layer);
   GimpItem           *item     = GIMP_ITEM (layer);
@@ -927,16 +1166,12 @@ gimp_text_layer_render_layout (GimpTextLayer  *layer,
   GimpColorTransform *transform;
   cairo_t            *cr;
   cairo_surface_t    *surface;
-  gint                width;
-  gint                height;
   cairo_status_t      status;
 
-  g_return_if_fail (gimp_drawable_has_alpha (drawable));
-
-  width  = gimp_item_get_width  (item);
-  height = gimp_item_get_height (item);
+  g_return_val_if_fail (gimp_drawable_has_alpha (drawable), FALSE);
 
-  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        area->width, area->height);
   status = cairo_surface_status (surface);
 
   if (status != CAIRO_STATUS_SUCCESS)
@@ -947,10 +1182,12 @@ gimp_text_layer_render_layout (GimpTextLayer  *layer,
                             _("Your text cannot be rendered. It is likely too big. "
                               "Please make it shorter or use a smaller font."));
       cairo_surface_destroy (surface);
-      return;
+      return FALSE;
     }
 
   cr = cairo_create (surface);
+  cairo_translate (cr, -area->x, -area->y);
+
   if (layer->text->outline != GIMP_TEXT_OUTLINE_STROKE_ONLY)
     {
       cairo_save (cr);
@@ -1019,16 +1256,19 @@ gimp_text_layer_render_layout (GimpTextLayer  *layer,
                                            buffer,
                                            NULL,
                                            gimp_drawable_get_buffer (drawable),
-                                           NULL);
+                                           area);
     }
   else
     {
       gimp_gegl_buffer_copy (buffer, NULL, GEGL_ABYSS_NONE,
-                             gimp_drawable_get_buffer (drawable), NULL);
+                             gimp_drawable_get_buffer (drawable), area);
     }
 
   g_object_unref (buffer);
   cairo_surface_destroy (surface);
 
-  gimp_drawable_update (drawable, 0, 0, width, height);
+  gimp_drawable_update (drawable,
+                        area->x, area->y, area->width, area->height);
+
+  return TRUE;
 }
@@ -22,12 +22,22 @@
 
 #include <pango/pangocairo.h>
 
+#include "libgimpmath/gimpmath.h"
+
 #include "text-types.h"
 
 #include "gimptextlayout.h"
 #include "gimptextlayout-render.h"
 
 
+static void     gimp_text_layout_get_matrix (GimpTextLayout    *layout,
+                                             GimpTextDirection  base_dir,
+                                             cairo_matrix_t    *matrix);
+static guint64  gimp_text_layout_hash_line  (PangoLayoutLine   *line);
+
+
+/*  public functions  */
+
 void
 gimp_text_layout_render (GimpTextLayout    *layout,
                          cairo_t           *cr,
@@ -35,43 +45,225 @@ gimp_text_layout_render (GimpTextLayout    *layout,
                          gboolean           path)
 {
   PangoLayout    *pango_layout;
-  cairo_matrix_t  trafo;
-  gint            x, y;
-  gint            width, height;
+  cairo_matrix_t  matrix;
 
   g_return_if_fail (GIMP_IS_TEXT_LAYOUT (layout));
   g_return_if_fail (cr != NULL);
 
   cairo_save (cr);
 
+  gimp_text_layout_get_matrix (layout, base_dir, &matrix);
+  cairo_transform (cr, &matrix);
+
+  pango_layout = gimp_text_layout_get_pango_layout (layout);
+
+  if (path)
+    pango_cairo_layout_path (cr, pango_layout);
+  else
+    pango_cairo_show_layout (cr, pango_layout);
+
+  cairo_restore (cr);
+}
+
+/**
+ * gimp_text_layout_get_lines:
+ * @layout:   a #GimpTextLayout
+ * @base_dir: the base direction @layout is rendered with
+ *
+ * Describes the lines of @layout, as rendered by
+ * gimp_text_layout_render().  Two lines with the same hash and
+ * extents render the same, which allows finding the parts of a
+ * rendering that changed between two layouts.
+ *
+ * Returns: a #GArray of #GimpTextLayoutLine, to be freed with
+ *          g_array_unref().
+ **/
+GArray *
+gimp_text_layout_get_lines (GimpTextLayout    *layout,
+                            GimpTextDirection  base_dir)
+{
+  GArray          *lines;
+  PangoLayoutIter *iter;
+  cairo_matrix_t   matrix;
+
+  g_return_val_if_fail (GIMP_IS_TEXT_LAYOUT (layout), NULL);
+
+  lines = g_array_new (FALSE, FALSE, sizeof (GimpTextLayoutLine));
+
+  gimp_text_layout_get_matrix (layout, base_dir, &matrix);
+
+  iter = pango_layout_get_iter (gimp_text_layout_get_pango_layout (layout));
+
+  do
+    {
+      GimpTextLayoutLine line;
+      PangoRectangle     ink;
+      PangoRectangle     logical;
+      gdouble            x1, y1;
+      gdouble            x2, y2;
+      gint               i;
+
+      pango_layout_iter_get_line_extents (iter, &ink, &logical);
+
+      line.hash = gimp_text_layout_hash_line (
+        pango_layout_iter_get_line_readonly (iter));
+
+      line.hash = line.hash * 31 + logical.x;
+      line.hash = line.hash * 31 + logical.y;
+      line.hash = line.hash * 31 + pango_layout_iter_get_baseline (iter);
+
+      x1 = y1 = G_MAXDOUBLE;
+      x2 = y2 = -G_MAXDOUBLE;
+
+      /*  the bounding box of the transformed ink rectangle  */
+      for (i = 0; i < 4; i++)
+        {
+          gdouble x = (gdouble) (ink.x + (i & 1 ? ink.width  : 0)) / PANGO_SCALE;
+          gdouble y = (gdouble) (ink.y + (i & 2 ? ink.height : 0)) / PANGO_SCALE;
+
+          cairo_matrix_transform_point (&matrix, &x, &y);
+
+          x1 = MIN (x1, x);
+          y1 = MIN (y1, y);
+          x2 = MAX (x2, x);
+          y2 = MAX (y2, y);
+        }
+
+      if (ink.width > 0 && ink.height > 0)
+        {
+          /*  leave room for antialiasing  */
+          line.extents.x      = floor (x1) - 1;
+          line.extents.y      = floor (y1) - 1;
+          line.extents.width  = ceil (x2) + 1 - line.extents.x;
+          line.extents.height = ceil (y2) + 1 - line.extents.y;
+        }
+      else
+        {
+          line.extents.x      = 0;
+          line.extents.y      = 0;
+          line.extents.width  = 0;
+          line.extents.height = 0;
+        }
+
+      g_array_append_val (lines, line);
+    }
+  while (pango_layout_iter_next_line (iter));
+
+  pango_layout_iter_free (iter);
+
+  return lines;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_text_layout_get_matrix (GimpTextLayout    *layout,
+                             GimpTextDirection  base_dir,
+                             cairo_matrix_t    *matrix)
+{
+  cairo_matrix_t trafo;
+  gint           x, y;
+  gint           width, height;
+
   gimp_text_layout_get_offsets (layout, &x, &y);
-  cairo_translate (cr, x, y);
+  cairo_matrix_init_translate (matrix, x, y);
 
   gimp_text_layout_get_transform (layout, &trafo);
-  cairo_transform (cr, &trafo);
+  cairo_matrix_multiply (matrix, &trafo, matrix);
 
   if (base_dir == GIMP_TEXT_DIRECTION_TTB_RTL ||
       base_dir == GIMP_TEXT_DIRECTION_TTB_RTL_UPRIGHT)
     {
       gimp_text_layout_get_size (layout, &width, &height);
-      cairo_translate (cr, width, 0);
-      cairo_rotate (cr, G_PI_2);
+
+      cairo_matrix_init_translate (&trafo, width, 0);
+      cairo_matrix_multiply (matrix, &trafo, matrix);
+
+      cairo_matrix_init_rotate (&trafo, G_PI_2);
+      cairo_matrix_multiply (matrix, &trafo, matrix);
     }
 
   if (base_dir == GIMP_TEXT_DIRECTION_TTB_LTR ||
       base_dir == GIMP_TEXT_DIRECTION_TTB_LTR_UPRIGHT)
     {
       gimp_text_layout_get_size (layout, &width, &height);
-      cairo_translate (cr, 0, height);
-      cairo_rotate (cr, -G_PI_2);
+
+      cairo_matrix_init_translate (&trafo, 0, height);
+      cairo_matrix_multiply (matrix, &trafo, matrix);
+
+      cairo_matrix_init_rotate (&trafo, -G_PI_2);
+      cairo_matrix_multiply (matrix, &trafo, matrix);
     }
+}
 
-  pango_layout = gimp_text_layout_get_pango_layout (layout);
+static guint64
+gimp_text_layout_hash_line (PangoLayoutLine *line)
+{
+  guint64  hash = line->resolved_dir;
+  GSList  *list;
 
-  if (path)
-    pango_cairo_layout_path (cr, pango_layout);
-  else
-    pango_cairo_show_layout (cr, pango_layout);
+  for (list = line->runs; list; list = g_slist_next (list))
+    {
+      PangoGlyphItem       *run = list->data;
+      PangoFontDescription *desc;
+      GSList               *attrs;
+      gint                  i;
 
-  cairo_restore (cr);
+      desc = pango_font_describe_with_absolute_size (run->item->analysis.font);
+      hash = hash * 31 + pango_font_description_hash (desc);
+      pango_font_description_free (desc);
+
+      hash = hash * 31 + run->item->analysis.level;
+      hash = hash * 31 + run->item->analysis.gravity;
+
+      for (i = 0; i < run->glyphs->num_glyphs; i++)
+        {
+          const PangoGlyphInfo *glyph = &run->glyphs->glyphs[i];
+
+          hash = hash * 31 + glyph->glyph;
+          hash = hash * 31 + glyph->geometry.width;
+          hash = hash * 31 + glyph->geometry.x_offset;
+          hash = hash * 31 + glyph->geometry.y_offset;
+        }
+
+      /*  the attributes that don't affect shaping  */
+      for (attrs = run->item->analysis.extra_attrs;
+           attrs;
+           attrs = g_slist_next (attrs))
+        {
+          const PangoAttribute *attr = attrs->data;
+
+          hash = hash * 31 + attr->klass->type;
+
+          switch (attr->klass->type)
+            {
+            case PANGO_ATTR_FOREGROUND:
+            case PANGO_ATTR_BACKGROUND:
+            case PANGO_ATTR_UNDERLINE_COLOR:
+            case PANGO_ATTR_STRIKETHROUGH_COLOR:
+              {
+                const PangoColor *color = &((PangoAttrColor *) attr)->color;
+
+                hash = hash * 31 + color->red;
+                hash = hash * 31 + color->green;
+                hash = hash * 31 + color->blue;
+              }
+              break;
+
+            case PANGO_ATTR_UNDERLINE:
+            case PANGO_ATTR_STRIKETHROUGH:
+            case PANGO_ATTR_RISE:
+            case PANGO_ATTR_FOREGROUND_ALPHA:
+            case PANGO_ATTR_BACKGROUND_ALPHA:
+              hash = hash * 31 + ((PangoAttrInt *) attr)->value;
+              break;
+
+            default:
+              break;
+            }
+        }
+    }
+
+  return hash;
 }
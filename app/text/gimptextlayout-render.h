@@ -22,10 +22,26 @@
 #define __GIMP_TEXT_LAYOUT_RENDER_H__
 
 
-void  gimp_text_layout_render (GimpTextLayout    *layout,
-                               cairo_t           *cr,
-                               GimpTextDirection  base_dir,
-                               gboolean           path);
+typedef struct _GimpTextLayoutLine GimpTextLayoutLine;
+
+struct _GimpTextLayoutLine
+{
+  guint64                hash;     /*  of the line's glyphs, attributes
+                                    *  and position
+                                    */
+  cairo_rectangle_int_t  extents;  /*  the line's ink extents, in the
+                                    *  coordinates of the rendering
+                                    */
+};
+
+
+void     gimp_text_layout_render    (GimpTextLayout    *layout,
+                                     cairo_t           *cr,
+                                     GimpTextDirection  base_dir,
+                                     gboolean           path);
+
+GArray * gimp_text_layout_get_lines (GimpTextLayout    *layout,
+                                     GimpTextDirection  base_dir);
 
 
 #endif /* __GIMP_TEXT_LAYOUT_RENDER_H__ */
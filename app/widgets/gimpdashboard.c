@@ -64,6 +64,7 @@
 #include "core/gimp-parallel.h"
 #include "core/gimpasync.h"
 #include "core/gimpbacktrace.h"
+#include "core/gimpbrushcache.h"
 #include "core/gimptempbuf.h"
 #include "core/gimpwaitable.h"
 
@@ -152,9 +153,13 @@ typedef enum
   VARIABLE_ASSIGNED_THREADS,
   VARIABLE_ACTIVE_THREADS,
   VARIABLE_ASYNC_RUNNING,
+  VARIABLE_ASYNC_QUEUED,
+  VARIABLE_ASYNC_STEALS,
   VARIABLE_TILE_ALLOC_TOTAL,
   VARIABLE_SCRATCH_TOTAL,
   VARIABLE_TEMP_BUF_TOTAL,
+  VARIABLE_BRUSH_CACHE_TOTAL,
+  VARIABLE_BRUSH_CACHE_HIT_RATE,
 
 
   N_VARIABLES,
@@ -735,6 +740,25 @@ static const VariableInfo variables[] =
     .data             = gimp_async_get_n_running
   },
 
+  [VARIABLE_ASYNC_QUEUED] =
+  { .name             = "async-queued",
+    .title            = NC_("dashboard-variable", "Queued"),
+    .description      = N_("Number of asynchronous operations waiting to run"),
+    .type             = VARIABLE_TYPE_INTEGER,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_parallel_run_async_get_n_queued
+  },
+
+  [VARIABLE_ASYNC_STEALS] =
+  { .name             = "async-steals",
+    .title            = NC_("dashboard-variable", "Steals"),
+    .description      = N_("Number of asynchronous operations taken over by "
+                           "an idle worker thread"),
+    .type             = VARIABLE_TYPE_INTEGER,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_parallel_run_async_get_n_steals
+  },
+
   [VARIABLE_TILE_ALLOC_TOTAL] =
   { .name             = "tile-alloc-total",
     .title            = NC_("dashboard-variable", "Tile"),
@@ -764,6 +788,25 @@ static const VariableInfo variables[] =
     .type             = VARIABLE_TYPE_SIZE,
     .sample_func      = gimp_dashboard_sample_function,
     .data             = gimp_temp_buf_get_total_memsize
+  },
+
+  [VARIABLE_BRUSH_CACHE_TOTAL] =
+  { .name             = "brush-cache-total",
+    .title            = NC_("dashboard-variable", "Brush cache"),
+    .description      = N_("Total size of transformed brush caches"),
+    .type             = VARIABLE_TYPE_SIZE,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_brush_cache_get_total_memsize
+  },
+
+  [VARIABLE_BRUSH_CACHE_HIT_RATE] =
+  { .name             = "brush-cache-hit-rate",
+    .title            = NC_("dashboard-variable", "Brush hits"),
+    .description      = N_("Rate of transformed brushes found in the "
+                           "brush caches"),
+    .type             = VARIABLE_TYPE_PERCENTAGE,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_brush_cache_get_hit_rate
   }
 };
 
@@ -972,6 +1015,12 @@ static const GroupInfo groups[] =
                           { .variable       = VARIABLE_ASYNC_RUNNING,
                             .default_active = TRUE
                           },
+                          { .variable       = VARIABLE_ASYNC_QUEUED,
+                            .default_active = FALSE
+                          },
+                          { .variable       = VARIABLE_ASYNC_STEALS,
+                            .default_active = FALSE
+                          },
                           { .variable       = VARIABLE_TILE_ALLOC_TOTAL,
                             .default_active = TRUE
                           },
@@ -981,6 +1030,12 @@ static const GroupInfo groups[] =
                           { .variable       = VARIABLE_TEMP_BUF_TOTAL,
                             .default_active = TRUE
                           },
+                          { .variable       = VARIABLE_BRUSH_CACHE_TOTAL,
+                            .default_active = FALSE
+                          },
+                          { .variable       = VARIABLE_BRUSH_CACHE_HIT_RATE,
+                            .default_active = FALSE
+                          },
 
                           {}
                         }
@@ -76,6 +76,14 @@ static void     gimp_histogram_editor_frozen_update (GimpHistogramEditor *editor
 static void     gimp_histogram_editor_buffer_update (GimpHistogramEditor *editor,
                                                      const GParamSpec    *pspec);
 static void     gimp_histogram_editor_update        (GimpHistogramEditor *editor);
+static void     gimp_histogram_editor_drawable_update
+                                                    (GimpDrawable        *drawable,
+                                                     gint                 x,
+                                                     gint                 y,
+                                                     gint                 width,
+                                                     gint                 height,
+                                                     GimpHistogramEditor *editor);
+static void     gimp_histogram_editor_mask_changed  (GimpHistogramEditor *editor);
 
 static gboolean gimp_histogram_editor_idle_update   (GimpHistogramEditor *editor);
 static gboolean gimp_histogram_menu_sensitivity     (gint                 value,
@@ -348,7 +356,7 @@ gimp_histogram_editor_set_image (GimpImageEditor *image_editor,
       editor->update_pending = FALSE;
 
       g_signal_handlers_disconnect_by_func (image_editor->image,
-                                            gimp_histogram_editor_update,
+                                            gimp_histogram_editor_mask_changed,
                                             editor);
       g_signal_handlers_disconnect_by_func (image_editor->image,
                                             gimp_histogram_editor_layer_changed,
@@ -381,7 +389,7 @@ gimp_histogram_editor_set_image (GimpImageEditor *image_editor,
                                G_CALLBACK (gimp_histogram_editor_layer_changed),
                                editor, 0);
       g_signal_connect_object (image, "mask-changed",
-                               G_CALLBACK (gimp_histogram_editor_update),
+                               G_CALLBACK (gimp_histogram_editor_mask_changed),
                                editor, G_CONNECT_SWAPPED);
     }
 
@@ -421,7 +429,7 @@ gimp_histogram_editor_layer_changed (GimpImage           *image,
                                             gimp_histogram_editor_menu_update,
                                             editor);
       g_signal_handlers_disconnect_by_func (editor->drawable,
-                                            gimp_histogram_editor_update,
+                                            gimp_histogram_editor_drawable_update,
                                             editor);
       g_signal_handlers_disconnect_by_func (editor->drawable,
                                             gimp_histogram_editor_buffer_update,
@@ -459,8 +467,8 @@ gimp_histogram_editor_layer_changed (GimpImage           *image,
                                G_CALLBACK (gimp_histogram_editor_buffer_update),
                                editor, G_CONNECT_SWAPPED);
       g_signal_connect_object (editor->drawable, "update",
-                               G_CALLBACK (gimp_histogram_editor_update),
-                               editor, G_CONNECT_SWAPPED);
+                               G_CALLBACK (gimp_histogram_editor_drawable_update),
+                               editor, 0);
       g_signal_connect_object (editor->drawable, "alpha-changed",
                                G_CALLBACK (gimp_histogram_editor_menu_update),
                                editor, G_CONNECT_SWAPPED);
@@ -531,6 +539,9 @@ gimp_histogram_editor_validate (GimpHistogramEditor *editor)
 
               editor->histogram = gimp_histogram_new (editor->trc);
 
+              /*  only recalculate the parts of the drawable that changed  */
+              gimp_histogram_set_incremental (editor->histogram, TRUE);
+
               gimp_histogram_clear_values (
                 editor->histogram,
                 babl_format_get_n_components (
@@ -631,6 +642,9 @@ static void
 gimp_histogram_editor_buffer_update (GimpHistogramEditor *editor,
                                      const GParamSpec    *pspec)
 {
+  if (editor->histogram)
+    gimp_histogram_invalidate (editor->histogram, NULL);
+
   g_object_set (editor,
                 "trc", gimp_drawable_get_trc (editor->drawable),
                 NULL);
@@ -662,6 +676,35 @@ gimp_histogram_editor_update (GimpHistogramEditor *editor)
                         NULL);
 }
 
+static void
+gimp_histogram_editor_drawable_update (GimpDrawable        *drawable,
+                                       gint                 x,
+                                       gint                 y,
+                                       gint                 width,
+                                       gint                 height,
+                                       GimpHistogramEditor *editor)
+{
+  if (editor->histogram)
+    {
+      gimp_histogram_invalidate (editor->histogram,
+                                 GEGL_RECTANGLE (x, y, width, height));
+    }
+
+  gimp_histogram_editor_update (editor);
+}
+
+static void
+gimp_histogram_editor_mask_changed (GimpHistogramEditor *editor)
+{
+  /*  the mask area is part of what the histogram's chunks were
+   *  calculated from, but a change of its contents isn't
+   */
+  if (editor->histogram)
+    gimp_histogram_invalidate (editor->histogram, NULL);
+
+  gimp_histogram_editor_update (editor);
+}
+
 static gboolean
 gimp_histogram_editor_idle_update (GimpHistogramEditor *editor)
 {
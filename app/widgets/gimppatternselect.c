@@ -105,18 +105,18 @@ gimp_pattern_select_run_callback (GimpPdbDialog  *dialog,
                                   GError        **error)
 {
   GimpPattern    *pattern = GIMP_PATTERN (object);
+  GimpTempBuf    *mask    = gimp_pattern_get_mask (pattern);
   const Babl     *format;
   gpointer        data;
   GBytes         *bytes;
   GimpValueArray *return_vals;
 
-  format = gimp_babl_compat_u8_format (
-    gimp_temp_buf_get_format (pattern->mask));
-  data   = gimp_temp_buf_lock (pattern->mask, format, GEGL_ACCESS_READ);
+  format = gimp_babl_compat_u8_format (gimp_temp_buf_get_format (mask));
+  data   = gimp_temp_buf_lock (mask, format, GEGL_ACCESS_READ);
 
   bytes = g_bytes_new_static (data,
-                              gimp_temp_buf_get_width         (pattern->mask) *
-                              gimp_temp_buf_get_height        (pattern->mask) *
+                              gimp_temp_buf_get_width         (mask) *
+                              gimp_temp_buf_get_height        (mask) *
                               babl_format_get_bytes_per_pixel (format));
 
   return_vals =
@@ -125,16 +125,16 @@ gimp_pattern_select_run_callback (GimpPdbDialog  *dialog,
                                         NULL, error,
                                         dialog->callback_name,
                                         G_TYPE_STRING,         gimp_object_get_name (object),
-                                        G_TYPE_INT,            gimp_temp_buf_get_width  (pattern->mask),
-                                        G_TYPE_INT,            gimp_temp_buf_get_height (pattern->mask),
-                                        G_TYPE_INT,            babl_format_get_bytes_per_pixel (gimp_temp_buf_get_format (pattern->mask)),
+                                        G_TYPE_INT,            gimp_temp_buf_get_width  (mask),
+                                        G_TYPE_INT,            gimp_temp_buf_get_height (mask),
+                                        G_TYPE_INT,            babl_format_get_bytes_per_pixel (gimp_temp_buf_get_format (mask)),
                                         G_TYPE_BYTES,          bytes,
                                         G_TYPE_BOOLEAN,        closing,
                                         G_TYPE_NONE);
 
   g_bytes_unref (bytes);
 
-  gimp_temp_buf_unlock (pattern->mask, data);
+  gimp_temp_buf_unlock (mask, data);
 
   return return_vals;
 }
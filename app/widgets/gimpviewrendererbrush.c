@@ -168,6 +168,8 @@ gimp_view_renderer_brush_render_timeout (gpointer data)
 
   brush_pipe = GIMP_BRUSH_PIPE (renderer->viewable);
 
+  gimp_brush_load_pixels (GIMP_BRUSH (brush_pipe));
+
   renderbrush->pipe_animation_index++;
 
   if (renderbrush->pipe_animation_index >= brush_pipe->n_brushes)
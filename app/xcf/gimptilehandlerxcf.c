@@ -0,0 +1,534 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <cairo.h>
+#include <gio/gio.h>
+#include <gegl.h>
+
+#include "core/core-types.h"
+
+#include "xcf-private.h"
+#include "xcf-read.h"
+
+#include "gimptilehandlerxcf.h"
+
+
+static void       gimp_tile_handler_xcf_finalize   (GObject                 *object);
+
+static void       gimp_tile_handler_xcf_validate   (GimpTileHandlerValidate *validate,
+                                                    const GeglRectangle     *rect,
+                                                    const Babl              *format,
+                                                    gpointer                 dest_buf,
+                                                    gint                     dest_stride);
+
+static gpointer   gimp_tile_handler_xcf_command    (GeglTileSource          *source,
+                                                    GeglTileCommand          command,
+                                                    gint                     x,
+                                                    gint                     y,
+                                                    gint                     z,
+                                                    gpointer                 data);
+
+static void       gimp_tile_handler_xcf_load_tiles (GimpTileHandlerXcf      *xcf,
+                                                    gint                     x,
+                                                    gint                     y,
+                                                    gint                     n);
+static gboolean   gimp_tile_handler_xcf_read_tile  (GimpTileHandlerXcf      *xcf,
+                                                    gint                     tile,
+                                                    guchar                  *data,
+                                                    gsize                   *length);
+static void       gimp_tile_handler_xcf_release    (GimpTileHandlerXcf      *xcf);
+static gboolean   gimp_tile_handler_xcf_detach_idle
+                                                   (GimpTileHandlerXcf      *xcf);
+
+
+G_DEFINE_TYPE (GimpTileHandlerXcf, gimp_tile_handler_xcf,
+               GIMP_TYPE_TILE_HANDLER_VALIDATE)
+
+#define parent_class gimp_tile_handler_xcf_parent_class
+
+
+/*  all handlers which were assigned to a buffer, so that the files they
+ *  read from can be fully loaded before they are overwritten.
+ */
+static GList *handlers = NULL;
+G_LOCK_DEFINE_STATIC (handlers);
+
+/*  serializes seeking and reading on the handlers' input streams, and
+ *  their release.
+ */
+static GMutex read_mutex;
+
+
+static void
+gimp_tile_handler_xcf_class_init (GimpTileHandlerXcfClass *klass)
+{
+  GObjectClass                 *object_class = G_OBJECT_CLASS (klass);
+  GimpTileHandlerValidateClass *validate_class;
+
+  validate_class = GIMP_TILE_HANDLER_VALIDATE_CLASS (klass);
+
+  object_class->finalize   = gimp_tile_handler_xcf_finalize;
+
+  validate_class->validate = gimp_tile_handler_xcf_validate;
+}
+
+static void
+gimp_tile_handler_xcf_init (GimpTileHandlerXcf *xcf)
+{
+  GeglTileSource *source = GEGL_TILE_SOURCE (xcf);
+
+  /*  chain up to GimpTileHandlerValidate's command handler from ours  */
+  xcf->validate_command = source->command;
+  source->command       = gimp_tile_handler_xcf_command;
+
+  g_weak_ref_init (&xcf->buffer, NULL);
+}
+
+static void
+gimp_tile_handler_xcf_finalize (GObject *object)
+{
+  GimpTileHandlerXcf *xcf = GIMP_TILE_HANDLER_XCF (object);
+
+  G_LOCK (handlers);
+  handlers = g_list_remove (handlers, xcf);
+  G_UNLOCK (handlers);
+
+  g_weak_ref_clear (&xcf->buffer);
+
+  gimp_tile_handler_xcf_release (xcf);
+
+  g_clear_object (&xcf->file);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gimp_tile_handler_xcf_validate (GimpTileHandlerValidate *validate,
+                                const GeglRectangle     *rect,
+                                const Babl              *format,
+                                gpointer                 dest_buf,
+                                gint                     dest_stride)
+{
+  GimpTileHandlerXcf *xcf = GIMP_TILE_HANDLER_XCF (validate);
+  guchar             *file_data;
+  guchar             *tile_data;
+  gint                bpp;
+  gint                n_components;
+  gint                col0, col1;
+  gint                row0, row1;
+  gint                row;
+  gint                col;
+
+  bpp          = babl_format_get_bytes_per_pixel (format);
+  n_components = babl_format_get_n_components (format);
+
+  file_data = g_malloc (MAX (xcf->max_length, 1));
+  tile_data = g_malloc (XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp);
+
+  col0 = rect->x / XCF_TILE_WIDTH;
+  col1 = (rect->x + rect->width  - 1) / XCF_TILE_WIDTH;
+  row0 = rect->y / XCF_TILE_HEIGHT;
+  row1 = (rect->y + rect->height - 1) / XCF_TILE_HEIGHT;
+
+  for (row = row0; row <= row1; row++)
+    {
+      for (col = col0; col <= col1; col++)
+        {
+          GeglRectangle  tile_rect;
+          GeglRectangle  area;
+          gint           n_tile_cols;
+          gint           tile;
+          gint           tile_size;
+          gsize          length;
+          const guchar  *src;
+          guchar        *dest;
+          gint           y;
+
+          tile_rect.x      = col * XCF_TILE_WIDTH;
+          tile_rect.y      = row * XCF_TILE_HEIGHT;
+          tile_rect.width  = MIN (XCF_TILE_WIDTH,  xcf->width  - tile_rect.x);
+          tile_rect.height = MIN (XCF_TILE_HEIGHT, xcf->height - tile_rect.y);
+
+          if (! gegl_rectangle_intersect (&area, &tile_rect, rect))
+            continue;
+
+          n_tile_cols = (xcf->width + XCF_TILE_WIDTH - 1) / XCF_TILE_WIDTH;
+          tile        = row * n_tile_cols + col;
+          tile_size   = bpp * tile_rect.width * tile_rect.height;
+
+          if (! gimp_tile_handler_xcf_read_tile (xcf, tile,
+                                                 file_data, &length) ||
+              ! xcf->decompress (&tile_rect, format,
+                                 file_data, length,
+                                 tile_data, NULL))
+            {
+              /*  the file has been opened already, so a broken or
+               *  truncated tile can't fail loading anymore, leave it
+               *  transparent.
+               */
+              memset (tile_data, 0, tile_size);
+            }
+          else if (xcf->file_version >= 12)
+            {
+              xcf_read_from_be (bpp / n_components, tile_data,
+                                tile_size / bpp * n_components);
+            }
+
+          src  = tile_data +
+                 ((area.y - tile_rect.y) * tile_rect.width +
+                  (area.x - tile_rect.x)) * bpp;
+          dest = (guchar *) dest_buf +
+                 (area.y - rect->y) * dest_stride +
+                 (area.x - rect->x) * bpp;
+
+          for (y = 0; y < area.height; y++)
+            {
+              memcpy (dest, src, area.width * bpp);
+
+              src  += tile_rect.width * bpp;
+              dest += dest_stride;
+            }
+        }
+    }
+
+  g_free (tile_data);
+  g_free (file_data);
+}
+
+static gpointer
+gimp_tile_handler_xcf_command (GeglTileSource  *source,
+                               GeglTileCommand  command,
+                               gint             x,
+                               gint             y,
+                               gint             z,
+                               gpointer         data)
+{
+  GimpTileHandlerXcf      *xcf      = GIMP_TILE_HANDLER_XCF (source);
+  GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (source);
+
+  if (cairo_region_is_empty (validate->dirty_region))
+    {
+      if (! validate->validating &&
+          g_atomic_int_compare_and_exchange (&xcf->detach_pending,
+                                             FALSE, TRUE))
+        {
+          gimp_tile_handler_xcf_release (xcf);
+
+          /*  all tiles are loaded, we are not needed in the buffer's
+           *  tile chain anymore, but can't remove ourselves from it
+           *  while it's running a command.
+           */
+          g_idle_add_full (G_PRIORITY_LOW,
+                           (GSourceFunc) gimp_tile_handler_xcf_detach_idle,
+                           g_object_ref (xcf),
+                           (GDestroyNotify) g_object_unref);
+        }
+    }
+  else if (! validate->suspend_validate)
+    {
+      /*  unlike a projection, the tiles below us are not a cache of the
+       *  data we provide, but its only copy once loaded, so make sure
+       *  they are loaded before anything looks at them without going
+       *  through GEGL_TILE_GET at level 0.
+       */
+      switch (command)
+        {
+        case GEGL_TILE_GET:
+          if (z > 0)
+            gimp_tile_handler_xcf_load_tiles (xcf, x << z, y << z, 1 << z);
+          break;
+
+        case GEGL_TILE_COPY:
+          if (z == 0)
+            gimp_tile_handler_xcf_load_tiles (xcf, x, y, 1);
+          break;
+
+        case GEGL_TILE_EXIST:
+          if (z == 0)
+            {
+              cairo_rectangle_int_t tile_rect;
+
+              tile_rect.x      = x * validate->tile_width;
+              tile_rect.y      = y * validate->tile_height;
+              tile_rect.width  = validate->tile_width;
+              tile_rect.height = validate->tile_height;
+
+              if (cairo_region_contains_rectangle (validate->dirty_region,
+                                                   &tile_rect) !=
+                  CAIRO_REGION_OVERLAP_OUT)
+                {
+                  return GINT_TO_POINTER (TRUE);
+                }
+            }
+          break;
+
+        case GEGL_TILE_VOID:
+          if (z == 0)
+            {
+              cairo_rectangle_int_t tile_rect;
+
+              tile_rect.x      = x * validate->tile_width;
+              tile_rect.y      = y * validate->tile_height;
+              tile_rect.width  = validate->tile_width;
+              tile_rect.height = validate->tile_height;
+
+              cairo_region_subtract_rectangle (validate->dirty_region,
+                                               &tile_rect);
+            }
+          break;
+
+        default:
+          break;
+        }
+    }
+
+  return xcf->validate_command (source, command, x, y, z, data);
+}
+
+static void
+gimp_tile_handler_xcf_load_tiles (GimpTileHandlerXcf *xcf,
+                                  gint                x,
+                                  gint                y,
+                                  gint                n)
+{
+  GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (xcf);
+  GeglTileSource          *source   = GEGL_TILE_SOURCE (xcf);
+  cairo_rectangle_int_t    rect;
+  gint                     i;
+  gint                     j;
+
+  rect.x      = x * validate->tile_width;
+  rect.y      = y * validate->tile_height;
+  rect.width  = n * validate->tile_width;
+  rect.height = n * validate->tile_height;
+
+  if (cairo_region_contains_rectangle (validate->dirty_region, &rect) ==
+      CAIRO_REGION_OVERLAP_OUT)
+    {
+      return;
+    }
+
+  for (j = y; j < y + n; j++)
+    {
+      for (i = x; i < x + n; i++)
+        {
+          GeglTile *tile;
+
+          tile = xcf->validate_command (source, GEGL_TILE_GET, i, j, 0, NULL);
+
+          if (tile)
+            gegl_tile_unref (tile);
+        }
+    }
+}
+
+/*  reads the compressed data of @tile into @data, which must hold at
+ *  least xcf->max_length bytes.  the data is read from an open stream,
+ *  instead of being mapped, so that a file which is truncated under us
+ *  only results in a short read.
+ */
+static gboolean
+gimp_tile_handler_xcf_read_tile (GimpTileHandlerXcf *xcf,
+                                 gint                tile,
+                                 guchar             *data,
+                                 gsize              *length)
+{
+  gboolean success = FALSE;
+
+  *length = 0;
+
+  g_mutex_lock (&read_mutex);
+
+  if (xcf->input && tile < xcf->n_tiles && xcf->lengths[tile] > 0)
+    {
+      success = g_seekable_seek (G_SEEKABLE (xcf->input),
+                                 xcf->offsets[tile], G_SEEK_SET,
+                                 NULL, NULL) &&
+                g_input_stream_read_all (xcf->input,
+                                         data, xcf->lengths[tile], length,
+                                         NULL, NULL) &&
+                *length > 0;
+    }
+
+  g_mutex_unlock (&read_mutex);
+
+  return success;
+}
+
+static void
+gimp_tile_handler_xcf_release (GimpTileHandlerXcf *xcf)
+{
+  g_mutex_lock (&read_mutex);
+
+  g_clear_object (&xcf->input);
+  g_clear_pointer (&xcf->offsets, g_free);
+  g_clear_pointer (&xcf->lengths, g_free);
+
+  xcf->n_tiles = 0;
+
+  g_mutex_unlock (&read_mutex);
+}
+
+static gboolean
+gimp_tile_handler_xcf_detach_idle (GimpTileHandlerXcf *xcf)
+{
+  GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (xcf);
+  GeglBuffer              *buffer;
+
+  buffer = g_weak_ref_get (&xcf->buffer);
+
+  if (buffer)
+    {
+      if (gimp_tile_handler_validate_get_assigned (buffer) == validate &&
+          cairo_region_is_empty (validate->dirty_region))
+        {
+          gimp_tile_handler_validate_unassign (validate, buffer);
+        }
+      else
+        {
+          /*  we were temporarily unassigned, or invalidated again,
+           *  try again the next time all tiles are loaded.
+           */
+          g_atomic_int_set (&xcf->detach_pending, FALSE);
+        }
+
+      g_object_unref (buffer);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+
+/*  public functions  */
+
+GeglTileHandler *
+gimp_tile_handler_xcf_new (GFile              *file,
+                           GInputStream       *input,
+                           gint                width,
+                           gint                height,
+                           gint                file_version,
+                           DecompressTileFunc  decompress,
+                           const goffset      *offsets,
+                           const gint         *lengths,
+                           gint                n_tiles)
+{
+  GimpTileHandlerXcf *xcf;
+  gint                i;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (G_IS_SEEKABLE (input), NULL);
+  g_return_val_if_fail (decompress != NULL, NULL);
+  g_return_val_if_fail (offsets != NULL, NULL);
+  g_return_val_if_fail (lengths != NULL, NULL);
+
+  xcf = g_object_new (GIMP_TYPE_TILE_HANDLER_XCF, NULL);
+
+  xcf->file         = g_object_ref (file);
+  xcf->input        = g_object_ref (input);
+  xcf->width        = width;
+  xcf->height       = height;
+  xcf->file_version = file_version;
+  xcf->decompress   = decompress;
+  xcf->offsets      = g_memdup2 (offsets, n_tiles * sizeof (goffset));
+  xcf->lengths      = g_memdup2 (lengths, n_tiles * sizeof (gint));
+  xcf->n_tiles      = n_tiles;
+
+  for (i = 0; i < n_tiles; i++)
+    xcf->max_length = MAX (xcf->max_length, lengths[i]);
+
+  return GEGL_TILE_HANDLER (xcf);
+}
+
+void
+gimp_tile_handler_xcf_assign (GimpTileHandlerXcf *xcf,
+                              GeglBuffer         *buffer)
+{
+  g_return_if_fail (GIMP_IS_TILE_HANDLER_XCF (xcf));
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+  g_return_if_fail (xcf->input != NULL);
+
+  gimp_tile_handler_validate_assign (GIMP_TILE_HANDLER_VALIDATE (xcf),
+                                     buffer);
+
+  gimp_tile_handler_validate_invalidate (GIMP_TILE_HANDLER_VALIDATE (xcf),
+                                         GEGL_RECTANGLE (0, 0,
+                                                         xcf->width,
+                                                         xcf->height));
+
+  g_weak_ref_set (&xcf->buffer, buffer);
+
+  G_LOCK (handlers);
+  handlers = g_list_prepend (handlers, xcf);
+  G_UNLOCK (handlers);
+}
+
+/*  loads all pending tiles of the buffers whose data is read from
+ *  @file, so that it can be safely overwritten.
+ */
+void
+gimp_tile_handler_xcf_load_file (GFile *file)
+{
+  GList *buffers = NULL;
+  GList *list;
+
+  g_return_if_fail (G_IS_FILE (file));
+
+  G_LOCK (handlers);
+
+  for (list = handlers; list; list = g_list_next (list))
+    {
+      GimpTileHandlerXcf *xcf = list->data;
+      GeglBuffer         *buffer;
+
+      if (! g_file_equal (xcf->file, file))
+        continue;
+
+      /*  the buffer may be finalized on another thread, only keep it
+       *  if we can get a strong reference.
+       */
+      buffer = g_weak_ref_get (&xcf->buffer);
+
+      if (buffer)
+        buffers = g_list_prepend (buffers, buffer);
+    }
+
+  G_UNLOCK (handlers);
+
+  for (list = buffers; list; list = g_list_next (list))
+    {
+      GeglBuffer              *buffer = list->data;
+      GimpTileHandlerValidate *validate;
+
+      validate = gimp_tile_handler_validate_get_assigned (buffer);
+
+      if (GIMP_IS_TILE_HANDLER_XCF (validate))
+        {
+          gimp_tile_handler_validate_validate (validate, buffer, NULL,
+                                               TRUE, TRUE);
+
+          gimp_tile_handler_xcf_release (GIMP_TILE_HANDLER_XCF (validate));
+
+          gimp_tile_handler_validate_unassign (validate, buffer);
+        }
+    }
+
+  g_list_free_full (buffers, g_object_unref);
+}
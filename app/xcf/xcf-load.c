@@ -20,6 +20,10 @@
 #include <string.h>
 #include <zlib.h>
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #include <cairo.h>
 #include <gegl.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
@@ -30,6 +34,7 @@
 #include "core/core-types.h"
 
 #include "config/gimpcoreconfig.h"
+#include "config/gimpgeglconfig.h"
 
 #include "gegl/gimp-babl.h"
 #include "gegl/gimp-gegl-tile-compat.h"
@@ -77,6 +82,8 @@
 #include "xcf-seek.h"
 #include "xcf-utils.h"
 
+#include "gimptilehandlerxcf.h"
+
 #include "gimp-log.h"
 #include "gimp-intl.h"
 
@@ -86,6 +93,33 @@
 /* #define GIMP_XCF_PATH_DEBUG */
 
 
+/* Per thread data for xcf_load_tile_parallel */
+typedef struct
+{
+  /* Common to all jobs. */
+  GeglBuffer         *buffer;
+  gint                file_version;
+  DecompressTileFunc  decompress;
+  gpointer            decompress_data;
+
+  /* Job specific. */
+  gint                tile;
+  gint                batch_size;
+
+  /* Compressed data of all the tiles in the batch. */
+  guchar             *in_data;
+  goffset             in_data_size;
+  goffset             in_data_offset[XCF_TILE_LOAD_BATCH_SIZE];
+  gint                in_data_len[XCF_TILE_LOAD_BATCH_SIZE];
+
+  /* Temp data to avoid too many allocations. */
+  guchar             *tile_data;
+
+  /* Return data. */
+  gboolean            success;
+} XcfLoadJobData;
+
+
 static void            xcf_load_add_masks     (GimpImage     *image);
 static gboolean        xcf_load_image_props   (XcfInfo       *info,
                                                GimpImage     *image);
@@ -128,16 +162,29 @@ static gboolean        xcf_load_tile          (XcfInfo       *info,
                                                GeglBuffer    *buffer,
                                                GeglRectangle *tile_rect,
                                                const Babl    *format);
-static gboolean        xcf_load_tile_rle      (XcfInfo       *info,
-                                               GeglBuffer    *buffer,
-                                               GeglRectangle *tile_rect,
+static void            xcf_load_free_job_data (XcfLoadJobData *data);
+static void            xcf_load_tile_parallel (XcfLoadJobData *job_data,
+                                               GAsyncQueue    *queue);
+static gboolean        xcf_load_tile_rle      (GeglRectangle *tile_rect,
                                                const Babl    *format,
-                                               gint           data_length);
-static gboolean        xcf_load_tile_zlib     (XcfInfo       *info,
-                                               GeglBuffer    *buffer,
-                                               GeglRectangle *tile_rect,
+                                               const guchar  *xcfdata,
+                                               gint           data_length,
+                                               guchar        *tile_data,
+                                               gpointer       decompress_data);
+static gboolean        xcf_load_tile_zlib     (GeglRectangle *tile_rect,
+                                               const Babl    *format,
+                                               const guchar  *xcfdata,
+                                               gint           data_length,
+                                               guchar        *tile_data,
+                                               gpointer       decompress_data);
+#ifdef HAVE_ZSTD
+static gboolean        xcf_load_tile_zstd     (GeglRectangle *tile_rect,
                                                const Babl    *format,
-                                               gint           data_length);
+                                               const guchar  *xcfdata,
+                                               gint           data_length,
+                                               guchar        *tile_data,
+                                               gpointer       decompress_data);
+#endif
 static GimpParasite  * xcf_load_parasite      (XcfInfo       *info);
 static gboolean        xcf_load_old_paths     (XcfInfo       *info,
                                                GimpImage     *image);
@@ -1090,10 +1137,23 @@ xcf_load_image_props (XcfInfo   *info,
 
             xcf_read_int8 (info, (guint8 *) &compression, 1);
 
+#ifndef HAVE_ZSTD
+            if (compression == COMPRESS_ZSTD)
+              {
+                gimp_message_literal (info->gimp, G_OBJECT (info->progress),
+                                      GIMP_MESSAGE_ERROR,
+                                      "This XCF file uses Zstandard "
+                                      "compression, which is not supported "
+                                      "by this build of GIMP");
+                return FALSE;
+              }
+#endif
+
             if ((compression != COMPRESS_NONE) &&
                 (compression != COMPRESS_RLE) &&
                 (compression != COMPRESS_ZLIB) &&
-                (compression != COMPRESS_FRACTAL))
+                (compression != COMPRESS_FRACTAL) &&
+                (compression != COMPRESS_ZSTD))
               {
                 gimp_message (info->gimp, G_OBJECT (info->progress),
                               GIMP_MESSAGE_ERROR,
@@ -3093,7 +3153,7 @@ xcf_load_level (XcfInfo    *info,
 {
   const Babl *format;
   gint        bpp;
-  goffset     saved_pos;
+  goffset    *offset_table;
   goffset     offset;
   goffset     offset2;
   goffset     max_data_length;
@@ -3103,7 +3163,7 @@ xcf_load_level (XcfInfo    *info,
   gint        width;
   gint        height;
   gint        i;
-  gint        fail;
+  gboolean    success = TRUE;
 
   format = gegl_buffer_get_format (buffer);
   bpp    = babl_format_get_bytes_per_pixel (format);
@@ -3134,109 +3194,339 @@ xcf_load_level (XcfInfo    *info,
   n_tile_cols = gimp_gegl_buffer_get_n_tile_cols (buffer, XCF_TILE_WIDTH);
 
   ntiles = n_tile_rows * n_tile_cols;
-  for (i = 0; i < ntiles; i++)
+
+  /* read in the rest of the offset table at once, so that we don't have to
+   * seek back and forth between the table and the tiles.  the table has
+   * ntiles + 1 entries, since a zero offset indicates its end.
+   * Do not use g_alloca since it may cause Stack Overflow on
+   * large images, see issue #6138.
+   */
+  offset_table = g_new (goffset, ntiles + 1);
+  offset_table[0] = offset;
+
+  /* xcf_read_offset() uses the stack, so read the table in chunks */
+  for (i = 1; i <= ntiles; i += XCF_TILE_LOAD_BATCH_SIZE)
     {
-      GeglRectangle rect;
+      gint count = MIN (XCF_TILE_LOAD_BATCH_SIZE, ntiles + 1 - i);
+
+      if (xcf_read_offset (info, offset_table + i, count) !=
+          count * info->bytes_per_offset)
+        {
+          g_free (offset_table);
+          return FALSE;
+        }
+    }
 
-      fail = FALSE;
+  /* validate the table before loading anything */
+  for (i = 0; i < ntiles; i++)
+    {
+      offset  = offset_table[i];
+      offset2 = offset_table[i + 1];
 
       if (offset == 0)
         {
           gimp_message_literal (info->gimp, G_OBJECT (info->progress),
                                 GIMP_MESSAGE_ERROR,
                                 "not enough tiles found in level");
+          g_free (offset_table);
           return FALSE;
         }
 
-      /* save the current position as it is where the
-       *  next tile offset is stored.
-       */
-      saved_pos = info->cp;
-
-      /* read in the offset of the next tile so we can calculate the amount
-       * of data needed for this tile
-       */
-      xcf_read_offset (info, &offset2, 1);
-
       /* if the offset is 0 then we need to read in the maximum possible
        * allowing for negative compression
        */
       if (offset2 == 0)
         offset2 = offset + max_data_length;
 
-      /* seek to the tile offset */
-      if (! xcf_seek_pos (info, offset, NULL))
-        return FALSE;
-
       if (offset2 < offset || offset2 - offset > max_data_length)
         {
           gimp_message (info->gimp, G_OBJECT (info->progress),
                         GIMP_MESSAGE_ERROR,
                         "invalid tile data length: %" G_GOFFSET_FORMAT,
                         offset2 - offset);
+          g_free (offset_table);
           return FALSE;
         }
+    }
 
-      /* get buffer rectangle to write to */
-      gimp_gegl_buffer_get_tile_rect (buffer,
-                                      XCF_TILE_WIDTH, XCF_TILE_HEIGHT,
-                                      i, &rect);
+  if (offset_table[ntiles] != 0)
+    {
+      gimp_message (info->gimp, G_OBJECT (info->progress), GIMP_MESSAGE_ERROR,
+                    "encountered garbage after reading level: %" G_GOFFSET_FORMAT,
+                    offset_table[ntiles]);
+      g_free (offset_table);
+      return FALSE;
+    }
 
-      GIMP_LOG (XCF, "loading tile %d/%d", i + 1, ntiles);
+  if (info->tile_input &&
+      (info->compression == COMPRESS_RLE  ||
+       info->compression == COMPRESS_ZLIB ||
+       info->compression == COMPRESS_ZSTD) &&
+      ! gimp_tile_handler_validate_get_assigned (buffer))
+    {
+      /* lazy implementation: the tiles are read from the file and
+       * decompressed by a tile handler, the first time they are accessed.
+       */
+      GeglTileHandler    *handler;
+      DecompressTileFunc  decompress;
+      gint               *lengths;
 
-      /* read in the tile */
       switch (info->compression)
         {
-        case COMPRESS_NONE:
-          if (! xcf_load_tile (info, buffer, &rect, format))
-            fail = TRUE;
-          break;
         case COMPRESS_RLE:
-          if (! xcf_load_tile_rle (info, buffer, &rect, format,
-                                   offset2 - offset))
-            fail = TRUE;
+          decompress = xcf_load_tile_rle;
           break;
+
         case COMPRESS_ZLIB:
-          if (! xcf_load_tile_zlib (info, buffer, &rect, format,
-                                    offset2 - offset))
-            fail = TRUE;
+          decompress = xcf_load_tile_zlib;
           break;
-        case COMPRESS_FRACTAL:
-          g_printerr ("xcf: fractal compression unimplemented. "
-                      "Possibly corrupt XCF file.");
-          fail = TRUE;
+
+#ifdef HAVE_ZSTD
+        case COMPRESS_ZSTD:
+          decompress = xcf_load_tile_zstd;
           break;
+#endif
+
         default:
-          g_printerr ("xcf: unknown compression. "
-                      "Possibly corrupt XCF file.");
-          fail = TRUE;
-          break;
+          g_return_val_if_reached (FALSE);
         }
 
-      if (fail)
-        return FALSE;
+      lengths = g_new (gint, ntiles);
 
-      GIMP_LOG (XCF, "loaded tile %d/%d", i + 1, ntiles);
+      for (i = 0; i < ntiles; i++)
+        {
+          offset  = offset_table[i];
+          offset2 = offset_table[i + 1];
 
-      /* restore the saved position so we'll be ready to
-       *  read the next offset.
-       */
-      if (!xcf_seek_pos (info, saved_pos, NULL))
-        return FALSE;
+          /* the data of the last tile may end before the maximum length,
+           * the handler reads as much of it as there is.
+           */
+          if (offset2 == 0)
+            offset2 = offset + max_data_length;
 
-      /* read in the offset of the next tile */
-      xcf_read_offset (info, &offset, 1);
+          lengths[i] = offset2 - offset;
+        }
+
+      handler = gimp_tile_handler_xcf_new (info->file, info->tile_input,
+                                           width, height,
+                                           info->file_version, decompress,
+                                           offset_table, lengths, ntiles);
+
+      gimp_tile_handler_xcf_assign (GIMP_TILE_HANDLER_XCF (handler), buffer);
+
+      g_object_unref (handler);
+
+      g_free (lengths);
     }
+  else if (info->compression == COMPRESS_RLE  ||
+           info->compression == COMPRESS_ZLIB ||
+           info->compression == COMPRESS_ZSTD)
+    {
+      /* parallel implementation: the compressed data of a batch of tiles is
+       * read sequentially on this thread, and decompressed by the thread
+       * pool, while we read in the next batch.
+       */
+      XcfLoadJobData *job_data;
+      GThreadPool    *pool;
+      GAsyncQueue    *queue;
+      gint            num_processors;
+      gint            num_tasks;
+      gint            n_running = 0;
+      gint            tile_size = XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp;
+
+      num_processors = GIMP_GEGL_CONFIG (info->gimp->config)->num_processors;
+      num_tasks      = num_processors * 2;
+
+      queue = g_async_queue_new_full ((GDestroyNotify) xcf_load_free_job_data);
+      pool  = g_thread_pool_new_full ((GFunc) xcf_load_tile_parallel,
+                                      queue,
+                                      (GDestroyNotify) xcf_load_free_job_data,
+                                      num_processors, TRUE, NULL);
+
+      for (i = 0; i < ntiles; )
+        {
+          goffset batch_length = 0;
+          gint    k;
+
+          /* reuse the data of a finished job once there are enough jobs in
+           * flight.
+           */
+          if (n_running < num_tasks)
+            {
+              job_data = g_new0 (XcfLoadJobData, 1);
+              job_data->buffer       = buffer;
+              job_data->file_version = info->file_version;
+
+              switch (info->compression)
+                {
+                case COMPRESS_RLE:
+                  job_data->decompress = xcf_load_tile_rle;
+                  break;
+
+                case COMPRESS_ZLIB:
+                  job_data->decompress = xcf_load_tile_zlib;
+                  break;
+
+#ifdef HAVE_ZSTD
+                case COMPRESS_ZSTD:
+                  job_data->decompress      = xcf_load_tile_zstd;
+                  job_data->decompress_data = ZSTD_createDCtx ();
+                  break;
+#endif
+
+                default:
+                  g_return_val_if_reached (FALSE);
+                }
+
+              job_data->tile_data    = g_malloc (tile_size);
+            }
+          else
+            {
+              job_data = g_async_queue_pop (queue);
+              n_running--;
+
+              if (! job_data->success)
+                {
+                  xcf_load_free_job_data (job_data);
+                  success = FALSE;
+                  break;
+                }
+            }
+
+          job_data->tile       = i;
+          job_data->batch_size = MIN (XCF_TILE_LOAD_BATCH_SIZE, ntiles - i);
+          job_data->success    = TRUE;
+
+          for (k = 0; k < job_data->batch_size; k++)
+            {
+              offset  = offset_table[i + k];
+              offset2 = offset_table[i + k + 1];
+
+              if (offset2 == 0)
+                offset2 = offset + max_data_length;
+
+              batch_length += offset2 - offset;
+            }
+
+          if (batch_length > job_data->in_data_size)
+            {
+              g_free (job_data->in_data);
+
+              job_data->in_data      = g_malloc (batch_length);
+              job_data->in_data_size = batch_length;
+            }
+
+          batch_length = 0;
+
+          GIMP_LOG (XCF, "reading tiles %d-%d/%d",
+                    i + 1, i + job_data->batch_size, ntiles);
+
+          for (k = 0; k < job_data->batch_size; k++)
+            {
+              gsize bytes_read;
+
+              offset  = offset_table[i + k];
+              offset2 = offset_table[i + k + 1];
+
+              if (offset2 == 0)
+                offset2 = offset + max_data_length;
+
+              /* seek to the tile offset */
+              if (! xcf_seek_pos (info, offset, NULL))
+                {
+                  success = FALSE;
+                  break;
+                }
+
+              /* we have to read directly instead of xcf_read_* because we may
+               * be reading past the end of the file here
+               */
+              g_input_stream_read_all (info->input,
+                                       job_data->in_data + batch_length,
+                                       offset2 - offset,
+                                       &bytes_read, NULL, NULL);
+              info->cp += bytes_read;
 
-  if (offset != 0)
+              job_data->in_data_offset[k] = batch_length;
+              job_data->in_data_len[k]    = bytes_read;
+
+              batch_length += bytes_read;
+            }
+
+          if (! success)
+            {
+              xcf_load_free_job_data (job_data);
+              break;
+            }
+
+          g_thread_pool_push (pool, job_data, NULL);
+          n_running++;
+
+          i += job_data->batch_size;
+        }
+
+      /* wait for the remaining jobs */
+      while (n_running > 0)
+        {
+          job_data = g_async_queue_pop (queue);
+          n_running--;
+
+          if (! job_data->success)
+            success = FALSE;
+
+          xcf_load_free_job_data (job_data);
+        }
+
+      g_thread_pool_free (pool, FALSE, TRUE);
+      g_async_queue_unref (queue);
+    }
+  else
     {
-      gimp_message (info->gimp, G_OBJECT (info->progress), GIMP_MESSAGE_ERROR,
-                    "encountered garbage after reading level: %" G_GOFFSET_FORMAT,
-                    offset);
-      return FALSE;
+      /* non parallel implementation */
+      for (i = 0; i < ntiles && success; i++)
+        {
+          GeglRectangle rect;
+
+          /* seek to the tile offset */
+          if (! xcf_seek_pos (info, offset_table[i], NULL))
+            {
+              success = FALSE;
+              break;
+            }
+
+          /* get buffer rectangle to write to */
+          gimp_gegl_buffer_get_tile_rect (buffer,
+                                          XCF_TILE_WIDTH, XCF_TILE_HEIGHT,
+                                          i, &rect);
+
+          GIMP_LOG (XCF, "loading tile %d/%d", i + 1, ntiles);
+
+          /* read in the tile */
+          switch (info->compression)
+            {
+            case COMPRESS_NONE:
+              if (! xcf_load_tile (info, buffer, &rect, format))
+                success = FALSE;
+              break;
+            case COMPRESS_FRACTAL:
+              g_printerr ("xcf: fractal compression unimplemented. "
+                          "Possibly corrupt XCF file.");
+              success = FALSE;
+              break;
+            default:
+              g_printerr ("xcf: unknown compression. "
+                          "Possibly corrupt XCF file.");
+              success = FALSE;
+              break;
+            }
+
+          GIMP_LOG (XCF, "loaded tile %d/%d", i + 1, ntiles);
+        }
     }
 
-  return TRUE;
+  g_free (offset_table);
+
+  return success;
 }
 
 static gboolean
@@ -3270,45 +3560,92 @@ xcf_load_tile (XcfInfo       *info,
   return TRUE;
 }
 
-static gboolean
-xcf_load_tile_rle (XcfInfo       *info,
-                   GeglBuffer    *buffer,
-                   GeglRectangle *tile_rect,
-                   const Babl    *format,
-                   gint           data_length)
+static void
+xcf_load_free_job_data (XcfLoadJobData *data)
 {
-  gint    bpp       = babl_format_get_bytes_per_pixel (format);
-  gint    tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar *tile_data = g_alloca (tile_size);
-  guchar  nonzero   = FALSE;
-  gsize   bytes_read;
-  gint    i;
-  guchar *xcfdata;
-  guchar *xcfodata;
-  guchar *xcfdatalimit;
-
-  /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
-   * this tile (return TRUE without storing data) as if it did not
-   * contain any data.  It is better than returning FALSE, which would
-   * skip the whole hierarchy while there may still be some valid
-   * tiles in the file.
-   */
-  if (data_length <= 0)
-    return TRUE;
+#ifdef HAVE_ZSTD
+  if (data->decompress == xcf_load_tile_zstd)
+    ZSTD_freeDCtx (data->decompress_data);
+#endif
+
+  g_free (data->in_data);
+  g_free (data->tile_data);
+  g_free (data);
+}
 
-  xcfdata = xcfodata = g_alloca (data_length);
+static void
+xcf_load_tile_parallel (XcfLoadJobData *job_data,
+                        GAsyncQueue    *queue)
+{
+  const Babl    *format;
+  GeglRectangle  tile_rect;
+  gint           bpp;
+  gint           n_components;
 
-  /* we have to read directly instead of xcf_read_* because we may be
-   * reading past the end of the file here
-   */
-  g_input_stream_read_all (info->input, xcfdata, data_length,
-                           &bytes_read, NULL, NULL);
-  info->cp += bytes_read;
+  format       = gegl_buffer_get_format (job_data->buffer);
+  bpp          = babl_format_get_bytes_per_pixel (format);
+  n_components = babl_format_get_n_components (format);
 
-  if (bytes_read == 0)
-    return TRUE;
+  for (gint i = 0; i < job_data->batch_size; ++i)
+    {
+      gint tile_size;
+
+      /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
+       * this tile (without storing data) as if it did not contain any data.
+       * It is better than failing, which would skip the whole hierarchy
+       * while there may still be some valid tiles in the file.
+       */
+      if (job_data->in_data_len[i] <= 0)
+        continue;
+
+      gimp_gegl_buffer_get_tile_rect (job_data->buffer,
+                                      XCF_TILE_WIDTH,
+                                      XCF_TILE_HEIGHT,
+                                      job_data->tile + i,
+                                      &tile_rect);
+
+      tile_size = bpp * tile_rect.width * tile_rect.height;
+
+      if (! job_data->decompress (&tile_rect, format,
+                                  job_data->in_data +
+                                  job_data->in_data_offset[i],
+                                  job_data->in_data_len[i],
+                                  job_data->tile_data,
+                                  job_data->decompress_data))
+        {
+          job_data->success = FALSE;
+          break;
+        }
+
+      if (! xcf_data_is_zero (job_data->tile_data, tile_size))
+        {
+          if (job_data->file_version >= 12)
+            {
+              xcf_read_from_be (bpp / n_components, job_data->tile_data,
+                                tile_size / bpp * n_components);
+            }
+
+          gegl_buffer_set (job_data->buffer, &tile_rect, 0, format,
+                           job_data->tile_data, GEGL_AUTO_ROWSTRIDE);
+        }
+    }
+
+  g_async_queue_push (queue, job_data);
+}
+
+static gboolean
+xcf_load_tile_rle (GeglRectangle *tile_rect,
+                   const Babl    *format,
+                   const guchar  *xcfdata,
+                   gint           data_length,
+                   guchar        *tile_data,
+                   gpointer       decompress_data)
+{
+  gint          bpp = babl_format_get_bytes_per_pixel (format);
+  gint          i;
+  const guchar *xcfdatalimit;
 
-  xcfdatalimit = &xcfodata[bytes_read - 1];
+  xcfdatalimit = &xcfdata[data_length - 1];
 
   for (i = 0; i < bpp; i++)
     {
@@ -3359,7 +3696,6 @@ xcf_load_tile_rle (XcfInfo       *info,
               while (length-- > 0)
                 {
                   *data = *xcfdata++;
-                  nonzero |= *data;
                   data += bpp;
                 }
             }
@@ -3391,7 +3727,6 @@ xcf_load_tile_rle (XcfInfo       *info,
                 }
 
               val = *xcfdata++;
-              nonzero |= val;
 
               for (j = 0; j < length; j++)
                 {
@@ -3402,20 +3737,6 @@ xcf_load_tile_rle (XcfInfo       *info,
         }
     }
 
-  if (nonzero)
-    {
-      if (info->file_version >= 12)
-        {
-          gint n_components = babl_format_get_n_components (format);
-
-          xcf_read_from_be (bpp / n_components, tile_data,
-                            tile_size / bpp * n_components);
-        }
-
-      gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                       GEGL_AUTO_ROWSTRIDE);
-    }
-
   return TRUE;
 
  bogus_rle:
@@ -3423,41 +3744,18 @@ xcf_load_tile_rle (XcfInfo       *info,
 }
 
 static gboolean
-xcf_load_tile_zlib (XcfInfo       *info,
-                    GeglBuffer    *buffer,
-                    GeglRectangle *tile_rect,
+xcf_load_tile_zlib (GeglRectangle *tile_rect,
                     const Babl    *format,
-                    gint           data_length)
+                    const guchar  *xcfdata,
+                    gint           data_length,
+                    guchar        *tile_data,
+                    gpointer       decompress_data)
 {
   z_stream  strm;
   int       action;
   int       status;
   gint      bpp       = babl_format_get_bytes_per_pixel (format);
   gint      tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar   *tile_data = g_alloca (tile_size);
-  gsize     bytes_read;
-  guchar   *xcfdata;
-
-  /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
-   * this tile (return TRUE without storing data) as if it did not
-   * contain any data.  It is better than returning FALSE, which would
-   * skip the whole hierarchy while there may still be some valid
-   * tiles in the file.
-   */
-  if (data_length <= 0)
-    return TRUE;
-
-  xcfdata = g_alloca (data_length);
-
-  /* we have to read directly instead of xcf_read_* because we may be
-   * reading past the end of the file here
-   */
-  g_input_stream_read_all (info->input, xcfdata, data_length,
-                           &bytes_read, NULL, NULL);
-  info->cp += bytes_read;
-
-  if (bytes_read == 0)
-    return TRUE;
 
   strm.next_out  = tile_data;
   strm.avail_out = tile_size;
@@ -3465,8 +3763,8 @@ xcf_load_tile_zlib (XcfInfo       *info,
   strm.zalloc    = Z_NULL;
   strm.zfree     = Z_NULL;
   strm.opaque    = Z_NULL;
-  strm.next_in   = xcfdata;
-  strm.avail_in  = bytes_read;
+  strm.next_in   = (Bytef *) xcfdata;
+  strm.avail_in  = data_length;
 
   /* Initialize the stream decompression. */
   status = inflateInit (&strm);
@@ -3503,24 +3801,64 @@ xcf_load_tile_zlib (XcfInfo       *info,
         }
     }
 
-  if (! xcf_data_is_zero (tile_data, tile_size))
-    {
-      if (info->file_version >= 12)
-        {
-          gint n_components = babl_format_get_n_components (format);
+  inflateEnd (&strm);
 
-          xcf_read_from_be (bpp / n_components, tile_data,
-                            tile_size / bpp * n_components);
-        }
+  return TRUE;
+}
 
-      gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                       GEGL_AUTO_ROWSTRIDE);
+#ifdef HAVE_ZSTD
+static gboolean
+xcf_load_tile_zstd (GeglRectangle *tile_rect,
+                    const Babl    *format,
+                    const guchar  *xcfdata,
+                    gint           data_length,
+                    guchar        *tile_data,
+                    gpointer       decompress_data)
+{
+  ZSTD_DCtx *dctx      = decompress_data;
+  gint       bpp       = babl_format_get_bytes_per_pixel (format);
+  gint       tile_size = bpp * tile_rect->width * tile_rect->height;
+  size_t     frame_size;
+  size_t     size;
+
+  /*  the length of the last tile of a level is computed up to the
+   *  next offset in the file, and includes whatever follows the tile,
+   *  which zstd refuses; only pass it the tile's frame
+   */
+  frame_size = ZSTD_findFrameCompressedSize (xcfdata, data_length);
+
+  if (ZSTD_isError (frame_size))
+    {
+      g_printerr ("xcf: tile decompression failed: %s\n",
+                  ZSTD_getErrorName (frame_size));
+      return FALSE;
     }
 
-  inflateEnd (&strm);
+  if (dctx)
+    size = ZSTD_decompressDCtx (dctx,
+                                tile_data, tile_size,
+                                xcfdata, frame_size);
+  else
+    size = ZSTD_decompress (tile_data, tile_size,
+                            xcfdata, frame_size);
+
+  if (ZSTD_isError (size))
+    {
+      g_printerr ("xcf: tile decompression failed: %s\n",
+                  ZSTD_getErrorName (size));
+      return FALSE;
+    }
+  else if (size != tile_size)
+    {
+      g_printerr ("xcf: decompressed tile size %" G_GSIZE_FORMAT
+                  " doesn't match the expected size %d.\n",
+                  size, tile_size);
+      return FALSE;
+    }
 
   return TRUE;
 }
+#endif
 
 static GimpParasite *
 xcf_load_parasite (XcfInfo *info)
@@ -23,6 +23,7 @@
 #define XCF_TILE_HEIGHT                 64
 #define XCF_TILE_MAX_DATA_LENGTH_FACTOR 1.5
 #define XCF_TILE_SAVE_BATCH_SIZE        128
+#define XCF_TILE_LOAD_BATCH_SIZE        128
 
 typedef enum
 {
@@ -77,9 +78,17 @@ typedef enum
   COMPRESS_NONE              =  0,
   COMPRESS_RLE               =  1,
   COMPRESS_ZLIB              =  2,  /* unused */
-  COMPRESS_FRACTAL           =  3   /* unused */
+  COMPRESS_FRACTAL           =  3,  /* unused */
+  COMPRESS_ZSTD              =  4   /* since XCF version 19 */
 } XcfCompressionType;
 
+typedef gboolean (* DecompressTileFunc) (GeglRectangle *tile_rect,
+                                         const Babl    *format,
+                                         const guchar  *xcfdata,
+                                         gint           data_length,
+                                         guchar        *tile_data,
+                                         gpointer       decompress_data);
+
 typedef enum
 {
   XCF_ORIENTATION_HORIZONTAL = 1,
@@ -109,6 +118,7 @@ struct _XcfInfo
   goffset             cp;
   gint                bytes_per_offset;
   GFile              *file;
+  GInputStream       *tile_input;
   GimpTattoo          tattoo_state;
   GList              *selected_layers;
   GList              *selected_channels;
@@ -129,6 +139,7 @@ struct _XcfInfo
   GimpLayer          *floating_sel;
   goffset             floating_sel_offset;
   XcfCompressionType  compression;
+  gint                compression_level;
   gint                file_version;
 };
 
@@ -20,6 +20,10 @@
 #include <string.h>
 #include <zlib.h>
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #include <cairo.h>
 #include <gegl.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
@@ -75,12 +79,14 @@
 
 #include "gimp-intl.h"
 
+/* sets *lenptr to a negative value on failure */
 typedef void (* CompressTileFunc) (GeglRectangle  *tile_rect,
                                    guchar         *tile_data,
                                    const Babl     *format,
                                    guchar         *out_data,
                                    gint            out_data_max_len,
-                                   gint           *lenptr);
+                                   gint           *lenptr,
+                                   gpointer        compress_data);
 
 /* Per thread data for xcf_save_tile_rle */
 typedef struct
@@ -90,6 +96,7 @@ typedef struct
   gint              file_version;
   gint              max_out_data_len;
   CompressTileFunc  compress;
+  gpointer          compress_data;
 
   /* Job specific. */
   gint              tile;
@@ -159,13 +166,24 @@ static void     xcf_save_tile_rle      (GeglRectangle     *tile_rect,
                                         const Babl        *format,
                                         guchar            *rlebuf,
                                         gint               rlebuf_max_len,
-                                        gint              *lenptr);
+                                        gint              *lenptr,
+                                        gpointer           compress_data);
 static void     xcf_save_tile_zlib     (GeglRectangle     *tile_rect,
                                         guchar            *tile_data,
                                         const Babl        *format,
                                         guchar            *zlib_data,
                                         gint               zlib_data_max_len,
-                                        gint              *lenptr);
+                                        gint              *lenptr,
+                                        gpointer           compress_data);
+#ifdef HAVE_ZSTD
+static void     xcf_save_tile_zstd     (GeglRectangle     *tile_rect,
+                                        guchar            *tile_data,
+                                        const Babl        *format,
+                                        guchar            *zstd_data,
+                                        gint               zstd_data_max_len,
+                                        gint              *lenptr,
+                                        gpointer           compress_data);
+#endif
 static gboolean xcf_save_parasite      (XcfInfo           *info,
                                         GimpParasite      *parasite,
                                         GError           **error);
@@ -1918,8 +1936,9 @@ xcf_save_level (XcfInfo     *info,
   /* 'offset' is where we will write the next tile */
   offset = info->cp;
 
-  if (info->compression == COMPRESS_RLE ||
-      info->compression == COMPRESS_ZLIB)
+  if (info->compression == COMPRESS_RLE  ||
+      info->compression == COMPRESS_ZLIB ||
+      info->compression == COMPRESS_ZSTD)
     {
       /* parallel implementation */
       XcfJobData  *job_data;
@@ -1958,8 +1977,36 @@ xcf_save_level (XcfInfo     *info,
           job_data->buffer        = buffer;
           job_data->file_version  = info->file_version;
           job_data->max_out_data_len = out_data_max_size;
-          job_data->compress      = (info->compression == COMPRESS_RLE) ?
-                                      xcf_save_tile_rle : xcf_save_tile_zlib;
+          job_data->compress_data = NULL;
+
+          switch (info->compression)
+            {
+            case COMPRESS_RLE:
+              job_data->compress = xcf_save_tile_rle;
+              break;
+
+            case COMPRESS_ZLIB:
+              job_data->compress = xcf_save_tile_zlib;
+              break;
+
+#ifdef HAVE_ZSTD
+            case COMPRESS_ZSTD:
+              /* each job gets its own compression context, which is reused
+               * for all its tiles.
+               */
+              job_data->compress      = xcf_save_tile_zstd;
+              job_data->compress_data = ZSTD_createCCtx ();
+
+              ZSTD_CCtx_setParameter (job_data->compress_data,
+                                      ZSTD_c_compressionLevel,
+                                      info->compression_level);
+              break;
+#endif
+
+            default:
+              g_return_val_if_reached (FALSE);
+            }
+
           job_data->tile_data     = g_malloc (tile_size);
           job_data->out_data      = g_malloc (out_data_max_size * XCF_TILE_SAVE_BATCH_SIZE);
 
@@ -2003,6 +2050,17 @@ xcf_save_level (XcfInfo     *info,
                   /* Now write the data. */
                   for (k = 0; k < batch_size; k++)
                     {
+                      if (out_data_len[k] < 0)
+                        {
+                          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                                       _("Error compressing tile data"));
+                          g_thread_pool_free (pool, TRUE, TRUE);
+                          g_async_queue_unref (queue);
+                          g_free (switch_out_data);
+                          g_free (offset_table);
+                          return FALSE;
+                        }
+
                       *next_offset++ = offset;
                       xcf_write_int8_check_error (info,
                                                   switch_out_data + out_data_max_size * k,
@@ -2040,6 +2098,17 @@ xcf_save_level (XcfInfo     *info,
 
               for (k = 0; k < job_data->batch_size; k++)
                 {
+                  if (job_data->out_data_len[k] < 0)
+                    {
+                      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                                   _("Error compressing tile data"));
+                      xcf_save_free_job_data (job_data);
+                      g_thread_pool_free (pool, TRUE, TRUE);
+                      g_async_queue_unref (queue);
+                      g_free (offset_table);
+                      return FALSE;
+                    }
+
                   *next_offset++ = offset;
                   xcf_write_int8_check_error (info,
                                               job_data->out_data + out_data_max_size * k,
@@ -2168,6 +2237,11 @@ xcf_save_tile (XcfInfo        *info,
 static void
 xcf_save_free_job_data (XcfJobData *data)
 {
+#ifdef HAVE_ZSTD
+  if (data->compress == xcf_save_tile_zstd)
+    ZSTD_freeCCtx (data->compress_data);
+#endif
+
   g_free (data->out_data);
   g_free (data->tile_data);
   g_free (data);
@@ -2221,7 +2295,8 @@ xcf_save_tile_parallel (XcfJobData  *job_data,
       job_data->compress (&tile_rect, job_data->tile_data, format,
                           job_data->out_data + job_data->max_out_data_len * i,
                           job_data->max_out_data_len,
-                          job_data->out_data_len + i);
+                          job_data->out_data_len + i,
+                          job_data->compress_data);
     }
 
   g_async_queue_push_sorted (queue, job_data,
@@ -2235,7 +2310,8 @@ xcf_save_tile_rle (GeglRectangle  *tile_rect,
                    const Babl     *format,
                    guchar         *rlebuf,
                    gint            rlebuf_max_len,
-                   gint           *lenptr)
+                   gint           *lenptr,
+                   gpointer        compress_data)
 {
   gint bpp = babl_format_get_bytes_per_pixel (format);
   gint len = 0;
@@ -2353,7 +2429,8 @@ xcf_save_tile_zlib (GeglRectangle  *tile_rect,
                     const Babl     *format,
                     guchar         *zlib_data,
                     gint            zlib_data_max_len,
-                    gint           *lenptr)
+                    gint           *lenptr,
+                    gpointer        compress_data)
 {
   gint      bpp       = babl_format_get_bytes_per_pixel (format);
   gint      tile_size = bpp * tile_rect->width * tile_rect->height;
@@ -2411,6 +2488,41 @@ xcf_save_tile_zlib (GeglRectangle  *tile_rect,
   deflateEnd (&strm);
 }
 
+#ifdef HAVE_ZSTD
+static void
+xcf_save_tile_zstd (GeglRectangle  *tile_rect,
+                    guchar         *tile_data,
+                    const Babl     *format,
+                    guchar         *zstd_data,
+                    gint            zstd_data_max_len,
+                    gint           *lenptr,
+                    gpointer        compress_data)
+{
+  ZSTD_CCtx *cctx      = compress_data;
+  gint       bpp       = babl_format_get_bytes_per_pixel (format);
+  gint       tile_size = bpp * tile_rect->width * tile_rect->height;
+  size_t     size;
+
+  *lenptr = 0;
+
+  size = ZSTD_compress2 (cctx,
+                         zstd_data, zstd_data_max_len,
+                         tile_data, tile_size);
+
+  if (ZSTD_isError (size))
+    {
+      g_printerr ("xcf: tile compression failed: %s\n",
+                  ZSTD_getErrorName (size));
+
+      /*  make xcf_save_level() abort the save  */
+      *lenptr = -1;
+      return;
+    }
+
+  *lenptr = size;
+}
+#endif
+
 static gboolean
 xcf_save_parasite (XcfInfo       *info,
                    GimpParasite  *parasite,
@@ -18,6 +18,7 @@
 #include "config.h"
 
 #include <gio/gio.h>
+#include <gegl.h>
 
 #include "core/core-types.h"
 
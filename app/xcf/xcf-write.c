@@ -20,6 +20,7 @@
 #include <string.h>
 
 #include <gio/gio.h>
+#include <gegl.h>
 
 #include "core/core-types.h"
 
@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <cairo.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <glib/gstdio.h>
 #include <gegl.h>
@@ -29,6 +30,8 @@
 
 #include "core/core-types.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "core/gimp.h"
 #include "core/gimpimage.h"
 #include "core/gimpdrawable.h"
@@ -44,6 +47,8 @@
 #include "xcf-read.h"
 #include "xcf-save.h"
 
+#include "gimptilehandlerxcf.h"
+
 #include "gimp-intl.h"
 
 
@@ -87,6 +92,7 @@ static GimpXcfLoaderFunc * const xcf_loaders[] =
   xcf_load_image,   /* version 16 */
   xcf_load_image,   /* version 17 */
   xcf_load_image,   /* version 18 */
+  xcf_load_image,   /* version 19 */
 };
 
 
@@ -272,6 +278,22 @@ xcf_load_stream (Gimp          *gimp,
   info.file             = input_file;
   info.compression      = COMPRESS_NONE;
 
+#ifndef G_OS_WIN32
+  /*  on Windows, a file can't be replaced while it is open.  elsewhere,
+   *  saving over the file replaces it with a new one, and the tiles which
+   *  are not loaded yet keep being read from the old one.
+   */
+  if (input_file && GIMP_CORE_CONFIG (gimp->config)->xcf_lazy_loading)
+    {
+      GFileInputStream *tile_input = g_file_read (input_file, NULL, NULL);
+
+      if (tile_input && g_seekable_can_seek (G_SEEKABLE (tile_input)))
+        info.tile_input = G_INPUT_STREAM (g_object_ref (tile_input));
+
+      g_clear_object (&tile_input);
+    }
+#endif
+
   if (progress)
     gimp_progress_start (progress, FALSE, _("Opening '%s'"), filename);
 
@@ -321,6 +343,8 @@ xcf_load_stream (Gimp          *gimp,
         }
     }
 
+  g_clear_object (&info.tile_input);
+
   if (progress)
     gimp_progress_end (progress);
 
@@ -361,13 +385,29 @@ xcf_save_stream (Gimp           *gimp,
   info.file             = output_file;
 
   if (gimp_image_get_xcf_compression (image))
-    info.compression = COMPRESS_ZLIB;
+    {
+#ifdef HAVE_ZSTD
+      GimpCoreConfig *config = GIMP_CORE_CONFIG (gimp->config);
+
+      if (config->xcf_compression_codec == GIMP_XCF_COMPRESSION_CODEC_ZSTD)
+        {
+          info.compression       = COMPRESS_ZSTD;
+          info.compression_level = config->xcf_zstd_level;
+        }
+      else
+#endif
+        {
+          info.compression = COMPRESS_ZLIB;
+        }
+    }
   else
-    info.compression = COMPRESS_RLE;
+    {
+      info.compression = COMPRESS_RLE;
+    }
 
   info.file_version = gimp_image_get_xcf_version (image,
-                                                  info.compression ==
-                                                  COMPRESS_ZLIB,
+                                                  info.compression !=
+                                                  COMPRESS_RLE,
                                                   NULL, NULL, NULL);
 
   if (info.file_version >= 11)
@@ -475,6 +515,9 @@ xcf_save_invoker (GimpProcedure         *procedure,
   image = g_value_get_object (gimp_value_array_index (args, 1));
   file  = g_value_get_object (gimp_value_array_index (args, 4));
 
+  /*  the file may still provide the pixels of lazily loaded images  */
+  gimp_tile_handler_xcf_load_file (file);
+
   output = G_OUTPUT_STREAM (g_file_replace (file,
                                             NULL, FALSE, G_FILE_CREATE_NONE,
                                             NULL, &my_error));
@@ -66,7 +66,6 @@
 #include "gimp-shm.h"
 
 
-#define TILE_MAP_SIZE     (gimp_tile_width () * gimp_tile_height () * 32)
 #define ERRMSG_SHM_FAILED "Could not attach to gimp shared memory segment"
 
 
@@ -76,6 +75,7 @@ static HANDLE  _shm_handle;
 
 static gint    _shm_ID   = -1;
 static guchar *_shm_addr = NULL;
+static gsize   _shm_size = 0;
 
 
 guchar *
@@ -84,10 +84,18 @@ _gimp_shm_addr (void)
   return _shm_addr;
 }
 
+gsize
+_gimp_shm_size (void)
+{
+  return _shm_addr ? _shm_size : 0;
+}
+
 void
-_gimp_shm_open (gint shm_ID)
+_gimp_shm_open (gint  shm_ID,
+                gsize shm_size)
 {
-  _shm_ID = shm_ID;
+  _shm_ID   = shm_ID;
+  _shm_size = shm_size;
 
   if (_shm_ID != -1)
     {
@@ -127,7 +135,7 @@ _gimp_shm_open (gint shm_ID)
           /* Map the shared memory into our address space for use */
           _shm_addr = (guchar *) MapViewOfFile (_shm_handle,
                                                 FILE_MAP_ALL_ACCESS,
-                                                0, 0, TILE_MAP_SIZE);
+                                                0, 0, _shm_size);
 
           /* Verify that we mapped our view */
           if (!_shm_addr)
@@ -158,7 +166,7 @@ _gimp_shm_open (gint shm_ID)
       if (shm_fd != -1)
         {
           /* Map the shared memory into our address space for use */
-          _shm_addr = (guchar *) mmap (NULL, TILE_MAP_SIZE,
+          _shm_addr = (guchar *) mmap (NULL, _shm_size,
                                        PROT_READ | PROT_WRITE, MAP_SHARED,
                                        shm_fd, 0);
 
@@ -197,7 +205,61 @@ _gimp_shm_close (void)
 #elif defined(USE_POSIX_SHM)
 
   if ((_shm_ID != -1) && (_shm_addr != MAP_FAILED))
-    munmap (_shm_addr, TILE_MAP_SIZE);
+    munmap (_shm_addr, _shm_size);
+
+#endif
+}
+
+/*  maps a shared memory object the core exported for us, privately,
+ *  so that our writes don't go back to it
+ */
+guchar *
+_gimp_shm_map (const gchar *name,
+               gsize        size)
+{
+#if defined(USE_POSIX_SHM)
+
+  guchar *addr;
+  gint    shm_fd;
+
+  g_return_val_if_fail (name != NULL, NULL);
 
+  shm_fd = shm_open (name, O_RDONLY, 0600);
+
+  if (shm_fd == -1)
+    {
+      g_printerr ("shm_open() failed: %s\n", g_strerror (errno));
+
+      return NULL;
+    }
+
+  addr = (guchar *) mmap (NULL, size,
+                          PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                          shm_fd, 0);
+
+  close (shm_fd);
+
+  if (addr == MAP_FAILED)
+    {
+      g_printerr ("mmap() failed: %s\n", g_strerror (errno));
+
+      return NULL;
+    }
+
+  return addr;
+
+#else
+
+  return NULL;
+
+#endif
+}
+
+void
+_gimp_shm_unmap (guchar *addr,
+                 gsize   size)
+{
+#if defined(USE_POSIX_SHM)
+  munmap (addr, size);
 #endif
 }
@@ -25,10 +25,17 @@ G_BEGIN_DECLS
 
 
 guchar * _gimp_shm_addr  (void);
+gsize    _gimp_shm_size  (void);
 
-void     _gimp_shm_open  (gint shm_ID);
+void     _gimp_shm_open  (gint         shm_ID,
+                          gsize        shm_size);
 void     _gimp_shm_close (void);
 
+guchar * _gimp_shm_map   (const gchar *name,
+                          gsize        size);
+void     _gimp_shm_unmap (guchar      *addr,
+                          gsize        size);
+
 
 G_END_DECLS
 
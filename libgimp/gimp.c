@@ -1106,5 +1106,5 @@ _gimp_config (GPConfig *config)
   g_free (path);
   g_object_unref (file);
 
-  _gimp_shm_open (config->shm_id);
+  _gimp_shm_open (config->shm_id, config->shm_size);
 }
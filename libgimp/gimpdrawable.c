@@ -23,6 +23,7 @@
 #include "gimp.h"
 
 #include "gimppixbuf.h"
+#include "gimptilebackendmapped.h"
 #include "gimptilebackendplugin.h"
 
 
@@ -330,6 +331,87 @@ gimp_drawable_get_shadow_buffer (GimpDrawable *drawable)
   return NULL;
 }
 
+/**
+ * gimp_drawable_get_mapped_buffer:
+ * @drawable: the ID of the #GimpDrawable to get the buffer for.
+ *
+ * Returns a #GeglBuffer of a specified drawable, like
+ * gimp_drawable_get_buffer(), whose tiles are read from a snapshot of
+ * the drawable's pixels the core shares with the plug-in, instead of
+ * being copied over one by one. This makes reading large drawables
+ * much cheaper.
+ *
+ * The snapshot is taken when this function is called, and changes
+ * the core makes to the drawable later are not visible in the
+ * buffer. Data written to the buffer is synced back with the core
+ * drawable like for gimp_drawable_get_buffer().
+ *
+ * Falls back to gimp_drawable_get_buffer() where the drawable can't
+ * be shared.
+ *
+ * Returns: (transfer full): The #GeglBuffer.
+ *
+ * See Also: gimp_drawable_get_mapped_shadow_buffer()
+ *
+ * Since: 3.0
+ */
+GeglBuffer *
+gimp_drawable_get_mapped_buffer (GimpDrawable *drawable)
+{
+  if (gimp_item_is_valid (GIMP_ITEM (drawable)))
+    {
+      GeglTileBackend *backend;
+      GeglBuffer      *buffer;
+
+      backend = _gimp_tile_backend_mapped_new (drawable, FALSE);
+
+      if (! backend)
+        return gimp_drawable_get_buffer (drawable);
+
+      buffer = gegl_buffer_new_for_backend (NULL, backend);
+      g_object_unref (backend);
+
+      return buffer;
+    }
+
+  return NULL;
+}
+
+/**
+ * gimp_drawable_get_mapped_shadow_buffer:
+ * @drawable: the ID of the #GimpDrawable to get the buffer for.
+ *
+ * Returns a #GeglBuffer of a specified drawable's shadow tiles, like
+ * gimp_drawable_get_shadow_buffer(), whose tiles are read from a
+ * copy-on-write snapshot the core shares with the plug-in. See
+ * gimp_drawable_get_mapped_buffer().
+ *
+ * Returns: (transfer full): The #GeglBuffer.
+ *
+ * Since: 3.0
+ */
+GeglBuffer *
+gimp_drawable_get_mapped_shadow_buffer (GimpDrawable *drawable)
+{
+  if (gimp_item_is_valid (GIMP_ITEM (drawable)))
+    {
+      GeglTileBackend *backend;
+      GeglBuffer      *buffer;
+
+      backend = _gimp_tile_backend_mapped_new (drawable, TRUE);
+
+      if (! backend)
+        return gimp_drawable_get_shadow_buffer (drawable);
+
+      buffer = gegl_buffer_new_for_backend (NULL, backend);
+      g_object_unref (backend);
+
+      return buffer;
+    }
+
+  return NULL;
+}
+
 /**
  * gimp_drawable_get_format:
  * @drawable: the ID of the #GimpDrawable to get the format for.
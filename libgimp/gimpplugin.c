@@ -1223,6 +1223,10 @@ gimp_plug_in_loop (GimpPlugIn *plug_in)
         case GP_TILE_REQ:
         case GP_TILE_ACK:
         case GP_TILE_DATA:
+        case GP_TILES_REQ:
+        case GP_TILES_DATA:
+        case GP_TILES_MAP_REQ:
+        case GP_TILES_MAP:
           g_warning ("unexpected tile message received (should not happen)");
           break;
 
@@ -1285,6 +1289,10 @@ gimp_plug_in_process_message (GimpPlugIn      *plug_in,
     case GP_TILE_REQ:
     case GP_TILE_ACK:
     case GP_TILE_DATA:
+    case GP_TILES_REQ:
+    case GP_TILES_DATA:
+    case GP_TILES_MAP_REQ:
+    case GP_TILES_MAP:
       g_warning ("unexpected tile message received (should not happen)");
       break;
     case GP_PROC_RUN:
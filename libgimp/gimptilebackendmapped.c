@@ -0,0 +1,263 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimptilebackendmapped.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gimp.h"
+
+#include "libgimpbase/gimpprotocol.h"
+#include "libgimpbase/gimpwire.h"
+
+#include "gimp-shm.h"
+#include "gimpplugin-private.h"
+#include "gimptilebackendmapped.h"
+#include "gimptilebackendplugin.h"
+
+
+/*  GimpTileBackendMapped reads the tiles of a drawable directly from a
+ *  private mapping of a snapshot the core exported, without copying
+ *  them.  Writes to the mapped tiles only touch our private pages, and
+ *  are sent to the core through a GimpTileBackendPlugin.
+ */
+
+
+#define TILE_WIDTH  gimp_tile_width()
+#define TILE_HEIGHT gimp_tile_height()
+
+
+typedef struct _GimpTileMap GimpTileMap;
+
+struct _GimpTileMap
+{
+  gint    ref_count;
+  guchar *addr;
+  gsize   size;
+};
+
+
+struct _GimpTileBackendMappedPrivate
+{
+  GeglTileBackend *plugin;
+  GimpTileMap     *map;
+  gint             ntile_rows;
+  gint             ntile_cols;
+  gint             tile_size;
+};
+
+
+static void       gimp_tile_backend_mapped_finalize (GObject         *object);
+
+static gpointer   gimp_tile_backend_mapped_command  (GeglTileSource  *tile_store,
+                                                     GeglTileCommand  command,
+                                                     gint             x,
+                                                     gint             y,
+                                                     gint             z,
+                                                     gpointer         data);
+
+static GimpTileMap * gimp_tile_map_ref              (GimpTileMap     *map);
+static void          gimp_tile_map_unref            (GimpTileMap     *map);
+
+
+G_DEFINE_TYPE_WITH_PRIVATE (GimpTileBackendMapped, _gimp_tile_backend_mapped,
+                            GEGL_TYPE_TILE_BACKEND)
+
+#define parent_class _gimp_tile_backend_mapped_parent_class
+
+
+static void
+_gimp_tile_backend_mapped_class_init (GimpTileBackendMappedClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gimp_tile_backend_mapped_finalize;
+}
+
+static void
+_gimp_tile_backend_mapped_init (GimpTileBackendMapped *backend)
+{
+  GeglTileSource *source = GEGL_TILE_SOURCE (backend);
+
+  backend->priv = _gimp_tile_backend_mapped_get_instance_private (backend);
+
+  source->command = gimp_tile_backend_mapped_command;
+}
+
+static void
+gimp_tile_backend_mapped_finalize (GObject *object)
+{
+  GimpTileBackendMapped *backend_mapped = GIMP_TILE_BACKEND_MAPPED (object);
+
+  g_clear_object (&backend_mapped->priv->plugin);
+  g_clear_pointer (&backend_mapped->priv->map, gimp_tile_map_unref);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gpointer
+gimp_tile_backend_mapped_command (GeglTileSource  *tile_store,
+                                  GeglTileCommand  command,
+                                  gint             x,
+                                  gint             y,
+                                  gint             z,
+                                  gpointer         data)
+{
+  GimpTileBackendMapped        *backend_mapped = GIMP_TILE_BACKEND_MAPPED (tile_store);
+  GimpTileBackendMappedPrivate *priv           = backend_mapped->priv;
+  gpointer                      result         = NULL;
+
+  switch (command)
+    {
+    case GEGL_TILE_GET:
+      if (z == 0                          &&
+          x >= 0 && x < priv->ntile_cols &&
+          y >= 0 && y < priv->ntile_rows)
+        {
+          GeglTile *tile = gegl_tile_new_bare ();
+          gint      num  = y * priv->ntile_cols + x;
+
+          gegl_tile_set_data_full (tile,
+                                   priv->map->addr +
+                                   (gsize) num * priv->tile_size,
+                                   priv->tile_size,
+                                   (GDestroyNotify) gimp_tile_map_unref,
+                                   gimp_tile_map_ref (priv->map));
+
+          result = tile;
+        }
+      break;
+
+    case GEGL_TILE_SET:
+    case GEGL_TILE_FLUSH:
+      result = gegl_tile_source_command (GEGL_TILE_SOURCE (priv->plugin),
+                                         command, x, y, z, data);
+      break;
+
+    default:
+      result = gegl_tile_backend_command (GEGL_TILE_BACKEND (tile_store),
+                                          command, x, y, z, data);
+      break;
+    }
+
+  return result;
+}
+
+
+/*  public functions  */
+
+/*  returns NULL if the core can't export the drawable's tiles  */
+GeglTileBackend *
+_gimp_tile_backend_mapped_new (GimpDrawable *drawable,
+                               gint          shadow)
+{
+  GeglTileBackend       *backend;
+  GimpTileBackendMapped *backend_mapped;
+  GimpPlugIn            *plug_in = gimp_get_plug_in ();
+  const Babl            *format  = gimp_drawable_get_format (drawable);
+  gint                   width   = gimp_drawable_get_width  (drawable);
+  gint                   height  = gimp_drawable_get_height (drawable);
+  gint                   bpp     = gimp_drawable_get_bpp (drawable);
+  gint                   ntile_rows;
+  gint                   ntile_cols;
+  gint                   tile_size;
+  GPTilesMapReq          tiles_map_req;
+  GPTilesMap            *tiles_map;
+  GimpWireMessage        msg;
+  guchar                *addr = NULL;
+
+  ntile_rows = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+  ntile_cols = (width  + TILE_WIDTH  - 1) / TILE_WIDTH;
+  tile_size  = TILE_WIDTH * TILE_HEIGHT * bpp;
+
+  tiles_map_req.drawable_id = gimp_item_get_id (GIMP_ITEM (drawable));
+  tiles_map_req.shadow      = shadow;
+
+  if (! gp_tiles_map_req_write (_gimp_plug_in_get_write_channel (plug_in),
+                                &tiles_map_req, plug_in))
+    gimp_quit ();
+
+  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILES_MAP);
+
+  tiles_map = msg.data;
+
+  if (tiles_map->name                                    &&
+      tiles_map->drawable_id == tiles_map_req.drawable_id &&
+      tiles_map->shadow      == tiles_map_req.shadow      &&
+      tiles_map->bpp         == bpp)
+    {
+      addr = _gimp_shm_map (tiles_map->name,
+                            (gsize) ntile_rows * ntile_cols * tile_size);
+    }
+
+  /*  the core removes the name once we are done with it  */
+  if (! gp_tile_ack_write (_gimp_plug_in_get_write_channel (plug_in),
+                           plug_in))
+    gimp_quit ();
+
+  gimp_wire_destroy (&msg);
+
+  if (! addr)
+    return NULL;
+
+  backend = g_object_new (GIMP_TYPE_TILE_BACKEND_MAPPED,
+                          "tile-width",  TILE_WIDTH,
+                          "tile-height", TILE_HEIGHT,
+                          "format",      format,
+                          NULL);
+
+  backend_mapped = GIMP_TILE_BACKEND_MAPPED (backend);
+
+  backend_mapped->priv->plugin     = _gimp_tile_backend_plugin_new (drawable,
+                                                                    shadow);
+  backend_mapped->priv->map        = g_slice_new (GimpTileMap);
+  backend_mapped->priv->ntile_rows = ntile_rows;
+  backend_mapped->priv->ntile_cols = ntile_cols;
+  backend_mapped->priv->tile_size  = tile_size;
+
+  backend_mapped->priv->map->ref_count = 1;
+  backend_mapped->priv->map->addr      = addr;
+  backend_mapped->priv->map->size      = (gsize) ntile_rows * ntile_cols *
+                                         tile_size;
+
+  gegl_tile_backend_set_extent (backend,
+                                GEGL_RECTANGLE (0, 0, width, height));
+
+  return backend;
+}
+
+
+/*  private functions  */
+
+static GimpTileMap *
+gimp_tile_map_ref (GimpTileMap *map)
+{
+  g_atomic_int_inc (&map->ref_count);
+
+  return map;
+}
+
+static void
+gimp_tile_map_unref (GimpTileMap *map)
+{
+  if (g_atomic_int_dec_and_test (&map->ref_count))
+    {
+      _gimp_shm_unmap (map->addr, map->size);
+
+      g_slice_free (GimpTileMap, map);
+    }
+}
@@ -0,0 +1,58 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimptilebackendmapped.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_TILE_BACKEND_MAPPED_H__
+#define __GIMP_TILE_BACKEND_MAPPED_H__
+
+#include <gegl-buffer-backend.h>
+
+G_BEGIN_DECLS
+
+#define GIMP_TYPE_TILE_BACKEND_MAPPED            (_gimp_tile_backend_mapped_get_type ())
+#define GIMP_TILE_BACKEND_MAPPED(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_TILE_BACKEND_MAPPED, GimpTileBackendMapped))
+#define GIMP_TILE_BACKEND_MAPPED_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GIMP_TYPE_TILE_BACKEND_MAPPED, GimpTileBackendMappedClass))
+#define GIMP_IS_TILE_BACKEND_MAPPED(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_TILE_BACKEND_MAPPED))
+#define GIMP_IS_TILE_BACKEND_MAPPED_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GIMP_TYPE_TILE_BACKEND_MAPPED))
+#define GIMP_TILE_BACKEND_MAPPED_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GIMP_TYPE_TILE_BACKEND_MAPPED, GimpTileBackendMappedClass))
+
+
+typedef struct _GimpTileBackendMapped        GimpTileBackendMapped;
+typedef struct _GimpTileBackendMappedClass   GimpTileBackendMappedClass;
+typedef struct _GimpTileBackendMappedPrivate GimpTileBackendMappedPrivate;
+
+struct _GimpTileBackendMapped
+{
+  GeglTileBackend               parent_instance;
+
+  GimpTileBackendMappedPrivate *priv;
+};
+
+struct _GimpTileBackendMappedClass
+{
+  GeglTileBackendClass parent_class;
+};
+
+GType             _gimp_tile_backend_mapped_get_type (void) G_GNUC_CONST;
+
+GeglTileBackend * _gimp_tile_backend_mapped_new      (GimpDrawable *drawable,
+                                                      gint          shadow);
+
+G_END_DECLS
+
+#endif /* __GIMP_TILE_BACKEND_MAPPED_H__ */
@@ -37,6 +37,9 @@
 #define TILE_WIDTH  gimp_tile_width()
 #define TILE_HEIGHT gimp_tile_height()
 
+/* the maximum number of tiles transferred in one go, see GP_TILES_REQ */
+#define MAX_RUN_TILES 64
+
 
 typedef struct _GimpTile GimpTile;
 
@@ -46,8 +49,6 @@ struct _GimpTile
 
   guint   ewidth;   /* the effective width of the tile */
   guint   eheight;  /* the effective height of the tile */
-
-  guchar *data;     /* the pixel data for the tile */
 };
 
 
@@ -60,34 +61,50 @@ struct _GimpTileBackendPluginPrivate
   gint     bpp;
   gint     ntile_rows;
   gint     ntile_cols;
+  gint     max_run;
+
+  /*  tiles read ahead of being asked for  */
+  guint    read_first;
+  gint     n_read;
+  guchar  *read_data;
+  gint     read_ahead;
+  guint    next_tile;
+
+  /*  tiles written but not yet sent to the core  */
+  guint    write_first;
+  gint     n_write;
+  guchar  *write_data;
 };
 
 
-static gpointer   gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
-                                                    GeglTileCommand  command,
-                                                    gint             x,
-                                                    gint             y,
-                                                    gint             z,
-                                                    gpointer         data);
-
-static gboolean   gimp_tile_write (GimpTileBackendPlugin *backend_plugin,
-                                   gint                   x,
-                                   gint                   y,
-                                   GeglTile              *tile);
-static GeglTile * gimp_tile_read  (GimpTileBackendPlugin *backend_plugin,
-                                   gint                   x,
-                                   gint                   y);
-
-static gboolean   gimp_tile_init  (GimpTileBackendPlugin *backend_plugin,
-                                   GimpTile              *tile,
-                                   gint                   row,
-                                   gint                   col);
-static void       gimp_tile_unset (GimpTileBackendPlugin *backend_plugin,
-                                   GimpTile              *tile);
-static void       gimp_tile_get   (GimpTileBackendPlugin *backend_plugin,
-                                   GimpTile              *tile);
-static void       gimp_tile_put   (GimpTileBackendPlugin *backend_plugin,
-                                   GimpTile              *tile);
+static void       gimp_tile_backend_plugin_finalize (GObject         *object);
+
+static gpointer   gimp_tile_backend_plugin_command  (GeglTileSource  *tile_store,
+                                                     GeglTileCommand  command,
+                                                     gint             x,
+                                                     gint             y,
+                                                     gint             z,
+                                                     gpointer         data);
+
+static gboolean   gimp_tile_write     (GimpTileBackendPlugin *backend_plugin,
+                                       gint                   x,
+                                       gint                   y,
+                                       GeglTile              *tile);
+static GeglTile * gimp_tile_read      (GimpTileBackendPlugin *backend_plugin,
+                                       gint                   x,
+                                       gint                   y);
+
+static gboolean   gimp_tile_init      (GimpTileBackendPlugin *backend_plugin,
+                                       GimpTile              *tile,
+                                       gint                   row,
+                                       gint                   col);
+static gsize      gimp_tiles_length   (GimpTileBackendPlugin *backend_plugin,
+                                       guint                  first_tile,
+                                       gint                   n_tiles);
+static void       gimp_tiles_get      (GimpTileBackendPlugin *backend_plugin,
+                                       guint                  first_tile);
+static void       gimp_tiles_put      (GimpTileBackendPlugin *backend_plugin);
+static void       gimp_tiles_drop     (GimpTileBackendPlugin *backend_plugin);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpTileBackendPlugin, _gimp_tile_backend_plugin,
@@ -102,6 +119,9 @@ static GMutex backend_plugin_mutex;
 static void
 _gimp_tile_backend_plugin_class_init (GimpTileBackendPluginClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gimp_tile_backend_plugin_finalize;
 }
 
 static void
@@ -114,6 +134,23 @@ _gimp_tile_backend_plugin_init (GimpTileBackendPlugin *backend)
   source->command = gimp_tile_backend_plugin_command;
 }
 
+static void
+gimp_tile_backend_plugin_finalize (GObject *object)
+{
+  GimpTileBackendPlugin *backend_plugin = GIMP_TILE_BACKEND_PLUGIN (object);
+
+  g_mutex_lock (&backend_plugin_mutex);
+
+  gimp_tiles_put (backend_plugin);
+  gimp_tiles_drop (backend_plugin);
+
+  g_mutex_unlock (&backend_plugin_mutex);
+
+  g_clear_pointer (&backend_plugin->priv->write_data, g_free);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static gpointer
 gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
                                   GeglTileCommand  command,
@@ -156,6 +193,15 @@ gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
       break;
 
     case GEGL_TILE_FLUSH:
+      /*  send the pending tiles, and forget the tiles read ahead, so
+       *  we see what the core has after the flush
+       */
+      g_mutex_lock (&backend_plugin_mutex);
+
+      gimp_tiles_put (backend_plugin);
+      gimp_tiles_drop (backend_plugin);
+
+      g_mutex_unlock (&backend_plugin_mutex);
       break;
 
     default:
@@ -179,6 +225,7 @@ _gimp_tile_backend_plugin_new (GimpDrawable *drawable,
   const Babl            *format = gimp_drawable_get_format (drawable);
   gint                   width  = gimp_drawable_get_width  (drawable);
   gint                   height = gimp_drawable_get_height (drawable);
+  gsize                  shm_size;
 
   backend = g_object_new (GIMP_TYPE_TILE_BACKEND_PLUGIN,
                           "tile-width",  TILE_WIDTH,
@@ -196,6 +243,21 @@ _gimp_tile_backend_plugin_new (GimpDrawable *drawable,
   backend_plugin->priv->ntile_rows  = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
   backend_plugin->priv->ntile_cols  = (width  + TILE_WIDTH  - 1) / TILE_WIDTH;
 
+  /*  keep runs small enough to go through shared memory  */
+  shm_size = _gimp_shm_size ();
+
+  if (shm_size > 0)
+    {
+      backend_plugin->priv->max_run =
+        CLAMP (shm_size /
+               (TILE_WIDTH * TILE_HEIGHT * backend_plugin->priv->bpp),
+               1, MAX_RUN_TILES);
+    }
+  else
+    {
+      backend_plugin->priv->max_run = MAX_RUN_TILES;
+    }
+
   gegl_tile_backend_set_extent (backend,
                                 GEGL_RECTANGLE (0, 0, width, height));
 
@@ -216,19 +278,31 @@ gimp_tile_read (GimpTileBackendPlugin *backend_plugin,
   GimpTile                      gimp_tile = { 0, };
   gint                          tile_size;
   guchar                       *tile_data;
+  const guchar                 *gimp_tile_data;
 
   if (! gimp_tile_init (backend_plugin, &gimp_tile, y, x))
     return NULL;
 
+  if (priv->n_read == 0                            ||
+      gimp_tile.tile_num <  priv->read_first       ||
+      gimp_tile.tile_num >= priv->read_first + priv->n_read)
+    {
+      gimp_tiles_get (backend_plugin, gimp_tile.tile_num);
+    }
+
+  gimp_tile_data = priv->read_data +
+                   gimp_tiles_length (backend_plugin, priv->read_first,
+                                      gimp_tile.tile_num - priv->read_first);
+
+  priv->next_tile = gimp_tile.tile_num + 1;
+
   tile_size  = gegl_tile_backend_get_tile_size (backend);
   tile       = gegl_tile_new (tile_size);
   tile_data  = gegl_tile_get_data (tile);
 
-  gimp_tile_get (backend_plugin, &gimp_tile);
-
   if (gimp_tile.ewidth * gimp_tile.eheight * priv->bpp == tile_size)
     {
-      memcpy (tile_data, gimp_tile.data, tile_size);
+      memcpy (tile_data, gimp_tile_data, tile_size);
     }
   else
     {
@@ -239,13 +313,11 @@ gimp_tile_read (GimpTileBackendPlugin *backend_plugin,
       for (row = 0; row < gimp_tile.eheight; row++)
         {
           memcpy (tile_data      + row * tile_stride,
-                  gimp_tile.data + row * gimp_tile_stride,
+                  gimp_tile_data + row * gimp_tile_stride,
                   gimp_tile_stride);
         }
     }
 
-  gimp_tile_unset (backend_plugin, &gimp_tile);
-
   return tile;
 }
 
@@ -260,20 +332,60 @@ gimp_tile_write (GimpTileBackendPlugin *backend_plugin,
   GimpTile                      gimp_tile = { 0, };
   gint                          tile_size;
   guchar                       *tile_data;
+  guchar                       *gimp_tile_data;
 
   if (! gimp_tile_init (backend_plugin, &gimp_tile, y, x))
     return FALSE;
 
+  /*  a tile read ahead is stale now  */
+  if (priv->n_read > 0                             &&
+      gimp_tile.tile_num >= priv->read_first       &&
+      gimp_tile.tile_num <  priv->read_first + priv->n_read)
+    {
+      gimp_tiles_drop (backend_plugin);
+    }
+
+  if (priv->n_write > 0                            &&
+      gimp_tile.tile_num >= priv->write_first      &&
+      gimp_tile.tile_num <  priv->write_first + priv->n_write)
+    {
+      /*  the tile is already pending, overwrite it  */
+      gimp_tile_data = priv->write_data +
+                       gimp_tiles_length (backend_plugin, priv->write_first,
+                                          gimp_tile.tile_num -
+                                          priv->write_first);
+    }
+  else
+    {
+      /*  append the tile to the pending run, if it continues it  */
+      if (priv->n_write > 0 &&
+          (gimp_tile.tile_num != priv->write_first + priv->n_write ||
+           priv->n_write == priv->max_run))
+        {
+          gimp_tiles_put (backend_plugin);
+        }
+
+      if (! priv->write_data)
+        priv->write_data = g_new (guchar,
+                                  priv->max_run *
+                                  TILE_WIDTH * TILE_HEIGHT * priv->bpp);
+
+      if (priv->n_write == 0)
+        priv->write_first = gimp_tile.tile_num;
+
+      gimp_tile_data = priv->write_data +
+                       gimp_tiles_length (backend_plugin, priv->write_first,
+                                          priv->n_write);
+
+      priv->n_write++;
+    }
+
   tile_size = gegl_tile_backend_get_tile_size (backend);
   tile_data = gegl_tile_get_data (tile);
 
-  gimp_tile.data = g_new (guchar,
-                          gimp_tile.ewidth * gimp_tile.eheight *
-                          priv->bpp);
-
   if (gimp_tile.ewidth * gimp_tile.eheight * priv->bpp == tile_size)
     {
-      memcpy (gimp_tile.data, tile_data, tile_size);
+      memcpy (gimp_tile_data, tile_data, tile_size);
     }
   else
     {
@@ -283,15 +395,12 @@ gimp_tile_write (GimpTileBackendPlugin *backend_plugin,
 
       for (row = 0; row < gimp_tile.eheight; row++)
         {
-          memcpy (gimp_tile.data + row * gimp_tile_stride,
+          memcpy (gimp_tile_data + row * gimp_tile_stride,
                   tile_data      + row * tile_stride,
                   gimp_tile_stride);
         }
     }
 
-  gimp_tile_put (backend_plugin, &gimp_tile);
-  gimp_tile_unset (backend_plugin, &gimp_tile);
-
   return TRUE;
 }
 
@@ -321,77 +430,97 @@ gimp_tile_init (GimpTileBackendPlugin *backend_plugin,
   else
     tile->eheight = TILE_HEIGHT;
 
-  tile->data = NULL;
-
   return TRUE;
 }
 
-static void
-gimp_tile_unset (GimpTileBackendPlugin *backend_plugin,
-                 GimpTile              *tile)
+/*  the size of the packed pixels of a run of tiles  */
+static gsize
+gimp_tiles_length (GimpTileBackendPlugin *backend_plugin,
+                   guint                  first_tile,
+                   gint                   n_tiles)
 {
-  g_clear_pointer (&tile->data, g_free);
+  GimpTileBackendPluginPrivate *priv   = backend_plugin->priv;
+  gsize                         length = 0;
+  gint                          i;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      GimpTile tile;
+      guint    tile_num = first_tile + i;
+
+      gimp_tile_init (backend_plugin, &tile,
+                      tile_num / priv->ntile_cols,
+                      tile_num % priv->ntile_cols);
+
+      length += tile.ewidth * tile.eheight * priv->bpp;
+    }
+
+  return length;
 }
 
 static void
-gimp_tile_get (GimpTileBackendPlugin *backend_plugin,
-               GimpTile              *tile)
+gimp_tiles_get (GimpTileBackendPlugin *backend_plugin,
+                guint                  first_tile)
 {
   GimpTileBackendPluginPrivate *priv    = backend_plugin->priv;
   GimpPlugIn                   *plug_in = gimp_get_plug_in ();
-  GPTileReq                     tile_req;
-  GPTileData                   *tile_data;
+  GPTilesReq                    tiles_req;
+  GPTilesData                  *tiles_data;
   GimpWireMessage               msg;
+  guint                         n_tiles;
+  gsize                         length;
 
-  tile_req.drawable_id = priv->drawable_id;
-  tile_req.tile_num    = tile->tile_num;
-  tile_req.shadow      = priv->shadow;
+  /*  the core must see our pending tiles before we read any  */
+  gimp_tiles_put (backend_plugin);
 
-  if (! gp_tile_req_write (_gimp_plug_in_get_write_channel (plug_in),
-                           &tile_req, plug_in))
+  gimp_tiles_drop (backend_plugin);
+
+  /*  read further ahead the longer we are asked for consecutive tiles  */
+  if (first_tile == priv->next_tile)
+    priv->read_ahead = MIN (MAX (priv->read_ahead * 2, 2), priv->max_run);
+  else
+    priv->read_ahead = 1;
+
+  n_tiles = MIN (priv->read_ahead,
+                 priv->ntile_rows * priv->ntile_cols - first_tile);
+  length  = gimp_tiles_length (backend_plugin, first_tile, n_tiles);
+
+  tiles_req.drawable_id = priv->drawable_id;
+  tiles_req.first_tile  = first_tile;
+  tiles_req.n_tiles     = n_tiles;
+  tiles_req.shadow      = priv->shadow;
+
+  if (! gp_tiles_req_write (_gimp_plug_in_get_write_channel (plug_in),
+                            &tiles_req, plug_in))
     gimp_quit ();
 
-  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILE_DATA);
+  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILES_DATA);
 
-  tile_data = msg.data;
-  if (tile_data->drawable_id != priv->drawable_id ||
-      tile_data->tile_num    != tile->tile_num    ||
-      tile_data->shadow      != priv->shadow      ||
-      tile_data->width       != tile->ewidth      ||
-      tile_data->height      != tile->eheight     ||
-      tile_data->bpp         != priv->bpp)
+  tiles_data = msg.data;
+  if (tiles_data->drawable_id != priv->drawable_id ||
+      tiles_data->first_tile  != first_tile        ||
+      tiles_data->n_tiles     != n_tiles           ||
+      tiles_data->shadow      != priv->shadow      ||
+      tiles_data->bpp         != priv->bpp         ||
+      tiles_data->length      != length)
     {
-#if 0
-      g_printerr ("tile_data: %d %d %d %d %d %d\n"
-                  "tile:      %d %d %d %d %d %d\n",
-                  tile_data->drawable_id,
-                  tile_data->tile_num,
-                  tile_data->shadow,
-                  tile_data->width,
-                  tile_data->height,
-                  tile_data->bpp,
-                  priv->drawable_id,
-                  tile->tile_num,
-                  priv->shadow,
-                  tile->ewidth,
-                  tile->eheight,
-                  priv->bpp);
-#endif
-      g_printerr ("received tile info did not match computed tile info");
+      g_printerr ("received tiles info did not match computed tiles info");
       gimp_quit ();
     }
 
-  if (tile_data->use_shm)
+  if (tiles_data->use_shm)
     {
-      tile->data = g_memdup2 (_gimp_shm_addr (),
-                              tile->ewidth * tile->eheight * priv->bpp);
+      priv->read_data = g_memdup2 (_gimp_shm_addr (), length);
     }
   else
     {
-      tile->data = tile_data->data;
-      tile_data->data = NULL;
+      priv->read_data = tiles_data->data;
+      tiles_data->data = NULL;
     }
 
+  priv->read_first = first_tile;
+  priv->n_read     = n_tiles;
+
   if (! gp_tile_ack_write (_gimp_plug_in_get_write_channel (plug_in),
                            plug_in))
     gimp_quit ();
@@ -400,58 +529,65 @@ gimp_tile_get (GimpTileBackendPlugin *backend_plugin,
 }
 
 static void
-gimp_tile_put (GimpTileBackendPlugin *backend_plugin,
-               GimpTile              *tile)
+gimp_tiles_put (GimpTileBackendPlugin *backend_plugin)
 {
   GimpTileBackendPluginPrivate *priv    = backend_plugin->priv;
   GimpPlugIn                   *plug_in = gimp_get_plug_in ();
-  GPTileReq                     tile_req;
-  GPTileData                    tile_data;
-  GPTileData                   *tile_info;
+  GPTilesReq                    tiles_req = { 0, };
+  GPTilesData                   tiles_data;
+  GPTilesData                  *tiles_info;
   GimpWireMessage               msg;
+  gsize                         length;
+
+  if (priv->n_write == 0)
+    return;
 
-  tile_req.drawable_id = -1;
-  tile_req.tile_num    = 0;
-  tile_req.shadow      = 0;
+  length = gimp_tiles_length (backend_plugin, priv->write_first,
+                              priv->n_write);
 
-  if (! gp_tile_req_write (_gimp_plug_in_get_write_channel (plug_in),
-                           &tile_req, plug_in))
+  tiles_req.drawable_id = -1;
+
+  if (! gp_tiles_req_write (_gimp_plug_in_get_write_channel (plug_in),
+                            &tiles_req, plug_in))
     gimp_quit ();
 
-  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILE_DATA);
+  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILES_DATA);
 
-  tile_info = msg.data;
+  tiles_info = msg.data;
 
-  tile_data.drawable_id = priv->drawable_id;
-  tile_data.tile_num    = tile->tile_num;
-  tile_data.shadow      = priv->shadow;
-  tile_data.bpp         = priv->bpp;
-  tile_data.width       = tile->ewidth;
-  tile_data.height      = tile->eheight;
-  tile_data.use_shm     = tile_info->use_shm;
-  tile_data.data        = NULL;
+  tiles_data.drawable_id = priv->drawable_id;
+  tiles_data.first_tile  = priv->write_first;
+  tiles_data.n_tiles     = priv->n_write;
+  tiles_data.shadow      = priv->shadow;
+  tiles_data.bpp         = priv->bpp;
+  tiles_data.length      = length;
+  tiles_data.use_shm     = (tiles_info->use_shm &&
+                            length <= _gimp_shm_size ());
+  tiles_data.data        = NULL;
 
-  if (tile_info->use_shm)
-    {
-      memcpy (_gimp_shm_addr (),
-              tile->data,
-              tile->ewidth * tile->eheight * priv->bpp);
-    }
+  if (tiles_data.use_shm)
+    memcpy (_gimp_shm_addr (), priv->write_data, length);
   else
-    {
-      tile_data.data = tile->data;
-    }
+    tiles_data.data = priv->write_data;
 
-  if (! gp_tile_data_write (_gimp_plug_in_get_write_channel (plug_in),
-                            &tile_data, plug_in))
+  if (! gp_tiles_data_write (_gimp_plug_in_get_write_channel (plug_in),
+                             &tiles_data, plug_in))
     gimp_quit ();
 
-  if (! tile_info->use_shm)
-    tile_data.data = NULL;
-
   gimp_wire_destroy (&msg);
 
+  priv->n_write = 0;
+
   _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILE_ACK);
 
   gimp_wire_destroy (&msg);
 }
+
+static void
+gimp_tiles_drop (GimpTileBackendPlugin *backend_plugin)
+{
+  GimpTileBackendPluginPrivate *priv = backend_plugin->priv;
+
+  g_clear_pointer (&priv->read_data, g_free);
+  priv->n_read = 0;
+}
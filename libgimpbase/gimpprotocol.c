@@ -144,6 +144,38 @@ static void _gp_has_init_write           (GIOChannel       *channel,
                                           gpointer          user_data);
 static void _gp_has_init_destroy         (GimpWireMessage  *msg);
 
+static void _gp_tiles_req_read           (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tiles_req_write          (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tiles_req_destroy        (GimpWireMessage  *msg);
+
+static void _gp_tiles_data_read          (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tiles_data_write         (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tiles_data_destroy       (GimpWireMessage  *msg);
+
+static void _gp_tiles_map_req_read       (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tiles_map_req_write      (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tiles_map_req_destroy    (GimpWireMessage  *msg);
+
+static void _gp_tiles_map_read           (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tiles_map_write          (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tiles_map_destroy        (GimpWireMessage  *msg);
+
 
 
 void
@@ -201,6 +233,22 @@ gp_init (void)
                       _gp_has_init_read,
                       _gp_has_init_write,
                       _gp_has_init_destroy);
+  gimp_wire_register (GP_TILES_REQ,
+                      _gp_tiles_req_read,
+                      _gp_tiles_req_write,
+                      _gp_tiles_req_destroy);
+  gimp_wire_register (GP_TILES_DATA,
+                      _gp_tiles_data_read,
+                      _gp_tiles_data_write,
+                      _gp_tiles_data_destroy);
+  gimp_wire_register (GP_TILES_MAP_REQ,
+                      _gp_tiles_map_req_read,
+                      _gp_tiles_map_req_write,
+                      _gp_tiles_map_req_destroy);
+  gimp_wire_register (GP_TILES_MAP,
+                      _gp_tiles_map_read,
+                      _gp_tiles_map_write,
+                      _gp_tiles_map_destroy);
 }
 
 /* public writing API */
@@ -448,6 +496,82 @@ gp_has_init_write (GIOChannel *channel,
   return TRUE;
 }
 
+gboolean
+gp_tiles_req_write (GIOChannel *channel,
+                    GPTilesReq *tiles_req,
+                    gpointer    user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_TILES_REQ;
+  msg.data = tiles_req;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_tiles_data_write (GIOChannel  *channel,
+                     GPTilesData *tiles_data,
+                     gpointer     user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_TILES_DATA;
+  msg.data = tiles_data;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_tiles_map_req_write (GIOChannel    *channel,
+                        GPTilesMapReq *tiles_map_req,
+                        gpointer       user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_TILES_MAP_REQ;
+  msg.data = tiles_map_req;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_tiles_map_write (GIOChannel *channel,
+                    GPTilesMap *tiles_map,
+                    gpointer    user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_TILES_MAP;
+  msg.data = tiles_map;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
 /*  quit  */
 
 static void
@@ -568,6 +692,9 @@ _gp_config_read (GIOChannel      *channel,
                                (guint32 *) &config->num_processors, 1,
                                user_data))
     goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &config->shm_size, 1, user_data))
+    goto cleanup;
 
   msg->data = config;
   return;
@@ -682,6 +809,9 @@ _gp_config_write (GIOChannel      *channel,
                                 (const guint32 *) &config->num_processors, 1,
                                 user_data))
     return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &config->shm_size, 1, user_data))
+    return;
 }
 
 static void
@@ -1987,3 +2117,285 @@ static void
 _gp_has_init_destroy (GimpWireMessage *msg)
 {
 }
+
+/*  tiles_req  */
+
+static void
+_gp_tiles_req_read (GIOChannel      *channel,
+                    GimpWireMessage *msg,
+                    gpointer         user_data)
+{
+  GPTilesReq *tiles_req = g_slice_new0 (GPTilesReq);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &tiles_req->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_req->first_tile, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_req->n_tiles, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_req->shadow, 1, user_data))
+    goto cleanup;
+
+  msg->data = tiles_req;
+  return;
+
+ cleanup:
+  g_slice_free (GPTilesReq, tiles_req);
+  msg->data = NULL;
+}
+
+static void
+_gp_tiles_req_write (GIOChannel      *channel,
+                     GimpWireMessage *msg,
+                     gpointer         user_data)
+{
+  GPTilesReq *tiles_req = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &tiles_req->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_req->first_tile, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_req->n_tiles, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_req->shadow, 1, user_data))
+    return;
+}
+
+static void
+_gp_tiles_req_destroy (GimpWireMessage *msg)
+{
+  GPTilesReq *tiles_req = msg->data;
+
+  if (tiles_req)
+    g_slice_free (GPTilesReq, tiles_req);
+}
+
+/*  tiles_data  */
+
+static void
+_gp_tiles_data_read (GIOChannel      *channel,
+                     GimpWireMessage *msg,
+                     gpointer         user_data)
+{
+  GPTilesData *tiles_data = g_slice_new0 (GPTilesData);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &tiles_data->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_data->first_tile, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_data->n_tiles, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_data->shadow, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_data->bpp, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_data->length, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_data->use_shm, 1, user_data))
+    goto cleanup;
+
+  if (! tiles_data->use_shm && tiles_data->length > 0)
+    {
+      tiles_data->data = g_try_malloc (tiles_data->length);
+
+      if (! tiles_data->data)
+        goto cleanup;
+
+      if (! _gimp_wire_read_int8 (channel,
+                                  (guint8 *) tiles_data->data,
+                                  tiles_data->length, user_data))
+        goto cleanup;
+    }
+
+  msg->data = tiles_data;
+  return;
+
+ cleanup:
+  g_free (tiles_data->data);
+  g_slice_free (GPTilesData, tiles_data);
+  msg->data = NULL;
+}
+
+static void
+_gp_tiles_data_write (GIOChannel      *channel,
+                      GimpWireMessage *msg,
+                      gpointer         user_data)
+{
+  GPTilesData *tiles_data = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &tiles_data->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_data->first_tile, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_data->n_tiles, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_data->shadow, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_data->bpp, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_data->length, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_data->use_shm, 1, user_data))
+    return;
+
+  if (! tiles_data->use_shm && tiles_data->length > 0)
+    {
+      if (! _gimp_wire_write_int8 (channel,
+                                   (const guint8 *) tiles_data->data,
+                                   tiles_data->length, user_data))
+        return;
+    }
+}
+
+static void
+_gp_tiles_data_destroy (GimpWireMessage *msg)
+{
+  GPTilesData *tiles_data = msg->data;
+
+  if (tiles_data)
+    {
+      g_free (tiles_data->data);
+      g_slice_free (GPTilesData, tiles_data);
+    }
+}
+
+/*  tiles_map_req  */
+
+static void
+_gp_tiles_map_req_read (GIOChannel      *channel,
+                        GimpWireMessage *msg,
+                        gpointer         user_data)
+{
+  GPTilesMapReq *tiles_map_req = g_slice_new0 (GPTilesMapReq);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &tiles_map_req->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_map_req->shadow, 1, user_data))
+    goto cleanup;
+
+  msg->data = tiles_map_req;
+  return;
+
+ cleanup:
+  g_slice_free (GPTilesMapReq, tiles_map_req);
+  msg->data = NULL;
+}
+
+static void
+_gp_tiles_map_req_write (GIOChannel      *channel,
+                         GimpWireMessage *msg,
+                         gpointer         user_data)
+{
+  GPTilesMapReq *tiles_map_req = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &tiles_map_req->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_map_req->shadow, 1, user_data))
+    return;
+}
+
+static void
+_gp_tiles_map_req_destroy (GimpWireMessage *msg)
+{
+  GPTilesMapReq *tiles_map_req = msg->data;
+
+  if (tiles_map_req)
+    g_slice_free (GPTilesMapReq, tiles_map_req);
+}
+
+/*  tiles_map  */
+
+static void
+_gp_tiles_map_read (GIOChannel      *channel,
+                    GimpWireMessage *msg,
+                    gpointer         user_data)
+{
+  GPTilesMap *tiles_map = g_slice_new0 (GPTilesMap);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &tiles_map->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_map->shadow, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tiles_map->bpp, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_string (channel,
+                                &tiles_map->name, 1, user_data))
+    goto cleanup;
+
+  msg->data = tiles_map;
+  return;
+
+ cleanup:
+  g_slice_free (GPTilesMap, tiles_map);
+  msg->data = NULL;
+}
+
+static void
+_gp_tiles_map_write (GIOChannel      *channel,
+                     GimpWireMessage *msg,
+                     gpointer         user_data)
+{
+  GPTilesMap *tiles_map = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &tiles_map->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_map->shadow, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tiles_map->bpp, 1, user_data))
+    return;
+  if (! _gimp_wire_write_string (channel,
+                                 &tiles_map->name, 1, user_data))
+    return;
+}
+
+static void
+_gp_tiles_map_destroy (GimpWireMessage *msg)
+{
+  GPTilesMap *tiles_map = msg->data;
+
+  if (tiles_map)
+    {
+      g_free (tiles_map->name);
+      g_slice_free (GPTilesMap, tiles_map);
+    }
+}
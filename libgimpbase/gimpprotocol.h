@@ -26,7 +26,7 @@ G_BEGIN_DECLS
 
 /* Increment every time the protocol changes
  */
-#define GIMP_PROTOCOL_VERSION  0x010F
+#define GIMP_PROTOCOL_VERSION  0x0111
 
 
 enum
@@ -43,7 +43,11 @@ enum
   GP_PROC_INSTALL,
   GP_PROC_UNINSTALL,
   GP_EXTENSION_ACK,
-  GP_HAS_INIT
+  GP_HAS_INIT,
+  GP_TILES_REQ,
+  GP_TILES_DATA,
+  GP_TILES_MAP_REQ,
+  GP_TILES_MAP
 };
 
 typedef enum
@@ -80,6 +84,10 @@ typedef struct _GPConfig           GPConfig;
 typedef struct _GPTileReq          GPTileReq;
 typedef struct _GPTileAck          GPTileAck;
 typedef struct _GPTileData         GPTileData;
+typedef struct _GPTilesReq         GPTilesReq;
+typedef struct _GPTilesData        GPTilesData;
+typedef struct _GPTilesMapReq      GPTilesMapReq;
+typedef struct _GPTilesMap         GPTilesMap;
 typedef struct _GPParamDef         GPParamDef;
 typedef struct _GPParamDefInt      GPParamDefInt;
 typedef struct _GPParamDefUnit     GPParamDefUnit;
@@ -130,6 +138,9 @@ struct _GPConfig
   /* since protocol version 0x010F: */
   GimpRGB  check_custom_color1;
   GimpRGB  check_custom_color2;
+
+  /* since protocol version 0x0110: */
+  guint32  shm_size;
 };
 
 struct _GPTileReq
@@ -151,6 +162,53 @@ struct _GPTileData
   guchar  *data;
 };
 
+/* since protocol version 0x0110: a run of consecutive tiles, in the
+ * row-major order of the drawable's tiles.
+ */
+struct _GPTilesReq
+{
+  gint32   drawable_id;
+  guint32  first_tile;
+  guint32  n_tiles;
+  guint32  shadow;
+};
+
+/* the pixels of all the tiles of the run, each tile's rows packed
+ * without padding, one tile after the other.
+ */
+struct _GPTilesData
+{
+  gint32   drawable_id;
+  guint32  first_tile;
+  guint32  n_tiles;
+  guint32  shadow;
+  guint32  bpp;
+  guint32  length;
+  guint32  use_shm;
+  guchar  *data;
+};
+
+/* since protocol version 0x0111: a request for all of a drawable's
+ * tiles in a shared memory object the plug-in maps itself.
+ */
+struct _GPTilesMapReq
+{
+  gint32   drawable_id;
+  guint32  shadow;
+};
+
+/* the name of the shared memory object, or NULL if the tiles can't be
+ * mapped.  it holds all the tiles in row-major order, each one padded
+ * to the full tile size.
+ */
+struct _GPTilesMap
+{
+  gint32   drawable_id;
+  guint32  shadow;
+  guint32  bpp;
+  gchar   *name;
+};
+
 struct _GPParamDefInt
 {
   gint64 min_val;
@@ -327,6 +385,18 @@ gboolean  gp_extension_ack_write    (GIOChannel      *channel,
                                      gpointer         user_data);
 gboolean  gp_has_init_write         (GIOChannel      *channel,
                                      gpointer         user_data);
+gboolean  gp_tiles_req_write        (GIOChannel      *channel,
+                                     GPTilesReq      *tiles_req,
+                                     gpointer         user_data);
+gboolean  gp_tiles_data_write       (GIOChannel      *channel,
+                                     GPTilesData     *tiles_data,
+                                     gpointer         user_data);
+gboolean  gp_tiles_map_req_write    (GIOChannel      *channel,
+                                     GPTilesMapReq   *tiles_map_req,
+                                     gpointer         user_data);
+gboolean  gp_tiles_map_write        (GIOChannel      *channel,
+                                     GPTilesMap      *tiles_map,
+                                     gpointer         user_data);
 
 
 G_END_DECLS
@@ -0,0 +1,58 @@
+/* LIBGIMP - The GIMP Library
+ * Copyright (C) 1995-1997 Spencer Kimball and Peter Mattis
+ *
+ * gimpcolortransform-sse2.c
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "gimpcolortransform-sse2.h"
+
+
+#if COMPILE_SSE2_INTRINISICS
+
+#include <emmintrin.h>
+
+
+/* blends the four corners of a LUT tetrahedron.  all four nodes, and
+ * @dest, hold 4 floats.  see lut_interpolate() in gimpcolortransform.c
+ * for the scalar version.
+ */
+void
+gimp_color_transform_lut_blend_sse2 (const gfloat *c0,
+                                     const gfloat *ca,
+                                     const gfloat *cb,
+                                     const gfloat *c1,
+                                     gfloat        w0,
+                                     gfloat        wa,
+                                     gfloat        wb,
+                                     gfloat        w1,
+                                     gfloat       *dest)
+{
+  __m128 v;
+
+  v =                _mm_mul_ps (_mm_loadu_ps (c0), _mm_set1_ps (w0));
+  v = _mm_add_ps (v, _mm_mul_ps (_mm_loadu_ps (ca), _mm_set1_ps (wa)));
+  v = _mm_add_ps (v, _mm_mul_ps (_mm_loadu_ps (cb), _mm_set1_ps (wb)));
+  v = _mm_add_ps (v, _mm_mul_ps (_mm_loadu_ps (c1), _mm_set1_ps (w1)));
+
+  _mm_storeu_ps (dest, v);
+}
+
+#endif /* COMPILE_SSE2_INTRINISICS */
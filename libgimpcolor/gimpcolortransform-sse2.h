@@ -0,0 +1,40 @@
+/* LIBGIMP - The GIMP Library
+ * Copyright (C) 1995-1997 Spencer Kimball and Peter Mattis
+ *
+ * gimpcolortransform-sse2.h
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_COLOR_TRANSFORM_SSE2_H__
+#define __GIMP_COLOR_TRANSFORM_SSE2_H__
+
+
+#if COMPILE_SSE2_INTRINISICS
+
+void   gimp_color_transform_lut_blend_sse2 (const gfloat *c0,
+                                            const gfloat *ca,
+                                            const gfloat *cb,
+                                            const gfloat *c1,
+                                            gfloat        w0,
+                                            gfloat        wa,
+                                            gfloat        wb,
+                                            gfloat        w1,
+                                            gfloat       *dest);
+
+#endif /* COMPILE_SSE2_INTRINISICS */
+
+
+#endif /* __GIMP_COLOR_TRANSFORM_SSE2_H__ */
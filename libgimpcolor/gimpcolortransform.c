@@ -23,6 +23,7 @@
 
 #include "config.h"
 
+#include <math.h>
 #include <string.h>
 
 #include <lcms2.h>
@@ -37,6 +38,7 @@
 
 #include "gimpcolorprofile.h"
 #include "gimpcolortransform.h"
+#include "gimpcolortransform-sse2.h"
 
 #include "libgimp/libgimp-intl.h"
 
@@ -58,6 +60,16 @@
  **/
 
 
+/* the number of transforms kept alive by the transform cache */
+#define CACHE_SIZE 16
+
+/* the number of nodes along each axis of the 3D LUT, and the largest
+ * error the LUT may have.  see gimp_color_transform_make_lut().
+ */
+#define LUT_SIZE      33
+#define LUT_MAX_ERROR 0.001
+
+
 enum
 {
   PROGRESS,
@@ -75,10 +87,42 @@ struct _GimpColorTransformPrivate
 
   cmsHTRANSFORM     transform;
   const Babl       *fish;
+
+  gfloat           *lut;
+  gint              lut_n_components;
+  gboolean          lut_sse2;
 };
 
 
-static void   gimp_color_transform_finalize (GObject *object);
+static void   gimp_color_transform_finalize     (GObject                  *object);
+
+static gchar * gimp_color_transform_cache_key   (GimpColorProfile         *src_profile,
+                                                 const Babl               *src_format,
+                                                 GimpColorProfile         *dest_profile,
+                                                 const Babl               *dest_format,
+                                                 GimpColorProfile         *proof_profile,
+                                                 GimpColorRenderingIntent  proof_intent,
+                                                 GimpColorRenderingIntent  display_intent,
+                                                 GimpColorTransformFlags   flags);
+static GimpColorTransform *
+              gimp_color_transform_cache_lookup (const gchar              *key);
+static GimpColorTransform *
+              gimp_color_transform_cache_insert (gchar                    *key,
+                                                 GimpColorTransform       *transform);
+
+static void   gimp_color_transform_make_lut     (GimpColorTransform       *transform,
+                                                 cmsUInt32Number           lcms_src_format,
+                                                 cmsUInt32Number           lcms_dest_format,
+                                                 GimpColorTransformFlags   flags);
+static gboolean
+              gimp_color_transform_process_lut  (GimpColorTransform       *transform,
+                                                 const gfloat             *src,
+                                                 gfloat                   *dest,
+                                                 gsize                     length);
+static void   gimp_color_transform_process      (GimpColorTransform       *transform,
+                                                 gconstpointer             src,
+                                                 gpointer                  dest,
+                                                 gsize                     length);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpColorTransform, gimp_color_transform,
@@ -90,6 +134,14 @@ static guint gimp_color_transform_signals[LAST_SIGNAL] = { 0 };
 
 static gchar *lcms_last_error = NULL;
 
+/*  identical transforms are shared.  the cache maps a key describing
+ *  the transform to the transform, and keeps the CACHE_SIZE most
+ *  recently requested transforms alive.
+ */
+static GMutex      transform_cache_mutex;
+static GHashTable *transform_cache       = NULL;
+static GQueue      transform_cache_queue = G_QUEUE_INIT;
+
 
 static void
 lcms_error_clear (void)
@@ -147,6 +199,8 @@ gimp_color_transform_finalize (GObject *object)
 
   g_clear_pointer (&transform->priv->transform, cmsDeleteTransform);
 
+  g_clear_pointer (&transform->priv->lut, g_free);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -175,6 +229,11 @@ gimp_color_transform_finalize (GObject *object)
  * returns a non-%NULL transform and the code takes care of doing only
  * exactly the requested color transform.
  *
+ * Transforms are shared: if an identical transform was requested
+ * recently, a new reference to it is returned instead of creating a
+ * new one.  Don't rely on the returned transform being a new object,
+ * in particular when connecting to its "progress" signal.
+ *
  * Returns: (nullable): the #GimpColorTransform, or %NULL if there was an error.
  *
  * Since: 2.10
@@ -193,6 +252,7 @@ gimp_color_transform_new (GimpColorProfile         *src_profile,
   cmsHPROFILE                dest_lcms;
   cmsUInt32Number            lcms_src_format;
   cmsUInt32Number            lcms_dest_format;
+  gchar                     *key;
   GError                    *error = NULL;
 
   g_return_val_if_fail (GIMP_IS_COLOR_PROFILE (src_profile), NULL);
@@ -200,6 +260,20 @@ gimp_color_transform_new (GimpColorProfile         *src_profile,
   g_return_val_if_fail (GIMP_IS_COLOR_PROFILE (dest_profile), NULL);
   g_return_val_if_fail (dest_format != NULL, NULL);
 
+  key = gimp_color_transform_cache_key (src_profile,  src_format,
+                                        dest_profile, dest_format,
+                                        NULL, 0,
+                                        rendering_intent, flags);
+
+  transform = gimp_color_transform_cache_lookup (key);
+
+  if (transform)
+    {
+      g_free (key);
+
+      return transform;
+    }
+
   transform = g_object_new (GIMP_TYPE_COLOR_TRANSFORM, NULL);
 
   priv = transform->priv;
@@ -243,7 +317,7 @@ gimp_color_transform_new (GimpColorProfile         *src_profile,
                gimp_color_profile_get_label (src_profile),
                gimp_color_profile_get_label (dest_profile));
 
-      return transform;
+      return gimp_color_transform_cache_insert (key, transform);
     }
 
   /* see above: when using lcms, don't mess with formats with color
@@ -283,10 +357,16 @@ gimp_color_transform_new (GimpColorProfile         *src_profile,
   if (! priv->transform)
     {
       g_object_unref (transform);
-      transform = NULL;
+      g_free (key);
+
+      return NULL;
     }
 
-  return transform;
+  gimp_color_transform_make_lut (transform,
+                                 lcms_src_format, lcms_dest_format,
+                                 flags);
+
+  return gimp_color_transform_cache_insert (key, transform);
 }
 
 /**
@@ -303,7 +383,7 @@ gimp_color_transform_new (GimpColorProfile         *src_profile,
  * This function creates a simulation / proofing color transform.
  *
  * See gimp_color_transform_new() about the color spaces to transform
- * between.
+ * between, and about sharing transforms.
  *
  * Returns: (nullable): the #GimpColorTransform, or %NULL if there was an error.
  *
@@ -326,6 +406,7 @@ gimp_color_transform_new_proofing (GimpColorProfile         *src_profile,
   cmsHPROFILE                proof_lcms;
   cmsUInt32Number            lcms_src_format;
   cmsUInt32Number            lcms_dest_format;
+  gchar                     *key;
 
   g_return_val_if_fail (GIMP_IS_COLOR_PROFILE (src_profile), NULL);
   g_return_val_if_fail (src_format != NULL, NULL);
@@ -333,6 +414,20 @@ gimp_color_transform_new_proofing (GimpColorProfile         *src_profile,
   g_return_val_if_fail (dest_format != NULL, NULL);
   g_return_val_if_fail (GIMP_IS_COLOR_PROFILE (proof_profile), NULL);
 
+  key = gimp_color_transform_cache_key (src_profile,   src_format,
+                                        dest_profile,  dest_format,
+                                        proof_profile, proof_intent,
+                                        display_intent, flags);
+
+  transform = gimp_color_transform_cache_lookup (key);
+
+  if (transform)
+    {
+      g_free (key);
+
+      return transform;
+    }
+
   transform = g_object_new (GIMP_TYPE_COLOR_TRANSFORM, NULL);
 
   priv = transform->priv;
@@ -377,10 +472,16 @@ gimp_color_transform_new_proofing (GimpColorProfile         *src_profile,
   if (! priv->transform)
     {
       g_object_unref (transform);
-      transform = NULL;
+      g_free (key);
+
+      return NULL;
     }
 
-  return transform;
+  gimp_color_transform_make_lut (transform,
+                                 lcms_src_format, lcms_dest_format,
+                                 flags);
+
+  return gimp_color_transform_cache_insert (key, transform);
 }
 
 /**
@@ -455,14 +556,7 @@ gimp_color_transform_process_pixels (GimpColorTransform *transform,
       dest = dest_pixels;
     }
 
-  if (priv->transform)
-    {
-      cmsDoTransform (priv->transform, src, dest, length);
-    }
-  else
-    {
-      babl_process (priv->fish, src, dest, length);
-    }
+  gimp_color_transform_process (transform, src, dest, length);
 
   if (src_format != priv->src_format)
     {
@@ -555,16 +649,10 @@ gimp_color_transform_process_buffer (GimpColorTransform  *transform,
 
       while (gegl_buffer_iterator_next (iter))
         {
-          if (priv->transform)
-            {
-              cmsDoTransform (priv->transform,
-                              iter->items[0].data, iter->items[1].data, iter->length);
-            }
-          else
-            {
-              babl_process (priv->fish,
-                            iter->items[0].data, iter->items[1].data, iter->length);
-            }
+          gimp_color_transform_process (transform,
+                                        iter->items[0].data,
+                                        iter->items[1].data,
+                                        iter->length);
 
           done_pixels += iter->items[0].roi.width * iter->items[0].roi.height;
 
@@ -582,16 +670,10 @@ gimp_color_transform_process_buffer (GimpColorTransform  *transform,
 
       while (gegl_buffer_iterator_next (iter))
         {
-          if (priv->transform)
-            {
-              cmsDoTransform (priv->transform,
-                              iter->items[0].data, iter->items[0].data, iter->length);
-            }
-          else
-            {
-              babl_process (priv->fish,
-                            iter->items[0].data, iter->items[0].data, iter->length);
-            }
+          gimp_color_transform_process (transform,
+                                        iter->items[0].data,
+                                        iter->items[0].data,
+                                        iter->length);
 
           done_pixels += iter->items[0].roi.width * iter->items[0].roi.height;
 
@@ -640,3 +722,410 @@ gimp_color_transform_can_gegl_copy (GimpColorProfile *src_profile,
 
   return FALSE;
 }
+
+
+/*  private functions  */
+
+static gchar *
+gimp_color_transform_cache_key (GimpColorProfile         *src_profile,
+                                const Babl               *src_format,
+                                GimpColorProfile         *dest_profile,
+                                const Babl               *dest_format,
+                                GimpColorProfile         *proof_profile,
+                                GimpColorRenderingIntent  proof_intent,
+                                GimpColorRenderingIntent  display_intent,
+                                GimpColorTransformFlags   flags)
+{
+  GimpColorProfile *profiles[] = { src_profile, dest_profile, proof_profile };
+  GString          *key;
+  gint              i;
+
+  key = g_string_new (NULL);
+
+  /*  like gimp_color_profile_is_equal(), ignore the profiles' headers  */
+  for (i = 0; i < G_N_ELEMENTS (profiles); i++)
+    {
+      if (profiles[i])
+        {
+          const guint8 *data;
+          gsize         length;
+          gchar        *checksum;
+
+          data = gimp_color_profile_get_icc_profile (profiles[i], &length);
+
+          checksum = g_compute_checksum_for_data (G_CHECKSUM_MD5,
+                                                  data + sizeof (cmsICCHeader),
+                                                  length - sizeof (cmsICCHeader));
+
+          g_string_append_printf (key, "%s:", checksum);
+
+          g_free (checksum);
+        }
+      else
+        {
+          g_string_append (key, "-:");
+        }
+    }
+
+  g_string_append_printf (key, "%s:%s:%d:%d:%d",
+                          babl_format_get_encoding (src_format),
+                          babl_format_get_encoding (dest_format),
+                          proof_intent, display_intent, flags);
+
+  /*  the alarm codes are global lcms state, baked into the transform  */
+  if (flags & GIMP_COLOR_TRANSFORM_FLAGS_GAMUT_CHECK)
+    {
+      cmsUInt16Number alarm_codes[cmsMAXCHANNELS];
+
+      cmsGetAlarmCodes (alarm_codes);
+
+      g_string_append_printf (key, ":%d,%d,%d",
+                              alarm_codes[0], alarm_codes[1], alarm_codes[2]);
+    }
+
+  return g_string_free (key, FALSE);
+}
+
+static GimpColorTransform *
+gimp_color_transform_cache_lookup (const gchar *key)
+{
+  GimpColorTransform *transform = NULL;
+
+  g_mutex_lock (&transform_cache_mutex);
+
+  if (transform_cache)
+    {
+      GList *link;
+
+      transform = g_hash_table_lookup (transform_cache, key);
+
+      if (transform)
+        {
+          g_object_ref (transform);
+
+          /*  move the transform to the front of the queue  */
+          link = g_queue_find_custom (&transform_cache_queue, key,
+                                      (GCompareFunc) strcmp);
+
+          g_queue_unlink (&transform_cache_queue, link);
+          g_queue_push_head_link (&transform_cache_queue, link);
+        }
+    }
+
+  g_mutex_unlock (&transform_cache_mutex);
+
+  return transform;
+}
+
+/*  takes ownership of @key and of @transform's reference, and returns a
+ *  reference to the cached transform, which is a different one if an
+ *  identical transform was inserted in the meantime
+ */
+static GimpColorTransform *
+gimp_color_transform_cache_insert (gchar              *key,
+                                   GimpColorTransform *transform)
+{
+  GimpColorTransform *cached;
+
+  g_mutex_lock (&transform_cache_mutex);
+
+  if (! transform_cache)
+    {
+      transform_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, g_object_unref);
+    }
+
+  cached = g_hash_table_lookup (transform_cache, key);
+
+  if (cached)
+    {
+      g_object_unref (transform);
+      g_free (key);
+
+      transform = g_object_ref (cached);
+    }
+  else
+    {
+      g_hash_table_insert (transform_cache, key, g_object_ref (transform));
+      g_queue_push_head (&transform_cache_queue, key);
+
+      while (g_queue_get_length (&transform_cache_queue) > CACHE_SIZE)
+        {
+          gchar *last = g_queue_pop_tail (&transform_cache_queue);
+
+          g_hash_table_remove (transform_cache, last);
+        }
+    }
+
+  g_mutex_unlock (&transform_cache_mutex);
+
+  return transform;
+}
+
+static inline void
+lut_interpolate (const gfloat *lut,
+                 gboolean      sse2,
+                 const gfloat *src,
+                 gfloat       *dest)
+{
+  const gint    n  = LUT_SIZE - 1;
+  const gint    db = 4;
+  const gint    dg = 4 * LUT_SIZE;
+  const gint    dr = 4 * LUT_SIZE * LUT_SIZE;
+  gfloat        fr = src[0] * n;
+  gfloat        fg = src[1] * n;
+  gfloat        fb = src[2] * n;
+  gint          ir = MIN ((gint) fr, n - 1);
+  gint          ig = MIN ((gint) fg, n - 1);
+  gint          ib = MIN ((gint) fb, n - 1);
+  gfloat        w1, w2, w3;
+  gint          a, b;
+  const gfloat *c0;
+
+  fr -= ir;
+  fg -= ig;
+  fb -= ib;
+
+  c0 = lut + ir * dr + ig * dg + ib * db;
+
+  /*  the tetrahedron containing the point is the one whose path from
+   *  c000 to c111 visits the axes in decreasing order of the fractions
+   */
+  if (fr >= fg)
+    {
+      if (fg >= fb)
+        { w1 = fr; w2 = fg; w3 = fb; a = dr; b = dr + dg; }
+      else if (fr >= fb)
+        { w1 = fr; w2 = fb; w3 = fg; a = dr; b = dr + db; }
+      else
+        { w1 = fb; w2 = fr; w3 = fg; a = db; b = dr + db; }
+    }
+  else
+    {
+      if (fb >= fg)
+        { w1 = fb; w2 = fg; w3 = fr; a = db; b = dg + db; }
+      else if (fr >= fb)
+        { w1 = fg; w2 = fr; w3 = fb; a = dg; b = dr + dg; }
+      else
+        { w1 = fg; w2 = fb; w3 = fr; a = dg; b = dg + db; }
+    }
+
+#if COMPILE_SSE2_INTRINISICS
+  if (sse2)
+    {
+      gimp_color_transform_lut_blend_sse2 (c0, c0 + a, c0 + b,
+                                           c0 + dr + dg + db,
+                                           1.0f - w1, w1 - w2, w2 - w3, w3,
+                                           dest);
+
+      return;
+    }
+#endif
+
+  {
+    const gfloat *ca = c0 + a;
+    const gfloat *cb = c0 + b;
+    const gfloat *c1 = c0 + dr + dg + db;
+    gint          i;
+
+    for (i = 0; i < 3; i++)
+      {
+        dest[i] = (1.0f - w1) * c0[i] +
+                  (w1 - w2)   * ca[i] +
+                  (w2 - w3)   * cb[i] +
+                  w3          * c1[i];
+      }
+  }
+}
+
+/*  the 3D LUT replaces lcms for float RGB transforms, which lcms doesn't
+ *  precalculate, unless the transform was created with
+ *  GIMP_COLOR_TRANSFORM_FLAGS_NOOPTIMIZE.  lcms already precalculates
+ *  8-bit and 16-bit transforms on its own.
+ *
+ *  the LUT samples the transform on a LUT_SIZE^3 grid over [0, 1], and
+ *  is evaluated using tetrahedral interpolation.  its error is
+ *  dominated by the curvature of the transform, which can be arbitrarily
+ *  high near black, e.g. for a destination TRC which is a pure gamma
+ *  curve.  the LUT is therefore checked against lcms at the center of
+ *  each cell, where its error is the highest, and dropped if it's off
+ *  by more than LUT_MAX_ERROR anywhere.  since a grid which is uniform
+ *  in linear light does much worse near black, only perceptual source
+ *  encodings are precalculated.  pixels outside of [0, 1] are left to
+ *  lcms.
+ */
+static void
+gimp_color_transform_make_lut (GimpColorTransform      *transform,
+                               cmsUInt32Number          lcms_src_format,
+                               cmsUInt32Number          lcms_dest_format,
+                               GimpColorTransformFlags  flags)
+{
+  GimpColorTransformPrivate *priv = transform->priv;
+  const Babl                *model;
+  gint                       n_components;
+  gint                       n_nodes;
+  gfloat                    *nodes;
+  gfloat                    *output;
+  gint                       n_cells;
+  gint                       r, g, b;
+  gint                       i;
+
+  if (flags & (GIMP_COLOR_TRANSFORM_FLAGS_NOOPTIMIZE |
+               GIMP_COLOR_TRANSFORM_FLAGS_GAMUT_CHECK))
+    return;
+
+  if (g_getenv ("GIMP_COLOR_TRANSFORM_DISABLE_LUT"))
+    return;
+
+  if (lcms_src_format == TYPE_RGB_FLT && lcms_dest_format == TYPE_RGB_FLT)
+    n_components = 3;
+  else if (lcms_src_format == TYPE_RGBA_FLT && lcms_dest_format == TYPE_RGBA_FLT)
+    n_components = 4;
+  else
+    return;
+
+  model = babl_format_get_model (priv->src_format);
+
+  if (model != babl_model ("R'G'B'")  &&
+      model != babl_model ("R'G'B'A") &&
+      model != babl_model ("R~G~B~")  &&
+      model != babl_model ("R~G~B~A"))
+    {
+      return;
+    }
+
+  n_nodes = LUT_SIZE * LUT_SIZE * LUT_SIZE;
+
+  nodes  = g_new (gfloat, n_nodes * n_components);
+  output = g_new (gfloat, n_nodes * n_components);
+
+  for (r = 0, i = 0; r < LUT_SIZE; r++)
+    for (g = 0; g < LUT_SIZE; g++)
+      for (b = 0; b < LUT_SIZE; b++, i += n_components)
+        {
+          nodes[i + 0] = (gfloat) r / (LUT_SIZE - 1);
+          nodes[i + 1] = (gfloat) g / (LUT_SIZE - 1);
+          nodes[i + 2] = (gfloat) b / (LUT_SIZE - 1);
+
+          if (n_components == 4)
+            nodes[i + 3] = 1.0f;
+        }
+
+  cmsDoTransform (priv->transform, nodes, output, n_nodes);
+
+  priv->lut              = g_new (gfloat, n_nodes * 4);
+  priv->lut_n_components = n_components;
+
+#if COMPILE_SSE2_INTRINISICS
+  priv->lut_sse2 = (gimp_cpu_accel_get_support () &
+                    GIMP_CPU_ACCEL_X86_SSE2) != 0;
+#endif
+
+  for (i = 0; i < n_nodes; i++)
+    {
+      priv->lut[4 * i + 0] = output[n_components * i + 0];
+      priv->lut[4 * i + 1] = output[n_components * i + 1];
+      priv->lut[4 * i + 2] = output[n_components * i + 2];
+      priv->lut[4 * i + 3] = 0.0f;
+    }
+
+  n_cells = (LUT_SIZE - 1) * (LUT_SIZE - 1) * (LUT_SIZE - 1);
+
+  for (r = 0, i = 0; r < LUT_SIZE - 1; r++)
+    for (g = 0; g < LUT_SIZE - 1; g++)
+      for (b = 0; b < LUT_SIZE - 1; b++, i += n_components)
+        {
+          nodes[i + 0] = (r + 0.5f) / (LUT_SIZE - 1);
+          nodes[i + 1] = (g + 0.5f) / (LUT_SIZE - 1);
+          nodes[i + 2] = (b + 0.5f) / (LUT_SIZE - 1);
+
+          if (n_components == 4)
+            nodes[i + 3] = 1.0f;
+        }
+
+  cmsDoTransform (priv->transform, nodes, output, n_cells);
+
+  for (i = 0; i < n_cells * n_components; i += n_components)
+    {
+      gfloat pixel[4];
+
+      lut_interpolate (priv->lut, priv->lut_sse2, nodes + i, pixel);
+
+      if (fabsf (pixel[0] - output[i + 0]) > LUT_MAX_ERROR ||
+          fabsf (pixel[1] - output[i + 1]) > LUT_MAX_ERROR ||
+          fabsf (pixel[2] - output[i + 2]) > LUT_MAX_ERROR)
+        {
+          g_debug ("%s: transform is too curved, not using a LUT",
+                   G_STRFUNC);
+
+          g_clear_pointer (&priv->lut, g_free);
+
+          break;
+        }
+    }
+
+  g_free (output);
+  g_free (nodes);
+}
+
+static gboolean
+gimp_color_transform_process_lut (GimpColorTransform *transform,
+                                  const gfloat       *src,
+                                  gfloat             *dest,
+                                  gsize               length)
+{
+  GimpColorTransformPrivate *priv         = transform->priv;
+  gint                       n_components = priv->lut_n_components;
+  gsize                      i;
+
+  for (i = 0; i < length * n_components; i += n_components)
+    {
+      /*  written so that NaNs fail, too  */
+      if (! (src[i + 0] >= 0.0f && src[i + 0] <= 1.0f &&
+             src[i + 1] >= 0.0f && src[i + 1] <= 1.0f &&
+             src[i + 2] >= 0.0f && src[i + 2] <= 1.0f))
+        {
+          return FALSE;
+        }
+    }
+
+  for (i = 0; i < length; i++)
+    {
+      gfloat pixel[4];
+
+      lut_interpolate (priv->lut, priv->lut_sse2, src, pixel);
+
+      /*  src and dest may be the same  */
+      if (n_components == 4)
+        dest[3] = src[3];
+
+      dest[0] = pixel[0];
+      dest[1] = pixel[1];
+      dest[2] = pixel[2];
+
+      src  += n_components;
+      dest += n_components;
+    }
+
+  return TRUE;
+}
+
+static void
+gimp_color_transform_process (GimpColorTransform *transform,
+                              gconstpointer       src,
+                              gpointer            dest,
+                              gsize               length)
+{
+  GimpColorTransformPrivate *priv = transform->priv;
+
+  if (priv->lut &&
+      gimp_color_transform_process_lut (transform, src, dest, length))
+    {
+      return;
+    }
+
+  if (priv->transform)
+    cmsDoTransform (priv->transform, src, dest, length);
+  else
+    babl_process (priv->fish, src, dest, length);
+}
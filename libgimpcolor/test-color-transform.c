@@ -0,0 +1,313 @@
+/* unit tests for the transform cache and the 3D LUT in
+ * gimpcolortransform.c
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <babl/babl.h>
+#include <gegl.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include <glib-object.h>
+#include <cairo.h>
+
+#include "gimpcolor.h"
+
+
+/* must match gimpcolortransform.c */
+#define LUT_MAX_ERROR 0.001
+
+#define N_SAMPLES     100000
+
+#define FLAGS         GIMP_COLOR_TRANSFORM_FLAGS_BLACK_POINT_COMPENSATION
+
+
+static gint
+check_shared (GimpColorProfile *src_profile,
+              GimpColorProfile *dest_profile,
+              const Babl       *format)
+{
+  GimpColorProfile   *src_copy;
+  GimpColorTransform *transform;
+  GimpColorTransform *shared;
+  GimpColorTransform *other;
+  const guint8       *data;
+  gsize               length;
+  gint                failures = 0;
+
+  data     = gimp_color_profile_get_icc_profile (src_profile, &length);
+  src_copy = gimp_color_profile_new_from_icc_profile (data, length, NULL);
+
+  transform = gimp_color_transform_new (src_profile, format,
+                                        dest_profile, format,
+                                        GIMP_COLOR_RENDERING_INTENT_PERCEPTUAL,
+                                        FLAGS);
+  shared    = gimp_color_transform_new (src_copy, format,
+                                        dest_profile, format,
+                                        GIMP_COLOR_RENDERING_INTENT_PERCEPTUAL,
+                                        FLAGS);
+  other     = gimp_color_transform_new (src_profile, format,
+                                        dest_profile, format,
+                                        GIMP_COLOR_RENDERING_INTENT_PERCEPTUAL,
+                                        FLAGS |
+                                        GIMP_COLOR_TRANSFORM_FLAGS_NOOPTIMIZE);
+
+  if (shared != transform)
+    {
+      g_print ("Equal profiles and flags returned different transforms!\n");
+      failures++;
+    }
+
+  if (other == transform)
+    {
+      g_print ("Different flags returned the same transform!\n");
+      failures++;
+    }
+
+  g_object_unref (other);
+  g_object_unref (shared);
+  g_object_unref (transform);
+  g_object_unref (src_copy);
+
+  return failures;
+}
+
+static gint
+check_accuracy (GimpColorProfile *src_profile,
+                GimpColorProfile *dest_profile,
+                const Babl       *format)
+{
+  GimpColorTransform *transform;
+  GimpColorTransform *direct;
+  GRand              *rand;
+  gfloat             *src;
+  gfloat             *lut_dest;
+  gfloat             *direct_dest;
+  gdouble             max_error = 0.0;
+  gint                i;
+
+  transform = gimp_color_transform_new (src_profile, format,
+                                        dest_profile, format,
+                                        GIMP_COLOR_RENDERING_INTENT_PERCEPTUAL,
+                                        FLAGS);
+  direct    = gimp_color_transform_new (src_profile, format,
+                                        dest_profile, format,
+                                        GIMP_COLOR_RENDERING_INTENT_PERCEPTUAL,
+                                        FLAGS |
+                                        GIMP_COLOR_TRANSFORM_FLAGS_NOOPTIMIZE);
+
+  src         = g_new (gfloat, 4 * N_SAMPLES);
+  lut_dest    = g_new (gfloat, 4 * N_SAMPLES);
+  direct_dest = g_new (gfloat, 4 * N_SAMPLES);
+
+  rand = g_rand_new_with_seed (0);
+
+  for (i = 0; i < 4 * N_SAMPLES; i += 4)
+    {
+      gint c;
+
+      for (c = 0; c < 3; c++)
+        {
+          gfloat v = g_rand_double (rand);
+
+          /*  put a quarter of the samples near black, where the LUT
+           *  is the least accurate
+           */
+          if (i % 16 == 0)
+            v = v * v * v;
+
+          src[i + c] = v;
+        }
+
+      src[i + 3] = 1.0f;
+    }
+
+  g_rand_free (rand);
+
+  gimp_color_transform_process_pixels (transform,
+                                       format, src,
+                                       format, lut_dest,
+                                       N_SAMPLES);
+  gimp_color_transform_process_pixels (direct,
+                                       format, src,
+                                       format, direct_dest,
+                                       N_SAMPLES);
+
+  for (i = 0; i < 4 * N_SAMPLES; i++)
+    {
+      if (i % 4 == 3)
+        continue;
+
+      max_error = MAX (max_error, fabs (lut_dest[i] - direct_dest[i]));
+    }
+
+  g_free (direct_dest);
+  g_free (lut_dest);
+  g_free (src);
+
+  g_object_unref (direct);
+  g_object_unref (transform);
+
+  if (max_error > LUT_MAX_ERROR)
+    {
+      g_print ("Transform from \"%s\" to \"%s\" is off by %g!\n",
+               gimp_color_profile_get_label (src_profile),
+               gimp_color_profile_get_label (dest_profile),
+               max_error);
+      return 1;
+    }
+
+  return 0;
+}
+
+/*  whether the transform from @src_profile to @dest_profile uses a LUT:
+ *  a transform made with the LUT disabled, which uses a format without
+ *  alpha so it isn't shared with the first one, gives the exact same
+ *  results only if the first one doesn't use a LUT either
+ */
+static gint
+check_lut (GimpColorProfile *src_profile,
+           GimpColorProfile *dest_profile,
+           gboolean          expect_lut)
+{
+  const Babl         *format       = babl_format ("R'G'B'A float");
+  const Babl         *plain_format = babl_format ("R'G'B' float");
+  GimpColorTransform *transform;
+  GimpColorTransform *plain;
+  GRand              *rand;
+  gfloat             *src;
+  gfloat             *plain_src;
+  gfloat             *dest;
+  gfloat             *plain_dest;
+  gboolean            has_lut = FALSE;
+  gint                i;
+
+  transform = gimp_color_transform_new (src_profile, format,
+                                        dest_profile, format,
+                                        GIMP_COLOR_RENDERING_INTENT_PERCEPTUAL,
+                                        FLAGS);
+
+  g_setenv ("GIMP_COLOR_TRANSFORM_DISABLE_LUT", "1", TRUE);
+
+  plain = gimp_color_transform_new (src_profile, plain_format,
+                                    dest_profile, plain_format,
+                                    GIMP_COLOR_RENDERING_INTENT_PERCEPTUAL,
+                                    FLAGS);
+
+  g_unsetenv ("GIMP_COLOR_TRANSFORM_DISABLE_LUT");
+
+  src        = g_new (gfloat, 4 * N_SAMPLES);
+  plain_src  = g_new (gfloat, 3 * N_SAMPLES);
+  dest       = g_new (gfloat, 4 * N_SAMPLES);
+  plain_dest = g_new (gfloat, 3 * N_SAMPLES);
+
+  rand = g_rand_new_with_seed (0);
+
+  for (i = 0; i < N_SAMPLES; i++)
+    {
+      gint c;
+
+      for (c = 0; c < 3; c++)
+        {
+          src[4 * i + c]       = g_rand_double (rand);
+          plain_src[3 * i + c] = src[4 * i + c];
+        }
+
+      src[4 * i + 3] = 1.0f;
+    }
+
+  g_rand_free (rand);
+
+  gimp_color_transform_process_pixels (transform,
+                                       format, src,
+                                       format, dest,
+                                       N_SAMPLES);
+  gimp_color_transform_process_pixels (plain,
+                                       plain_format, plain_src,
+                                       plain_format, plain_dest,
+                                       N_SAMPLES);
+
+  for (i = 0; i < N_SAMPLES && ! has_lut; i++)
+    {
+      gint c;
+
+      for (c = 0; c < 3; c++)
+        {
+          if (dest[4 * i + c] != plain_dest[3 * i + c])
+            has_lut = TRUE;
+        }
+    }
+
+  g_free (plain_dest);
+  g_free (dest);
+  g_free (plain_src);
+  g_free (src);
+
+  g_object_unref (plain);
+  g_object_unref (transform);
+
+  if (has_lut != expect_lut)
+    {
+      g_print ("Transform from \"%s\" to \"%s\" %s a LUT!\n",
+               gimp_color_profile_get_label (src_profile),
+               gimp_color_profile_get_label (dest_profile),
+               has_lut ? "uses" : "doesn't use");
+      return 1;
+    }
+
+  return 0;
+}
+
+int
+main (void)
+{
+  GimpColorProfile *srgb;
+  GimpColorProfile *srgb_linear;
+  GimpColorProfile *adobe;
+  const Babl       *format;
+  gint              failures = 0;
+
+  g_print ("\nTesting GIMP color transforms ...\n");
+
+  /*  matrix-shaper transforms are done by babl otherwise  */
+  g_setenv ("GIMP_COLOR_TRANSFORM_DISABLE_BABL", "1", TRUE);
+
+  babl_init ();
+
+  srgb        = gimp_color_profile_new_rgb_srgb ();
+  srgb_linear = gimp_color_profile_new_rgb_srgb_linear ();
+  adobe       = gimp_color_profile_new_rgb_adobe ();
+
+  format = babl_format ("R'G'B'A float");
+
+  failures += check_shared (srgb, adobe, format);
+
+  /*  the LUT is used for the first transform, and rejected for the
+   *  second one, whose destination TRC is a pure gamma curve
+   */
+  failures += check_lut (srgb, srgb_linear, TRUE);
+  failures += check_lut (srgb, adobe,       FALSE);
+
+  failures += check_accuracy (srgb, srgb_linear, format);
+  failures += check_accuracy (srgb, adobe,       format);
+
+  g_object_unref (adobe);
+  g_object_unref (srgb_linear);
+  g_object_unref (srgb);
+
+  babl_exit ();
+
+  if (failures)
+    {
+      g_print ("%d checks failed!\n\n", failures);
+      return EXIT_FAILURE;
+    }
+  else
+    {
+      g_print ("All checks passed.\n\n");
+      return EXIT_SUCCESS;
+    }
+}
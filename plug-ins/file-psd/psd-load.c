@@ -39,6 +39,51 @@
 
 #define COMP_MODE_SIZE sizeof(guint16)
 
+/* the decoded size of the layers read ahead of the layer being added */
+#define MAX_READ_AHEAD (256 * 1024 * 1024)
+
+
+/* The compressed data of a layer channel */
+typedef struct
+{
+  guint16               compression;
+  guint32              *rle_pack_len;
+  gchar                *data;
+  guint32               len;
+} PSDchannelsource;
+
+/* A layer whose channels are read from the file in order, and then
+ * decoded, and interleaved, by a worker thread, while the following
+ * layers are read.
+ */
+typedef struct
+{
+  PSDlayer             *layer;
+  PSDchannel          **lyr_chn;
+  PSDchannelsource     *sources;
+  gboolean              empty;
+  gboolean              empty_mask;
+  gsize                 size;                   /* Decoded size */
+
+  /* set by the worker */
+  guint16               channel_idx[MAX_CHANNELS];
+  guint16               layer_channels;
+  guint16               base_channels;
+  gboolean              alpha;
+  gboolean              user_mask;
+  guint16               user_mask_chn;
+  guchar               *pixels;                 /* Interleaved layer pixels */
+  GError               *error;
+  gboolean              done;
+} PSDlayerjob;
+
+typedef struct
+{
+  PSDimage             *img_a;
+  GMutex                mutex;
+  GCond                 cond;
+} PSDdecoder;
+
 
 /*  Local function prototypes  */
 static gint             read_header_block          (PSDimage       *img_a,
@@ -110,7 +155,16 @@ static gboolean         read_RLE_channel           (PSDimage       *img_a,
                                                     PSDchannel     *lyr_chn,
                                                     guint64         channel_data_len,
                                                     GInputStream   *input,
+                                                    PSDchannelsource *source,
+                                                    GError        **error);
+
+static gboolean         read_layer_channels        (PSDimage       *img_a,
+                                                    PSDlayerjob    *job,
+                                                    GInputStream   *input,
                                                     GError        **error);
+static void             decode_layer               (PSDlayerjob    *job,
+                                                    PSDdecoder     *decoder);
+static void             free_layer_job             (PSDlayerjob    *job);
 
 static gint             read_channel_data          (PSDchannel     *channel,
                                                     guint16         bps,
@@ -120,6 +174,23 @@ static gint             read_channel_data          (PSDchannel     *channel,
                                                     guint32         comp_len,
                                                     GError        **error);
 
+static gboolean         read_channel_source        (PSDchannel     *channel,
+                                                    guint16         bps,
+                                                    guint16         compression,
+                                                    const guint32  *rle_pack_len,
+                                                    GInputStream   *input,
+                                                    guint32         comp_len,
+                                                    gchar         **src,
+                                                    GError        **error);
+
+static gint             decode_channel_data        (PSDchannel     *channel,
+                                                    guint16         bps,
+                                                    guint16         compression,
+                                                    const guint32  *rle_pack_len,
+                                                    gchar          *src,
+                                                    guint32         comp_len,
+                                                    GError        **error);
+
 static void             decode_32_bit_predictor    (gchar          *src,
                                                     gchar          *dst,
                                                     guint32         rows,
@@ -1729,6 +1800,7 @@ read_RLE_channel (PSDimage      *img_a,
                   PSDchannel    *lyr_chn,
                   guint64        channel_data_len,
                   GInputStream  *input,
+                  PSDchannelsource *source,
                   GError       **error)
 {
   gint      rle_count_size = (img_a->version == 1 ? 2 : 4);
@@ -1762,16 +1834,17 @@ read_RLE_channel (PSDimage      *img_a,
                              GUINT32_FROM_BE (rle_pack_len[rowi]);
     }
 
-  if (read_channel_data (lyr_chn, img_a->bps,
-                         PSD_COMP_RLE, rle_pack_len, input, 0,
-                         error) < 1)
+  if (! read_channel_source (lyr_chn, img_a->bps,
+                             PSD_COMP_RLE, rle_pack_len, input, 0,
+                             &source->data, error))
     {
       psd_set_error (error);
       g_free (rle_pack_len);
       return FALSE;
     }
 
-  g_free (rle_pack_len);
+  source->compression  = PSD_COMP_RLE;
+  source->rle_pack_len = rle_pack_len;
   return TRUE;
 }
 
@@ -1786,6 +1859,394 @@ free_lyr_chn (PSDchannel **lyr_chn, gint channel_count)
   g_free (lyr_chn);
 }
 
+/* Reads the channel data of a layer, without decoding it */
+static gboolean
+read_layer_channels (PSDimage      *img_a,
+                     PSDlayerjob   *job,
+                     GInputStream  *input,
+                     GError       **error)
+{
+  PSDlayer    *lyr = job->layer;
+  PSDchannel **lyr_chn;
+  gint         cidx;
+
+  if (lyr->drop)
+    {
+      /* Step past layer data */
+      for (cidx = 0; cidx < lyr->num_channels; ++cidx)
+        {
+          if (! psd_seek (input, lyr->chn_info[cidx].data_len,
+                          G_SEEK_CUR, error))
+            {
+              psd_set_error (error);
+              return FALSE;
+            }
+        }
+
+      return TRUE;
+    }
+
+  /* Empty layer */
+  if (lyr->bottom - lyr->top == 0
+      || lyr->right - lyr->left == 0)
+      job->empty = TRUE;
+  else
+      job->empty = FALSE;
+
+  /* Empty mask */
+  if (lyr->layer_mask.bottom - lyr->layer_mask.top == 0
+      || lyr->layer_mask.right - lyr->layer_mask.left == 0)
+      job->empty_mask = TRUE;
+  else
+      job->empty_mask = FALSE;
+
+  IFDBG(3) g_debug ("Empty mask %d, size %d %d", job->empty_mask,
+                    lyr->layer_mask.bottom - lyr->layer_mask.top,
+                    lyr->layer_mask.right - lyr->layer_mask.left);
+
+  /* Load layer channel data */
+  IFDBG(2) g_debug ("Number of channels: %d", lyr->num_channels);
+  /* Create pointer array for the channel records */
+  lyr_chn      = g_new0 (PSDchannel *, lyr->num_channels);
+  job->lyr_chn = lyr_chn;
+  job->sources = g_new0 (PSDchannelsource, lyr->num_channels);
+  for (cidx = 0; cidx < lyr->num_channels; ++cidx)
+    {
+      PSDchannelsource *source    = &job->sources[cidx];
+      guint16           comp_mode = PSD_COMP_RAW;
+
+      /* Allocate channel record */
+      lyr_chn[cidx] = g_malloc (sizeof (PSDchannel) );
+
+      lyr_chn[cidx]->id = lyr->chn_info[cidx].channel_id;
+      lyr_chn[cidx]->rows = lyr->bottom - lyr->top;
+      lyr_chn[cidx]->columns = lyr->right - lyr->left;
+      lyr_chn[cidx]->data = NULL;
+
+      if (lyr_chn[cidx]->id == PSD_CHANNEL_EXTRA_MASK)
+        {
+          if (! psd_seek (input, lyr->chn_info[cidx].data_len,
+                          G_SEEK_CUR, error))
+            {
+              psd_set_error (error);
+              return FALSE;
+            }
+
+          continue;
+        }
+      else if (lyr_chn[cidx]->id == PSD_CHANNEL_MASK)
+        {
+          /* Works around a bug in panotools psd files where the layer mask
+             size is given as 0 but data exists. Set mask size to layer size.
+          */
+          if (job->empty_mask && lyr->chn_info[cidx].data_len - 2 > 0)
+            {
+              job->empty_mask = FALSE;
+              if (lyr->layer_mask.top == lyr->layer_mask.bottom)
+                {
+                  lyr->layer_mask.top = lyr->top;
+                  lyr->layer_mask.bottom = lyr->bottom;
+                }
+              if (lyr->layer_mask.right == lyr->layer_mask.left)
+                {
+                  lyr->layer_mask.right = lyr->right;
+                  lyr->layer_mask.left = lyr->left;
+                }
+            }
+          lyr_chn[cidx]->rows = (lyr->layer_mask.bottom -
+                                lyr->layer_mask.top);
+          lyr_chn[cidx]->columns = (lyr->layer_mask.right -
+                                   lyr->layer_mask.left);
+        }
+
+      IFDBG(3) g_debug ("Channel id %d, %dx%d",
+                        lyr_chn[cidx]->id,
+                        lyr_chn[cidx]->columns,
+                        lyr_chn[cidx]->rows);
+
+      /* Only read channel data if there is any channel
+       * data. Note that the channel data can contain a
+       * compression method but no actual data.
+       */
+      if (lyr->chn_info[cidx].data_len >= COMP_MODE_SIZE)
+        {
+          if (psd_read (input, &comp_mode, COMP_MODE_SIZE, error) < COMP_MODE_SIZE)
+            {
+              psd_set_error (error);
+              return FALSE;
+            }
+
+          if (! img_a->ibm_pc_format)
+            comp_mode = GUINT16_FROM_BE (comp_mode);
+          else
+            comp_mode = GUINT16_FROM_LE (comp_mode);
+          IFDBG(3) g_debug ("Compression mode: %d", comp_mode);
+        }
+      if (lyr->chn_info[cidx].data_len > COMP_MODE_SIZE)
+        {
+          switch (comp_mode)
+            {
+              case PSD_COMP_RAW:        /* Planar raw data */
+                IFDBG(3) g_debug ("Raw data length: %" G_GSIZE_FORMAT,
+                                  lyr->chn_info[cidx].data_len - 2);
+                source->compression = PSD_COMP_RAW;
+                if (! read_channel_source (lyr_chn[cidx], img_a->bps,
+                                           PSD_COMP_RAW, NULL, input, 0,
+                                           &source->data, error))
+                  {
+                    psd_set_error (error);
+                    return FALSE;
+                  }
+                break;
+
+              case PSD_COMP_RLE:        /* Packbits */
+                if (! read_RLE_channel (img_a, lyr_chn[cidx],
+                                        lyr->chn_info[cidx].data_len,
+                                        input, source, error))
+                  {
+                    psd_set_error (error);
+                    return FALSE;
+                  }
+                break;
+
+              case PSD_COMP_ZIP:                 /* ? */
+              case PSD_COMP_ZIP_PRED:
+                source->compression = comp_mode;
+                source->len         = lyr->chn_info[cidx].data_len - 2;
+                if (! read_channel_source (lyr_chn[cidx], img_a->bps,
+                                           comp_mode, NULL, input,
+                                           source->len,
+                                           &source->data, error))
+                  {
+                    psd_set_error (error);
+                    return FALSE;
+                  }
+                break;
+
+              default:
+                g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                            _("Unsupported compression mode: %d"), comp_mode);
+                return FALSE;
+                break;
+            }
+        }
+
+      job->size += (gsize) lyr_chn[cidx]->rows * lyr_chn[cidx]->columns *
+                   MAX (img_a->bps / 8, 1);
+    }
+
+  return TRUE;
+}
+
+static void
+get_layer_channels (PSDimage    *img_a,
+                    PSDlayerjob *job)
+{
+  PSDlayer    *lyr       = job->layer;
+  PSDchannel **lyr_chn   = job->lyr_chn;
+  guint16      alpha_chn = -1;
+  gint         cidx;
+
+  job->alpha          = FALSE;
+  job->user_mask      = FALSE;
+  job->user_mask_chn  = -1;
+  job->layer_channels = 0;
+
+  if (img_a->color_mode == PSD_CMYK)
+    job->base_channels = 4;
+  else if (img_a->color_mode == PSD_RGB || img_a->color_mode == PSD_LAB)
+    job->base_channels = 3;
+  else
+    job->base_channels = 1;
+
+  IFDBG(3) g_debug ("Re-hash channel indices");
+  for (cidx = 0; cidx < lyr->num_channels; ++cidx)
+    {
+      IFDBG(3) g_debug ("Channel: %d - id: %d", cidx, lyr_chn[cidx]->id);
+      if (lyr_chn[cidx]->id == PSD_CHANNEL_MASK ||
+          lyr_chn[cidx]->id == PSD_CHANNEL_EXTRA_MASK)
+        {
+          /* According to the specs the extra mask (which they call
+           * real user supplied layer mask) is used "when both a user
+           * mask and a vector mask are present".
+           * I haven't seen an example that has the extra mask, so not
+           * sure which of the masks would appear first.
+           * For now assuming that the extra mask will be first. */
+          if (! job->user_mask)
+            {
+              job->user_mask = TRUE;
+              job->user_mask_chn = cidx;
+            }
+          else
+            {
+              /* Not using this mask, make sure it gets freed. */
+              g_clear_pointer (&lyr_chn[cidx]->data, g_free);
+            }
+        }
+      else if (lyr_chn[cidx]->id == PSD_CHANNEL_ALPHA)
+        {
+          job->alpha = TRUE;
+          alpha_chn = cidx;
+        }
+      else if (lyr_chn[cidx]->data)
+        {
+          if (job->layer_channels < job->base_channels)
+            {
+              job->channel_idx[job->layer_channels] = cidx;   /* Assumes in sane order */
+              job->layer_channels++;                          /* RGB, Lab, CMYK etc.   */
+            }
+          else
+            {
+              /* channel_idx[base_channels] is reserved for alpha channel,
+               * but this layer apparently has extra channels.
+               * From the one example I have (see #8411) it looks like
+               * that channel is the same as the alpha channel. */
+              IFDBG(2) g_debug ("This layer has an extra channel (id: %d)", lyr_chn[cidx]->id);
+              job->channel_idx[job->layer_channels+1] = cidx; /* Assumes in sane order */
+              job->layer_channels += 2;                       /* RGB, Lab, CMYK etc.   */
+            }
+        }
+      else
+        {
+          IFDBG(4) g_debug ("Channel %d (id: %d) has no data", cidx, lyr_chn[cidx]->id);
+        }
+    }
+
+  if (job->alpha)
+    {
+      if (job->layer_channels <= job->base_channels)
+        {
+          job->channel_idx[job->layer_channels] = alpha_chn;
+          job->layer_channels++;
+        }
+      else
+        {
+          job->channel_idx[job->base_channels] = alpha_chn;
+        }
+      job->base_channels++;
+    }
+}
+
+/* Interleaves the planar channel data of a layer into job->pixels */
+static void
+interleave_layer_channels (PSDimage    *img_a,
+                           PSDlayerjob *job)
+{
+  PSDlayer *lyr      = job->layer;
+  gint      bps      = MAX (img_a->bps / 8, 1);
+  gint      dst_step = bps * job->base_channels;
+  gsize     n_pixels;
+  gint      cidx;
+
+  n_pixels = (gsize) (lyr->right - lyr->left) * (lyr->bottom - lyr->top);
+
+  job->pixels = g_malloc0 (n_pixels * dst_step);
+
+  for (cidx = 0; cidx < job->base_channels; ++cidx)
+    {
+      const guint8 *src;
+      guint8       *dst;
+      gsize         i;
+      gint          b;
+
+      IFDBG(3) g_debug ("Start channel %d", job->channel_idx[cidx]);
+
+      src = (const guint8 *) job->lyr_chn[job->channel_idx[cidx]]->data;
+      dst = job->pixels + cidx * bps;
+
+      if (! src)
+        continue;
+
+      for (i = 0; i < n_pixels; i++)
+        {
+          for (b = 0; b < bps; ++b)
+            dst[b] = src[b];
+
+          src += bps;
+          dst += dst_step;
+        }
+    }
+
+  for (cidx = 0; cidx < job->layer_channels; ++cidx)
+    g_clear_pointer (&job->lyr_chn[job->channel_idx[cidx]]->data, g_free);
+}
+
+/* Decodes the channel data of a layer, on a thread of the pool */
+static void
+decode_layer (PSDlayerjob *job,
+              PSDdecoder  *decoder)
+{
+  PSDimage *img_a = decoder->img_a;
+  PSDlayer *lyr   = job->layer;
+  gint      cidx;
+
+  for (cidx = 0; cidx < lyr->num_channels; ++cidx)
+    {
+      PSDchannelsource *source = &job->sources[cidx];
+
+      if (source->data && ! job->error)
+        {
+          if (decode_channel_data (job->lyr_chn[cidx], img_a->bps,
+                                   source->compression,
+                                   source->rle_pack_len,
+                                   source->data, source->len,
+                                   &job->error) < 1)
+            {
+              psd_set_error (&job->error);
+            }
+
+          source->data = NULL;
+        }
+
+      g_clear_pointer (&source->rle_pack_len, g_free);
+    }
+
+  if (! job->error)
+    {
+      get_layer_channels (img_a, job);
+
+      if (lyr->group_type == 0 && ! job->empty)
+        interleave_layer_channels (img_a, job);
+    }
+
+  g_mutex_lock (&decoder->mutex);
+  job->done = TRUE;
+  g_cond_broadcast (&decoder->cond);
+  g_mutex_unlock (&decoder->mutex);
+}
+
+static void
+free_layer_job (PSDlayerjob *job)
+{
+  gint cidx;
+
+  if (job->lyr_chn)
+    {
+      for (cidx = 0; cidx < job->layer->num_channels; ++cidx)
+        {
+          if (job->lyr_chn[cidx])
+            g_free (job->lyr_chn[cidx]->data);
+        }
+
+      free_lyr_chn (job->lyr_chn, job->layer->num_channels);
+      job->lyr_chn = NULL;
+    }
+
+  if (job->sources)
+    {
+      for (cidx = 0; cidx < job->layer->num_channels; ++cidx)
+        {
+          g_free (job->sources[cidx].data);
+          g_free (job->sources[cidx].rle_pack_len);
+        }
+
+      g_clear_pointer (&job->sources, g_free);
+    }
+
+  g_clear_pointer (&job->pixels, g_free);
+  g_clear_error (&job->error);
+}
+
 static gint
 add_layers (GimpImage     *image,
             PSDimage      *img_a,
@@ -1797,10 +2258,7 @@ add_layers (GimpImage     *image,
   GArray               *parent_group_stack;
   GimpLayer            *parent_group = NULL;
   GimpLayer            *clipping_group = NULL;
-  guint16               alpha_chn;
   guint16               user_mask_chn;
-  guint16               layer_channels, base_channels;
-  guint16               channel_idx[MAX_CHANNELS];
   guint16               bps;
   gint32                l_x;                   /* Layer x */
   gint32                l_y;                   /* Layer y */
@@ -1824,6 +2282,12 @@ add_layers (GimpImage     *image,
   GeglBuffer           *buffer;
   GimpImageType         image_type;
   LayerModeInfo         mode_info;
+  PSDdecoder            decoder;
+  GThreadPool          *pool;
+  PSDlayerjob          *jobs;
+  gint                  n_read;                /* Number of layers read */
+  gint                  i;
+  gsize                 read_ahead;
 
 
   IFDBG(2) g_debug ("Number of layers: %d", img_a->num_layers);
@@ -1904,180 +2368,75 @@ add_layers (GimpImage     *image,
   parent_group_stack = g_array_new (FALSE, FALSE, sizeof (GimpLayer *));
   g_array_append_val (parent_group_stack, parent_group);
 
+  decoder.img_a = img_a;
+  g_mutex_init (&decoder.mutex);
+  g_cond_init (&decoder.cond);
+
+  pool = g_thread_pool_new ((GFunc) decode_layer, &decoder,
+                            gimp_get_num_processors (), FALSE, NULL);
+
+  jobs       = g_new0 (PSDlayerjob, img_a->num_layers);
+  n_read     = 0;
+  read_ahead = 0;
+
   for (lidx = 0; lidx < img_a->num_layers; ++lidx)
     {
-      IFDBG(2) g_debug ("Process Layer No %d (%s).", lidx, lyr_a[lidx]->name);
+      PSDlayerjob *job = &jobs[lidx];
 
-      if (lyr_a[lidx]->drop)
-        {
-          IFDBG(2) g_debug ("Drop layer %d", lidx);
+      IFDBG(2) g_debug ("Process Layer No %d (%s).", lidx, lyr_a[lidx]->name);
 
-          /* Step past layer data */
-          for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
-            {
-              if (! psd_seek (input, lyr_a[lidx]->chn_info[cidx].data_len,
-                              G_SEEK_CUR, error))
-                {
-                  psd_set_error (error);
-                  return -1;
-                }
-            }
-        }
-      else
+      /* Read the channel data of the following layers, while the layers
+       * read before are decoded by the thread pool.  The file is read
+       * sequentially, and the layers are added in order below.
+       */
+      while (n_read < img_a->num_layers &&
+             (n_read <= lidx || read_ahead < MAX_READ_AHEAD))
         {
-          /* Empty layer */
-          if (lyr_a[lidx]->bottom - lyr_a[lidx]->top == 0
-              || lyr_a[lidx]->right - lyr_a[lidx]->left == 0)
-              empty = TRUE;
-          else
-              empty = FALSE;
+          PSDlayerjob *next = &jobs[n_read];
 
-          /* Empty mask */
-          if (lyr_a[lidx]->layer_mask.bottom - lyr_a[lidx]->layer_mask.top == 0
-              || lyr_a[lidx]->layer_mask.right - lyr_a[lidx]->layer_mask.left == 0)
-              empty_mask = TRUE;
-          else
-              empty_mask = FALSE;
+          next->layer = lyr_a[n_read++];
 
-          IFDBG(3) g_debug ("Empty mask %d, size %d %d", empty_mask,
-                            lyr_a[lidx]->layer_mask.bottom - lyr_a[lidx]->layer_mask.top,
-                            lyr_a[lidx]->layer_mask.right - lyr_a[lidx]->layer_mask.left);
+          if (! read_layer_channels (img_a, next, input, error))
+            goto decode_error;
 
-          /* Load layer channel data */
-          IFDBG(2) g_debug ("Number of channels: %d", lyr_a[lidx]->num_channels);
-          /* Create pointer array for the channel records */
-          lyr_chn = g_new0 (PSDchannel *, lyr_a[lidx]->num_channels);
-          for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
-            {
-              guint16 comp_mode = PSD_COMP_RAW;
+          read_ahead += next->size;
 
-              /* Allocate channel record */
-              lyr_chn[cidx] = g_malloc (sizeof (PSDchannel) );
+          if (next->lyr_chn)
+            g_thread_pool_push (pool, next, NULL);
+          else
+            next->done = TRUE;
+        }
 
-              lyr_chn[cidx]->id = lyr_a[lidx]->chn_info[cidx].channel_id;
-              lyr_chn[cidx]->rows = lyr_a[lidx]->bottom - lyr_a[lidx]->top;
-              lyr_chn[cidx]->columns = lyr_a[lidx]->right - lyr_a[lidx]->left;
-              lyr_chn[cidx]->data = NULL;
+      g_mutex_lock (&decoder.mutex);
+      while (! job->done)
+        g_cond_wait (&decoder.cond, &decoder.mutex);
+      g_mutex_unlock (&decoder.mutex);
 
-              if (lyr_chn[cidx]->id == PSD_CHANNEL_EXTRA_MASK)
-                {
-                  if (! psd_seek (input, lyr_a[lidx]->chn_info[cidx].data_len,
-                                  G_SEEK_CUR, error))
-                    {
-                      psd_set_error (error);
-                      free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                      return -1;
-                    }
+      read_ahead -= job->size;
 
-                  continue;
-                }
-              else if (lyr_chn[cidx]->id == PSD_CHANNEL_MASK)
-                {
-                  /* Works around a bug in panotools psd files where the layer mask
-                     size is given as 0 but data exists. Set mask size to layer size.
-                  */
-                  if (empty_mask && lyr_a[lidx]->chn_info[cidx].data_len - 2 > 0)
-                    {
-                      empty_mask = FALSE;
-                      if (lyr_a[lidx]->layer_mask.top == lyr_a[lidx]->layer_mask.bottom)
-                        {
-                          lyr_a[lidx]->layer_mask.top = lyr_a[lidx]->top;
-                          lyr_a[lidx]->layer_mask.bottom = lyr_a[lidx]->bottom;
-                        }
-                      if (lyr_a[lidx]->layer_mask.right == lyr_a[lidx]->layer_mask.left)
-                        {
-                          lyr_a[lidx]->layer_mask.right = lyr_a[lidx]->right;
-                          lyr_a[lidx]->layer_mask.left = lyr_a[lidx]->left;
-                        }
-                    }
-                  lyr_chn[cidx]->rows = (lyr_a[lidx]->layer_mask.bottom -
-                                        lyr_a[lidx]->layer_mask.top);
-                  lyr_chn[cidx]->columns = (lyr_a[lidx]->layer_mask.right -
-                                           lyr_a[lidx]->layer_mask.left);
-                }
-
-              IFDBG(3) g_debug ("Channel id %d, %dx%d",
-                                lyr_chn[cidx]->id,
-                                lyr_chn[cidx]->columns,
-                                lyr_chn[cidx]->rows);
-
-              /* Only read channel data if there is any channel
-               * data. Note that the channel data can contain a
-               * compression method but no actual data.
-               */
-              if (lyr_a[lidx]->chn_info[cidx].data_len >= COMP_MODE_SIZE)
-                {
-                  if (psd_read (input, &comp_mode, COMP_MODE_SIZE, error) < COMP_MODE_SIZE)
-                    {
-                      psd_set_error (error);
-                      free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                      return -1;
-                    }
+      if (job->error)
+        {
+          g_propagate_error (error, job->error);
+          job->error = NULL;
 
-                  if (! img_a->ibm_pc_format)
-                    comp_mode = GUINT16_FROM_BE (comp_mode);
-                  else
-                    comp_mode = GUINT16_FROM_LE (comp_mode);
-                  IFDBG(3) g_debug ("Compression mode: %d", comp_mode);
-                }
-              if (lyr_a[lidx]->chn_info[cidx].data_len > COMP_MODE_SIZE)
-                {
-                  switch (comp_mode)
-                    {
-                      case PSD_COMP_RAW:        /* Planar raw data */
-                        IFDBG(3) g_debug ("Raw data length: %" G_GSIZE_FORMAT,
-                                          lyr_a[lidx]->chn_info[cidx].data_len - 2);
-                        if (read_channel_data (lyr_chn[cidx], img_a->bps,
-                                               PSD_COMP_RAW, NULL, input, 0,
-                                               error) < 1)
-                          {
-                            psd_set_error (error);
-                            free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                            return -1;
-                          }
-                        break;
+          goto decode_error;
+        }
 
-                      case PSD_COMP_RLE:        /* Packbits */
-                        if (! read_RLE_channel (img_a, lyr_chn[cidx],
-                                                lyr_a[lidx]->chn_info[cidx].data_len,
-                                                input, error))
-                          {
-                            psd_set_error (error);
-                            free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                            return -1;
-                          }
-                        break;
-
-                      case PSD_COMP_ZIP:                 /* ? */
-                      case PSD_COMP_ZIP_PRED:
-                        if (read_channel_data (lyr_chn[cidx], img_a->bps,
-                                               comp_mode, NULL, input,
-                                               lyr_a[lidx]->chn_info[cidx].data_len - 2,
-                                               error) < 1)
-                          {
-                            psd_set_error (error);
-                            free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                            return -1;
-                          }
-                        break;
-
-                      default:
-                        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                                    _("Unsupported compression mode: %d"), comp_mode);
-                        free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                        return -1;
-                        break;
-                    }
-                }
-            }
+      if (lyr_a[lidx]->drop)
+        {
+          IFDBG(2) g_debug ("Drop layer %d", lidx);
+        }
+      else
+        {
+          lyr_chn       = job->lyr_chn;
+          empty         = job->empty;
+          empty_mask    = job->empty_mask;
+          alpha         = job->alpha;
+          user_mask     = job->user_mask;
+          user_mask_chn = job->user_mask_chn;
 
           /* Draw layer */
 
-          alpha = FALSE;
-          alpha_chn = -1;
-          user_mask = FALSE;
-          user_mask_chn = -1;
-          layer_channels = 0;
           l_x = 0;
           l_y = 0;
           l_w = img_a->columns;
@@ -2088,80 +2447,6 @@ add_layers (GimpImage     *image,
           else
             parent_group = NULL; /* root */
 
-          if (img_a->color_mode == PSD_CMYK)
-            base_channels = 4;
-          else if (img_a->color_mode == PSD_RGB || img_a->color_mode == PSD_LAB)
-            base_channels = 3;
-          else
-            base_channels = 1;
-
-          IFDBG(3) g_debug ("Re-hash channel indices");
-          for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
-            {
-              IFDBG(3) g_debug ("Channel: %d - id: %d", cidx, lyr_chn[cidx]->id);
-              if (lyr_chn[cidx]->id == PSD_CHANNEL_MASK ||
-                  lyr_chn[cidx]->id == PSD_CHANNEL_EXTRA_MASK)
-                {
-                  /* According to the specs the extra mask (which they call
-                   * real user supplied layer mask) is used "when both a user
-                   * mask and a vector mask are present".
-                   * I haven't seen an example that has the extra mask, so not
-                   * sure which of the masks would appear first.
-                   * For now assuming that the extra mask will be first. */
-                  if (! user_mask)
-                    {
-                      user_mask = TRUE;
-                      user_mask_chn = cidx;
-                    }
-                  else
-                    {
-                      /* Not using this mask, make sure it gets freed. */
-                      g_free (lyr_chn[cidx]->data);
-                    }
-                }
-              else if (lyr_chn[cidx]->id == PSD_CHANNEL_ALPHA)
-                {
-                  alpha = TRUE;
-                  alpha_chn = cidx;
-                }
-              else if (lyr_chn[cidx]->data)
-                {
-                  if (layer_channels < base_channels)
-                    {
-                      channel_idx[layer_channels] = cidx;   /* Assumes in sane order */
-                      layer_channels++;                     /* RGB, Lab, CMYK etc.   */
-                    }
-                  else
-                    {
-                      /* channel_idx[base_channels] is reserved for alpha channel,
-                       * but this layer apparently has extra channels.
-                       * From the one example I have (see #8411) it looks like
-                       * that channel is the same as the alpha channel. */
-                      IFDBG(2) g_debug ("This layer has an extra channel (id: %d)", lyr_chn[cidx]->id);
-                      channel_idx[layer_channels+1] = cidx;   /* Assumes in sane order */
-                      layer_channels += 2;                    /* RGB, Lab, CMYK etc.   */
-                    }
-                }
-              else
-                {
-                  IFDBG(4) g_debug ("Channel %d (id: %d) has no data", cidx, lyr_chn[cidx]->id);
-                }
-            }
-
-          if (alpha)
-            {
-              if (layer_channels <= base_channels)
-                {
-                  channel_idx[layer_channels] = alpha_chn;
-                  layer_channels++;
-                }
-              else
-                {
-                  channel_idx[base_channels] = alpha_chn;
-                }
-              base_channels++;
-            }
-
           IFDBG(4) g_debug ("Create the layer (group type: %d, clipping group type: %d)",
                             lyr_a[lidx]->group_type, lyr_a[lidx]->clipping_group_type);
 
@@ -2328,91 +2613,60 @@ add_layers (GimpImage     *image,
                     }
                   else
                     {
-                      GeglBufferIterator *iter;
-
-                      bps = img_a->bps / 8;
-                      if (bps == 0)
-                        bps++;
+                      const Babl *format = get_layer_format (img_a, alpha);
 
                       buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
 
-                      iter = gegl_buffer_iterator_new (
-                        buffer, NULL, 0, get_layer_format (img_a, alpha),
-                        GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
-
-                      while (gegl_buffer_iterator_next (iter))
+                      if (img_a->color_mode == PSD_CMYK || img_a->color_mode == PSD_LAB)
                         {
-                          const GeglRectangle *roi      = &iter->items[0].roi;
-                          guint8              *dst0     = iter->items[0].data;
-                          gint                 src_step = bps;
-                          gint                 dst_step = bps * base_channels;
+                          gint    strip  = gimp_tile_height ();
+                          gint    stride;
+                          guchar *dst;
+                          gint    y;
 
-                          if (img_a->color_mode == PSD_CMYK || img_a->color_mode == PSD_LAB)
-                            {
-                              dst0 = gegl_scratch_alloc (base_channels * bps *
-                                                         iter->length);
-                            }
+                          bps = img_a->bps / 8;
+                          if (bps == 0)
+                            bps++;
 
-                          for (cidx = 0; cidx < base_channels; ++cidx)
-                            {
-                              gint b;
-
-                              if (roi->x == 0 && roi->y == 0)
-                                IFDBG(3) g_debug ("Start channel %d", channel_idx[cidx]);
-
-                              for (b = 0; b < bps; ++b)
-                                {
-                                  guint8 *dst;
-                                  gint    y;
-
-                                  dst = &dst0[cidx * bps + b];
-
-                                  for (y = 0; y < roi->height; y++)
-                                    {
-                                      const guint8 *src;
-                                      gint          x;
-
-                                      src = (const guint8 *)
-                                        &lyr_chn[channel_idx[cidx]]->data[
-                                          ((roi->y + y) * l_w +
-                                           roi->x)      * bps +
-                                          b];
-
-                                      for (x = 0; x < roi->width; ++x)
-                                        {
-                                          *dst = *src;
-
-                                          src += src_step;
-                                          dst += dst_step;
-                                        }
-                                    }
-                                }
-                            }
+                          stride = l_w * bps * job->base_channels;
+                          dst    = g_malloc ((gsize) l_w * MIN (strip, l_h) *
+                                             babl_format_get_bytes_per_pixel (format));
 
-                          if (img_a->color_mode == PSD_CMYK)
+                          /* Convert the layer, and upload it, a row of
+                           * tiles at a time
+                           */
+                          for (y = 0; y < l_h; y += strip)
                             {
-                              psd_convert_cmyk_to_srgb (
-                                img_a,
-                                iter->items[0].data, dst0,
-                                roi->width, roi->height,
-                                alpha, error);
-
-                              gegl_scratch_free (dst0);
+                              gint height = MIN (strip, l_h - y);
+
+                              if (img_a->color_mode == PSD_CMYK)
+                                psd_convert_cmyk_to_srgb (img_a,
+                                                          dst, job->pixels + (gsize) y * stride,
+                                                          l_w, height,
+                                                          alpha, error);
+                              else
+                                psd_convert_lab_to_srgb (img_a,
+                                                         dst, job->pixels + (gsize) y * stride,
+                                                         l_w, height,
+                                                         alpha);
+
+                              gegl_buffer_set (buffer,
+                                               GEGL_RECTANGLE (0, y, l_w, height),
+                                               0, format, dst,
+                                               GEGL_AUTO_ROWSTRIDE);
                             }
-                          else if (img_a->color_mode == PSD_LAB)
-                            {
-                              psd_convert_lab_to_srgb (
-                                img_a,
-                                iter->items[0].data, dst0,
-                                roi->width, roi->height,
-                                alpha);
 
-                              gegl_scratch_free (dst0);
-                            }
+                          g_free (dst);
+                        }
+                      else
+                        {
+                          gegl_buffer_set (buffer,
+                                           GEGL_RECTANGLE (0, 0, l_w, l_h),
+                                           0, format, job->pixels,
+                                           GEGL_AUTO_ROWSTRIDE);
                         }
 
-                      for (cidx = 0; cidx < layer_channels; ++cidx)
-                        g_free (lyr_chn[channel_idx[cidx]]->data);
+                      g_clear_pointer (&job->pixels, g_free);
 
                       g_object_unref (buffer);
                     }
@@ -2483,7 +2737,7 @@ add_layers (GimpImage     *image,
                           gimp_layer_set_apply_mask (layer,
                                                      ! lyr_a[lidx]->layer_mask.mask_flags.disabled);
                         }
-                      g_free (lyr_chn[user_mask_chn]->data);
+                      g_clear_pointer (&lyr_chn[user_mask_chn]->data, g_free);
                     }
                 }
 
@@ -2507,13 +2761,18 @@ add_layers (GimpImage     *image,
                       }
                   }
             }
-
-          free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
         }
+
+      free_layer_job (job);
+
       g_free (lyr_a[lidx]->chn_info);
       g_free (lyr_a[lidx]->name);
       g_free (lyr_a[lidx]);
     }
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_mutex_clear (&decoder.mutex);
+  g_cond_clear (&decoder.cond);
+  g_free (jobs);
   g_free (lyr_a);
   g_array_free (parent_group_stack, FALSE);
 
@@ -2522,6 +2781,20 @@ add_layers (GimpImage     *image,
   g_list_free (img_a->layer_selection);
 
   return 0;
+
+decode_error:
+  g_thread_pool_free (pool, TRUE, TRUE);
+  g_mutex_clear (&decoder.mutex);
+  g_cond_clear (&decoder.cond);
+
+  for (i = lidx; i < n_read; i++)
+    free_layer_job (&jobs[i]);
+
+  g_free (jobs);
+  g_list_free (selected_layers);
+  g_array_free (parent_group_stack, FALSE);
+
+  return -1;
 }
 
 static gint
@@ -3078,77 +3351,142 @@ read_channel_data (PSDchannel     *channel,
                    guint32         comp_len,
                    GError        **error)
 {
-  gchar    *raw_data = NULL;
-  gchar    *src;
-  guint32   readline_len;
-  gint      i, j;
+  gchar *src;
+
+  if (! read_channel_source (channel, bps, compression, rle_pack_len,
+                             input, comp_len, &src, error))
+    return -1;
 
+  return decode_channel_data (channel, bps, compression, rle_pack_len,
+                              src, comp_len, error);
+}
+
+static guint32
+get_readline_len (PSDchannel *channel,
+                  guint16     bps)
+{
   if (bps == 1)
-    readline_len = ((channel->columns + 7) / 8);
+    return ((channel->columns + 7) / 8);
   else
-    readline_len = (channel->columns * bps / 8);
+    return (channel->columns * bps / 8);
+}
+
+/* Reads the still compressed data of a channel into @src, so that it
+ * can be decoded separately, possibly on another thread.
+ */
+static gboolean
+read_channel_source (PSDchannel     *channel,
+                     guint16         bps,
+                     guint16         compression,
+                     const guint32  *rle_pack_len,
+                     GInputStream   *input,
+                     guint32         comp_len,
+                     gchar         **src,
+                     GError        **error)
+{
+  guint32   readline_len;
+  guint64   src_len = 0;
+  gint      i;
+
+  readline_len = get_readline_len (channel, bps);
 
   IFDBG(4) g_debug ("raw data size %d x %d = %d", readline_len,
                     channel->rows, readline_len * channel->rows);
 
+  *src = NULL;
+
   /* sanity check, int overflow check (avoid divisions by zero) */
   if ((channel->rows == 0) || (channel->columns == 0) ||
       (channel->rows > G_MAXINT32 / channel->columns / MAX (bps / 8, 1)))
     {
       g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
                    _("Unsupported or invalid channel size"));
-      return -1;
+      return FALSE;
     }
 
-  raw_data = g_malloc (readline_len * channel->rows);
   switch (compression)
     {
       case PSD_COMP_RAW:
-        if (psd_read (input, raw_data, readline_len * channel->rows, error) < readline_len * channel->rows)
-          {
-            psd_set_error (error);
-            g_free (raw_data);
-            return -1;
-          }
+        src_len = (guint64) readline_len * channel->rows;
         break;
 
       case PSD_COMP_RLE:
         for (i = 0; i < channel->rows; ++i)
-          {
-            src = gegl_scratch_alloc (rle_pack_len[i]);
-/*      FIXME check for over-run
-            if (PSD_TELL(input) + rle_pack_len[i] > block_end)
-              {
-                psd_set_error (TRUE, errno, error);
-                return -1;
-              }
-*/
-            if (psd_read (input, src, rle_pack_len[i], error) < rle_pack_len[i])
-              {
-                psd_set_error (error);
-                gegl_scratch_free (src);
-                g_free (raw_data);
-                return -1;
-              }
-            /* FIXME check for errors returned from decode packbits */
-            decode_packbits (src, raw_data + i * readline_len,
-                             rle_pack_len[i], readline_len);
-            gegl_scratch_free (src);
-          }
+          src_len += rle_pack_len[i];
         break;
+
       case PSD_COMP_ZIP:
       case PSD_COMP_ZIP_PRED:
+        src_len = comp_len;
+        break;
+    }
+
+  if (src_len > G_MAXINT32 ||
+      (src_len > 0 && ! (*src = g_try_malloc (src_len))))
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   _("Unsupported or invalid channel size"));
+      return FALSE;
+    }
+
+  if (psd_read (input, *src, src_len, error) < src_len)
+    {
+      psd_set_error (error);
+      g_clear_pointer (src, g_free);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Decodes the compressed data @src of a channel, read by
+ * read_channel_source(), and converts it to GIMP format.  Takes
+ * ownership of @src.  Doesn't access the file, and may be called from
+ * any thread.
+ */
+static gint
+decode_channel_data (PSDchannel     *channel,
+                     guint16         bps,
+                     guint16         compression,
+                     const guint32  *rle_pack_len,
+                     gchar          *src,
+                     guint32         comp_len,
+                     GError        **error)
+{
+  gchar    *raw_data = NULL;
+  guint32   readline_len;
+  gint      i, j;
+
+  readline_len = get_readline_len (channel, bps);
+
+  switch (compression)
+    {
+      case PSD_COMP_RAW:
+        raw_data = src;
+        src      = NULL;
+        break;
+
+      case PSD_COMP_RLE:
         {
-          z_stream zs;
+          const gchar *packed = src;
 
-          src = g_malloc (comp_len);
-          if (psd_read (input, src, comp_len, error) < comp_len)
+          raw_data = g_malloc (readline_len * channel->rows);
+          for (i = 0; i < channel->rows; ++i)
             {
-              psd_set_error (error);
-              g_free (src);
-              g_free (raw_data);
-              return -1;
+              /* FIXME check for errors returned from decode packbits */
+              decode_packbits (packed, raw_data + i * readline_len,
+                               rle_pack_len[i], readline_len);
+              packed += rle_pack_len[i];
             }
+          break;
+        }
+
+      case PSD_COMP_ZIP:
+      case PSD_COMP_ZIP_PRED:
+        {
+          z_stream zs;
+
+          raw_data = g_malloc (readline_len * channel->rows);
 
           zs.next_in = (guchar*) src;
           zs.avail_in = comp_len;
@@ -3170,12 +3508,16 @@ read_channel_data (PSDchannel     *channel,
               g_free (raw_data);
               return -1;
             }
-
-          g_free (src);
           break;
         }
+
+      default:
+        raw_data = g_malloc (readline_len * channel->rows);
+        break;
     }
 
+  g_free (src);
+
   /* Convert channel data to GIMP format */
   switch (bps)
     {